@@ -0,0 +1,277 @@
+#include "AccountHealth.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+// ========== AccountHealthTracker::Probe ==========
+
+AccountHealthTracker::Probe::Probe(Probe&& other) noexcept
+    : owner_(other.owner_), key_(std::move(other.key_)), seq_(other.seq_)
+{
+    other.owner_ = nullptr;
+}
+
+AccountHealthTracker::Probe& AccountHealthTracker::Probe::operator=(Probe&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        owner_ = other.owner_;
+        key_ = std::move(other.key_);
+        seq_ = other.seq_;
+        other.owner_ = nullptr;
+    }
+    return *this;
+}
+
+AccountHealthTracker::Probe::~Probe()
+{
+    release();
+}
+
+void AccountHealthTracker::Probe::release()
+{
+    if (owner_) {
+        owner_->abortProbe(key_, seq_);
+        owner_ = nullptr;
+    }
+}
+
+// ========== AccountHealthTracker ==========
+
+AccountHealthTracker& AccountHealthTracker::getInstance()
+{
+    static AccountHealthTracker instance;
+    return instance;
+}
+
+void AccountHealthTracker::setSettings(const RuntimeConfig::AccountHealth& settings)
+{
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    settings_ = settings;
+    latencyReferenceMs_.store(std::max(1, settings.latencyReferenceMs), std::memory_order_relaxed);
+}
+
+RuntimeConfig::AccountHealth AccountHealthTracker::settings() const
+{
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    return settings_;
+}
+
+string AccountHealthTracker::keyOf(const string& apiName, const string& userName)
+{
+    return apiName + '\n' + userName;
+}
+
+bool AccountHealthTracker::rejects(const Entry& entry, Clock::time_point now)
+{
+    if (!entry.open) {
+        return false;
+    }
+    return now < entry.openUntil || (entry.probeInFlight && now - entry.probeStartedAt < kProbeTimeout);
+}
+
+AccountHealthTracker::Shard& AccountHealthTracker::shardFor(const string& key)
+{
+    return shards_[std::hash<string>{}(key) % kShardCount];
+}
+
+const AccountHealthTracker::Shard& AccountHealthTracker::shardFor(const string& key) const
+{
+    return shards_[std::hash<string>{}(key) % kShardCount];
+}
+
+bool AccountHealthTracker::record(const string& apiName, const string& userName, double latencyMs, bool success,
+                                  Clock::time_point now)
+{
+    const auto settings = this->settings();
+    const string key = keyOf(apiName, userName);
+    auto& shard = shardFor(key);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& entry = shard.entries[key];
+    if (entry.samples == 0) {
+        entry.apiName = apiName;
+        entry.userName = userName;
+        entry.latencyEwmaMs = std::max(0.0, latencyMs);
+        entry.errorRateEwma = success ? 0.0 : 1.0;
+    } else {
+        const double alpha = settings.ewmaAlpha;
+        entry.latencyEwmaMs += alpha * (std::max(0.0, latencyMs) - entry.latencyEwmaMs);
+        entry.errorRateEwma += alpha * ((success ? 0.0 : 1.0) - entry.errorRateEwma);
+    }
+    entry.samples++;
+
+    const bool halfOpen = entry.open && now >= entry.openUntil;
+    entry.probeInFlight = false;
+    if (success) {
+        entry.successes++;
+        entry.consecutiveFailures = 0;
+        // 熔断期内完成的成功调用（熔断前已发出）不提前恢复，只有半开探测成功才关闭
+        if (halfOpen) {
+            entry.open = false;
+            entry.lastOpenSeconds = 0;
+        }
+        return false;
+    }
+
+    entry.failures++;
+    entry.consecutiveFailures++;
+
+    int openSeconds = 0;
+    if (halfOpen) {
+        openSeconds = std::min(std::max(entry.lastOpenSeconds, 1) * 2, settings.maxOpenSeconds);
+    } else if (!entry.open &&
+               ((entry.samples >= static_cast<uint64_t>(settings.minSamples) &&
+                 entry.errorRateEwma >= settings.errorThreshold) ||
+                entry.consecutiveFailures >= settings.consecutiveFailures)) {
+        openSeconds = settings.openSeconds;
+    }
+    if (openSeconds <= 0) {
+        return false;
+    }
+
+    entry.open = true;
+    entry.openUntil = now + std::chrono::seconds(openSeconds);
+    entry.lastOpenSeconds = openSeconds;
+    entry.trips++;
+    return true;
+}
+
+bool AccountHealthTracker::isOpen(const string& apiName, const string& userName, Clock::time_point now) const
+{
+    const string key = keyOf(apiName, userName);
+    const auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    return it != shard.entries.end() && rejects(it->second, now);
+}
+
+AccountHealthTracker::Probe AccountHealthTracker::beginProbe(const string& apiName, const string& userName,
+                                                             Clock::time_point now)
+{
+    string key = keyOf(apiName, userName);
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end() || rejects(it->second, now) || !it->second.open) {
+        return Probe();
+    }
+    it->second.probeInFlight = true;
+    it->second.probeStartedAt = now;
+    return Probe(this, std::move(key), ++it->second.probeSeq);
+}
+
+void AccountHealthTracker::abortProbe(const string& key, uint64_t seq)
+{
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end() && it->second.probeInFlight && it->second.probeSeq == seq) {
+        it->second.probeInFlight = false;
+    }
+}
+
+double AccountHealthTracker::loadCost(const Accountinfo_st& account, Clock::time_point now) const
+{
+    const double base = static_cast<double>(std::max(account.useCount, 0)) + 1.0;
+    const string key = keyOf(account.apiName, account.userName);
+    const auto& shard = shardFor(key);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        return base;
+    }
+    const auto& entry = it->second;
+    if (rejects(entry, now)) {
+        return std::numeric_limits<double>::infinity();
+    }
+    // 错误率 100% 时负载放大 5 倍；延迟等于参考值时负载放大 2 倍
+    const double errorPenalty = 1.0 + 4.0 * entry.errorRateEwma;
+    const double latencyPenalty = 1.0 + entry.latencyEwmaMs / latencyReferenceMs_.load(std::memory_order_relaxed);
+    return base * errorPenalty * latencyPenalty;
+}
+
+AccountHealthTracker::Stats AccountHealthTracker::toStats(const Entry& entry, Clock::time_point now)
+{
+    Stats stats;
+    stats.apiName = entry.apiName;
+    stats.userName = entry.userName;
+    stats.latencyEwmaMs = entry.latencyEwmaMs;
+    stats.errorRateEwma = entry.errorRateEwma;
+    stats.samples = entry.samples;
+    stats.successes = entry.successes;
+    stats.failures = entry.failures;
+    stats.consecutiveFailures = entry.consecutiveFailures;
+    stats.trips = entry.trips;
+    if (entry.open) {
+        if (now < entry.openUntil) {
+            stats.state = CircuitState::Open;
+            stats.openRemainingSeconds =
+                std::chrono::duration_cast<std::chrono::seconds>(entry.openUntil - now).count() + 1;
+        } else {
+            stats.state = CircuitState::HalfOpen;
+        }
+    }
+    return stats;
+}
+
+AccountHealthTracker::Stats AccountHealthTracker::get(const string& apiName, const string& userName,
+                                                      Clock::time_point now) const
+{
+    const string key = keyOf(apiName, userName);
+    const auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        Stats stats;
+        stats.apiName = apiName;
+        stats.userName = userName;
+        return stats;
+    }
+    return toStats(it->second, now);
+}
+
+std::vector<AccountHealthTracker::Stats> AccountHealthTracker::snapshot(const string& apiName,
+                                                                        Clock::time_point now) const
+{
+    std::vector<Stats> out;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [_, entry] : shard.entries) {
+            if (apiName.empty() || entry.apiName == apiName) {
+                out.push_back(toStats(entry, now));
+            }
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const Stats& a, const Stats& b) {
+        return a.apiName != b.apiName ? a.apiName < b.apiName : a.userName < b.userName;
+    });
+    return out;
+}
+
+void AccountHealthTracker::forget(const string& apiName, const string& userName)
+{
+    const string key = keyOf(apiName, userName);
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries.erase(key);
+}
+
+void AccountHealthTracker::clear()
+{
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+}
+
+const char* AccountHealthTracker::stateName(CircuitState state)
+{
+    switch (state) {
+        case CircuitState::Open: return "open";
+        case CircuitState::HalfOpen: return "half_open";
+        case CircuitState::Closed:
+        default: return "closed";
+    }
+}
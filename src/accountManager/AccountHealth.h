@@ -0,0 +1,154 @@
+#ifndef ACCOUNT_HEALTH_H
+#define ACCOUNT_HEALTH_H
+#include "AccountInfo.h"
+#include <utils/RuntimeConfig.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 账号健康度统计与熔断
+ *
+ * 每次上游调用结束后由 provider 上报耗时与成败，按 (apiName, userName) 维护延迟与错误率的 EWMA。
+ * 错误率超过阈值或连续失败过多时账号进入熔断（Open），熔断期内不参与调度；
+ * 到期后进入半开（HalfOpen），只放行一个探测调用：调用方占用账号后调用 beginProbe()，
+ * 探测上报前其他调用方仍视该账号为熔断；探测成功则恢复，失败则以翻倍时长重新熔断。
+ * beginProbe() 返回的 Probe 在未经 record() 上报就析构时归还探测名额（如调用前出错返回），
+ * 探测超过 kProbeTimeout 未上报也视为丢失，允许下一个调用方重新探测。
+ *
+ * AccountPool 取号时通过 loadCost() 把健康度折算进负载：健康账号按 useCount 均衡，
+ * 慢或易错的账号被按比例降权，熔断中的账号排在所有可用账号之后。
+ * 统计按 key 哈希分片加锁，取号路径上不引入跨渠道的全局锁。
+ */
+class AccountHealthTracker
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class CircuitState { Closed, Open, HalfOpen };
+
+    /// 占用中的半开探测名额；未上报结果即析构时归还，已 record() 过则析构无副作用
+    class Probe
+    {
+      public:
+        Probe() = default;
+        Probe(Probe&& other) noexcept;
+        Probe& operator=(Probe&& other) noexcept;
+        Probe(const Probe&) = delete;
+        Probe& operator=(const Probe&) = delete;
+        ~Probe();
+
+        explicit operator bool() const { return owner_ != nullptr; }
+        void release();
+
+      private:
+        friend class AccountHealthTracker;
+        Probe(AccountHealthTracker* owner, string key, uint64_t seq) : owner_(owner), key_(std::move(key)), seq_(seq) {}
+
+        AccountHealthTracker* owner_ = nullptr;
+        string key_;
+        uint64_t seq_ = 0;
+    };
+
+    struct Stats
+    {
+        string apiName;
+        string userName;
+        double latencyEwmaMs = 0.0;
+        double errorRateEwma = 0.0;
+        uint64_t samples = 0;
+        uint64_t successes = 0;
+        uint64_t failures = 0;
+        int consecutiveFailures = 0;
+        CircuitState state = CircuitState::Closed;
+        /// 熔断剩余秒数（仅 Open 状态有意义）
+        int64_t openRemainingSeconds = 0;
+        /// 累计熔断次数
+        uint64_t trips = 0;
+    };
+
+    static AccountHealthTracker& getInstance();
+
+    void setSettings(const RuntimeConfig::AccountHealth& settings);
+    RuntimeConfig::AccountHealth settings() const;
+
+    /// 上报一次上游调用结果，本次上报导致熔断（含半开探测失败后重新熔断）时返回 true
+    bool record(const string& apiName, const string& userName, double latencyMs, bool success,
+                Clock::time_point now = Clock::now());
+
+    /// 账号是否处于熔断期内；半开时仅在没有进行中的探测时视为可用
+    bool isOpen(const string& apiName, const string& userName, Clock::time_point now = Clock::now()) const;
+
+    /// 调用方已占用账号并将发出调用：账号半开且无进行中的探测时，本次调用成为探测；否则返回空 Probe
+    Probe beginProbe(const string& apiName, const string& userName, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief 调度负载：(useCount + 1) × 错误率惩罚 × 延迟惩罚，越小越优先
+     *
+     * 熔断中（含半开且探测进行中）的账号返回 +inf。
+     */
+    double loadCost(const Accountinfo_st& account, Clock::time_point now = Clock::now()) const;
+
+    Stats get(const string& apiName, const string& userName, Clock::time_point now = Clock::now()) const;
+    /// apiName 为空时返回全部账号
+    std::vector<Stats> snapshot(const string& apiName = "", Clock::time_point now = Clock::now()) const;
+
+    void forget(const string& apiName, const string& userName);
+    void clear();
+
+    static const char* stateName(CircuitState state);
+
+    static constexpr std::chrono::seconds kProbeTimeout{120};
+
+  private:
+    AccountHealthTracker() = default;
+
+    struct Entry
+    {
+        string apiName;
+        string userName;
+        double latencyEwmaMs = 0.0;
+        double errorRateEwma = 0.0;
+        uint64_t samples = 0;
+        uint64_t successes = 0;
+        uint64_t failures = 0;
+        int consecutiveFailures = 0;
+        bool open = false;
+        Clock::time_point openUntil;
+        int lastOpenSeconds = 0;
+        uint64_t trips = 0;
+        bool probeInFlight = false;
+        Clock::time_point probeStartedAt;
+        /// 每次占用探测递增，避免旧 Probe 归还后来者占用的名额
+        uint64_t probeSeq = 0;
+    };
+
+    static constexpr size_t kShardCount = 16;
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<string, Entry> entries;
+    };
+
+    static string keyOf(const string& apiName, const string& userName);
+    /// 熔断期内，或半开且探测进行中
+    static bool rejects(const Entry& entry, Clock::time_point now);
+    static Stats toStats(const Entry& entry, Clock::time_point now);
+    /// 探测 seq 仍在进行中时归还名额
+    void abortProbe(const string& key, uint64_t seq);
+    Shard& shardFor(const string& key);
+    const Shard& shardFor(const string& key) const;
+
+    std::array<Shard, kShardCount> shards_;
+    mutable std::mutex settingsMutex_;
+    RuntimeConfig::AccountHealth settings_;
+    std::atomic<int> latencyReferenceMs_{30000};
+};
+
+#endif
@@ -0,0 +1,271 @@
+#include "AccountPool.h"
+#include "AccountHealth.h"
+#include "AccountThrottle.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// 调度负载：冷却中、在途已满或熔断中的账号为无穷大，其余按健康度折算
+double selectionCost(const Accountinfo_st& account, AccountHealthTracker::Clock::time_point now)
+{
+    if (!AccountThrottle::getInstance().isAvailable(account.apiName, account.userName, now)) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return AccountHealthTracker::getInstance().loadCost(account, now);
+}
+
+// 返回 a、b 中优先级更高的账号：tokenStatus 有效优先，其次按调度负载择优
+const shared_ptr<Accountinfo_st>& betterOf(const shared_ptr<Accountinfo_st>& a, const shared_ptr<Accountinfo_st>& b,
+                                           AccountHealthTracker::Clock::time_point now)
+{
+    if (a->tokenStatus != b->tokenStatus) {
+        return a->tokenStatus ? a : b;
+    }
+    return selectionCost(*b, now) < selectionCost(*a, now) ? b : a;
+}
+
+}
+
+void AccountPool::Slot::add(const shared_ptr<Accountinfo_st>& account)
+{
+    auto it = position.find(account->userName);
+    if (it != position.end()) {
+        accounts[it->second] = account;
+        return;
+    }
+    position[account->userName] = accounts.size();
+    accounts.push_back(account);
+}
+
+void AccountPool::Slot::erase(const string& userName)
+{
+    auto it = position.find(userName);
+    if (it == position.end()) {
+        return;
+    }
+    const size_t index = it->second;
+    const size_t last = accounts.size() - 1;
+    if (index != last) {
+        accounts[index] = std::move(accounts[last]);
+        position[accounts[index]->userName] = index;
+    }
+    accounts.pop_back();
+    position.erase(it);
+}
+
+void AccountPool::ApiPool::putLocked(const shared_ptr<Accountinfo_st>& account)
+{
+    auto typeIt = indexedType.find(account->userName);
+    if (typeIt != indexedType.end() && typeIt->second != account->accountType) {
+        auto slotIt = byType.find(typeIt->second);
+        if (slotIt != byType.end()) {
+            slotIt->second.erase(account->userName);
+            if (slotIt->second.accounts.empty()) {
+                byType.erase(slotIt);
+            }
+        }
+    }
+    all.add(account);
+    byType[account->accountType].add(account);
+    indexedType[account->userName] = account->accountType;
+}
+
+void AccountPool::ApiPool::eraseLocked(const string& userName)
+{
+    auto typeIt = indexedType.find(userName);
+    if (typeIt != indexedType.end()) {
+        auto slotIt = byType.find(typeIt->second);
+        if (slotIt != byType.end()) {
+            slotIt->second.erase(userName);
+            if (slotIt->second.accounts.empty()) {
+                byType.erase(slotIt);
+            }
+        }
+        indexedType.erase(typeIt);
+    }
+    all.erase(userName);
+}
+
+size_t AccountPool::ApiPool::nextIndex(size_t bound)
+{
+    // xorshift64*：子池锁内调用，无需额外同步
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return static_cast<size_t>((rngState * 0x2545F4914F6CDD1DULL) % bound);
+}
+
+shared_ptr<AccountPool::ApiPool> AccountPool::findPool(const string& apiName) const
+{
+    std::shared_lock<std::shared_mutex> lock(poolsMutex_);
+    auto it = pools_.find(apiName);
+    return it == pools_.end() ? nullptr : it->second;
+}
+
+shared_ptr<AccountPool::ApiPool> AccountPool::getOrCreatePool(const string& apiName)
+{
+    if (auto pool = findPool(apiName)) {
+        return pool;
+    }
+    std::unique_lock<std::shared_mutex> lock(poolsMutex_);
+    auto& pool = pools_[apiName];
+    if (!pool) {
+        pool = std::make_shared<ApiPool>();
+    }
+    return pool;
+}
+
+void AccountPool::put(const shared_ptr<Accountinfo_st>& account)
+{
+    if (!account) {
+        return;
+    }
+    auto pool = getOrCreatePool(account->apiName);
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->putLocked(account);
+}
+
+void AccountPool::remove(const string& apiName, const string& userName)
+{
+    auto pool = findPool(apiName);
+    if (!pool) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->eraseLocked(userName);
+}
+
+void AccountPool::reset(const string& apiName, const std::vector<shared_ptr<Accountinfo_st>>& accounts)
+{
+    auto fresh = std::make_shared<ApiPool>();
+    for (const auto& account : accounts) {
+        if (account) {
+            fresh->putLocked(account);
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(poolsMutex_);
+    if (fresh->all.accounts.empty()) {
+        pools_.erase(apiName);
+    } else {
+        pools_[apiName] = fresh;
+    }
+}
+
+void AccountPool::reindex(const string& apiName)
+{
+    auto pool = findPool(apiName);
+    if (!pool) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    const auto accounts = pool->all.accounts;
+    for (const auto& account : accounts) {
+        pool->putLocked(account);
+    }
+}
+
+void AccountPool::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(poolsMutex_);
+    pools_.clear();
+}
+
+shared_ptr<Accountinfo_st> AccountPool::acquire(const string& apiName, const string& accountType)
+{
+    auto pool = findPool(apiName);
+    if (!pool) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(pool->mutex);
+
+    Slot* slot = &pool->all;
+    if (!accountType.empty()) {
+        auto slotIt = pool->byType.find(accountType);
+        if (slotIt == pool->byType.end()) {
+            return nullptr;
+        }
+        slot = &slotIt->second;
+    }
+
+    const auto& accounts = slot->accounts;
+    const size_t n = accounts.size();
+    if (n == 0) {
+        return nullptr;
+    }
+    const auto now = AccountHealthTracker::Clock::now();
+    auto chosen = accounts[pool->nextIndex(n)];
+    if (n > 1) {
+        chosen = betterOf(chosen, accounts[pool->nextIndex(n)], now);
+    }
+    if (!chosen->tokenStatus || std::isinf(selectionCost(*chosen, now))) {
+        // 两个候选都不可用（token 失效、熔断、冷却或在途已满）时退化为线性查找，保证有可用账号时一定选中；
+        // 全部不可用时仍返回其中之一，由调用方决定是否使用
+        for (const auto& account : accounts) {
+            if (account->tokenStatus) {
+                chosen = betterOf(chosen, account, now);
+            }
+        }
+    }
+
+    if (chosen->tokenStatus) {
+        chosen->useCount++;
+    }
+    return chosen;
+}
+
+void AccountPool::update(const shared_ptr<Accountinfo_st>& account,
+                         const std::function<void(Accountinfo_st&)>& mutator)
+{
+    if (!account) {
+        return;
+    }
+    auto pool = getOrCreatePool(account->apiName);
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    mutator(*account);
+    auto it = pool->all.position.find(account->userName);
+    if (it != pool->all.position.end() && pool->all.accounts[it->second] == account) {
+        pool->putLocked(account);
+    }
+}
+
+void AccountPool::recordUse(const shared_ptr<Accountinfo_st>& account)
+{
+    if (!account) {
+        return;
+    }
+    auto pool = getOrCreatePool(account->apiName);
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    account->useCount++;
+}
+
+size_t AccountPool::size(const string& apiName) const
+{
+    auto pool = findPool(apiName);
+    if (!pool) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    return pool->all.accounts.size();
+}
+
+std::vector<string> AccountPool::apiNames() const
+{
+    std::shared_lock<std::shared_mutex> lock(poolsMutex_);
+    std::vector<string> names;
+    names.reserve(pools_.size());
+    for (const auto& [apiName, _] : pools_) {
+        names.push_back(apiName);
+    }
+    return names;
+}
+
+std::vector<shared_ptr<Accountinfo_st>> AccountPool::snapshot(const string& apiName) const
+{
+    auto pool = findPool(apiName);
+    if (!pool) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    return pool->all.accounts;
+}
@@ -0,0 +1,91 @@
+#ifndef ACCOUNT_POOL_H
+#define ACCOUNT_POOL_H
+#include "AccountInfo.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 按 (apiName, accountType) 索引的可调度账号池
+ *
+ * 每个 apiName 一个子池，各自持有独立的互斥锁，不同渠道的取号互不阻塞，也不占用 accountListMutex。
+ * 子池内部为扁平数组 + userName 位置索引，增删 O(1)；取号采用 power-of-two-choices：
+ * 随机取两个候选，tokenStatus 有效优先，其次按 AccountHealthTracker::loadCost()
+ * （useCount 经延迟/错误率加权，熔断中为无穷大）择优，O(1) 完成选择；
+ * AccountThrottle 判定为冷却中或在途已满的账号同样视为负载无穷大。
+ *
+ * 取号读取的 accountType / tokenStatus / useCount 等字段只能在子池锁内修改：
+ * 刷新 token、更新账号类型等流程一律通过 update() 修改账号，类型变化随之重新归类，
+ * 类型分组因此始终与账号字段一致。
+ */
+class AccountPool
+{
+  public:
+    /// 加入或重新归类账号（已存在则按当前 accountType 移动到对应类型分组）
+    void put(const shared_ptr<Accountinfo_st>& account);
+    void remove(const string& apiName, const string& userName);
+    /// 以给定账号集合整体替换某渠道的子池
+    void reset(const string& apiName, const std::vector<shared_ptr<Accountinfo_st>>& accounts);
+    /// 按账号当前的 accountType 重建某渠道的类型分组
+    void reindex(const string& apiName);
+    void clear();
+
+    /**
+     * @brief 取号
+     *
+     * @param accountType 为空时在整个渠道内选择，否则只在该类型分组内选择
+     * @return 选中的账号；tokenStatus 为 true 时 useCount 加 1。池为空或无该类型账号时返回 nullptr
+     */
+    shared_ptr<Accountinfo_st> acquire(const string& apiName, const string& accountType = "");
+
+    /**
+     * @brief 在账号所属渠道的子池锁内修改账号字段
+     *
+     * 账号已在池中时按修改后的 accountType 重新归类；不在池中时只修改字段，
+     * 是否加入/移出账号池仍由调用方按状态决定（put() / remove()）。
+     */
+    void update(const shared_ptr<Accountinfo_st>& account, const std::function<void(Accountinfo_st&)>& mutator);
+
+    /// 在子池锁内累加 useCount（用于按用户名直接取号等绕过 acquire 的路径）
+    void recordUse(const shared_ptr<Accountinfo_st>& account);
+
+    size_t size(const string& apiName) const;
+    std::vector<string> apiNames() const;
+    std::vector<shared_ptr<Accountinfo_st>> snapshot(const string& apiName) const;
+
+  private:
+    struct Slot
+    {
+        std::vector<shared_ptr<Accountinfo_st>> accounts;
+        std::unordered_map<string, size_t> position;  // userName -> accounts 下标
+
+        void add(const shared_ptr<Accountinfo_st>& account);
+        void erase(const string& userName);
+    };
+
+    struct ApiPool
+    {
+        mutable std::mutex mutex;
+        Slot all;
+        std::unordered_map<string, Slot> byType;
+        std::unordered_map<string, string> indexedType;  // userName -> 归类时的 accountType
+        uint64_t rngState = 0x9E3779B97F4A7C15ULL;
+
+        void putLocked(const shared_ptr<Accountinfo_st>& account);
+        void eraseLocked(const string& userName);
+        size_t nextIndex(size_t bound);
+    };
+
+    shared_ptr<ApiPool> findPool(const string& apiName) const;
+    shared_ptr<ApiPool> getOrCreatePool(const string& apiName);
+
+    mutable std::shared_mutex poolsMutex_;
+    std::unordered_map<string, shared_ptr<ApiPool>> pools_;
+};
+
+#endif
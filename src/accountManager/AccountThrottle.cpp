@@ -0,0 +1,388 @@
+#include "AccountThrottle.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+// 学习到的上限回升到该值以上时取消限制
+constexpr double kLearnedCeilingPerMinute = 600.0;
+// 学习到的上限不低于该值，也不低于最近一分钟成功数的一半
+constexpr double kLearnedFloorPerMinute = 6.0;
+
+std::string trimCopy(const std::string& value)
+{
+    const auto begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+double burstOf(double perMinute)
+{
+    return std::max(1.0, perMinute / 10.0);
+}
+
+// 解析 "1m30s" / "250ms" / "2h" 形式的时长，失败返回 -1
+double parseGoDuration(const std::string& value)
+{
+    double total = 0.0;
+    size_t i = 0;
+    bool any = false;
+    while (i < value.size()) {
+        const char* begin = value.c_str() + i;
+        char* end = nullptr;
+        const double number = std::strtod(begin, &end);
+        if (end == begin) {
+            return -1.0;
+        }
+        i += static_cast<size_t>(end - begin);
+        std::string unit;
+        while (i < value.size() && std::isalpha(static_cast<unsigned char>(value[i]))) {
+            unit += value[i++];
+        }
+        if (unit == "h") total += number * 3600.0;
+        else if (unit == "m") total += number * 60.0;
+        else if (unit == "s") total += number;
+        else if (unit == "ms") total += number / 1000.0;
+        else return -1.0;
+        any = true;
+    }
+    return any ? total : -1.0;
+}
+
+}
+
+// ========== Lease ==========
+
+AccountThrottle::Lease::Lease(Lease&& other) noexcept : owner_(other.owner_), key_(std::move(other.key_))
+{
+    other.owner_ = nullptr;
+}
+
+AccountThrottle::Lease& AccountThrottle::Lease::operator=(Lease&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        owner_ = other.owner_;
+        key_ = std::move(other.key_);
+        other.owner_ = nullptr;
+    }
+    return *this;
+}
+
+AccountThrottle::Lease::~Lease()
+{
+    release();
+}
+
+void AccountThrottle::Lease::release()
+{
+    if (owner_) {
+        owner_->release(key_);
+        owner_ = nullptr;
+    }
+}
+
+// ========== AccountThrottle ==========
+
+AccountThrottle& AccountThrottle::getInstance()
+{
+    static AccountThrottle instance;
+    return instance;
+}
+
+AccountThrottle::AccountThrottle() : settings_(std::make_shared<RuntimeConfig::AccountThrottle>())
+{
+}
+
+void AccountThrottle::setSettings(const RuntimeConfig::AccountThrottle& settings)
+{
+    auto next = std::make_shared<const RuntimeConfig::AccountThrottle>(settings);
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    settings_ = std::move(next);
+}
+
+std::shared_ptr<const RuntimeConfig::AccountThrottle> AccountThrottle::settings() const
+{
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    return settings_;
+}
+
+std::string AccountThrottle::keyOf(const std::string& provider, const std::string& account)
+{
+    return provider + '\n' + account;
+}
+
+AccountThrottle::Shard& AccountThrottle::shardFor(const std::string& key)
+{
+    return shards_[std::hash<std::string>{}(key) % kShardCount];
+}
+
+const AccountThrottle::Shard& AccountThrottle::shardFor(const std::string& key) const
+{
+    return shards_[std::hash<std::string>{}(key) % kShardCount];
+}
+
+void AccountThrottle::refill(Entry& entry, Clock::time_point now)
+{
+    if (entry.learnedPerMinute <= 0.0) {
+        return;
+    }
+    const double elapsed = std::chrono::duration<double>(now - entry.lastRefill).count();
+    if (elapsed > 0) {
+        entry.tokens = std::min(burstOf(entry.learnedPerMinute), entry.tokens + elapsed * entry.learnedPerMinute / 60.0);
+        entry.lastRefill = now;
+    }
+}
+
+void AccountThrottle::rollWindow(Entry& entry, Clock::time_point now)
+{
+    const auto elapsed = now - entry.windowStart;
+    if (elapsed < std::chrono::minutes(1)) {
+        return;
+    }
+    entry.lastWindowSuccesses = elapsed < std::chrono::minutes(2) ? entry.windowSuccesses : 0;
+    entry.windowStart = now;
+    entry.windowStarts = 0;
+    entry.windowSuccesses = 0;
+}
+
+int AccountThrottle::recentSuccesses(const Entry& entry, Clock::time_point now)
+{
+    const auto elapsed = now - entry.windowStart;
+    if (elapsed < std::chrono::minutes(1)) {
+        return std::max(entry.windowSuccesses, entry.lastWindowSuccesses);
+    }
+    return elapsed < std::chrono::minutes(2) ? entry.windowSuccesses : 0;
+}
+
+bool AccountThrottle::admits(const Entry& entry, int maxInFlight, Clock::time_point now)
+{
+    if (now < entry.coolUntil) {
+        return false;
+    }
+    if (maxInFlight > 0 && entry.inFlight >= maxInFlight) {
+        return false;
+    }
+    if (entry.learnedPerMinute > 0.0) {
+        const double elapsed = std::max(0.0, std::chrono::duration<double>(now - entry.lastRefill).count());
+        const double tokens = std::min(burstOf(entry.learnedPerMinute), entry.tokens + elapsed * entry.learnedPerMinute / 60.0);
+        if (tokens < 1.0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AccountThrottle::isAvailable(const std::string& provider, const std::string& account, Clock::time_point now) const
+{
+    const auto maxInFlight = settings()->maxInFlightFor(provider);
+    const std::string key = keyOf(provider, account);
+    const auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    return it == shard.entries.end() || admits(it->second, maxInFlight, now);
+}
+
+AccountThrottle::Lease AccountThrottle::tryBegin(const std::string& provider, const std::string& account, Clock::time_point now)
+{
+    const auto maxInFlight = settings()->maxInFlightFor(provider);
+    const std::string key = keyOf(provider, account);
+    auto& shard = shardFor(key);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& entry = shard.entries[key];
+    if (entry.provider.empty()) {
+        entry.provider = provider;
+        entry.account = account;
+        entry.windowStart = now;
+    }
+    if (!admits(entry, maxInFlight, now)) {
+        entry.rejectedCount++;
+        return Lease();
+    }
+
+    refill(entry, now);
+    if (entry.learnedPerMinute > 0.0) {
+        entry.tokens -= 1.0;
+    }
+    rollWindow(entry, now);
+    entry.windowStarts++;
+    entry.inFlight++;
+    return Lease(this, key);
+}
+
+void AccountThrottle::release(const std::string& key)
+{
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end() && it->second.inFlight > 0) {
+        it->second.inFlight--;
+    }
+}
+
+double AccountThrottle::noteRateLimited(const std::string& provider, const std::string& account, double retryAfterSeconds,
+                                        Clock::time_point now)
+{
+    const auto settings = this->settings();
+    const std::string key = keyOf(provider, account);
+    auto& shard = shardFor(key);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& entry = shard.entries[key];
+    if (entry.provider.empty()) {
+        entry.provider = provider;
+        entry.account = account;
+        entry.windowStart = now;
+    }
+    entry.rateLimitedCount++;
+    entry.consecutiveRateLimited++;
+
+    double delay = 0.0;
+    if (retryAfterSeconds >= 0) {
+        delay = std::clamp(retryAfterSeconds, 1.0, static_cast<double>(settings->maxCooldownSeconds));
+    } else {
+        const int exponent = std::min(entry.consecutiveRateLimited - 1, 16);
+        delay = std::min(static_cast<double>(settings->defaultCooldownSeconds) * std::pow(2.0, exponent),
+                         static_cast<double>(settings->maxCooldownSeconds));
+    }
+    const auto until = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(delay));
+    entry.coolUntil = std::max(entry.coolUntil, until);
+
+    if (settings->learnRate) {
+        const int observed = now - entry.windowStart < std::chrono::minutes(1) ? entry.windowStarts : 0;
+        // 连续 429 反复减半时不低于最近确实跑通的速率的一半，避免把账号压到每分钟 1 次
+        const double floor = std::max(kLearnedFloorPerMinute, recentSuccesses(entry, now) / 2.0);
+        entry.learnedPerMinute = std::max(floor, entry.learnedPerMinute > 0.0
+            ? entry.learnedPerMinute / 2.0
+            : observed / 2.0);
+        entry.tokens = 0.0;
+        entry.lastRefill = entry.coolUntil;
+    }
+    return delay;
+}
+
+void AccountThrottle::noteSuccess(const std::string& provider, const std::string& account, Clock::time_point now)
+{
+    const std::string key = keyOf(provider, account);
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        return;
+    }
+    auto& entry = it->second;
+    entry.consecutiveRateLimited = 0;
+    rollWindow(entry, now);
+    entry.windowSuccesses++;
+    if (entry.learnedPerMinute > 0.0) {
+        entry.learnedPerMinute += 1.0;
+        if (entry.learnedPerMinute > kLearnedCeilingPerMinute) {
+            entry.learnedPerMinute = 0.0;
+        }
+    }
+}
+
+double AccountThrottle::cooldownRemaining(const std::string& provider, const std::string& account, Clock::time_point now) const
+{
+    const std::string key = keyOf(provider, account);
+    const auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end() || now >= it->second.coolUntil) {
+        return 0.0;
+    }
+    return std::chrono::duration<double>(it->second.coolUntil - now).count();
+}
+
+std::vector<AccountThrottle::Stats> AccountThrottle::snapshot(const std::string& provider, Clock::time_point now) const
+{
+    std::vector<Stats> out;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [_, entry] : shard.entries) {
+            if (!provider.empty() && entry.provider != provider) {
+                continue;
+            }
+            const bool cooling = now < entry.coolUntil;
+            if (entry.inFlight == 0 && !cooling && entry.learnedPerMinute <= 0.0 &&
+                entry.rateLimitedCount == 0 && entry.rejectedCount == 0) {
+                continue;
+            }
+            Stats stats;
+            stats.provider = entry.provider;
+            stats.account = entry.account;
+            stats.inFlight = entry.inFlight;
+            stats.coolingRemainingSeconds = cooling
+                ? static_cast<int64_t>(std::ceil(std::chrono::duration<double>(entry.coolUntil - now).count()))
+                : 0;
+            stats.learnedPerMinute = entry.learnedPerMinute;
+            stats.rateLimitedCount = entry.rateLimitedCount;
+            stats.rejectedCount = entry.rejectedCount;
+            out.push_back(std::move(stats));
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const Stats& a, const Stats& b) {
+        return a.provider != b.provider ? a.provider < b.provider : a.account < b.account;
+    });
+    return out;
+}
+
+void AccountThrottle::clear()
+{
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+    }
+}
+
+double AccountThrottle::parseDelaySeconds(const std::string& raw, std::time_t nowEpoch)
+{
+    const std::string value = trimCopy(raw);
+    if (value.empty()) {
+        return -1.0;
+    }
+
+    char* end = nullptr;
+    const double number = std::strtod(value.c_str(), &end);
+    if (end != value.c_str() && *end == '\0') {
+        if (number < 0) {
+            return -1.0;
+        }
+        // 大于 1e9 视为 epoch 秒形式的重置时间
+        if (number > 1e9) {
+            return std::max(0.0, number - static_cast<double>(nowEpoch));
+        }
+        return number;
+    }
+
+    const double duration = parseGoDuration(value);
+    if (duration >= 0) {
+        return duration;
+    }
+
+    std::tm tm{};
+    const char* parsed = strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S", &tm);
+    if (parsed) {
+        const std::time_t at = timegm(&tm);
+        return std::max(0.0, static_cast<double>(at - nowEpoch));
+    }
+    return -1.0;
+}
+
+double AccountThrottle::retryAfterFromHeaders(std::initializer_list<std::string> values, std::time_t nowEpoch)
+{
+    for (const auto& value : values) {
+        const double delay = parseDelaySeconds(value, nowEpoch);
+        if (delay >= 0) {
+            return delay;
+        }
+    }
+    return -1.0;
+}
@@ -0,0 +1,149 @@
+#ifndef ACCOUNT_THROTTLE_H
+#define ACCOUNT_THROTTLE_H
+#include <utils/RuntimeConfig.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 按上游账号的限流感知：429 冷却、学习到的速率上限与在途请求上限
+ *
+ * 账号以 (provider, accountId) 标识，accountId 为账号池用户名、Retool workspaceId 或 OpenAI key 标签。
+ * - 上游返回 429 时按 Retry-After / 重置头冷却账号；未给出时按 default_cooldown_seconds 起步、连续 429 翻倍。
+ * - learn_rate 开启时，429 把账号的每分钟上限设为最近一分钟实际发出量的一半（已有上限则减半），
+ *   但不低于 6/min 与最近一分钟成功数的一半；之后每次成功加 1，形成 AIMD；上限回升到 600/min 以上时取消限制。
+ * - tryBegin() 原子地检查冷却、令牌与在途上限并占用名额，返回的 Lease 析构时释放。
+ *
+ * 取号时 isAvailable() 只做只读判断，用于跳过冷却中或已满的账号；真正的占用以 tryBegin() 为准。
+ */
+class AccountThrottle
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    class Lease
+    {
+      public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        explicit operator bool() const { return owner_ != nullptr; }
+        void release();
+
+      private:
+        friend class AccountThrottle;
+        Lease(AccountThrottle* owner, std::string key) : owner_(owner), key_(std::move(key)) {}
+
+        AccountThrottle* owner_ = nullptr;
+        std::string key_;
+    };
+
+    struct Stats
+    {
+        std::string provider;
+        std::string account;
+        int inFlight = 0;
+        int64_t coolingRemainingSeconds = 0;
+        /// 学习到的每分钟上限，0 表示未限制
+        double learnedPerMinute = 0.0;
+        uint64_t rateLimitedCount = 0;
+        /// 因冷却/令牌/在途上限被拒绝占用的次数
+        uint64_t rejectedCount = 0;
+    };
+
+    static AccountThrottle& getInstance();
+
+    void setSettings(const RuntimeConfig::AccountThrottle& settings);
+
+    bool isAvailable(const std::string& provider, const std::string& account, Clock::time_point now = Clock::now()) const;
+    /// 占用失败时返回空 Lease
+    Lease tryBegin(const std::string& provider, const std::string& account, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief 记录一次上游 429
+     *
+     * @param retryAfterSeconds 上游给出的等待秒数，小于 0 表示未给出
+     * @return 实际采用的冷却秒数
+     */
+    double noteRateLimited(const std::string& provider, const std::string& account, double retryAfterSeconds,
+                           Clock::time_point now = Clock::now());
+    void noteSuccess(const std::string& provider, const std::string& account, Clock::time_point now = Clock::now());
+
+    /// 剩余冷却秒数，未冷却时为 0
+    double cooldownRemaining(const std::string& provider, const std::string& account, Clock::time_point now = Clock::now()) const;
+
+    /// provider 为空时返回全部账号；只包含有在途请求、冷却或限流记录的账号
+    std::vector<Stats> snapshot(const std::string& provider = "", Clock::time_point now = Clock::now()) const;
+    void clear();
+
+    /**
+     * @brief 解析 Retry-After / x-ratelimit-reset* 等头的值
+     *
+     * 支持秒数（可带小数）、Go 风格时长（"1m30s"、"250ms"）、epoch 秒（大于 1e9 时视为绝对时间）
+     * 与 HTTP-date。无法解析时返回 -1。
+     */
+    static double parseDelaySeconds(const std::string& value, std::time_t nowEpoch);
+    /// 依次解析多个头的值，返回第一个可解析的结果，均无法解析时返回 -1
+    static double retryAfterFromHeaders(std::initializer_list<std::string> values, std::time_t nowEpoch);
+
+  private:
+    AccountThrottle();
+
+    struct Entry
+    {
+        std::string provider;
+        std::string account;
+        int inFlight = 0;
+        Clock::time_point coolUntil;
+        int consecutiveRateLimited = 0;
+        uint64_t rateLimitedCount = 0;
+        uint64_t rejectedCount = 0;
+        // 学习到的速率上限（令牌桶）
+        double learnedPerMinute = 0.0;
+        double tokens = 0.0;
+        Clock::time_point lastRefill;
+        // 最近一分钟内的发出量与成功数（固定窗口），以及上一窗口的成功数
+        Clock::time_point windowStart;
+        int windowStarts = 0;
+        int windowSuccesses = 0;
+        int lastWindowSuccesses = 0;
+    };
+
+    static constexpr size_t kShardCount = 16;
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    static std::string keyOf(const std::string& provider, const std::string& account);
+    Shard& shardFor(const std::string& key);
+    const Shard& shardFor(const std::string& key) const;
+    std::shared_ptr<const RuntimeConfig::AccountThrottle> settings() const;
+
+    /// 调用方需持有所在分片的锁
+    static void refill(Entry& entry, Clock::time_point now);
+    static bool admits(const Entry& entry, int maxInFlight, Clock::time_point now);
+    static void rollWindow(Entry& entry, Clock::time_point now);
+    /// 最近一分钟左右的成功数（当前窗口与上一窗口取大者）
+    static int recentSuccesses(const Entry& entry, Clock::time_point now);
+    void release(const std::string& key);
+
+    std::array<Shard, kShardCount> shards_;
+    mutable std::mutex settingsMutex_;
+    std::shared_ptr<const RuntimeConfig::AccountThrottle> settings_;
+};
+
+#endif
@@ -13,6 +13,7 @@
 #include <channelManager/channelManager.h>
 #include <retoolWorkspace/RetoolWorkspaceManager.h>
 #include <retoolWorkspace/RetoolWorkspaceService.h>
+#include <apipoint/nexosapi/NexosSerializedData.h>
 using namespace drogon;
 using namespace drogon::orm;
 
@@ -210,9 +211,9 @@ std::string extractErrorMessageFromEnvelope(const Json::Value& json, const std::
     return fallback;
 }
 
-Json::Value fetchNexosChatDataByCookie(const std::string& cookieHeader) {
+NexosSerializedData fetchNexosChatDataByCookie(const std::string& cookieHeader) {
     if (cookieHeader.empty()) {
-        return Json::Value();
+        return NexosSerializedData();
     }
 
     auto client = HttpClient::newHttpClient("https://workspace.nexos.ai");
@@ -225,15 +226,10 @@ Json::Value fetchNexosChatDataByCookie(const std::string& cookieHeader) {
 
     auto [result, response] = client->sendRequest(request, 30.0);
     if (result != ReqResult::Ok || !response || response->getStatusCode() != 200) {
-        return Json::Value();
+        return NexosSerializedData();
     }
 
-    Json::Value json;
-    std::string errs;
-    if (!parseJsonBody(std::string(response->getBody()), json, errs) || !json.isArray() || json.empty()) {
-        return Json::Value();
-    }
-    return json;
+    return NexosSerializedData::parse(std::string(response->getBody()));
 }
 
 std::string extractNexosCookieHeader(const std::string& authTokenOrSessionHandle) {
@@ -255,88 +251,9 @@ std::string extractNexosCookieHeader(const std::string& authTokenOrSessionHandle
     return authTokenOrSessionHandle;
 }
 
-Json::Value decodeNexosSerializedRef(
-    int index,
-    const Json::Value& root,
-    std::map<int, Json::Value>& memo,
-    std::set<int>& inProgress);
-
-Json::Value decodeNexosSerializedInline(
-    const Json::Value& value,
-    const Json::Value& root,
-    std::map<int, Json::Value>& memo,
-    std::set<int>& inProgress)
-{
-    if (value.isNull() || value.isString() || value.isBool() || value.isDouble()) {
-        return value;
-    }
-    if (value.isInt()) {
-        const int n = value.asInt();
-        if (n < 0) return Json::nullValue;
-        if (!root.isArray() || n >= static_cast<int>(root.size())) return value;
-        return decodeNexosSerializedRef(n, root, memo, inProgress);
-    }
-    if (value.isArray()) {
-        Json::Value out(Json::arrayValue);
-        for (const auto& item : value) out.append(decodeNexosSerializedInline(item, root, memo, inProgress));
-        return out;
-    }
-    if (value.isObject()) {
-        Json::Value out(Json::objectValue);
-        for (const auto& key : value.getMemberNames()) {
-            std::string resolvedKey = key;
-            if (key.size() > 1 && key[0] == '_' &&
-                std::all_of(key.begin() + 1, key.end(), [](unsigned char ch) { return std::isdigit(ch); })) {
-                try {
-                    const unsigned long long idxUll = std::stoull(key.substr(1));
-                    if (root.isArray() && idxUll < static_cast<unsigned long long>(root.size())) {
-                        Json::Value keyValue = decodeNexosSerializedRef(static_cast<int>(idxUll), root, memo, inProgress);
-                        if (keyValue.isString()) {
-                            resolvedKey = keyValue.asString();
-                        }
-                    }
-                } catch (const std::exception&) {
-                    // 保持原始 key，避免异常导致启动阶段崩溃
-                }
-            }
-            out[resolvedKey] = decodeNexosSerializedInline(value[key], root, memo, inProgress);
-        }
-        return out;
-    }
-    return value;
-}
-
-Json::Value decodeNexosSerializedRef(
-    int index,
-    const Json::Value& root,
-    std::map<int, Json::Value>& memo,
-    std::set<int>& inProgress)
-{
-    if (!root.isArray() || index < 0 || index >= static_cast<int>(root.size())) {
-        return Json::Value(index);
-    }
-    auto it = memo.find(index);
-    if (it != memo.end()) return it->second;
-    if (inProgress.count(index)) return Json::Value();
-    inProgress.insert(index);
-    Json::Value resolved = decodeNexosSerializedInline(root[index], root, memo, inProgress);
-    inProgress.erase(index);
-    memo[index] = resolved;
-    return resolved;
-}
-
-std::string extractNexosEmailFromChatData(const Json::Value& chatData) {
-    if (!chatData.isArray() || chatData.empty()) {
-        return "";
-    }
-    std::map<int, Json::Value> memo;
-    std::set<int> inProgress;
-    const Json::Value decoded = decodeNexosSerializedRef(0, chatData, memo, inProgress);
-    const auto& user = decoded["domains/auth/routes/LoggedInLayout"]["data"]["user"];
-    if (user.isObject() && user.isMember("email") && user["email"].isString()) {
-        return user["email"].asString();
-    }
-    return "";
+std::string extractNexosEmailFromChatData(const NexosSerializedData& chatData) {
+    const Json::Value email = chatData.get({"domains/auth/routes/LoggedInLayout", "data", "user", "email"});
+    return email.isString() ? email.asString() : "";
 }
 
 }
@@ -620,7 +537,7 @@ void AccountManager::normalizeNexosAccountsInDatabase()
             continue;
         }
 
-        const Json::Value chatData = fetchNexosChatDataByCookie(normalizedToken);
+        const auto chatData = fetchNexosChatDataByCookie(normalizedToken);
         const std::string email = extractNexosEmailFromChatData(chatData);
         if (email.empty() || email == account.userName) {
             continue;
@@ -644,7 +561,7 @@ void AccountManager::normalizeNexosAccountsInDatabase()
  
 void AccountManager::loadAccount()
 {
-    accountPoolMap.clear();
+    accountPool_.clear();
     LOG_INFO << "[账户管理] 加载账户开始";
     // 旧设计备注：可从配置文件加载账号，当前优先从数据库加载
     if(accountDbManager->isTableExist())
@@ -656,9 +573,9 @@ void AccountManager::loadAccount()
         loadAccountFromConfig();
     }
 
-    for(auto& apiName : accountPoolMap)
+    for(const auto& apiName : accountPool_.apiNames())
     {
-        LOG_INFO << "[账户管理] API名称: " << apiName.first << ", 账户队列大小: " << apiName.second->size();
+        LOG_INFO << "[账户管理] API名称: " << apiName << ", 账户队列大小: " << accountPool_.size(apiName);
 
     }
     LOG_INFO << "[账户管理] 加载账户完成";
@@ -705,11 +622,7 @@ void AccountManager::addAccount(string apiName,string userName,string passwd,str
 
     // 只有 active 状态的账号才加入账号池
     if (status == AccountStatus::ACTIVE) {
-        if(accountPoolMap[apiName] == nullptr)
-        {
-            accountPoolMap[apiName] = make_shared<priority_queue<shared_ptr<Accountinfo_st>,vector<shared_ptr<Accountinfo_st>>,AccountCompare>>();
-        }
-        accountPoolMap[apiName]->push(account);
+        accountPool_.put(account);
     } else {
         LOG_INFO << "[账户管理] 账号 " << userName << " 状态为 " << status << ", 不加入账号池";
     }
@@ -727,11 +640,7 @@ bool AccountManager::addAccountbyPost(Accountinfo_st accountinfo)
     
     // 只有 active 状态的账号才加入账号池
     if (accountinfo.status == AccountStatus::ACTIVE) {
-        if(accountPoolMap[accountinfo.apiName] == nullptr)
-        {
-            accountPoolMap[accountinfo.apiName] = make_shared<priority_queue<shared_ptr<Accountinfo_st>,vector<shared_ptr<Accountinfo_st>>,AccountCompare>>();
-        }
-        accountPoolMap[accountinfo.apiName]->push(account);
+        accountPool_.put(account);
     } else {
         LOG_INFO << "[账户管理] 账号 " << accountinfo.userName << " 状态为 " << accountinfo.status << ", 不加入账号池";
     }
@@ -746,15 +655,18 @@ bool AccountManager::updateAccount(Accountinfo_st accountinfo)
         return false;
     }
     auto account = accountList[accountinfo.apiName][accountinfo.userName];
-    account->passwd = accountinfo.passwd;
-    account->authToken = accountinfo.authToken;
-    account->useCount = accountinfo.useCount;
-    account->tokenStatus = accountinfo.tokenStatus;
-    account->accountStatus = accountinfo.accountStatus;
-    account->userTobitId = accountinfo.userTobitId;
-    account->personId = accountinfo.personId;
-    account->accountType = accountinfo.accountType;
-    account->status = accountinfo.status;
+    accountPool_.update(account, [&accountinfo](Accountinfo_st& info) {
+        info.passwd = accountinfo.passwd;
+        info.authToken = accountinfo.authToken;
+        info.useCount = accountinfo.useCount;
+        info.tokenStatus = accountinfo.tokenStatus;
+        info.accountStatus = accountinfo.accountStatus;
+        info.userTobitId = accountinfo.userTobitId;
+        info.personId = accountinfo.personId;
+        info.accountType = accountinfo.accountType;
+        info.status = accountinfo.status;
+    });
+    syncAccountPool(account);
     return true;
 }
 bool AccountManager::deleteAccountbyPost(string apiName,string userName)
@@ -762,79 +674,43 @@ bool AccountManager::deleteAccountbyPost(string apiName,string userName)
     std::lock_guard<std::mutex> lock(accountListMutex);
     if(accountList.find(apiName) != accountList.end() && accountList[apiName].find(userName) != accountList[apiName].end())
     {
-        accountList[apiName][userName]->tokenStatus = false;
-        accountList[apiName][userName]->accountStatus = false;
+        accountPool_.update(accountList[apiName][userName], [](Accountinfo_st& info) {
+            info.tokenStatus = false;
+            info.accountStatus = false;
+        });
         accountList[apiName].erase(userName);
-
-        if (accountList[apiName].empty()) {
-            accountPoolMap.erase(apiName);
-        } else {
-            auto rebuiltQueue = std::make_shared<priority_queue<shared_ptr<Accountinfo_st>,vector<shared_ptr<Accountinfo_st>>,AccountCompare>>();
-            for (const auto& [_, account] : accountList[apiName]) {
-                if (!account || account->status != AccountStatus::ACTIVE || shouldExcludeFromPoolOnLoad(account)) {
-                    continue;
-                }
-                rebuiltQueue->push(account);
-            }
-            accountPoolMap[apiName] = rebuiltQueue;
-        }
+        accountPool_.remove(apiName, userName);
+        AccountHealthTracker::getInstance().forget(apiName, userName);
         return true;
     }
     return false;
 }
 void AccountManager::getAccount(string apiName,shared_ptr<Accountinfo_st>& account, string accountType)
 {
-    std::lock_guard<std::mutex> lock(accountListMutex);
-    if(accountPoolMap.find(apiName) == accountPoolMap.end() || accountPoolMap[apiName] == nullptr || accountPoolMap[apiName]->empty())
+    // 取号只锁对应渠道的子池，不占用 accountListMutex
+    if (accountPool_.size(apiName) == 0)
     {
         LOG_ERROR << "[账户管理] 账户池 [" << apiName << "] 为空或未找到";
         return;
     }
 
-    if (accountType.empty()) {
-        account = accountPoolMap[apiName]->top();
-        accountPoolMap[apiName]->pop();
-        if(account->tokenStatus)
-        {
-            account->useCount++;
-            LOG_INFO << "[账户管理] 使用次数已增加: " << account->userName << ", 新值: " << account->useCount;
-            if (accountList.find(apiName) != accountList.end() &&
-                accountList[apiName].find(account->userName) != accountList[apiName].end()) {
-                LOG_INFO << "[账户管理] 账户列表已更新: " << accountList[apiName][account->userName]->userName << ", 新值: " << accountList[apiName][account->userName]->useCount;
-            }
-        }
-        accountPoolMap[apiName]->push(account);
-    } else {
-        vector<shared_ptr<Accountinfo_st>> tempAccounts;
-        bool found = false;
-        
-        while(!accountPoolMap[apiName]->empty()) {
-            auto currentAccount = accountPoolMap[apiName]->top();
-            accountPoolMap[apiName]->pop();
-            
-            if (currentAccount->accountType == accountType) {
-                account = currentAccount;
-                found = true;
-                if(account->tokenStatus)
-                {
-                    account->useCount++;
-                    LOG_INFO << "[账户管理] 使用次数已增加: " << account->userName << " (" << accountType << "), 新值: " << account->useCount;
-                }
-                accountPoolMap[apiName]->push(account);
-                break;
-            }
-            tempAccounts.push_back(currentAccount);
-        }
-        
-        for(const auto& acc : tempAccounts) {
-            accountPoolMap[apiName]->push(acc);
-        }
-        
-        if (!found) {
-            LOG_ERROR << "[账户管理] 未找到类型为 " << accountType << " 的账户, API: " << apiName;
-        }
+    auto picked = accountPool_.acquire(apiName, accountType);
+    if (!picked) {
+        LOG_ERROR << "[账户管理] 未找到类型为 " << accountType << " 的账户, API: " << apiName;
+        return;
+    }
+
+    account = picked;
+    if (account->tokenStatus) {
+        LOG_INFO << "[账户管理] 使用次数已增加: " << account->userName
+                 << (accountType.empty() ? "" : " (" + accountType + ")") << ", 新值: " << account->useCount;
     }
 }
+void AccountManager::mutateAccount(const shared_ptr<Accountinfo_st>& account,
+                                   const std::function<void(Accountinfo_st&)>& mutator)
+{
+    accountPool_.update(account, mutator);
+}
 void AccountManager::getAccountByUserName(string apiName, string userName, shared_ptr<Accountinfo_st>& account)
 {
     std::lock_guard<std::mutex> lock(accountListMutex);
@@ -842,7 +718,7 @@ void AccountManager::getAccountByUserName(string apiName, string userName, share
         accountList[apiName].find(userName) != accountList[apiName].end()) {
         account = accountList[apiName][userName];
         if (account && account->tokenStatus) {
-            account->useCount++;
+            accountPool_.recordUse(account);
             LOG_INFO << "[账户管理] 按用户名获取账户: 使用次数已增加 " << account->userName << ", 新值: " << account->useCount;
         }
     } else {
@@ -850,6 +726,57 @@ void AccountManager::getAccountByUserName(string apiName, string userName, share
         account = nullptr;
     }
 }
+void AccountManager::reportAccountResult(const string& apiName, const string& userName, double latencyMs, bool success)
+{
+    if (userName.empty()) {
+        return;
+    }
+    if (success) {
+        AccountThrottle::getInstance().noteSuccess(apiName, userName);
+    }
+    auto& health = AccountHealthTracker::getInstance();
+    if (health.record(apiName, userName, latencyMs, success)) {
+        const auto stats = health.get(apiName, userName);
+        LOG_WARN << "[账户管理] 账号熔断: " << apiName << "/" << userName
+                 << ", 错误率EWMA=" << stats.errorRateEwma
+                 << ", 连续失败=" << stats.consecutiveFailures
+                 << ", 熔断秒数=" << stats.openRemainingSeconds;
+    }
+}
+bool AccountManager::isAccountCircuitOpen(const string& apiName, const string& userName) const
+{
+    return AccountHealthTracker::getInstance().isOpen(apiName, userName);
+}
+AccountHealthTracker::Probe AccountManager::beginAccountProbe(const string& apiName, const string& userName)
+{
+    return AccountHealthTracker::getInstance().beginProbe(apiName, userName);
+}
+AccountThrottle::Lease AccountManager::acquireAccount(const string& apiName, shared_ptr<Accountinfo_st>& account, const string& accountType,
+                                                      bool* throttled)
+{
+    if (throttled) {
+        *throttled = false;
+    }
+    // 账号池已把冷却/在途已满的账号排在最后；并发取到同一账号导致占用失败时换号重试
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        shared_ptr<Accountinfo_st> picked;
+        getAccount(apiName, picked, accountType);
+        if (!picked) {
+            break;
+        }
+        auto lease = AccountThrottle::getInstance().tryBegin(apiName, picked->userName);
+        if (lease) {
+            account = picked;
+            return lease;
+        }
+        LOG_WARN << "[账户管理] 账号冷却中或在途请求已满: " << apiName << "/" << picked->userName;
+        if (throttled) {
+            *throttled = true;
+        }
+    }
+    account = nullptr;
+    return AccountThrottle::Lease();
+}
 void AccountManager::checkAccount()
 {
     LOG_INFO << "[账户管理] 检查账户开始";
@@ -859,20 +786,30 @@ void AccountManager::checkAccount()
 }   
 void AccountManager::refreshAccountQueue(string apiName)
 {
-    shared_ptr<Accountinfo_st> account = accountPoolMap[apiName]->top();
-    accountPoolMap[apiName]->pop();
-    accountPoolMap[apiName]->push(account);
+    // 刷新 token 后账号类型可能变化，按当前 accountType 重新归类
+    accountPool_.reindex(apiName);
+}
+
+void AccountManager::syncAccountPool(const shared_ptr<Accountinfo_st>& account)
+{
+    if (!account) {
+        return;
+    }
+    if (account->status == AccountStatus::ACTIVE && !shouldExcludeFromPoolOnLoad(account)) {
+        accountPool_.put(account);
+    } else {
+        accountPool_.remove(account->apiName, account->userName);
+    }
 }
 void AccountManager::printAccountPoolMap()
 {
     LOG_INFO << "[账户管理] 打印账户池映射开始";
-    for(auto& apiName : accountPoolMap)
+    for(const auto& apiName : accountPool_.apiNames())
     {
-        LOG_INFO << "[账户管理] API名称: " << apiName.first << ", 账户队列大小: " << apiName.second->size();
-        auto tempQueue = *apiName.second;
-       while(!tempQueue.empty())
+        const auto accounts = accountPool_.snapshot(apiName);
+        LOG_INFO << "[账户管理] API名称: " << apiName << ", 账户队列大小: " << accounts.size();
+       for(const auto& account : accounts)
        {
-            auto account = tempQueue.top();
             LOG_INFO << "[账户管理] 用户名: " << account->userName;
             LOG_INFO << "[账户管理] 密码: " << account->passwd;
             LOG_INFO << "[账户管理] Token状态: " << account->tokenStatus;
@@ -881,7 +818,6 @@ void AccountManager::printAccountPoolMap()
             LOG_INFO << "[账户管理] 使用次数: " << account->useCount;
             LOG_INFO << "[账户管理] 认证Token: " << account->authToken;
             LOG_INFO << "[账户管理] --------------------------------"; 
-            tempQueue.pop();
        }
     }
     LOG_INFO << "[账户管理] 打印账户池映射完成";
@@ -941,16 +877,19 @@ void AccountManager::updateNexosToken(shared_ptr<Accountinfo_st> accountinfo)
     LOG_INFO << "[账户管理] 开始更新 Nexos 登录态，用户: " << accountinfo->userName;
 
     // 1. 先规范化 authToken 为 cookie header
-    accountinfo->authToken = extractNexosCookieHeader(accountinfo->authToken);
+    const string cookieHeader = extractNexosCookieHeader(accountinfo->authToken);
+    mutateAccount(accountinfo, [&cookieHeader](Accountinfo_st& info) { info.authToken = cookieHeader; });
 
     // 2. 先检查现有 cookie 是否仍然有效；有效则直接保留，不重复登录
-    if (!accountinfo->authToken.empty() && checkNexosToken(accountinfo->authToken)) {
+    if (!cookieHeader.empty() && checkNexosToken(cookieHeader)) {
         LOG_INFO << "[账户管理] Nexos cookie 仍然有效，跳过重新登录: " << accountinfo->userName;
-        accountinfo->tokenStatus = true;
-        accountinfo->accountStatus = true;
-        if (accountinfo->accountType.empty()) {
-            accountinfo->accountType = "pro";
-        }
+        mutateAccount(accountinfo, [](Accountinfo_st& info) {
+            info.tokenStatus = true;
+            info.accountStatus = true;
+            if (info.accountType.empty()) {
+                info.accountType = "pro";
+            }
+        });
         return;
     }
 
@@ -961,21 +900,25 @@ void AccountManager::updateNexosToken(shared_ptr<Accountinfo_st> accountinfo)
         auto token = getNexosToken(accountinfo->userName, accountinfo->passwd);
         LOG_INFO << "[账户管理] Nexos 账号密码重新登录结果: " << (token.empty() ? "empty" : "not empty");
         if (!token.empty()) {
-            accountinfo->tokenStatus = true;
-            accountinfo->authToken = token["token"].asString();
-            accountinfo->accountStatus = true;
-            accountinfo->useCount = 0;
-            accountinfo->userTobitId = token["userid"].asInt();
-            accountinfo->personId = token["personid"].asString();
-            accountinfo->accountType = "pro";
+            mutateAccount(accountinfo, [&token](Accountinfo_st& info) {
+                info.tokenStatus = true;
+                info.authToken = token["token"].asString();
+                info.accountStatus = true;
+                info.useCount = 0;
+                info.userTobitId = token["userid"].asInt();
+                info.personId = token["personid"].asString();
+                info.accountType = "pro";
+            });
             return;
         }
     }
 
     // 4. cookie 无效且无法通过账号密码重新登录，则标记失效
     LOG_WARN << "[账户管理] Nexos 登录态刷新失败，账号将标记为失效: " << accountinfo->userName;
-    accountinfo->tokenStatus = false;
-    accountinfo->accountStatus = false;
+    mutateAccount(accountinfo, [](Accountinfo_st& info) {
+        info.tokenStatus = false;
+        info.accountStatus = false;
+    });
 }
 
 Json::Value AccountManager::getChaynsToken(string username,string passwd)
@@ -1242,18 +1185,20 @@ void AccountManager::updateChaynsToken(shared_ptr<Accountinfo_st> accountinfo)
     LOG_INFO << "[账户管理] Chayns 令牌更新结果: " << (token.empty()?"empty":"not empty");
     if(!token.empty())
     {
-                accountinfo->tokenStatus = true;
-                accountinfo->authToken = token["token"].asString();
-                accountinfo->accountStatus = true;
-                accountinfo->useCount = 0;
-                accountinfo->userTobitId = token["userid"].asInt();
-                accountinfo->personId = token["personid"].asString();
                 bool hasProAccess = false;
                 if (token.isMember("has_pro_access") && token["has_pro_access"].asBool()) {
                     hasProAccess = true;
                 }
-                string accountType = hasProAccess ? "pro" : "free";
-                accountinfo->accountType=accountType;
+                const string accountType = hasProAccess ? "pro" : "free";
+                mutateAccount(accountinfo, [&token, &accountType](Accountinfo_st& info) {
+                    info.tokenStatus = true;
+                    info.authToken = token["token"].asString();
+                    info.accountStatus = true;
+                    info.useCount = 0;
+                    info.userTobitId = token["userid"].asInt();
+                    info.personId = token["personid"].asString();
+                    info.accountType = accountType;
+                });
     }
     LOG_INFO << "[账户管理] Chayns 令牌更新流程结束";
 }
@@ -1360,7 +1305,7 @@ void AccountManager::setStatusAccountStatus(string apiName,string userName,bool
     std::lock_guard<std::mutex> lock(accountListMutex);
     if(accountList.find(apiName) != accountList.end() && accountList[apiName].find(userName) != accountList[apiName].end())
     {
-        accountList[apiName][userName]->accountStatus = status;
+        accountPool_.update(accountList[apiName][userName], [status](Accountinfo_st& info) { info.accountStatus = status; });
     }
 }
 void AccountManager::setStatusTokenStatus(string apiName,string userName,bool status)
@@ -1368,7 +1313,7 @@ void AccountManager::setStatusTokenStatus(string apiName,string userName,bool st
     std::lock_guard<std::mutex> lock(accountListMutex);
     if(accountList.find(apiName) != accountList.end() && accountList[apiName].find(userName) != accountList[apiName].end())
     {
-        accountList[apiName][userName]->tokenStatus = status;
+        accountPool_.update(accountList[apiName][userName], [status](Accountinfo_st& info) { info.tokenStatus = status; });
         if(!status && !shouldSkipLifecycleRefresh(accountList[apiName][userName]))
             {
                 std::lock_guard<std::mutex> lock2(accountListNeedUpdateMutex);
@@ -2104,7 +2049,8 @@ void AccountManager::updateAccountType(shared_ptr<Accountinfo_st> account)
     if (account->accountType != newAccountType) {
         LOG_INFO << "[账户管理] 账号类型发生变化，用户: " << account->userName
                  << ": " << account->accountType << " -> " << newAccountType;
-        account->accountType = newAccountType;
+        mutateAccount(account, [&newAccountType](Accountinfo_st& info) { info.accountType = newAccountType; });
+        syncAccountPool(account);
         
         // 更新数据库
         if (accountDbManager->updateAccount(*account)) {
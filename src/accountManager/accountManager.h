@@ -8,97 +8,14 @@
 #include <list>
 #include <set>
 #include <APIinterface.h>
+#include "AccountInfo.h"
+#include "AccountPool.h"
+#include "AccountHealth.h"
+#include "AccountThrottle.h"
 #include <../dbManager/account/accountDbManager.h>
 using namespace std;
 using namespace drogon;
 class AccountDbManager;
-// 账号状态常量
-namespace AccountStatus {
-    const string WAITING = "waiting";       // 待注册（已创建占位记录）
-    const string REGISTERING = "registering"; // 注册中（HTTP请求已发送）
-    const string ACTIVE = "active";         // 正常激活
-    const string DISABLED = "disabled";     // 已禁用
-}
-
-struct Accountinfo_st
-{
-    string apiName;
-    string userName;
-    string passwd;
-    string authToken;
-    int useCount;
-    bool tokenStatus=false;
-    bool accountStatus=false;
-    int userTobitId;
-    string personId;
-    string createTime;
-    string accountType;  // 账号类型: "pro" 或 "free"
-    string status;       // 账号状态: "pending", "active", "disabled"
-
-    Accountinfo_st(){}
-    Accountinfo_st(string apiName,string userName,string passwd,string authToken,int useCount,bool tokenStatus,bool accountStatus,int userTobitId,string personId,string createTime="",string accountType="free",string status="active")
-    {
-        this->apiName = apiName;
-        this->userName = userName;
-        this->passwd = passwd;
-        this->authToken = authToken;
-        this->useCount = useCount;
-        this->tokenStatus = tokenStatus;
-        this->accountStatus = accountStatus;
-        this->userTobitId = userTobitId;
-        this->personId = personId;
-        this->createTime = createTime;
-        this->accountType = accountType;
-        this->status = status;
-    }
-
-    // 将请求/数据库中的 JSON 字段解析为统一账号结构（仅保留 camelCase 新命名）。
-    static Accountinfo_st fromJson(const Json::Value& value)
-    {
-        Accountinfo_st result;
-        result.apiName = value.get("apiName", "").asString();
-        result.userName = value.get("userName", "").asString();
-        result.passwd = value.get("password", "").asString();
-        result.authToken = value.get("authToken", "").asString();
-        result.useCount = value.get("useCount", 0).asInt();
-        result.tokenStatus = value.get("tokenStatus", false).asBool();
-        result.accountStatus = value.get("accountStatus", false).asBool();
-        result.userTobitId = value.get("userTobitId", 0).asInt();
-        result.personId = value.get("personId", "").asString();
-        result.createTime = value.get("createTime", "").asString();
-        result.accountType = value.get("accountType", "free").asString();
-        result.status = value.get("status", "active").asString();
-        return result;
-    }
-
-    // 将账号结构导出为统一 JSON（仅保留 camelCase 新命名）。
-    Json::Value toJson() const
-    {
-        Json::Value value;
-        value["apiName"] = apiName;
-        value["userName"] = userName;
-        value["password"] = passwd;
-        value["authToken"] = authToken;
-        value["useCount"] = useCount;
-        value["tokenStatus"] = tokenStatus;
-        value["accountStatus"] = accountStatus;
-        value["userTobitId"] = userTobitId;
-        value["personId"] = personId;
-        value["createTime"] = createTime;
-        value["accountType"] = accountType;
-        value["status"] = status;
-        return value;
-    }
-};
-
-struct AccountCompare
-{
-    bool operator()(const shared_ptr<Accountinfo_st>& a, const shared_ptr<Accountinfo_st>& b)
-    {
-        if(a->tokenStatus!=b->tokenStatus)return b->tokenStatus;
-        return a->useCount > b->useCount;
-    }
-};
 
 struct AccountAutomationSettings
 {
@@ -112,7 +29,7 @@ class AccountManager
 {
     private:
    // 旧单例写法保留：当前已改为函数内静态对象
-    map<string,shared_ptr<priority_queue<shared_ptr<Accountinfo_st>,vector<shared_ptr<Accountinfo_st>>,AccountCompare>>> accountPoolMap;
+    AccountPool accountPool_;  // 可调度账号池：按 (apiName, accountType) 索引，自带分片锁
     map<string,map<string,shared_ptr<Accountinfo_st>>> accountList;// 二级索引结构：apiName -> userName -> accountInfo
     mutable std::mutex accountListMutex;  // 保护 accountList 的互斥锁
     std::set<int> registeringAccountIds_;     // 正在注册中的账号ID集合
@@ -123,6 +40,7 @@ class AccountManager
     AccountAutomationSettings accountAutomationSettings_;
     mutable std::mutex accountAutomationSettingsMutex_;
     void normalizeNexosAccountsInDatabase();
+    void syncAccountPool(const shared_ptr<Accountinfo_st>& account);  // 按当前状态/类型同步账号在池中的归属
      // 
     map<string, void (AccountManager::*)(shared_ptr<Accountinfo_st>)> updateTokenMap = {
         {"chaynsapi", &AccountManager::updateChaynsToken},
@@ -154,8 +72,20 @@ class AccountManager
     bool addAccountbyPost(Accountinfo_st accountinfo);
     bool updateAccount(Accountinfo_st accountinfo);
     bool deleteAccountbyPost(string apiName,string userName);
+    // 修改取号会读取的账号字段（tokenStatus / accountType / useCount / status 等）必须经此在账号池锁内进行
+    void mutateAccount(const shared_ptr<Accountinfo_st>& account, const std::function<void(Accountinfo_st&)>& mutator);
     void getAccount(string apiName,shared_ptr<Accountinfo_st>& account, string accountType = "");
     void getAccountByUserName(string apiName, string userName, shared_ptr<Accountinfo_st>& account);
+    // 上报一次上游调用的耗时与成败，供调度加权与熔断使用
+    void reportAccountResult(const string& apiName, const string& userName, double latencyMs, bool success);
+    bool isAccountCircuitOpen(const string& apiName, const string& userName) const;
+    // 已占用账号、即将发出调用：账号半开时本次调用成为唯一的探测；
+    // 返回的 Probe 需持有到 reportAccountResult() 之后，提前析构会归还探测名额
+    AccountHealthTracker::Probe beginAccountProbe(const string& apiName, const string& userName);
+    // 取号并占用该账号的一个在途名额（lease 析构时释放）；账号均在冷却或在途已满时 account 置空，
+    // 并在 throttled 非空时置为 true（区别于池中无账号）
+    AccountThrottle::Lease acquireAccount(const string& apiName, shared_ptr<Accountinfo_st>& account, const string& accountType = "",
+                                          bool* throttled = nullptr);
     void checkAccount();
     void checkToken();
     void updateToken();
@@ -4,6 +4,7 @@
 #include <map>
 #include "sessionManager/core/Session.h"
 #include "ProviderResult.h"
+#include "ProviderContextStore.h"
 
 using std::map;
 using std::string;
@@ -32,10 +33,28 @@ class APIinterface
     virtual Json::Value getModels() = 0;
     virtual void init() = 0;
     virtual void afterResponseProcess(session_st& session) = 0;
-    virtual void eraseChatinfoMap(std::string ConversationId) = 0;
-    virtual void transferThreadContext(const std::string& oldId, const std::string& newId) = 0;
+    /// 会话过期时删除该会话在本 provider 下的上游上下文
+    virtual void eraseChatinfoMap(std::string ConversationId)
+    {
+        const auto ns = contextNamespace();
+        if (!ns.empty()) {
+            ProviderContextStore::getInstance().erase(ns, ConversationId);
+        }
+    }
+    /// 会话 id 变化（续聊生成新 id）时，将上游上下文转移到新 id 下
+    virtual void transferThreadContext(const std::string& oldId, const std::string& newId)
+    {
+        const auto ns = contextNamespace();
+        if (!ns.empty()) {
+            ProviderContextStore::getInstance().transfer(ns, oldId, newId);
+        }
+    }
     
     map<string,modelInfo> ModelInfoMap;
+
+    protected:
+    /// 本 provider 在 ProviderContextStore 中的命名空间；为空表示不保存上游上下文
+    virtual std::string contextNamespace() const { return ""; }
 };
 
 #endif
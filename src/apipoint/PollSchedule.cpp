@@ -0,0 +1,117 @@
+#include "PollSchedule.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kFirstBoundMs = 100.0;
+constexpr double kGrowth = 1.25;
+
+std::string statsKey(const std::string& provider, const std::string& model) {
+    return provider + "|" + model;
+}
+
+} // 匿名命名空间
+
+CompletionTimeStats& CompletionTimeStats::getInstance() {
+    static CompletionTimeStats instance;
+    return instance;
+}
+
+size_t CompletionTimeStats::bucketOf(Millis elapsed) {
+    const double ms = static_cast<double>(elapsed.count());
+    if (ms <= kFirstBoundMs) {
+        return 0;
+    }
+    const auto bucket = static_cast<size_t>(std::ceil(std::log(ms / kFirstBoundMs) / std::log(kGrowth)));
+    return std::min(bucket, kBuckets - 1);
+}
+
+CompletionTimeStats::Millis CompletionTimeStats::upperBoundOf(size_t bucket) {
+    return Millis(static_cast<Millis::rep>(kFirstBoundMs * std::pow(kGrowth, static_cast<double>(bucket))));
+}
+
+void CompletionTimeStats::record(const std::string& provider, const std::string& model, Millis elapsed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& histogram = histograms_[statsKey(provider, model)];
+    for (auto& count : histogram.counts) {
+        count *= kDecay;
+    }
+    histogram.counts[bucketOf(elapsed)] += 1.0;
+    histogram.total = histogram.total * kDecay + 1.0;
+}
+
+void CompletionTimeStats::record(const std::string& provider, const std::string& model, Millis lastMiss,
+                                 Millis detected) {
+    lastMiss = std::min(lastMiss, detected);
+    record(provider, model, lastMiss + (detected - lastMiss) / 2);
+}
+
+std::optional<CompletionTimeStats::Quantiles> CompletionTimeStats::quantiles(const std::string& provider,
+                                                                             const std::string& model) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = histograms_.find(statsKey(provider, model));
+    if (it == histograms_.end() || it->second.total < kMinSamples) {
+        return std::nullopt;
+    }
+    const auto& histogram = it->second;
+    auto quantileOf = [&histogram](double q) {
+        const double target = histogram.total * q;
+        double cumulative = 0.0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            const double count = histogram.counts[i];
+            if (count > 0.0 && cumulative + count >= target) {
+                // 桶内线性插值，直接取桶上界会让分位数整体偏大最多 25%
+                const double lower = i == 0 ? 0.0 : static_cast<double>(upperBoundOf(i - 1).count());
+                const double upper = static_cast<double>(upperBoundOf(i).count());
+                const double fraction = std::max(0.0, target - cumulative) / count;
+                return Millis(static_cast<Millis::rep>(lower + (upper - lower) * fraction));
+            }
+            cumulative += count;
+        }
+        return upperBoundOf(kBuckets - 1);
+    };
+    return Quantiles{quantileOf(0.1), quantileOf(0.5), quantileOf(0.9), histogram.total};
+}
+
+PollSchedule::PollSchedule(const Bounds& bounds, std::optional<CompletionTimeStats::Quantiles> quantiles)
+    : bounds_(bounds), quantiles_(quantiles) {
+    bounds_.maxInterval = std::max(bounds_.maxInterval, bounds_.minInterval);
+}
+
+PollSchedule PollSchedule::forModel(const std::string& provider, const std::string& model, const Bounds& bounds) {
+    return PollSchedule(bounds, CompletionTimeStats::getInstance().quantiles(provider, model));
+}
+
+PollSchedule::Millis PollSchedule::clamp(Millis delay) const {
+    return std::min(std::max(delay, bounds_.minInterval), bounds_.maxInterval);
+}
+
+PollSchedule::Millis PollSchedule::sparseCap() const {
+    if (quantiles_ && quantiles_->samples >= kTrustedSamples) {
+        return bounds_.maxInterval;
+    }
+    return std::min(bounds_.fallbackInterval, bounds_.maxInterval);
+}
+
+PollSchedule::Millis PollSchedule::initialDelay() const {
+    if (!quantiles_) {
+        return Millis(0);
+    }
+    return std::min(quantiles_->p10 / 2, sparseCap());
+}
+
+PollSchedule::Millis PollSchedule::nextDelay(Millis elapsed) const {
+    if (!quantiles_) {
+        return clamp(bounds_.fallbackInterval);
+    }
+    const auto& q = *quantiles_;
+    if (elapsed < q.p10) {
+        return clamp(std::min(q.p10 - elapsed, sparseCap()));
+    }
+    if (elapsed < q.p90) {
+        return clamp((q.p90 - q.p10) / kDensePolls);
+    }
+    return clamp(elapsed / 4);
+}
@@ -0,0 +1,104 @@
+#ifndef POLL_SCHEDULE_H
+#define POLL_SCHEDULE_H
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief 按 (provider, 模型) 统计上游完成耗时的在线直方图 - 单例
+ *
+ * 桶边界按 1.25 倍几何增长（100ms 起），每记录一个样本先把已有计数按 kDecay 衰减，
+ * 近期样本权重更高，上游变快或变慢后分布随之移动。分位数在桶内线性插值。
+ *
+ * 轮询只能观察到"上一次未完成的查询 ~ 本次查到完成"这一区间，直接记录查到的时刻会系统性偏晚，
+ * 而调度又按这些分位数推迟查询，偏差会逐轮放大；因此按区间中点记录。
+ */
+class CompletionTimeStats {
+public:
+    using Millis = std::chrono::milliseconds;
+
+    struct Quantiles {
+        Millis p10{0};
+        Millis p50{0};
+        Millis p90{0};
+        /// 衰减后的有效样本数
+        double samples = 0.0;
+    };
+
+    static CompletionTimeStats& getInstance();
+
+    CompletionTimeStats() = default;
+    CompletionTimeStats(const CompletionTimeStats&) = delete;
+    CompletionTimeStats& operator=(const CompletionTimeStats&) = delete;
+
+    void record(const std::string& provider, const std::string& model, Millis elapsed);
+    /// 上次查询（lastMiss）时尚未完成、本次查询（detected）时已完成，按区间中点记录
+    void record(const std::string& provider, const std::string& model, Millis lastMiss, Millis detected);
+    /// 有效样本不足 kMinSamples 时返回 nullopt
+    std::optional<Quantiles> quantiles(const std::string& provider, const std::string& model) const;
+
+    static constexpr size_t kBuckets = 48;
+    static constexpr double kDecay = 0.98;
+    static constexpr double kMinSamples = 5.0;
+
+private:
+    struct Histogram {
+        std::array<double, kBuckets> counts{};
+        double total = 0.0;
+    };
+
+    static size_t bucketOf(Millis elapsed);
+    static Millis upperBoundOf(size_t bucket);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Histogram> histograms_;
+};
+
+/**
+ * @brief 单次轮询的等待间隔
+ *
+ * 有历史分布时：首次查询在 p10 / 2，保证 p10 之前至少查询一次，早于 p10 的完成也能被观察到；
+ * 之后稀疏地等到 p10，p10 ~ p90 之间按 (p90 - p10) / kDensePolls 密集查询，
+ * 超过 p90 后按已等待时长的 1/4 逐步放宽。有效样本不足 kTrustedSamples 时，
+ * p10 之前的间隔不超过 fallbackInterval（原固定间隔）。
+ * 所有间隔限制在 [minInterval, maxInterval]。没有足够样本时退回固定间隔 fallbackInterval。
+ */
+class PollSchedule {
+public:
+    using Millis = std::chrono::milliseconds;
+
+    struct Bounds {
+        Millis minInterval{100};
+        Millis maxInterval{2000};
+        Millis fallbackInterval{1000};
+    };
+
+    static constexpr int kDensePolls = 8;
+    static constexpr double kTrustedSamples = 20.0;
+
+    PollSchedule(const Bounds& bounds, std::optional<CompletionTimeStats::Quantiles> quantiles);
+
+    /// 按 provider/模型的历史分布生成
+    static PollSchedule forModel(const std::string& provider, const std::string& model, const Bounds& bounds);
+
+    /// 发出请求后首次查询前的等待，无历史分布时为 0（立即查询）
+    Millis initialDelay() const;
+    /// 已等待 elapsed 后，到下一次查询的等待
+    Millis nextDelay(Millis elapsed) const;
+
+    bool adaptive() const { return quantiles_.has_value(); }
+
+private:
+    Millis clamp(Millis delay) const;
+    /// p10 之前单次等待的上限
+    Millis sparseCap() const;
+
+    Bounds bounds_;
+    std::optional<CompletionTimeStats::Quantiles> quantiles_;
+};
+
+#endif
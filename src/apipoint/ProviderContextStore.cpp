@@ -0,0 +1,253 @@
+#include "ProviderContextStore.h"
+
+#include <algorithm>
+
+ProviderContextStore& ProviderContextStore::getInstance() {
+    static ProviderContextStore instance;
+    return instance;
+}
+
+ProviderContextStore::ProviderContextStore(size_t shardCount) {
+    shards_.reserve(std::max<size_t>(1, shardCount));
+    for (size_t i = 0; i < std::max<size_t>(1, shardCount); ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+std::string ProviderContextStore::storeKey(const std::string& ns, const std::string& key) {
+    std::string combined;
+    combined.reserve(ns.size() + 1 + key.size());
+    combined.append(ns).push_back('\x1f');
+    combined.append(key);
+    return combined;
+}
+
+int64_t ProviderContextStore::toSeconds(Clock::time_point now) {
+    return std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+}
+
+ProviderContextStore::Shard& ProviderContextStore::shardFor(const std::string& storeKey) const {
+    return *shards_[std::hash<std::string>{}(storeKey) % shards_.size()];
+}
+
+int64_t ProviderContextStore::expiryFrom(Clock::time_point now) const {
+    return toSeconds(now) + ttlSeconds_.load();
+}
+
+void ProviderContextStore::touchLocked(Entry& entry, Clock::time_point now) const {
+    entry.expiresAt = expiryFrom(now);
+    // 每次读取都写库代价太高，顺延足够多时才记为待写
+    if (entry.expiresAt - entry.persistedExpiresAt > ttlSeconds_.load() / 4) {
+        entry.dirty = true;
+    }
+}
+
+bool ProviderContextStore::liveAt(const Entry& entry, int64_t nowSeconds) {
+    return !entry.erased && entry.expiresAt > nowSeconds;
+}
+
+void ProviderContextStore::setTtl(std::chrono::seconds ttl) {
+    ttlSeconds_ = std::max<int64_t>(1, ttl.count());
+}
+
+std::chrono::seconds ProviderContextStore::ttl() const {
+    return std::chrono::seconds(ttlSeconds_.load());
+}
+
+std::optional<Json::Value> ProviderContextStore::get(const std::string& ns, const std::string& key, Clock::time_point now) {
+    const auto id = storeKey(ns, key);
+    auto& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(id);
+    if (it == shard.entries.end() || !liveAt(it->second, toSeconds(now))) {
+        return std::nullopt;
+    }
+    touchLocked(it->second, now);
+    return it->second.value;
+}
+
+void ProviderContextStore::put(const std::string& ns, const std::string& key, Json::Value value, Clock::time_point now) {
+    const auto id = storeKey(ns, key);
+    auto& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& entry = shard.entries[id];
+    entry.ns = ns;
+    entry.key = key;
+    entry.value = std::move(value);
+    entry.expiresAt = expiryFrom(now);
+    entry.erased = false;
+    entry.dirty = true;
+}
+
+bool ProviderContextStore::update(const std::string& ns, const std::string& key, const Mutator& mutate, Clock::time_point now) {
+    const auto id = storeKey(ns, key);
+    auto& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(id);
+    const bool live = it != shard.entries.end() && liveAt(it->second, toSeconds(now));
+    Json::Value value = live ? it->second.value : Json::Value(Json::objectValue);
+    if (!mutate(value)) {
+        return false;
+    }
+    auto& entry = shard.entries[id];
+    entry.ns = ns;
+    entry.key = key;
+    entry.value = std::move(value);
+    entry.expiresAt = expiryFrom(now);
+    entry.erased = false;
+    entry.dirty = true;
+    return true;
+}
+
+bool ProviderContextStore::erase(const std::string& ns, const std::string& key) {
+    const auto id = storeKey(ns, key);
+    auto& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(id);
+    if (it == shard.entries.end() || it->second.erased) {
+        return false;
+    }
+    // 保留删除标记直到写库，库中的行随之删除
+    it->second.value = Json::Value();
+    it->second.erased = true;
+    it->second.dirty = true;
+    return true;
+}
+
+bool ProviderContextStore::transfer(const std::string& ns, const std::string& oldKey, const std::string& newKey, Clock::time_point now) {
+    if (oldKey.empty() || newKey.empty() || oldKey == newKey) {
+        return false;
+    }
+    Json::Value value;
+    {
+        const auto id = storeKey(ns, oldKey);
+        auto& shard = shardFor(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(id);
+        if (it == shard.entries.end() || !liveAt(it->second, toSeconds(now))) {
+            return false;
+        }
+        value = std::move(it->second.value);
+        it->second.value = Json::Value();
+        it->second.erased = true;
+        it->second.dirty = true;
+    }
+    put(ns, newKey, std::move(value), now);
+    return true;
+}
+
+size_t ProviderContextStore::evictExpired(Clock::time_point now) {
+    const auto nowSeconds = toSeconds(now);
+    size_t evicted = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto it = shard->entries.begin(); it != shard->entries.end();) {
+            if (!it->second.erased && it->second.expiresAt <= nowSeconds) {
+                it = shard->entries.erase(it);
+                ++evicted;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return evicted;
+}
+
+size_t ProviderContextStore::load(const std::vector<Record>& records, Clock::time_point now) {
+    const auto nowSeconds = toSeconds(now);
+    size_t loaded = 0;
+    for (const auto& record : records) {
+        if (record.erased || record.expiresAt <= nowSeconds || !record.value.isObject()) {
+            continue;
+        }
+        const auto id = storeKey(record.ns, record.key);
+        auto& shard = shardFor(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.entries.count(id) > 0) {
+            continue;
+        }
+        Entry entry;
+        entry.ns = record.ns;
+        entry.key = record.key;
+        entry.value = record.value;
+        entry.expiresAt = record.expiresAt;
+        entry.persistedExpiresAt = record.expiresAt;
+        shard.entries.emplace(id, std::move(entry));
+        ++loaded;
+    }
+    return loaded;
+}
+
+size_t ProviderContextStore::flush(const Writer& writer) {
+    std::vector<Record> records;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto it = shard->entries.begin(); it != shard->entries.end();) {
+            auto& entry = it->second;
+            if (!entry.dirty) {
+                ++it;
+                continue;
+            }
+            records.push_back(Record{entry.ns, entry.key, entry.value, entry.expiresAt, entry.erased});
+            if (entry.erased) {
+                it = shard->entries.erase(it);
+                continue;
+            }
+            entry.dirty = false;
+            entry.persistedExpiresAt = entry.expiresAt;
+            ++it;
+        }
+    }
+    if (records.empty() || writer(records)) {
+        return records.size();
+    }
+
+    // 写库失败：仍在内存中的记录重新标记待写，已删除的重新放回删除标记
+    for (const auto& record : records) {
+        const auto id = storeKey(record.ns, record.key);
+        auto& shard = shardFor(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(id);
+        if (it != shard.entries.end()) {
+            it->second.dirty = true;
+            it->second.persistedExpiresAt = 0;
+        } else if (record.erased) {
+            Entry entry;
+            entry.ns = record.ns;
+            entry.key = record.key;
+            entry.erased = true;
+            entry.dirty = true;
+            shard.entries.emplace(id, std::move(entry));
+        }
+    }
+    return 0;
+}
+
+size_t ProviderContextStore::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += static_cast<size_t>(std::count_if(shard->entries.begin(), shard->entries.end(), [](const auto& item) {
+            return !item.second.erased;
+        }));
+    }
+    return total;
+}
+
+size_t ProviderContextStore::pendingSize() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += static_cast<size_t>(std::count_if(shard->entries.begin(), shard->entries.end(), [](const auto& item) {
+            return item.second.dirty;
+        }));
+    }
+    return total;
+}
+
+void ProviderContextStore::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+    }
+}
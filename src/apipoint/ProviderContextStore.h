@@ -0,0 +1,104 @@
+#ifndef PROVIDER_CONTEXT_STORE_H
+#define PROVIDER_CONTEXT_STORE_H
+
+#include <json/json.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief provider 上游会话上下文（线程 id、chat id、所用账号等）的公共存储 - 单例
+ *
+ * 按 (命名空间, 会话 id) 保存一个 JSON 对象，命名空间取 provider 名称。
+ * 条目按会话 id 哈希分片，各分片独立加锁；读取时顺延过期时间（滑动 TTL），
+ * 过期条目由定时任务调用 evictExpired() 回收。
+ *
+ * 写入、删除与明显的过期时间顺延只记为待写，由定时任务调用 flush() 批量写库（write-behind），
+ * 启动时以 load() 载入库中未过期的记录，重启后续聊仍可沿用原上游线程。
+ */
+class ProviderContextStore {
+public:
+    using Clock = std::chrono::system_clock;
+    /// 返回 false 表示不写回（如字段未变化）；记录不存在时参数为空对象
+    using Mutator = std::function<bool(Json::Value&)>;
+
+    struct Record {
+        std::string ns;
+        std::string key;
+        Json::Value value;
+        int64_t expiresAt = 0;  // Unix 秒
+        bool erased = false;    // 删除标记，写库时删除对应行
+    };
+    using Writer = std::function<bool(const std::vector<Record>&)>;
+
+    static ProviderContextStore& getInstance();
+
+    explicit ProviderContextStore(size_t shardCount = 16);
+
+    ProviderContextStore(const ProviderContextStore&) = delete;
+    ProviderContextStore& operator=(const ProviderContextStore&) = delete;
+
+    void setTtl(std::chrono::seconds ttl);
+    std::chrono::seconds ttl() const;
+
+    std::optional<Json::Value> get(const std::string& ns, const std::string& key, Clock::time_point now = Clock::now());
+    void put(const std::string& ns, const std::string& key, Json::Value value, Clock::time_point now = Clock::now());
+    /// 在分片锁内读改写，供只更新部分字段的场景使用；返回是否写回
+    bool update(const std::string& ns, const std::string& key, const Mutator& mutate, Clock::time_point now = Clock::now());
+    bool erase(const std::string& ns, const std::string& key);
+    /// 将 oldKey 的上下文移到 newKey（覆盖 newKey 原有内容）；oldKey 不存在时返回 false
+    bool transfer(const std::string& ns, const std::string& oldKey, const std::string& newKey, Clock::time_point now = Clock::now());
+
+    /// 回收已过期的条目（库中的过期行由写库端按 expiresAt 清理）
+    size_t evictExpired(Clock::time_point now = Clock::now());
+
+    /// 载入库中记录，已过期或已在内存中的跳过，不计入待写
+    size_t load(const std::vector<Record>& records, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief 将待写记录交给 writer 批量写库
+     *
+     * writer 返回 false 时记录放回待写，下次重试。
+     * @return 本次写入的记录数
+     */
+    size_t flush(const Writer& writer);
+
+    size_t size() const;
+    size_t pendingSize() const;
+    void clear();
+
+private:
+    struct Entry {
+        std::string ns;
+        std::string key;
+        Json::Value value;
+        int64_t expiresAt = 0;
+        int64_t persistedExpiresAt = 0;  // 库中记录的过期时间，顺延超过 TTL 的 1/4 才重新写库
+        bool erased = false;
+        bool dirty = false;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    static std::string storeKey(const std::string& ns, const std::string& key);
+    static int64_t toSeconds(Clock::time_point now);
+    Shard& shardFor(const std::string& storeKey) const;
+    int64_t expiryFrom(Clock::time_point now) const;
+    void touchLocked(Entry& entry, Clock::time_point now) const;
+    static bool liveAt(const Entry& entry, int64_t nowSeconds);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<int64_t> ttlSeconds_{86400};
+};
+
+#endif
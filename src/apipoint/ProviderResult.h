@@ -39,6 +39,7 @@ struct ProviderError {
     std::string message;        // 错误消息
     std::string providerCode;   // 上游 原始错误码
     int httpStatusCode = 0;     // HTTP 状态码（如果适用）
+    bool localRejection = false; // 本地限流（冷却/在途上限）拒绝，请求未到达上游
     
     bool hasError() const {
         return code != ProviderErrorCode::None;
@@ -60,6 +61,13 @@ struct ProviderError {
         return ProviderError{ProviderErrorCode::RateLimited, msg, "", 429};
     }
     
+    /// 本地 AccountThrottle 拒绝：对调用方表现为 429，但不计入渠道熔断
+    static ProviderError localThrottle(const std::string& msg) {
+        ProviderError error = rateLimited(msg);
+        error.localRejection = true;
+        return error;
+    }
+    
     static ProviderError timeout(const std::string& msg) {
         return ProviderError{ProviderErrorCode::Timeout, msg, "", 504};
     }
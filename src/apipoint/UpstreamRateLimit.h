@@ -0,0 +1,40 @@
+#ifndef UPSTREAM_RATE_LIMIT_H
+#define UPSTREAM_RATE_LIMIT_H
+
+#include <accountManager/AccountThrottle.h>
+#include <drogon/drogon.h>
+#include <ctime>
+#include <string>
+
+namespace provider {
+
+/**
+ * @brief 上游响应为 429 时按 Retry-After / 重置头冷却对应账号
+ *
+ * 依次读取 Retry-After、x-ratelimit-reset-requests（OpenAI）、x-ratelimit-reset、ratelimit-reset，
+ * 均缺失时由 AccountThrottle 按连续 429 次数退避。
+ *
+ * @return 响应是否为 429
+ */
+inline bool noteUpstreamRateLimit(const drogon::HttpResponsePtr& resp,
+                                  const std::string& providerName,
+                                  const std::string& account)
+{
+    if (!resp || resp->statusCode() != drogon::k429TooManyRequests || account.empty()) {
+        return false;
+    }
+    const double retryAfter = AccountThrottle::retryAfterFromHeaders(
+        {resp->getHeader("retry-after"),
+         resp->getHeader("x-ratelimit-reset-requests"),
+         resp->getHeader("x-ratelimit-reset"),
+         resp->getHeader("ratelimit-reset")},
+        std::time(nullptr));
+    const double cooldown = AccountThrottle::getInstance().noteRateLimited(providerName, account, retryAfter);
+    LOG_WARN << "[" << providerName << "] 上游限流(429)，账号进入冷却: " << account
+             << ", 冷却秒数=" << cooldown << (retryAfter >= 0 ? " (上游指定)" : " (退避)");
+    return true;
+}
+
+} // namespace provider
+
+#endif
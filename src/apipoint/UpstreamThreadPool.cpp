@@ -0,0 +1,147 @@
+#include "UpstreamThreadPool.h"
+
+#include <algorithm>
+#include <iterator>
+
+UpstreamThreadPool& UpstreamThreadPool::getInstance() {
+    static UpstreamThreadPool instance;
+    return instance;
+}
+
+void UpstreamThreadPool::setSettings(const Settings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    settings_.maxPerAccount = std::max(0, settings_.maxPerAccount);
+    settings_.maxIdleSeconds = std::max(1, settings_.maxIdleSeconds);
+    settings_.demandWindowSeconds = std::max(1, settings_.demandWindowSeconds);
+    settings_.refillIntervalSeconds = std::max(1, settings_.refillIntervalSeconds);
+    if (settings_.maxPerAccount == 0) {
+        slots_.clear();
+    }
+}
+
+UpstreamThreadPool::Settings UpstreamThreadPool::settings() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+bool UpstreamThreadPool::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_.maxPerAccount > 0;
+}
+
+size_t UpstreamThreadPool::freshCountLocked(const Slot& slot, Clock::time_point now) const {
+    const auto maxIdle = std::chrono::seconds(settings_.maxIdleSeconds);
+    return static_cast<size_t>(std::count_if(slot.ready.begin(), slot.ready.end(), [&](const auto& item) {
+        return now - item.second < maxIdle;
+    }));
+}
+
+size_t UpstreamThreadPool::demandCountLocked(const Slot& slot, Clock::time_point now) const {
+    const auto window = std::chrono::seconds(settings_.demandWindowSeconds);
+    return static_cast<size_t>(std::count_if(slot.demand.begin(), slot.demand.end(), [&](const auto& at) {
+        return now - at < window;
+    }));
+}
+
+std::optional<std::string> UpstreamThreadPool::claim(const std::string& provider, const std::string& account, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (settings_.maxPerAccount <= 0) {
+        return std::nullopt;
+    }
+    auto& slot = slots_[SlotKey(provider, account)];
+    slot.demand.push_back(now);
+
+    const auto maxIdle = std::chrono::seconds(settings_.maxIdleSeconds);
+    while (!slot.ready.empty()) {
+        auto item = std::move(slot.ready.front());
+        slot.ready.pop_front();
+        if (now - item.second < maxIdle) {
+            return std::move(item.first);
+        }
+    }
+    return std::nullopt;
+}
+
+void UpstreamThreadPool::add(const std::string& provider, const std::string& account, const std::string& id, Clock::time_point now) {
+    if (id.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (settings_.maxPerAccount <= 0) {
+        return;
+    }
+    auto& slot = slots_[SlotKey(provider, account)];
+    if (slot.ready.size() >= static_cast<size_t>(settings_.maxPerAccount)) {
+        return;
+    }
+    slot.ready.emplace_back(id, now);
+}
+
+int UpstreamThreadPool::deficit(const std::string& provider, const std::string& account, Clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (settings_.maxPerAccount <= 0) {
+        return 0;
+    }
+    auto it = slots_.find(SlotKey(provider, account));
+    if (it == slots_.end()) {
+        return 0;
+    }
+    const auto demand = demandCountLocked(it->second, now);
+    if (demand == 0) {
+        return 0;
+    }
+    // 一个补充周期内预计的新会话数（向上取整）再加 1 个余量
+    const auto perRefill = (demand * static_cast<size_t>(settings_.refillIntervalSeconds) +
+                            static_cast<size_t>(settings_.demandWindowSeconds) - 1) /
+                           static_cast<size_t>(settings_.demandWindowSeconds);
+    const auto target = std::min(static_cast<size_t>(settings_.maxPerAccount), perRefill + 1);
+    const auto ready = freshCountLocked(it->second, now);
+    return target > ready ? static_cast<int>(target - ready) : 0;
+}
+
+std::vector<std::string> UpstreamThreadPool::demandedAccounts(const std::string& provider, Clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> accounts;
+    for (auto it = slots_.lower_bound(SlotKey(provider, "")); it != slots_.end() && it->first.first == provider; ++it) {
+        if (demandCountLocked(it->second, now) > 0) {
+            accounts.push_back(it->first.second);
+        }
+    }
+    return accounts;
+}
+
+void UpstreamThreadPool::dropAccount(const std::string& provider, const std::string& account) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.erase(SlotKey(provider, account));
+}
+
+size_t UpstreamThreadPool::evictStale(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto maxIdle = std::chrono::seconds(settings_.maxIdleSeconds);
+    const auto window = std::chrono::seconds(settings_.demandWindowSeconds);
+    size_t evicted = 0;
+    for (auto it = slots_.begin(); it != slots_.end();) {
+        auto& slot = it->second;
+        while (!slot.ready.empty() && now - slot.ready.front().second >= maxIdle) {
+            slot.ready.pop_front();
+            ++evicted;
+        }
+        while (!slot.demand.empty() && now - slot.demand.front() >= window) {
+            slot.demand.pop_front();
+        }
+        it = slot.ready.empty() && slot.demand.empty() ? slots_.erase(it) : std::next(it);
+    }
+    return evicted;
+}
+
+size_t UpstreamThreadPool::readyCount(const std::string& provider, const std::string& account) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = slots_.find(SlotKey(provider, account));
+    return it == slots_.end() ? 0 : it->second.ready.size();
+}
+
+void UpstreamThreadPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.clear();
+}
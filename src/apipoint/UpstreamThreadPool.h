@@ -0,0 +1,76 @@
+#ifndef UPSTREAM_THREAD_POOL_H
+#define UPSTREAM_THREAD_POOL_H
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 按 (provider, 账号) 预建的空上游线程 / chat 池 - 单例
+ *
+ * 新会话首轮需要上游线程时先 claim()：池中有预建的直接取出（先建先用），否则由调用方现建。
+ * 每次 claim 都记为一次需求；后台补充任务按各账号最近窗口内的需求折算补充数量，
+ * 没有需求的账号不预建。预建后长时间未被领取的条目按 maxIdleSeconds 丢弃。
+ *
+ * 账号键由 provider 自定（如 nexos 为 userName，retool 为 workspaceId|agentId）。
+ */
+class UpstreamThreadPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings {
+        int maxPerAccount = 2;          // 每个账号最多预建数，0 表示关闭
+        int maxIdleSeconds = 600;       // 预建条目的最长闲置时间
+        int demandWindowSeconds = 600;  // 统计需求的时间窗口
+        int refillIntervalSeconds = 15; // 后台补充间隔
+    };
+
+    static UpstreamThreadPool& getInstance();
+
+    UpstreamThreadPool() = default;
+    UpstreamThreadPool(const UpstreamThreadPool&) = delete;
+    UpstreamThreadPool& operator=(const UpstreamThreadPool&) = delete;
+
+    void setSettings(const Settings& settings);
+    Settings settings() const;
+    bool enabled() const;
+
+    /// 记一次需求，并取出一个预建条目；池为空或已关闭时返回 nullopt
+    std::optional<std::string> claim(const std::string& provider, const std::string& account, Clock::time_point now = Clock::now());
+    void add(const std::string& provider, const std::string& account, const std::string& id, Clock::time_point now = Clock::now());
+
+    /// 账号当前应补充的数量：窗口内需求折算到一个补充周期再加 1 个余量，不超过上限，减去已预建数
+    int deficit(const std::string& provider, const std::string& account, Clock::time_point now = Clock::now()) const;
+    /// 最近窗口内有需求的账号
+    std::vector<std::string> demandedAccounts(const std::string& provider, Clock::time_point now = Clock::now()) const;
+
+    /// 账号失效或配置变化时丢弃其预建条目与需求记录
+    void dropAccount(const std::string& provider, const std::string& account);
+    /// 丢弃闲置过久的预建条目与窗口外的需求记录，返回丢弃的预建条目数
+    size_t evictStale(Clock::time_point now = Clock::now());
+
+    size_t readyCount(const std::string& provider, const std::string& account) const;
+    void clear();
+
+private:
+    using SlotKey = std::pair<std::string, std::string>;
+
+    struct Slot {
+        std::deque<std::pair<std::string, Clock::time_point>> ready;  // (id, 预建时间)
+        std::deque<Clock::time_point> demand;
+    };
+
+    size_t freshCountLocked(const Slot& slot, Clock::time_point now) const;
+    size_t demandCountLocked(const Slot& slot, Clock::time_point now) const;
+
+    mutable std::mutex mutex_;
+    Settings settings_;
+    std::map<SlotKey, Slot> slots_;
+};
+
+#endif
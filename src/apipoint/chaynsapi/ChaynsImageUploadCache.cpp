@@ -0,0 +1,75 @@
+#include "ChaynsImageUploadCache.h"
+
+#include <iterator>
+
+namespace
+{
+constexpr size_t kPruneThreshold = 1024;
+}  // namespace
+
+std::string ChaynsImageUploadCache::keyOf(const std::string& personId, const std::string& digest)
+{
+    return personId + "|" + digest;
+}
+
+void ChaynsImageUploadCache::setTtl(std::chrono::seconds ttl)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = ttl;
+    if (ttl_.count() <= 0) {
+        entries_.clear();
+    }
+}
+
+std::chrono::seconds ChaynsImageUploadCache::ttl() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ttl_;
+}
+
+std::optional<std::string> ChaynsImageUploadCache::lookup(const std::string& personId,
+                                                          const std::string& digest,
+                                                          Clock::time_point now) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ttl_.count() <= 0) {
+        return std::nullopt;
+    }
+    auto it = entries_.find(keyOf(personId, digest));
+    if (it == entries_.end() || now - it->second.uploadedAt >= ttl_) {
+        return std::nullopt;
+    }
+    return it->second.url;
+}
+
+void ChaynsImageUploadCache::remember(const std::string& personId,
+                                      const std::string& digest,
+                                      const std::string& url,
+                                      Clock::time_point now)
+{
+    if (url.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ttl_.count() <= 0) {
+        return;
+    }
+    if (entries_.size() >= kPruneThreshold) {
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            it = now - it->second.uploadedAt >= ttl_ ? entries_.erase(it) : std::next(it);
+        }
+    }
+    entries_[keyOf(personId, digest)] = Entry{url, now};
+}
+
+size_t ChaynsImageUploadCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void ChaynsImageUploadCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
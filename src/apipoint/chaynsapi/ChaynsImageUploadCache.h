@@ -0,0 +1,49 @@
+#ifndef CHAYNS_IMAGE_UPLOAD_CACHE_H
+#define CHAYNS_IMAGE_UPLOAD_CACHE_H
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief chayns 图片上传结果缓存：(personId, 图片内容摘要) -> 图片服务 URL
+ *
+ * agent 客户端会在多轮对话中反复携带同一批截图；命中缓存的图片不再上传。
+ * 摘要取 ImageBlobStore 驻留图片时计算的内容摘要。条目按 TTL 过期，0 表示关闭缓存。
+ */
+class ChaynsImageUploadCache
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    void setTtl(std::chrono::seconds ttl);
+    std::chrono::seconds ttl() const;
+
+    std::optional<std::string> lookup(const std::string& personId,
+                                      const std::string& digest,
+                                      Clock::time_point now = Clock::now()) const;
+    void remember(const std::string& personId,
+                  const std::string& digest,
+                  const std::string& url,
+                  Clock::time_point now = Clock::now());
+
+    size_t size() const;
+    void clear();
+
+  private:
+    struct Entry
+    {
+        std::string url;
+        Clock::time_point uploadedAt;
+    };
+
+    static std::string keyOf(const std::string& personId, const std::string& digest);
+
+    mutable std::mutex mutex_;
+    std::chrono::seconds ttl_{3600};
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+#endif
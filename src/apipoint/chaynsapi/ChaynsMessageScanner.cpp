@@ -0,0 +1,107 @@
+#include "ChaynsMessageScanner.h"
+#include <json/json.h>
+#include <memory>
+
+namespace chayns
+{
+
+bool splitTopLevelArray(std::string_view body, std::vector<std::string_view>& elements)
+{
+    elements.clear();
+    size_t i = 0;
+    auto isWs = [](char ch) { return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n'; };
+    auto skipWs = [&]() {
+        while (i < body.size() && isWs(body[i])) {
+            ++i;
+        }
+    };
+    auto pushElement = [&](size_t begin, size_t end) {
+        while (end > begin && isWs(body[end - 1])) {
+            --end;
+        }
+        elements.push_back(body.substr(begin, end - begin));
+    };
+
+    skipWs();
+    if (i >= body.size() || body[i] != '[') {
+        return false;
+    }
+    ++i;
+
+    int depth = 0;
+    bool inString = false;
+    size_t start = std::string_view::npos;
+    for (; i < body.size(); ++i) {
+        const char ch = body[i];
+        if (inString) {
+            if (ch == '\\') {
+                ++i;
+            } else if (ch == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        if (isWs(ch)) {
+            continue;
+        }
+        if (start == std::string_view::npos) {
+            if (depth == 0 && ch == ']') {
+                return elements.empty();
+            }
+            start = i;
+        }
+        switch (ch) {
+            case '"': inString = true; break;
+            case '{':
+            case '[': ++depth; break;
+            case '}':
+            case ']':
+                if (depth == 0) {
+                    // 顶层数组结束
+                    pushElement(start, i);
+                    return ch == ']';
+                }
+                --depth;
+                break;
+            case ',':
+                if (depth == 0) {
+                    pushElement(start, i);
+                    start = std::string_view::npos;
+                }
+                break;
+            default: break;
+        }
+    }
+    return false;
+}
+
+std::optional<std::string> findLatestBotReply(std::string_view body, const std::string& userAuthorId)
+{
+    std::vector<std::string_view> elements;
+    if (!splitTopLevelArray(body, elements)) {
+        return std::nullopt;
+    }
+
+    static thread_local std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it) {
+        // 快速排除：typeId 不出现在元素中时不必解析
+        if (it->find("\"typeId\"") == std::string_view::npos) {
+            continue;
+        }
+        Json::Value msg;
+        if (!reader->parse(it->data(), it->data() + it->size(), &msg, nullptr) || !msg.isObject()) {
+            continue;
+        }
+        const auto& author = msg["author"];
+        if (!author.isObject() || !author.isMember("id") || author["id"].asString() == userAuthorId) {
+            continue;
+        }
+        if (!msg["typeId"].isIntegral() || msg["typeId"].asInt() != 1) {
+            continue;
+        }
+        return msg["text"].isString() ? msg["text"].asString() : std::string();
+    }
+    return std::nullopt;
+}
+
+}  // namespace chayns
@@ -0,0 +1,31 @@
+#ifndef CHAYNS_MESSAGE_SCANNER_H
+#define CHAYNS_MESSAGE_SCANNER_H
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief chayns 线程消息轮询响应（消息对象数组）的轻量扫描
+ *
+ * 轮询只关心最新一条 Bot 回复，不为整个数组构造 Json::Value：
+ * 先按字符串与括号深度切出顶层元素的位置，再从后往前只解析候选元素，
+ * 找到第一条非本账号发出、typeId 为 1 的消息即停止。
+ */
+namespace chayns
+{
+
+/// 切分顶层 JSON 数组的元素（返回指向 body 的视图）；body 不是完整数组时返回 false
+bool splitTopLevelArray(std::string_view body, std::vector<std::string_view>& elements);
+
+/**
+ * @brief 查找最新一条 Bot 回复
+ *
+ * @param userAuthorId 本账号在该线程中的 AuthorID，其消息被跳过
+ * @return 找到时返回回复文本（消息无 text 字段时为空串），未找到返回 nullopt
+ */
+std::optional<std::string> findLatestBotReply(std::string_view body, const std::string& userAuthorId);
+
+}  // namespace chayns
+
+#endif
@@ -1,8 +1,18 @@
 #include <drogon/drogon.h>
 #include <chaynsapi.h>
+#include "ChaynsMessageScanner.h"
 #include <../../apiManager/Apicomn.h>
+#include <sessionManager/core/ImageBlobStore.h>
+#include <sessionManager/tooling/ToolBridgePromptCache.h>
+#include <apipoint/PollSchedule.h>
+#include <apipoint/UpstreamRateLimit.h>
+#include <apipoint/UpstreamThreadPool.h>
+#include <utils/BackgroundTaskQueue.h>
 #include <unistd.h>
+#include <algorithm>
 #include <chrono>
+#include <future>
+#include <unordered_map>
 IMPLEMENT_RUNTIME(chaynsapi,chaynsapi);
 using namespace drogon;
 
@@ -15,50 +25,10 @@ chaynsapi::~chaynsapi()
 {
 }
 
-void chaynsapi::init()
-{
-    loadModels();
+namespace {
 
-    // 从配置 custom_config.upstream_error_texts 加载上游错误文本列表
-    auto& customConfig = drogon::app().getCustomConfig();
-    if (customConfig.isMember("upstream_error_texts") && customConfig["upstream_error_texts"].isArray()) {
-        for (const auto& item : customConfig["upstream_error_texts"]) {
-            if (item.isString()) {
-                m_upstreamErrorTexts.push_back(item.asString());
-            }
-        }
-        LOG_INFO << "[chaynsAPI] 已从配置加载" << m_upstreamErrorTexts.size() << " 条上游错误文本";
-    } else {
-        LOG_WARN << "[chaynsAPI] 配置中未找到 upstream_error_texts，上游错误文本匹配将不可用";
-    }
-}
-
-
-std::string chaynsapi::uploadImageToService(const ImageInfo& image, const std::string& personId, const std::string& authToken)
+HttpRequestPtr buildImageUploadRequest(const ImageInfo& image, const std::string& personId, const std::string& authToken)
 {
-    LOG_INFO << "[chaynsAPI] 正在上传图片到图片服务，personId：" << personId;
-    
-    // 如果已经有 URL，直接返回
-    if (!image.uploadedUrl.empty()) {
-        LOG_INFO << "[chaynsAPI] 图片已有URL：" << image.uploadedUrl;
-        return image.uploadedUrl;
-    }
-    
-    // 需要上传 图片
-    if (image.base64Data.empty()) {
-        LOG_ERROR << "[chaynsAPI] 没有图片数据可上传";
-        return "";
-    }
-    
-    auto client = HttpClient::newHttpClient("https://cube.tobit.cloud");
-    
-    // 构建上传请求
-
-    std::string uploadPath = "/image-service/v3/Images/" + personId;
-    
-    // 首先解码 数据
-    std::string decodedData = drogon::utils::base64Decode(image.base64Data);
-    
     // 确定文件扩展名
     std::string extension = "png";
     if (image.mediaType.find("jpeg") != std::string::npos || image.mediaType.find("jpg") != std::string::npos) {
@@ -68,65 +38,173 @@ std::string chaynsapi::uploadImageToService(const ImageInfo& image, const std::s
     } else if (image.mediaType.find("webp") != std::string::npos) {
         extension = "webp";
     }
-    
-    // 创建 HTTP 请求并构建 / 请求体
+    const std::string mimeType = extension == "jpg" ? "image/jpeg" : "image/" + extension;
+
     auto request = HttpRequest::newHttpRequest();
     request->setMethod(HttpMethod::Post);
-    request->setPath(uploadPath);
+    request->setPath("/image-service/v3/Images/" + personId);
     request->addHeader("Authorization", "Bearer " + authToken);
-    
 
-    std::string boundary = "----WebKitFormBoundary" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
-    std::string contentType = "multipart/form-data; boundary=" + boundary;
-    request->setContentTypeString(contentType);
-    
-    std::string mimeType = "image/" + extension;
-    if (extension == "jpg") mimeType = "image/jpeg";
-    
+    const std::string boundary = "----WebKitFormBoundary" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+    request->setContentTypeString("multipart/form-data; boundary=" + boundary);
+
+    const std::string& imageBytes = image.blob->bytes;
     std::string body;
-    body += "--" + boundary + "\r\n";
-    body += "Content-Disposition: form-data; name=\"file\"; filename=\"image." + extension + "\"\r\n";
-    body += "Content-Type: " + mimeType + "\r\n\r\n";
-    body += decodedData;
-    body += "\r\n--" + boundary + "--\r\n";
-    
-    request->setBody(body);
-    
-    auto [result, response] = client->sendRequest(request);
-    
-    if (result != ReqResult::Ok) {
+    body.reserve(imageBytes.size() + 2 * boundary.size() + 160);
+    body.append("--").append(boundary).append("\r\n");
+    body.append("Content-Disposition: form-data; name=\"file\"; filename=\"image.").append(extension).append("\"\r\n");
+    body.append("Content-Type: ").append(mimeType).append("\r\n\r\n");
+    body.append(imageBytes);
+    body.append("\r\n--").append(boundary).append("--\r\n");
+    request->setBody(std::move(body));
+    return request;
+}
+
+// 解析图片服务响应，失败返回空串
+std::string parseImageUploadResponse(ReqResult result, const HttpResponsePtr& response)
+{
+    if (result != ReqResult::Ok || !response) {
         LOG_ERROR << "[chaynsAPI] 上传图片失败： 网络错误";
         return "";
     }
-    
     if (response->statusCode() != k200OK && response->statusCode() != k201Created) {
         LOG_ERROR << "[chaynsAPI] 上传图片失败： 状态码" << response->statusCode() << " 响应: " << response->getBody();
         return "";
     }
-    
-    // 解析响应获取图片URL
     auto jsonResp = response->getJsonObject();
     if (!jsonResp) {
         LOG_ERROR << "[chaynsAPI] 解析上传响应JSON失败";
         return "";
     }
-    
-
     if (jsonResp->isMember("baseDomain") && jsonResp->isMember("image") && (*jsonResp)["image"].isMember("path")) {
-        std::string baseDomain = (*jsonResp)["baseDomain"].asString();
-        std::string imagePath = (*jsonResp)["image"]["path"].asString();
-        std::string imageUrl = baseDomain + imagePath;
+        std::string imageUrl = (*jsonResp)["baseDomain"].asString() + (*jsonResp)["image"]["path"].asString();
         LOG_INFO << "[chaynsAPI] 图片上传成功：" << imageUrl;
         return imageUrl;
     }
-    
     LOG_ERROR << "[chaynsAPI] 上传响应格式异常";
     return "";
 }
 
+// chayns 回复通常数秒到数十秒；无历史分布时保持原来的 BASE_DELAY 固定间隔
+PollSchedule::Bounds chaynsPollBounds()
+{
+    PollSchedule::Bounds bounds;
+    bounds.minInterval = std::chrono::milliseconds(BASE_DELAY);
+    bounds.maxInterval = std::chrono::milliseconds(BASE_DELAY * 20);
+    bounds.fallbackInterval = std::chrono::milliseconds(BASE_DELAY);
+    return bounds;
+}
+
+}  // namespace
+
+void chaynsapi::init()
+{
+    loadModels();
+
+    // 从配置 custom_config.upstream_error_texts 加载上游错误文本列表
+    auto& customConfig = drogon::app().getCustomConfig();
+    if (customConfig.isMember("upstream_error_texts") && customConfig["upstream_error_texts"].isArray()) {
+        for (const auto& item : customConfig["upstream_error_texts"]) {
+            if (item.isString()) {
+                m_upstreamErrorTexts.push_back(item.asString());
+            }
+        }
+        LOG_INFO << "[chaynsAPI] 已从配置加载" << m_upstreamErrorTexts.size() << " 条上游错误文本";
+    } else {
+        LOG_WARN << "[chaynsAPI] 配置中未找到 upstream_error_texts，上游错误文本匹配将不可用";
+    }
+
+    int imageCacheTtlSeconds = 3600;
+    if (customConfig.isMember("chaynsapi") && customConfig["chaynsapi"].isObject()) {
+        imageCacheTtlSeconds = customConfig["chaynsapi"].get("image_cache_ttl_seconds", imageCacheTtlSeconds).asInt();
+    }
+    imageCache_.setTtl(std::chrono::seconds(std::max(0, imageCacheTtlSeconds)));
+
+    // chayns 的线程随首条消息一并创建（且成员含按模型区分的 Bot），无法预建空线程；
+    // 这里只预取账号的 personId，省去新账号首轮的一次 userSettings 往返
+    if (UpstreamThreadPool::getInstance().enabled()) {
+        const auto refillSeconds = UpstreamThreadPool::getInstance().settings().refillIntervalSeconds;
+        app().getLoop()->runEvery(static_cast<double>(refillSeconds), [this]() {
+            if (personIdPrewarmRunning_.exchange(true)) {
+                return;
+            }
+            BackgroundTaskQueue::instance().enqueue("chayns_person_prewarm", [this]() {
+                prewarmPersonIds();
+                personIdPrewarmRunning_.store(false);
+            });
+        });
+    }
+}
+
+
+std::vector<std::string> chaynsapi::uploadImages(std::vector<ImageInfo>& images, const std::string& personId, const std::string& authToken)
+{
+    std::vector<std::string> urls(images.size());
+    std::vector<std::string> digests(images.size());
+    // 同一请求内内容相同的图片只上传一次，digest -> 负责上传的图片下标
+    std::unordered_map<std::string, size_t> uploaderOf;
+    std::vector<size_t> toUpload;
+    size_t cacheHits = 0;
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        const auto& image = images[i];
+        if (!image.uploadedUrl.empty()) {
+            urls[i] = image.uploadedUrl;
+            continue;
+        }
+        if (!image.blob) {
+            LOG_ERROR << "[chaynsAPI] 没有图片数据可上传";
+            continue;
+        }
+        digests[i] = image.mediaType + "|" + image.blob->digest;
+        if (auto cached = imageCache_.lookup(personId, digests[i])) {
+            urls[i] = std::move(*cached);
+            ++cacheHits;
+            continue;
+        }
+        if (uploaderOf.emplace(digests[i], i).second) {
+            toUpload.push_back(i);
+        }
+    }
+
+    // 未命中的图片同时发出上传请求，再依次等待结果
+    std::vector<std::future<std::string>> pending;
+    pending.reserve(toUpload.size());
+    for (size_t index : toUpload) {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        pending.push_back(promise->get_future());
+        auto client = HttpClient::newHttpClient("https://cube.tobit.cloud");
+        client->sendRequest(
+            buildImageUploadRequest(images[index], personId, authToken),
+            [promise, client](ReqResult result, const HttpResponsePtr& response) {
+                promise->set_value(parseImageUploadResponse(result, response));
+            },
+            IMAGE_UPLOAD_TIMEOUT_SECONDS);
+    }
+    for (size_t k = 0; k < toUpload.size(); ++k) {
+        const size_t index = toUpload[k];
+        urls[index] = pending[k].get();
+        imageCache_.remember(personId, digests[index], urls[index]);
+    }
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (urls[i].empty() && !digests[i].empty()) {
+            urls[i] = urls[uploaderOf[digests[i]]];
+        }
+        if (!urls[i].empty()) {
+            images[i].uploadedUrl = urls[i];
+        }
+    }
+
+    LOG_INFO << "[chaynsAPI] 图片处理完成，personId：" << personId
+             << "，共" << images.size() << " 张，缓存命中" << cacheHits
+             << " 张，实际上传" << toUpload.size() << " 张";
+    return urls;
+}
+
 provider::ProviderResult chaynsapi::generate(session_st& session)
 {
-    postChatMessage(session);
+    auto error = postChatMessage(session);
 
     provider::ProviderResult result;
     result.text = session.response.message.get("message", "").asString();
@@ -135,19 +213,43 @@ provider::ProviderResult chaynsapi::generate(session_st& session)
     if (result.statusCode == 200) {
         result.error = provider::ProviderError::none();
     } else {
-        result.error = provider::ProviderError{
-            provider::ProviderErrorCode::InternalError,
-            "Provider returned error",
-            "",
-            result.statusCode
-        };
+        result.error = error.hasError() ? std::move(error) : provider::ProviderError::internal("Provider returned error");
     }
 
     return result;
 }
 
-void chaynsapi::postChatMessage(session_st& session)
+provider::ProviderError chaynsapi::classifyHttpError(int httpStatus, const std::string& message) const
+{
+    if (httpStatus == 401 || httpStatus == 403) {
+        provider::ProviderError err = provider::ProviderError::auth(message);
+        err.httpStatusCode = httpStatus;
+        return err;
+    }
+    if (httpStatus == 408 || httpStatus == 504) {
+        provider::ProviderError err = provider::ProviderError::timeout(message);
+        err.httpStatusCode = httpStatus;
+        return err;
+    }
+    if (httpStatus == 429) {
+        return provider::ProviderError::rateLimited(message);
+    }
+    if (httpStatus >= 500) {
+        provider::ProviderError err = provider::ProviderError::internal(message);
+        err.httpStatusCode = httpStatus;
+        return err;
+    }
+
+    provider::ProviderError err;
+    err.code = provider::ProviderErrorCode::InvalidRequest;
+    err.message = message;
+    err.httpStatusCode = httpStatus > 0 ? httpStatus : 400;
+    return err;
+}
+
+provider::ProviderError chaynsapi::postChatMessage(session_st& session)
 {
+    lastDemandAt_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
     LOG_INFO << "[chaynsAPI] 发送聊天消息";
     string modelname = session.request.model;
     
@@ -167,10 +269,20 @@ void chaynsapi::postChatMessage(session_st& session)
     string final_threadId;
     string final_userAuthorId;
     string final_accountUserName;
+    string final_toolBridgeDigest;
     
     // 上传的图片URL（在首次尝试时上传，后续重试复用）
     std::vector<std::string> uploadedImageUrls;
     bool imagesUploaded = false;
+
+    // 最近一次失败的分类；没有任何尝试到达上游（只被本地限流拒绝）时不计入渠道熔断
+    provider::ProviderError lastError = provider::ProviderError::internal("Upstream failed after all retries");
+    bool reachedUpstream = false;
+    auto fail = [&session](const provider::ProviderError& error) {
+        session.response.message["error"] = error.message;
+        session.response.message["statusCode"] = error.httpStatusCode > 0 ? error.httpStatusCode : 500;
+        return error;
+    };
     
     while (totalAttempts < MAX_UPSTREAM_RETRIES && !upstreamSuccess) {
         totalAttempts++;
@@ -183,15 +295,17 @@ void chaynsapi::postChatMessage(session_st& session)
         
         // ---- 1. 获取账号 ----
         shared_ptr<Accountinfo_st> accountinfo = nullptr;
+        AccountThrottle::Lease accountLease;  // 本次尝试占用的账号在途名额
+        AccountHealthTracker::Probe accountProbe;  // 账号半开时本次尝试占用的探测名额，未上报即离开本轮时归还
+        bool accountThrottled = false;        // 取号失败是因为账号均在冷却或在途已满
         
         // 首次尝试时，检查是否有已保存的账户用于继续会话
         std::string savedAccountUserName;
         if (totalAttempts == 1 && !needSwitchAccount) {
             if (session.state.isContinuation && !session.provider.prevProviderKey.empty()) {
-                std::lock_guard<std::mutex> lock(m_threadMapMutex);
-                auto it = m_threadMap.find(session.provider.prevProviderKey);
-                if (it != m_threadMap.end() && !it->second.accountUserName.empty()) {
-                    savedAccountUserName = it->second.accountUserName;
+                const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), session.provider.prevProviderKey);
+                if (ctx && !ctx->get("accountUserName", "").asString().empty()) {
+                    savedAccountUserName = ctx->get("accountUserName", "").asString();
                     LOG_INFO << "[chaynsAPI] 找到已保存的账户用户名：" << savedAccountUserName
                              << " (prevProviderKey: " << session.provider.prevProviderKey << ")";
                 }
@@ -200,60 +314,64 @@ void chaynsapi::postChatMessage(session_st& session)
         
         if (!savedAccountUserName.empty() && !needSwitchAccount) {
             AccountManager::getInstance().getAccountByUserName("chaynsapi", savedAccountUserName, accountinfo);
-            if (accountinfo == nullptr || !accountinfo->tokenStatus) {
+            if (accountinfo != nullptr && AccountManager::getInstance().isAccountCircuitOpen("chaynsapi", savedAccountUserName)) {
+                LOG_WARN << "[chaynsAPI] 已保存账户" << savedAccountUserName << " 处于熔断中, 回退到获取新账户";
+                accountLease = AccountManager::getInstance().acquireAccount("chaynsapi", accountinfo, "pro", &accountThrottled);
+            } else if (accountinfo == nullptr || !accountinfo->tokenStatus) {
                 LOG_WARN << "[chaynsAPI] 已保存账户" << savedAccountUserName << " 不再有效, 回退到获取新账户";
-                AccountManager::getInstance().getAccount("chaynsapi", accountinfo, "pro");
+                accountLease = AccountManager::getInstance().acquireAccount("chaynsapi", accountinfo, "pro", &accountThrottled);
+            } else if (!(accountLease = AccountThrottle::getInstance().tryBegin("chaynsapi", savedAccountUserName))) {
+                LOG_WARN << "[chaynsAPI] 已保存账户" << savedAccountUserName << " 冷却中或在途请求已满, 回退到获取新账户";
+                accountLease = AccountManager::getInstance().acquireAccount("chaynsapi", accountinfo, "pro", &accountThrottled);
             }
         } else {
             // 新会话或需要换账号，获取新账户
-            AccountManager::getInstance().getAccount("chaynsapi", accountinfo, "pro");
+            accountLease = AccountManager::getInstance().acquireAccount("chaynsapi", accountinfo, "pro", &accountThrottled);
         }
         
         if (accountinfo == nullptr || !accountinfo->tokenStatus) {
+            if (accountThrottled) {
+                // 冷却/在途名额不会在几秒内恢复，不盲等，直接返回由渠道路由换渠道
+                LOG_WARN << "[chaynsAPI] 账号均在冷却或在途请求已满, 放弃本次请求";
+                return fail(reachedUpstream
+                    ? lastError
+                    : provider::ProviderError::localThrottle("chayns accounts are cooling down after upstream 429 or at their in-flight limit"));
+            }
             LOG_ERROR << "[chaynsAPI] 获取有效账户失败";
+            lastError = provider::ProviderError{provider::ProviderErrorCode::ServiceUnavailable,
+                                                "No valid account available", "", 503};
             if (totalAttempts >= MAX_UPSTREAM_RETRIES) {
-                session.response.message["error"] = "No valid account available";
-                session.response.message["statusCode"] = 500;
-                return;
+                return fail(lastError);
             }
             consecutiveFails++;
             std::this_thread::sleep_for(std::chrono::milliseconds(BASE_DELAY * 5));
             continue;
         }
         
+        accountProbe = AccountManager::getInstance().beginAccountProbe("chaynsapi", accountinfo->userName);
 
-        if (accountinfo->personId.empty()) {
+        // 本次外层尝试的耗时与成败上报给账号健康度统计
+        const auto attemptStart = std::chrono::steady_clock::now();
+        auto reportAttempt = [&accountinfo, attemptStart](bool success) {
+            const double latencyMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - attemptStart).count();
+            AccountManager::getInstance().reportAccountResult("chaynsapi", accountinfo->userName, latencyMs, success);
+        };
+
+        reachedUpstream = true;
+        std::string personId = personIdOf(accountinfo);
+        if (personId.empty()) {
             LOG_INFO << "[chaynsAPI] personId为空，正在尝试获取";
-            auto authClient = HttpClient::newHttpClient("https://auth.chayns.net");
-            auto request = HttpRequest::newHttpRequest();
-            request->setMethod(HttpMethod::Get);
-            request->setPath("/v2/userSettings");
-            request->addHeader("Authorization", "Bearer " + accountinfo->authToken);
-            auto [result, response] = authClient->sendRequest(request);
-            if (result == ReqResult::Ok && response->statusCode() == k200OK) {
-                auto jsonResp = response->getJsonObject();
-                if (jsonResp) {
-                    if (jsonResp->isMember("personId")) {
-                        accountinfo->personId = (*jsonResp)["personId"].asString();
-                        LOG_INFO << "[chaynsAPI] 成功获取personId：" << accountinfo->personId;
-                    } else {
-                        LOG_ERROR << "[chaynsAPI] 用户设置响应JSON中未找到personId，响应：" << response->getBody();
-                    }
-                } else {
-                    LOG_ERROR << "[chaynsAPI] 解析用户设置响应为JSON对象失败，响应：" << response->getBody();
-                }
-            } else {
-                LOG_ERROR << "[chaynsAPI] 获取用户设置失败，状态码：" << (response ? response->statusCode() : 0) << ", 响应: " << (response ? std::string(response->getBody()) : "无响应");
-            }
+            personId = resolvePersonId(accountinfo);
         }
         
-        if (accountinfo->personId.empty()) {
+        if (personId.empty()) {
             LOG_ERROR << "[chaynsAPI] 尝试获取后personId仍为空，中止当前尝试";
+            reportAttempt(false);
             consecutiveFails++;
+            lastError = provider::ProviderError::internal("Failed to obtain a valid personId");
             if (totalAttempts >= MAX_UPSTREAM_RETRIES) {
-                session.response.message["error"] = "Failed to obtain a valid personId";
-                session.response.message["statusCode"] = 500;
-                return;
+                return fail(lastError);
             }
             std::this_thread::sleep_for(std::chrono::milliseconds(BASE_DELAY * 5));
             continue;
@@ -262,11 +380,9 @@ void chaynsapi::postChatMessage(session_st& session)
         // ---- 3. 处理图片上传 (仅首次) ----
         if (!imagesUploaded && !session.request.images.empty()) {
             LOG_INFO << "[chaynsAPI] 正在处理" << session.request.images.size() << " 张图片上传";
-            for (auto& img : session.request.images) {
-                std::string imageUrl = uploadImageToService(img, accountinfo->personId, accountinfo->authToken);
+            for (auto& imageUrl : uploadImages(session.request.images, personId, accountinfo->authToken)) {
                 if (!imageUrl.empty()) {
-                    uploadedImageUrls.push_back(imageUrl);
-                    img.uploadedUrl = imageUrl;
+                    uploadedImageUrls.push_back(std::move(imageUrl));
                 }
             }
             LOG_INFO << "[chaynsAPI] 成功上传" << uploadedImageUrls.size() << " 张图片";
@@ -281,18 +397,27 @@ void chaynsapi::postChatMessage(session_st& session)
         
         // 只在首次尝试且未要求换账号时，尝试使用已有线程
         bool isFollowUp = false;
+        string threadToolBridgeDigest;
         if (totalAttempts == 1 && !needSwitchAccount && session.state.isContinuation && !session.provider.prevProviderKey.empty()) {
-            std::lock_guard<std::mutex> lock(m_threadMapMutex);
-            auto it = m_threadMap.find(session.provider.prevProviderKey);
-            if (it != m_threadMap.end()) {
-                threadId = it->second.threadId;
-                userAuthorId = it->second.userAuthorId;
+            const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), session.provider.prevProviderKey);
+            if (ctx) {
+                threadId = ctx->get("threadId", "").asString();
+                userAuthorId = ctx->get("userAuthorId", "").asString();
+                threadToolBridgeDigest = ctx->get("toolBridgeDigest", "").asString();
                 isFollowUp = true;
                 LOG_INFO << "[chaynsAPI] 找到现有线程Id：" << threadId
                          << " (prevProviderKey: " << session.provider.prevProviderKey << ")";
             }
         }
         
+        // 续聊线程已持有同一份工具定义时，只发送简短引用，避免每轮重复注入完整定义块
+        string turnMessage = session.request.message;
+        if (isFollowUp && toolcall::canReuseToolBridgeDefinitions(session, threadToolBridgeDigest)) {
+            turnMessage = toolcall::toolBridgeReferenceMessage(session);
+            LOG_INFO << "[chaynsAPI] 工具定义未变化，发送简短引用 (线程Id：" << threadId << ", "
+                     << session.request.message.size() << " -> " << turnMessage.size() << " 字符)";
+        }
+        
         Json::Value sendResponseJson;
         bool sendFailed = false;
         
@@ -301,7 +426,7 @@ void chaynsapi::postChatMessage(session_st& session)
             // 分支 A： 后续对话 (发送消息到现有 线程)
             // =================================================
             Json::Value messageBody;
-            string messageText = session.request.message;
+            const string& messageText = turnMessage;
             
             messageBody["text"] = messageText;
             LOG_DEBUG << "发送的消息" << messageText;
@@ -329,6 +454,7 @@ void chaynsapi::postChatMessage(session_st& session)
             auto sendResult = client->sendRequest(reqSend);
             if (sendResult.first != ReqResult::Ok || !sendResult.second) {
                 LOG_ERROR << "[chaynsAPI] 发送后续消息失败(网络错误)";
+                lastError = provider::ProviderError::network("failed to send chayns follow-up message");
                 sendFailed = true;
             } else {
                 auto responseSend = sendResult.second;
@@ -336,6 +462,7 @@ void chaynsapi::postChatMessage(session_st& session)
                     auto sendJson = responseSend->getJsonObject();
                     if (!sendJson) {
                         LOG_ERROR << "[chaynsAPI] 后续消息发送成功但响应JSON为空";
+                        lastError = provider::ProviderError::internal("chayns follow-up message response is not JSON");
                         sendFailed = true;
                     } else {
                         sendResponseJson = *sendJson;
@@ -348,6 +475,9 @@ void chaynsapi::postChatMessage(session_st& session)
                     }
                 } else {
                     LOG_ERROR << "[chaynsAPI] 后续消息发送失败，状态码：" << responseSend->statusCode() << ", 响应体: " << responseSend->getBody();
+                    provider::noteUpstreamRateLimit(responseSend, "chaynsapi", accountinfo->userName);
+                    lastError = classifyHttpError(static_cast<int>(responseSend->statusCode()),
+                                                  "chayns follow-up message failed: " + std::string(responseSend->getBody()));
                     sendFailed = true;
                 }
             }
@@ -372,16 +502,17 @@ void chaynsapi::postChatMessage(session_st& session)
             Json::Value sendMessageRequest;
             Json::Value member1;
             member1["isAdmin"] = true;
-            member1["personId"] = accountinfo->personId;
+            member1["personId"] = personId;
             sendMessageRequest["members"].append(member1);
             
             Json::Value member2;
             const auto& model_info = modelInfoMap[modelname];
             if (!model_info.isMember("personId") || !model_info["personId"].isString()) {
                 LOG_ERROR << "[chaynsAPI] 模型personId缺失：" << modelname;
+                // 本地配置问题，换渠道重试无意义，也不计入渠道熔断
                 session.response.message["error"] = "Model config error";
                 session.response.message["statusCode"] = 500;
-                return;
+                return provider::ProviderError{provider::ProviderErrorCode::InternalError, "Model config error", "", 0};
             }
             member2["personId"] = model_info["personId"].asString();
             sendMessageRequest["members"].append(member2);
@@ -416,6 +547,7 @@ void chaynsapi::postChatMessage(session_st& session)
             auto sendResult = client->sendRequest(reqSend);
             if (sendResult.first != ReqResult::Ok || !sendResult.second) {
                 LOG_ERROR << "[chaynsAPI] 创建线程失败(网络错误)";
+                lastError = provider::ProviderError::network("failed to create chayns thread");
                 sendFailed = true;
             } else {
                 auto responseSend = sendResult.second;
@@ -423,6 +555,7 @@ void chaynsapi::postChatMessage(session_st& session)
                     auto sendJson = responseSend->getJsonObject();
                     if (!sendJson) {
                         LOG_ERROR << "[chaynsAPI] 创建线程成功但响应JSON为空";
+                        lastError = provider::ProviderError::internal("chayns create thread response is not JSON");
                         sendFailed = true;
                     } else {
                         sendResponseJson = *sendJson;
@@ -432,7 +565,7 @@ void chaynsapi::postChatMessage(session_st& session)
                         
                         if (sendResponseJson.isMember("members") && sendResponseJson["members"].isArray()) {
                             for (const auto& member : sendResponseJson["members"]) {
-                                if (member.isMember("personId") && member["personId"].asString() == accountinfo->personId) {
+                                if (member.isMember("personId") && member["personId"].asString() == personId) {
                                     if (member.isMember("id") && member["id"].isString()) {
                                         userAuthorId = member["id"].asString();
                                     }
@@ -447,6 +580,9 @@ void chaynsapi::postChatMessage(session_st& session)
                     }
                 } else {
                     LOG_ERROR << "[chaynsAPI] 创建线程失败，状态码：" << responseSend->statusCode();
+                    provider::noteUpstreamRateLimit(responseSend, "chaynsapi", accountinfo->userName);
+                    lastError = classifyHttpError(static_cast<int>(responseSend->statusCode()),
+                                                  "chayns create thread failed: " + std::string(responseSend->getBody()));
                     sendFailed = true;
                 }
             }
@@ -454,6 +590,7 @@ void chaynsapi::postChatMessage(session_st& session)
         
         // 如果首次发送就失败了（网络错误等），直接进入外层重试
         if (sendFailed) {
+            reportAttempt(false);
             consecutiveFails++;
             LOG_WARN << "[chaynsAPI] 发送请求失败，连续失败次数：" << consecutiveFails;
             if (consecutiveFails >= CONSECUTIVE_FAILS_BEFORE_SWITCH) {
@@ -465,6 +602,8 @@ void chaynsapi::postChatMessage(session_st& session)
         
         if (threadId.empty() || lastMessageTime.empty()) {
             LOG_ERROR << "[chaynsAPI] 关键信息缺失： 线程Id或lastMessageTime";
+            lastError = provider::ProviderError::internal("chayns response is missing thread id or message time");
+            reportAttempt(false);
             consecutiveFails++;
             if (consecutiveFails >= CONSECUTIVE_FAILS_BEFORE_SWITCH) {
                 LOG_WARN << "[chaynsAPI] 连续失败" << consecutiveFails << " 次, 下次将切换账号";
@@ -488,8 +627,8 @@ void chaynsapi::postChatMessage(session_st& session)
                 
                 // 重新发送消息到同一线程
                 Json::Value retryMessageBody;
-                retryMessageBody["text"] = session.request.message;
-                retryMessageBody["cursorPosition"] = (int)session.request.message.size();
+                retryMessageBody["text"] = turnMessage;
+                retryMessageBody["cursorPosition"] = (int)turnMessage.size();
                 
                 if (!uploadedImageUrls.empty()) {
                     Json::Value imagesArray(Json::arrayValue);
@@ -512,12 +651,18 @@ void chaynsapi::postChatMessage(session_st& session)
                 auto retryResult = client->sendRequest(reqRetry);
                 if (retryResult.first != ReqResult::Ok) {
                     LOG_ERROR << "[chaynsAPI] 同线程重试发送失败(网络错误)";
+                    lastError = provider::ProviderError::network("failed to resend chayns message");
                     continue; // 尝试下一次同线程重试
                 }
                 
                 auto retryResponse = retryResult.second;
                 if (retryResponse->statusCode() != k200OK && retryResponse->statusCode() != k201Created) {
                     LOG_ERROR << "[chaynsAPI] 同线程重试发送失败，状态码：" << retryResponse->statusCode();
+                    lastError = classifyHttpError(static_cast<int>(retryResponse->statusCode()),
+                                                  "chayns resend message failed: " + std::string(retryResponse->getBody()));
+                    if (provider::noteUpstreamRateLimit(retryResponse, "chaynsapi", accountinfo->userName)) {
+                        break; // 账号已进入冷却，不再在同一账号上重试
+                    }
                     continue; // 尝试下一次同线程重试
                 }
                 
@@ -541,9 +686,20 @@ void chaynsapi::postChatMessage(session_st& session)
             bool pollFound = false;
             
             string pollPath = "/intercom-backend/v2/thread/" + threadId + "/message?take=1000&afterDate=" + lastMessageTime;
-            LOG_INFO << "[chaynsAPI] 开始轮询 (同线程第" << sameThreadAttempt << " 次), 最大轮询次数: " << MAX_RETRIES;
+            // 轮询间隔按该模型的历史完成耗时分布调整；总等待时长仍为 MAX_RETRIES * BASE_DELAY
+            const auto schedule = PollSchedule::forModel("chaynsapi", modelname, chaynsPollBounds());
+            const auto pollStart = std::chrono::steady_clock::now();
+            const auto pollDeadline = pollStart + std::chrono::milliseconds(MAX_RETRIES * BASE_DELAY);
+            auto pollElapsed = [&pollStart]() {
+                return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - pollStart);
+            };
+            LOG_INFO << "[chaynsAPI] 开始轮询 (同线程第" << sameThreadAttempt << " 次), 最长等待: "
+                     << MAX_RETRIES * BASE_DELAY / 1000 << "s, 自适应间隔: " << (schedule.adaptive() ? 1 : 0);
+            std::this_thread::sleep_for(schedule.initialDelay());
+            // 最近一次确认尚未回复的时刻，完成耗时按它与查到回复时刻的中点记录
+            auto lastMiss = std::chrono::milliseconds(0);
             
-            for (int retry = 0; retry < MAX_RETRIES; ++retry) {
+            while (std::chrono::steady_clock::now() < pollDeadline) {
                 pollCount++;
                 auto reqGet = HttpRequest::newHttpRequest();
                 reqGet->setMethod(HttpMethod::Get);
@@ -552,34 +708,26 @@ void chaynsapi::postChatMessage(session_st& session)
                 
                 auto getResult = client->sendRequest(reqGet);
                 if (getResult.first != ReqResult::Ok || !getResult.second) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(BASE_DELAY));
+                    std::this_thread::sleep_for(schedule.nextDelay(pollElapsed()));
                     continue;
                 }
                 
                 auto responseGet = getResult.second;
                 if (responseGet->statusCode() == k200OK) {
-                    auto jsonResp = responseGet->getJsonObject();
-                    if (jsonResp && jsonResp->isArray() && !jsonResp->empty()) {
-                        for (int i = jsonResp->size() - 1; i >= 0; --i) {
-                            const auto& msg = (*jsonResp)[i];
-                            if (msg.isMember("author") && msg["author"].isMember("id") &&
-                                msg["author"]["id"].asString() != userAuthorId &&
-                                msg.isMember("typeId") && msg["typeId"].asInt() == 1) {
-                                
-                                if (msg.isMember("text") && msg["text"].isString()) {
-                                    response_message = msg["text"].asString();
-                                }
-                                response_statusCode = 200;
-                                pollFound = true;
-                                LOG_INFO << "[chaynsAPI] 轮询结束，总计轮询" << pollCount << " 次, 成功获取响应";
-                                LOG_INFO << "[chaynsAPI] 回复内容" << response_message;
-                                break;
-                            }
-                        }
-                        if (pollFound) break;
+                    // 只解析从末尾起的候选消息，不为整个消息数组构造 Json::Value
+                    if (auto reply = chayns::findLatestBotReply(responseGet->getBody(), userAuthorId)) {
+                        response_message = std::move(*reply);
+                        response_statusCode = 200;
+                        pollFound = true;
+                        CompletionTimeStats::getInstance().record("chaynsapi", modelname, lastMiss, pollElapsed());
+                        LOG_INFO << "[chaynsAPI] 轮询结束，总计轮询" << pollCount << " 次, 耗时 "
+                                 << pollElapsed().count() << "ms, 成功获取响应";
+                        LOG_INFO << "[chaynsAPI] 回复内容" << response_message;
+                        break;
                     }
+                    lastMiss = pollElapsed();
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(BASE_DELAY));
+                std::this_thread::sleep_for(schedule.nextDelay(pollElapsed()));
             }
             
             if (!pollFound) {
@@ -591,12 +739,14 @@ void chaynsapi::postChatMessage(session_st& session)
             
             if (response_statusCode != 200) {
                 isUpstreamError = true;
+                lastError = provider::ProviderError::timeout("chayns reply polling timed out");
                 LOG_WARN << "[chaynsAPI] 上游错误： 轮询超时未获取响应 (线程Id：" << threadId 
                          << ", 同线程第 " << sameThreadAttempt << "/" << SAME_THREAD_RETRIES << " 次)";
             } else {
                 for (const auto& errorText : m_upstreamErrorTexts) {
                     if (response_message == errorText) {
                         isUpstreamError = true;
+                        lastError = provider::ProviderError::internal("chayns replied with upstream error text: " + errorText);
                         LOG_WARN << "[chaynsAPI] 上游错误： 收到错误文本 '" << errorText << "' (线程Id：" << threadId
                                  << ", 同线程第 " << sameThreadAttempt << "/" << SAME_THREAD_RETRIES << " 次)";
                         break;
@@ -613,6 +763,10 @@ void chaynsapi::postChatMessage(session_st& session)
                 final_threadId = threadId;
                 final_userAuthorId = userAuthorId;
                 final_accountUserName = accountinfo->userName;
+                // 本轮注入了完整定义块则记录新指纹；未注入时沿用线程已有的指纹
+                final_toolBridgeDigest = !session.provider.toolBridgeDigest.empty()
+                    ? session.provider.toolBridgeDigest
+                    : (isFollowUp ? threadToolBridgeDigest : "");
                 LOG_INFO << "[chaynsAPI] 上游请求成功 (外层第" << totalAttempts << " 次, 同线程第 " << sameThreadAttempt << " 次)";
                 break; // 退出同线程重试循环
             }
@@ -625,6 +779,8 @@ void chaynsapi::postChatMessage(session_st& session)
             
         } // 同线程重试循环结束
         
+        reportAttempt(upstreamSuccess);
+
         // 如果同线程重试成功，退出外层循环
         if (upstreamSuccess) {
             break;
@@ -651,21 +807,114 @@ void chaynsapi::postChatMessage(session_st& session)
     if (upstreamSuccess) {
         // 更新上下文映射表
         {
-            std::lock_guard<std::mutex> lock(m_threadMapMutex);
-            ThreadContext ctx;
-            ctx.threadId = final_threadId;
-            ctx.userAuthorId = final_userAuthorId;
-            ctx.accountUserName = final_accountUserName;
-            m_threadMap[session.state.conversationId] = ctx;
+            Json::Value ctx(Json::objectValue);
+            ctx["threadId"] = final_threadId;
+            ctx["userAuthorId"] = final_userAuthorId;
+            ctx["accountUserName"] = final_accountUserName;
+            ctx["toolBridgeDigest"] = final_toolBridgeDigest;
+            ProviderContextStore::getInstance().put(contextNamespace(), session.state.conversationId, std::move(ctx));
         }
         
         session.response.message["message"] = final_response_message;
         session.response.message["statusCode"] = final_response_statusCode;
+        return provider::ProviderError::none();
+    }
+    LOG_ERROR << "[chaynsAPI] 所有上游重试均失败 (总尝试次数：" << totalAttempts 
+             << "/" << MAX_UPSTREAM_RETRIES << ")";
+    return fail(lastError);
+}
+std::string chaynsapi::resolvePersonId(const shared_ptr<Accountinfo_st>& accountinfo, bool quiet)
+{
+    auto authClient = HttpClient::newHttpClient("https://auth.chayns.net");
+    auto request = HttpRequest::newHttpRequest();
+    request->setMethod(HttpMethod::Get);
+    request->setPath("/v2/userSettings");
+    request->addHeader("Authorization", "Bearer " + accountinfo->authToken);
+    auto [result, response] = authClient->sendRequest(request);
+    std::string failure;
+    if (result == ReqResult::Ok && response->statusCode() == k200OK) {
+        auto jsonResp = response->getJsonObject();
+        if (jsonResp) {
+            if (jsonResp->isMember("personId")) {
+                const std::string personId = (*jsonResp)["personId"].asString();
+                if (!personId.empty()) {
+                    std::lock_guard<std::mutex> lock(personIdMutex_);
+                    personIds_[accountinfo->userName] = personId;
+                    personIdBackoff_.erase(accountinfo->userName);
+                }
+                LOG_INFO << "[chaynsAPI] 成功获取personId：" << personId;
+                return personId;
+            }
+            failure = "用户设置响应JSON中未找到personId，响应：" + std::string(response->getBody());
+        } else {
+            failure = "解析用户设置响应为JSON对象失败，响应：" + std::string(response->getBody());
+        }
     } else {
-        LOG_ERROR << "[chaynsAPI] 所有上游重试均失败 (总尝试次数：" << totalAttempts 
-                 << "/" << MAX_UPSTREAM_RETRIES << ")";
-        session.response.message["error"] = "Upstream failed after all retries";
-        session.response.message["statusCode"] = 500;
+        failure = "获取用户设置失败，状态码：" + std::to_string(response ? static_cast<int>(response->statusCode()) : 0) +
+                  ", 响应: " + (response ? std::string(response->getBody()) : std::string("无响应"));
+    }
+    if (quiet) {
+        LOG_DEBUG << "[chaynsAPI] " << failure;
+    } else {
+        LOG_ERROR << "[chaynsAPI] " << failure;
+    }
+    return "";
+}
+std::string chaynsapi::personIdOf(const shared_ptr<Accountinfo_st>& accountinfo) const
+{
+    if (!accountinfo->personId.empty()) {
+        return accountinfo->personId;
+    }
+    std::lock_guard<std::mutex> lock(personIdMutex_);
+    auto it = personIds_.find(accountinfo->userName);
+    return it == personIds_.end() ? std::string() : it->second;
+}
+void chaynsapi::prewarmPersonIds()
+{
+    // 需求窗口内没有请求时不预取，避免空闲时对所有账号反复请求 userSettings
+    const auto now = std::chrono::steady_clock::now();
+    const auto window = std::chrono::seconds(UpstreamThreadPool::getInstance().settings().demandWindowSeconds);
+    const std::chrono::steady_clock::time_point lastDemand(
+        std::chrono::steady_clock::duration(lastDemandAt_.load(std::memory_order_relaxed)));
+    if (lastDemandAt_.load(std::memory_order_relaxed) == 0 || now - lastDemand > window) {
+        return;
+    }
+
+    auto accountList = AccountManager::getInstance().getAccountList();
+    auto apiIt = accountList.find("chaynsapi");
+    if (apiIt == accountList.end()) {
+        return;
+    }
+    int resolved = 0;
+    for (const auto& [userName, account] : apiIt->second) {
+        if (!account || !personIdOf(account).empty() || account->authToken.empty() ||
+            !account->tokenStatus || account->status == AccountStatus::DISABLED ||
+            AccountManager::getInstance().isAccountCircuitOpen("chaynsapi", userName)) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(personIdMutex_);
+            auto it = personIdBackoff_.find(userName);
+            if (it != personIdBackoff_.end() && now < it->second.retryAt) {
+                continue;
+            }
+        }
+        if (!resolvePersonId(account, true).empty()) {
+            ++resolved;
+            continue;
+        }
+        // 失败后按 1 分钟起步、翻倍至 1 小时退避；同一账号只在首次失败时告警
+        std::lock_guard<std::mutex> lock(personIdMutex_);
+        auto& backoff = personIdBackoff_[userName];
+        backoff.failures++;
+        const int exponent = std::min(backoff.failures - 1, 6);
+        backoff.retryAt = now + std::min(std::chrono::seconds(60) * (1 << exponent), std::chrono::seconds(3600));
+        if (backoff.failures == 1) {
+            LOG_WARN << "[chaynsAPI] 预取personId失败，账号 " << userName << " 暂停预取，之后按退避重试";
+        }
+    }
+    if (resolved > 0) {
+        LOG_DEBUG << "[chaynsAPI] 预取personId " << resolved << " 个";
     }
 }
 void chaynsapi::checkAlivableTokens()
@@ -763,30 +1012,9 @@ std::string generateGuid() {
     }
     return ss.str();
 }
-void chaynsapi::transferThreadContext(const std::string& oldId, const std::string& newId)
-{
-    LOG_INFO << "[chaynsAPI] 正在尝试转移线程上下文，从" << oldId << " 到 " << newId;
-    std::lock_guard<std::mutex> lock(m_threadMapMutex);
-    auto it = m_threadMap.find(oldId);
-    if (it != m_threadMap.end()) {
-        m_threadMap[newId] = it->second;
-        m_threadMap.erase(it);
-        LOG_INFO << "[chaynsAPI] 成功转移线程上下文，从" << oldId << " 到 " << newId;
-    }
-    else
-    {
-        LOG_WARN << "[chaynsAPI] 转移线程上下文失败： oldId" << oldId << "在线程Map中未找到";
-    }
-}
 void chaynsapi::afterResponseProcess(session_st& session)
 {
 
-}
-void chaynsapi::eraseChatinfoMap(string ConversationId)
-{
-    std::lock_guard<std::mutex> lock(m_threadMapMutex);
-    const auto erased = m_threadMap.erase(ConversationId);
-    LOG_INFO << "[chaynsAPI] 删除会话映射： convId 删除数量=" << erased;
 }
 Json::Value chaynsapi::getModels()
 {
@@ -3,22 +3,28 @@
 #include <accountManager/accountManager.h>
 #include "sessionManager/core/Session.h"
 #include "../../apiManager/ApiFactory.h"
+#include "ChaynsImageUploadCache.h"
+#include <atomic>
+#include <chrono>
 #include <list>
 #include <map>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <iomanip>
+#include <unordered_map>
 #include <vector>
 
 using std::list;
 using std::map;
 using std::string;
 
-const int MAX_RETRIES = 6000;  // 轮询最大重试次数
-const int BASE_DELAY = 100;  // 轮询重试间隔（毫秒）
+const int MAX_RETRIES = 6000;  // 轮询最长等待 MAX_RETRIES * BASE_DELAY 毫秒
+const int BASE_DELAY = 100;  // 轮询最小间隔，也是没有历史耗时分布时的固定间隔（毫秒）
 const int CONSECUTIVE_FAILS_BEFORE_SWITCH = 3;  // 连续失败n次后换账号
 const int MAX_UPSTREAM_RETRIES = 4;  // 上游最大总重试次数（外层循环，每次创建新线程或换账号）
 const int SAME_THREAD_RETRIES = 2;  // 同一线程上的最大重试次数（内层循环，在同一线程上重新发送消息）
+const double IMAGE_UPLOAD_TIMEOUT_SECONDS = 60.0;  // 单张图片上传超时（秒）
 // 上游错误文本列表从配置 custom_config.upstream_error_texts 加载
 
 std::string generateGuid();
@@ -28,15 +34,14 @@ class chaynsapi:public APIinterface
     public:
         static void* createApi();
         provider::ProviderResult generate(session_st& session) override;
-        void postChatMessage(session_st& session);
+        // 结果写入 session.response.message；失败时返回分类后的错误（成功为 ProviderError::none()）
+        provider::ProviderError postChatMessage(session_st& session);
         void checkAlivableTokens();
         void checkModels();
         Json::Value getModels();
         void init();
         ~chaynsapi();
         void afterResponseProcess(session_st& session);
-        void eraseChatinfoMap(string ConversationId);
-        void transferThreadContext(const std::string& oldId, const std::string& newId) override;
 
     private:
         DEClARE_RUNTIME(chaynsapi);
@@ -45,23 +50,43 @@ class chaynsapi:public APIinterface
 
         void loadModels();
         bool checkAlivableToken(string token);
-        // 上传图片到图片服务，返回上传后的 URL
-        std::string uploadImageToService(const ImageInfo& image, const std::string& personId, const std::string& authToken);
+        provider::ProviderError classifyHttpError(int httpStatus, const std::string& message) const;
+        // 通过 userSettings 获取账号的 personId，记入 personIds_ 后返回，失败返回空串；
+        // quiet 时失败只记 DEBUG 日志（后台预取由调用方按账号只告警一次）
+        std::string resolvePersonId(const shared_ptr<Accountinfo_st>& accountinfo, bool quiet = false);
+        // 账号的 personId：账号信息中已有则直接使用，否则取本进程解析并记下的值
+        std::string personIdOf(const shared_ptr<Accountinfo_st>& accountinfo) const;
+        // 最近有请求时，后台为尚无 personId 的可用账号预取 personId；失败的账号按指数退避
+        void prewarmPersonIds();
+        // 并发上传图片到图片服务，返回与 images 一一对应的 URL（失败为空串）；
+        // 已上传过的内容直接取 imageCache_ 中的 URL，并回写 ImageInfo::uploadedUrl
+        std::vector<std::string> uploadImages(std::vector<ImageInfo>& images, const std::string& personId, const std::string& authToken);
 
         chaynsapi();
-    
-    // 定义一个结构体保存线程上下文信息
-    struct ThreadContext {
-        std::string threadId;
-        std::string userAuthorId; // Bot在该线程中的AuthorID，用于轮询时过滤
-        std::string accountUserName; // 创建该线程时使用的账户userName，用于后续请求使用相同账户
-    };
-
 
-    std::map<std::string, ThreadContext> m_threadMap;
-    std::mutex m_threadMapMutex;
+    protected:
+        // 线程上下文保存在 ProviderContextStore 的 chaynsapi 命名空间下，字段：
+        // threadId、userAuthorId（Bot在该线程中的AuthorID，用于轮询时过滤）、
+        // accountUserName（创建该线程时使用的账户，后续请求使用相同账户）、
+        // toolBridgeDigest（该线程已收到的工具定义块指纹，相同时后续轮次只发送简短引用）
+        std::string contextNamespace() const override { return "chaynsapi"; }
 
+    private:
     // 上游错误文本列表，从配置 custom_config.upstream_error_texts 加载
     std::vector<std::string> m_upstreamErrorTexts;
+    std::atomic<bool> personIdPrewarmRunning_{false};
+    // 最近一次请求的时间（steady_clock 计数），无请求时后台不预取 personId
+    std::atomic<std::chrono::steady_clock::rep> lastDemandAt_{0};
+
+    struct PersonIdBackoff
+    {
+        int failures = 0;
+        std::chrono::steady_clock::time_point retryAt;
+    };
+    // 解析出的 personId 不回写共享的账号对象，避免与请求线程读写竞争；按 userName 记在这里
+    mutable std::mutex personIdMutex_;
+    std::unordered_map<std::string, std::string> personIds_;
+    std::unordered_map<std::string, PersonIdBackoff> personIdBackoff_;
+    ChaynsImageUploadCache imageCache_;
 };
 #endif
@@ -0,0 +1,53 @@
+#include "NexosBudgetTracker.h"
+#include <algorithm>
+
+void NexosBudgetTracker::setSettings(const Settings& settings)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+}
+
+NexosBudgetTracker::Settings NexosBudgetTracker::settings() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+void NexosBudgetTracker::updateObserved(const std::string& userName, double budgetUsed)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = entries_[userName];
+    entry.observedUsed = std::max(0.0, budgetUsed);
+    entry.estimatedSince = 0.0;
+}
+
+void NexosBudgetTracker::addEstimatedUsage(const std::string& userName, size_t chars)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[userName].estimatedSince += static_cast<double>(chars) / 1000.0 * settings_.costPer1kChars;
+}
+
+void NexosBudgetTracker::forget(const std::string& userName)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(userName);
+}
+
+double NexosBudgetTracker::remainingLocked(const Entry& entry) const
+{
+    return settings_.limit - std::max(0.0, entry.observedUsed) - entry.estimatedSince;
+}
+
+double NexosBudgetTracker::predictedRemaining(const std::string& userName) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(userName);
+    return it == entries_.end() ? settings_.limit : remainingLocked(it->second);
+}
+
+bool NexosBudgetTracker::likelyExhausted(const std::string& userName) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(userName);
+    return it != entries_.end() && remainingLocked(it->second) < settings_.reserve;
+}
@@ -0,0 +1,57 @@
+#ifndef NEXOS_BUDGET_TRACKER_H
+#define NEXOS_BUDGET_TRACKER_H
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief nexos 账号预算的内存预测
+ *
+ * 以 chat.data 中读到的 budget_used 为基准（后台定期刷新），两次刷新之间按请求/响应字符数
+ * 估算新增花费并累加到预测值上。预测剩余预算低于 reserve 的账号在选号时跳过，
+ * 避免先发出一次注定 402 的聊天请求再切换账号。
+ *
+ * 未刷新过的账号以 0 为基准，只累计估算值（乐观对待，真实耗尽仍由 402 兜底）。
+ */
+class NexosBudgetTracker
+{
+  public:
+    struct Settings
+    {
+        /// 单账号预算上限（与上游 "budget 5 has been reached" 对应）
+        double limit = 5.0;
+        /// 预测剩余低于该值时视为即将耗尽
+        double reserve = 0.1;
+        /// 每 1000 个字符（请求 + 响应）的估算花费
+        double costPer1kChars = 0.01;
+    };
+
+    void setSettings(const Settings& settings);
+    Settings settings() const;
+
+    /// 刷新得到真实用量，清零估算累计
+    void updateObserved(const std::string& userName, double budgetUsed);
+    /// 一次调用完成后按字符数累加估算花费
+    void addEstimatedUsage(const std::string& userName, size_t chars);
+    void forget(const std::string& userName);
+
+    double predictedRemaining(const std::string& userName) const;
+    bool likelyExhausted(const std::string& userName) const;
+
+  private:
+    struct Entry
+    {
+        double observedUsed = -1.0;
+        double estimatedSince = 0.0;
+    };
+
+    /// 调用方需持有 mutex_
+    double remainingLocked(const Entry& entry) const;
+
+    mutable std::mutex mutex_;
+    Settings settings_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+#endif
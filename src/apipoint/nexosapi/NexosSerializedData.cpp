@@ -0,0 +1,192 @@
+#include "NexosSerializedData.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+
+NexosSerializedData::NexosSerializedData(Json::Value table) : table_(std::move(table))
+{
+}
+
+NexosSerializedData NexosSerializedData::parse(const std::string& raw)
+{
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value table;
+    std::string errs;
+    if (raw.empty() || !reader->parse(raw.data(), raw.data() + raw.size(), &table, &errs) || !table.isArray()) {
+        return NexosSerializedData();
+    }
+    return NexosSerializedData(std::move(table));
+}
+
+NexosSerializedData::Ref NexosSerializedData::valueRef(const Json::Value& value) const
+{
+    Ref ref;
+    // 容器内的整数均为引用；负数为特殊值，越界视为无效引用，均解码为 null
+    if (value.type() == Json::intValue) {
+        const Json::LargestInt n = value.asLargestInt();
+        if (n >= 0 && n < static_cast<Json::LargestInt>(tableSize())) {
+            ref.index = static_cast<int>(n);
+        }
+        return ref;
+    }
+    if (value.type() == Json::uintValue) {
+        const Json::LargestUInt n = value.asLargestUInt();
+        if (n < tableSize()) {
+            ref.index = static_cast<int>(n);
+        }
+        return ref;
+    }
+    ref.inlineNode = &value;
+    return ref;
+}
+
+const Json::Value* NexosSerializedData::rawNode(const Ref& ref) const
+{
+    if (ref.index >= 0) {
+        return &table_[static_cast<Json::ArrayIndex>(ref.index)];
+    }
+    return ref.inlineNode;
+}
+
+std::string NexosSerializedData::decodeKey(const std::string& rawKey) const
+{
+    if (rawKey.size() < 2 || rawKey[0] != '_' ||
+        !std::all_of(rawKey.begin() + 1, rawKey.end(), [](unsigned char ch) { return std::isdigit(ch); }) ||
+        rawKey.size() > 10) {
+        return rawKey;
+    }
+    const unsigned long index = std::stoul(rawKey.substr(1));
+    if (index < tableSize() && table_[static_cast<Json::ArrayIndex>(index)].isString()) {
+        return table_[static_cast<Json::ArrayIndex>(index)].asString();
+    }
+    return rawKey;
+}
+
+bool NexosSerializedData::memberRef(const Json::Value& object, const std::string& key, Ref& out) const
+{
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        if (decodeKey(it.name()) == key) {
+            out = valueRef(*it);
+            return true;
+        }
+    }
+    return false;
+}
+
+Json::Value NexosSerializedData::resolve(const Ref& ref) const
+{
+    if (ref.index >= 0) {
+        return resolveIndex(ref.index);
+    }
+    return ref.inlineNode ? resolveNode(*ref.inlineNode) : Json::Value();
+}
+
+Json::Value NexosSerializedData::resolveNode(const Json::Value& raw) const
+{
+    if (raw.isObject()) {
+        Json::Value out(Json::objectValue);
+        for (auto it = raw.begin(); it != raw.end(); ++it) {
+            out[decodeKey(it.name())] = resolve(valueRef(*it));
+        }
+        return out;
+    }
+    if (raw.isArray()) {
+        Json::Value out(Json::arrayValue);
+        for (const auto& item : raw) {
+            out.append(resolve(valueRef(item)));
+        }
+        return out;
+    }
+    // 表中的标量即字面值
+    return raw;
+}
+
+Json::Value NexosSerializedData::resolveIndex(int index) const
+{
+    auto memoIt = memo_.find(index);
+    if (memoIt != memo_.end()) {
+        return memoIt->second;
+    }
+    if (!inProgress_.insert(index).second) {
+        return Json::Value();
+    }
+    Json::Value resolved = resolveNode(table_[static_cast<Json::ArrayIndex>(index)]);
+    inProgress_.erase(index);
+    memo_[index] = resolved;
+    return resolved;
+}
+
+Json::Value NexosSerializedData::get(std::initializer_list<const char*> path) const
+{
+    if (!valid()) {
+        return Json::Value();
+    }
+    Ref ref;
+    ref.index = 0;
+    for (const char* key : path) {
+        const Json::Value* raw = rawNode(ref);
+        if (!raw || !raw->isObject() || !memberRef(*raw, key, ref)) {
+            return Json::Value();
+        }
+    }
+    return resolve(ref);
+}
+
+bool NexosSerializedData::findFirstIn(const Ref& ref, const std::string& key, std::unordered_set<int>& visited,
+                                      Json::Value& out) const
+{
+    if (ref.index >= 0 && !visited.insert(ref.index).second) {
+        return false;
+    }
+    const Json::Value* raw = rawNode(ref);
+    if (!raw) {
+        return false;
+    }
+
+    if (raw->isObject()) {
+        Ref direct;
+        const bool hasDirect = memberRef(*raw, key, direct);
+        if (hasDirect) {
+            const Json::Value* directRaw = rawNode(direct);
+            if (directRaw && directRaw->isArray()) {
+                out = resolve(direct);
+                return true;
+            }
+        }
+        for (auto it = raw->begin(); it != raw->end(); ++it) {
+            if (findFirstIn(valueRef(*it), key, visited, out)) {
+                return true;
+            }
+        }
+        if (hasDirect) {
+            out = resolve(direct);
+            return true;
+        }
+    } else if (raw->isArray()) {
+        for (const auto& item : *raw) {
+            if (findFirstIn(valueRef(item), key, visited, out)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+Json::Value NexosSerializedData::findFirst(const std::string& key) const
+{
+    if (!valid()) {
+        return Json::Value();
+    }
+    Ref root;
+    root.index = 0;
+    std::unordered_set<int> visited;
+    Json::Value out;
+    findFirstIn(root, key, visited, out);
+    return out;
+}
+
+Json::Value NexosSerializedData::resolveRoot() const
+{
+    return valid() ? resolveIndex(0) : Json::Value();
+}
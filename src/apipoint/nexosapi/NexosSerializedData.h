@@ -0,0 +1,60 @@
+#ifndef NEXOS_SERIALIZED_DATA_H
+#define NEXOS_SERIALIZED_DATA_H
+#include <json/json.h>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * @brief nexos chat.data 序列化载荷的惰性解码器
+ *
+ * chat.data 是一张引用表（JSON 数组）：下标 0 为根节点，对象的键写作 "_N"（指向表中的字符串），
+ * 容器内的整数值是指向表中节点的下标，负数为 undefined/NaN 等特殊值（解码为 null）。
+ *
+ * 表只解析一次；get()/findFirst() 只沿所需路径解引用，解码过的节点按下标记忆化，
+ * 循环引用解码为 null。实例内部有缓存，不可跨线程共享。
+ */
+class NexosSerializedData
+{
+  public:
+    NexosSerializedData() = default;
+    explicit NexosSerializedData(Json::Value table);
+
+    /// 解析 chat.data 响应体；不是非空数组时返回无效实例
+    static NexosSerializedData parse(const std::string& raw);
+
+    bool valid() const { return table_.isArray() && !table_.empty(); }
+    Json::ArrayIndex tableSize() const { return table_.isArray() ? table_.size() : 0; }
+
+    /// 按解码后的键逐级取值并完整解码，路径不存在时返回 null
+    Json::Value get(std::initializer_list<const char*> path) const;
+    /// 深度查找第一个名为 key 的成员，值为数组者优先
+    Json::Value findFirst(const std::string& key) const;
+    /// 完整解码整个载荷
+    Json::Value resolveRoot() const;
+
+  private:
+    /// 表下标或内联节点；两者皆空表示 null
+    struct Ref
+    {
+        int index = -1;
+        const Json::Value* inlineNode = nullptr;
+    };
+
+    Ref valueRef(const Json::Value& value) const;
+    const Json::Value* rawNode(const Ref& ref) const;
+    std::string decodeKey(const std::string& rawKey) const;
+    bool memberRef(const Json::Value& object, const std::string& key, Ref& out) const;
+
+    Json::Value resolve(const Ref& ref) const;
+    Json::Value resolveNode(const Json::Value& raw) const;
+    Json::Value resolveIndex(int index) const;
+    bool findFirstIn(const Ref& ref, const std::string& key, std::unordered_set<int>& visited, Json::Value& out) const;
+
+    Json::Value table_;
+    mutable std::unordered_map<int, Json::Value> memo_;
+    mutable std::unordered_set<int> inProgress_;
+};
+
+#endif
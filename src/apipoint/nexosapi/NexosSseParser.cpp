@@ -0,0 +1,321 @@
+#include "NexosSseParser.h"
+#include <cstdint>
+
+namespace {
+
+// 只读扫描单个 JSON 事件，解析失败时放弃该行
+class FieldScanner
+{
+  public:
+    explicit FieldScanner(std::string_view input) : s_(input) {}
+
+    void skipWs()
+    {
+        while (i_ < s_.size() && (s_[i_] == ' ' || s_[i_] == '\t' || s_[i_] == '\r' || s_[i_] == '\n')) {
+            ++i_;
+        }
+    }
+
+    bool peek(char ch)
+    {
+        skipWs();
+        return i_ < s_.size() && s_[i_] == ch;
+    }
+
+    bool consume(char ch)
+    {
+        if (!peek(ch)) {
+            return false;
+        }
+        ++i_;
+        return true;
+    }
+
+    /// out 为空时只跳过
+    bool readString(std::string* out)
+    {
+        if (!consume('"')) {
+            return false;
+        }
+        while (i_ < s_.size()) {
+            const char ch = s_[i_++];
+            if (ch == '"') {
+                return true;
+            }
+            if (ch != '\\') {
+                if (out) out->push_back(ch);
+                continue;
+            }
+            if (i_ >= s_.size()) {
+                return false;
+            }
+            const char esc = s_[i_++];
+            char plain = 0;
+            switch (esc) {
+                case '"': plain = '"'; break;
+                case '\\': plain = '\\'; break;
+                case '/': plain = '/'; break;
+                case 'b': plain = '\b'; break;
+                case 'f': plain = '\f'; break;
+                case 'n': plain = '\n'; break;
+                case 'r': plain = '\r'; break;
+                case 't': plain = '\t'; break;
+                case 'u': {
+                    uint32_t cp = 0;
+                    if (!readHex4(cp)) {
+                        return false;
+                    }
+                    if (cp >= 0xD800 && cp <= 0xDBFF && i_ + 1 < s_.size() && s_[i_] == '\\' && s_[i_ + 1] == 'u') {
+                        i_ += 2;
+                        uint32_t low = 0;
+                        if (!readHex4(low)) {
+                            return false;
+                        }
+                        cp = (low >= 0xDC00 && low <= 0xDFFF) ? 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00) : 0xFFFD;
+                    } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+                        cp = 0xFFFD;
+                    }
+                    if (out) appendUtf8(*out, cp);
+                    continue;
+                }
+                default: return false;
+            }
+            if (out) out->push_back(plain);
+        }
+        return false;
+    }
+
+    bool skipValue()
+    {
+        skipWs();
+        if (i_ >= s_.size()) {
+            return false;
+        }
+        const char ch = s_[i_];
+        if (ch == '"') {
+            return readString(nullptr);
+        }
+        if (ch == '{' || ch == '[') {
+            const char close = ch == '{' ? '}' : ']';
+            ++i_;
+            if (consume(close)) {
+                return true;
+            }
+            while (true) {
+                if (ch == '{' && (!readString(nullptr) || !consume(':'))) {
+                    return false;
+                }
+                if (!skipValue()) {
+                    return false;
+                }
+                if (consume(close)) {
+                    return true;
+                }
+                if (!consume(',')) {
+                    return false;
+                }
+            }
+        }
+        // 数字 / true / false / null
+        const size_t start = i_;
+        while (i_ < s_.size() && s_[i_] != ',' && s_[i_] != '}' && s_[i_] != ']' &&
+               s_[i_] != ' ' && s_[i_] != '\t' && s_[i_] != '\r' && s_[i_] != '\n') {
+            ++i_;
+        }
+        return i_ > start;
+    }
+
+    /// 遍历对象成员；onMember 返回 false 表示未消费该值，由扫描器跳过
+    template <typename F>
+    bool forEachMember(F&& onMember)
+    {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        std::string key;
+        while (true) {
+            key.clear();
+            if (!readString(&key) || !consume(':')) {
+                return false;
+            }
+            bool ok = true;
+            if (!onMember(key, ok)) {
+                ok = skipValue();
+            }
+            if (!ok) {
+                return false;
+            }
+            if (consume('}')) {
+                return true;
+            }
+            if (!consume(',')) {
+                return false;
+            }
+        }
+    }
+
+    /// 当前值是字符串时读入 out，否则跳过
+    bool readStringOrSkip(std::string& out)
+    {
+        return peek('"') ? readString(&out) : skipValue();
+    }
+
+  private:
+    bool readHex4(uint32_t& out)
+    {
+        if (i_ + 4 > s_.size()) {
+            return false;
+        }
+        out = 0;
+        for (int k = 0; k < 4; ++k) {
+            const char ch = s_[i_++];
+            out <<= 4;
+            if (ch >= '0' && ch <= '9') out |= static_cast<uint32_t>(ch - '0');
+            else if (ch >= 'a' && ch <= 'f') out |= static_cast<uint32_t>(ch - 'a' + 10);
+            else if (ch >= 'A' && ch <= 'F') out |= static_cast<uint32_t>(ch - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t cp)
+    {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    std::string_view s_;
+    size_t i_ = 0;
+};
+
+struct SseEvent
+{
+    std::string contentType;
+    std::string text;
+    bool hasText = false;
+    std::string messageId;
+};
+
+bool scanEvent(std::string_view json, SseEvent& event)
+{
+    FieldScanner scanner(json);
+    return scanner.forEachMember([&](const std::string& key, bool& ok) {
+        if (key == "content_type") {
+            ok = scanner.readStringOrSkip(event.contentType);
+            return true;
+        }
+        if (key == "message_id" || key == "messageId" || key == "assistant_message_id") {
+            std::string id;
+            ok = scanner.readStringOrSkip(id);
+            if (!id.empty()) event.messageId = id;
+            return true;
+        }
+        if (key == "content" && scanner.peek('{')) {
+            ok = scanner.forEachMember([&](const std::string& inner, bool& innerOk) {
+                if (inner != "text" || !scanner.peek('"')) {
+                    return false;
+                }
+                event.text.clear();
+                innerOk = scanner.readString(&event.text);
+                event.hasText = innerOk;
+                return true;
+            });
+            return true;
+        }
+        if (key == "message" && scanner.peek('{')) {
+            ok = scanner.forEachMember([&](const std::string& inner, bool& innerOk) {
+                if (inner != "id") {
+                    return false;
+                }
+                std::string id;
+                innerOk = scanner.readStringOrSkip(id);
+                if (!id.empty() && event.messageId.empty()) event.messageId = id;
+                return true;
+            });
+            return true;
+        }
+        return false;
+    });
+}
+
+}
+
+NexosSseParser::NexosSseParser(DeltaCallback onDelta) : onDelta_(std::move(onDelta))
+{
+}
+
+void NexosSseParser::feed(std::string_view chunk)
+{
+    while (!chunk.empty()) {
+        const auto newline = chunk.find('\n');
+        if (newline == std::string_view::npos) {
+            pendingLine_.append(chunk.data(), chunk.size());
+            return;
+        }
+        if (pendingLine_.empty()) {
+            // 整行都在本块内时直接解析，不复制
+            processLine(chunk.substr(0, newline));
+        } else {
+            pendingLine_.append(chunk.data(), newline);
+            processLine(pendingLine_);
+            pendingLine_.clear();
+        }
+        chunk.remove_prefix(newline + 1);
+    }
+}
+
+void NexosSseParser::finish()
+{
+    if (!pendingLine_.empty()) {
+        processLine(pendingLine_);
+        pendingLine_.clear();
+    }
+}
+
+void NexosSseParser::processLine(std::string_view line)
+{
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    if (line.compare(0, 5, "data:") != 0) {
+        return;
+    }
+    line.remove_prefix(5);
+    if (!line.empty() && line.front() == ' ') {
+        line.remove_prefix(1);
+    }
+    if (line.compare(0, 6, "[DONE]") == 0) {
+        done_ = true;
+        return;
+    }
+
+    SseEvent event;
+    if (!scanEvent(line, event)) {
+        return;
+    }
+    if (!event.messageId.empty()) {
+        messageId_ = event.messageId;
+    }
+    if (event.contentType == "text" && event.hasText && !event.text.empty()) {
+        text_ += event.text;
+        if (onDelta_) {
+            onDelta_(event.text);
+        }
+    }
+}
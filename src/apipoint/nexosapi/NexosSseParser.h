@@ -0,0 +1,40 @@
+#ifndef NEXOS_SSE_PARSER_H
+#define NEXOS_SSE_PARSER_H
+#include <functional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief nexos 聊天 SSE 响应的增量解析器
+ *
+ * 按块 feed()，只缓存尚未结束的当前行；每个 `data:` 行用轻量字段扫描器读取
+ * content_type / content.text 与消息 id，不构造 Json::Value。
+ * 文本片段到达即通过回调发出，同时累加到 text()。
+ */
+class NexosSseParser
+{
+  public:
+    using DeltaCallback = std::function<void(const std::string&)>;
+
+    explicit NexosSseParser(DeltaCallback onDelta = nullptr);
+
+    void feed(std::string_view chunk);
+    /// 处理末尾没有换行的最后一行
+    void finish();
+
+    const std::string& text() const { return text_; }
+    /// 流中最后出现的消息 id，作为下一轮的 last_message_id
+    const std::string& messageId() const { return messageId_; }
+    bool done() const { return done_; }
+
+  private:
+    void processLine(std::string_view line);
+
+    DeltaCallback onDelta_;
+    std::string pendingLine_;
+    std::string text_;
+    std::string messageId_;
+    bool done_ = false;
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include <drogon/drogon.h>
 #include <json/json.h>
 #include <utils/BackgroundTaskQueue.h>
+#include <sessionManager/tooling/ToolBridgePromptCache.h>
+#include <apipoint/UpstreamRateLimit.h>
+#include <apipoint/UpstreamThreadPool.h>
 
 #include <algorithm>
 #include <cctype>
@@ -96,213 +99,15 @@ bool extractIntegerAfterToken(const std::string& raw, const std::string& token,
     return true;
 }
 
-bool isCycleMarkerString(const std::string& value)
+// 优先取 LoggedInLayout.subscription.budget_used，解码失败时退回原始文本扫描
+bool extractBudgetUsed(const NexosSerializedData& data, const std::string& raw, double& out)
 {
-    return value.size() >= 9 &&
-           value.rfind("<cycle:", 0) == 0 &&
-           value.back() == '>';
-}
-
-Json::Value sanitizeJsonValue(const Json::Value& value)
-{
-    if (value.isString()) {
-        const std::string text = value.asString();
-        if (isCycleMarkerString(text)) {
-            return Json::nullValue;
-        }
-        return value;
-    }
-
-    if (value.isArray()) {
-        Json::Value out(Json::arrayValue);
-        for (const auto& item : value) {
-            out.append(sanitizeJsonValue(item));
-        }
-        return out;
-    }
-
-    if (value.isObject()) {
-        Json::Value out(Json::objectValue);
-        for (const auto& key : value.getMemberNames()) {
-            out[key] = sanitizeJsonValue(value[key]);
-        }
-        return out;
-    }
-
-    return value;
-}
-
-Json::Value resolveSpecialNegative(const Json::Value& value)
-{
-    if (!value.isInt() && !value.isInt64()) {
-        return value;
-    }
-    const auto n = value.isInt64() ? value.asInt64() : value.asInt();
-    if (n == -5 || n == -7) {
-        return Json::nullValue;
-    }
-    return value;
-}
-
-Json::Value resolveInline(
-    const Json::Value& value,
-    const Json::Value& root,
-    std::unordered_map<int, Json::Value>& memo,
-    std::set<int>& inProgress
-);
-
-Json::Value resolveRef(
-    int index,
-    const Json::Value& root,
-    std::unordered_map<int, Json::Value>& memo,
-    std::set<int>& inProgress
-)
-{
-    if (!root.isArray() || index < 0 || index >= static_cast<int>(root.size())) {
-        return Json::Value(index);
-    }
-
-    auto memoIt = memo.find(index);
-    if (memoIt != memo.end()) {
-        return memoIt->second;
-    }
-
-    if (inProgress.count(index) > 0) {
-        return Json::Value("<cycle:" + std::to_string(index) + ">");
-    }
-
-    inProgress.insert(index);
-    Json::Value resolved = resolveInline(root[index], root, memo, inProgress);
-    inProgress.erase(index);
-    memo[index] = resolved;
-    return resolved;
-}
-
-Json::Value resolveInline(
-    const Json::Value& value,
-    const Json::Value& root,
-    std::unordered_map<int, Json::Value>& memo,
-    std::set<int>& inProgress
-)
-{
-    if (value.isNull() || value.isString() || value.isBool()) {
-        return value;
-    }
-
-    if (value.isInt()) {
-        const int n = value.asInt();
-        if (n < 0) {
-            return resolveSpecialNegative(value);
-        }
-        if (!root.isArray() || n >= static_cast<int>(root.size())) {
-            return value;
-        }
-        return resolveRef(n, root, memo, inProgress);
-    }
-
-    if (value.isInt64()) {
-        const auto n = value.asInt64();
-        if (n < 0) {
-            return resolveSpecialNegative(value);
-        }
-        if (!root.isArray() || n >= static_cast<Json::Int64>(root.size())) {
-            return value;
-        }
-        return resolveRef(static_cast<int>(n), root, memo, inProgress);
-    }
-
-    if (value.isUInt()) {
-        const unsigned int n = value.asUInt();
-        if (!root.isArray() || n >= root.size()) {
-            return value;
-        }
-        return resolveRef(static_cast<int>(n), root, memo, inProgress);
-    }
-
-    if (value.isUInt64()) {
-        const auto n = value.asUInt64();
-        if (!root.isArray() || n >= static_cast<Json::UInt64>(root.size())) {
-            return value;
-        }
-        return resolveRef(static_cast<int>(n), root, memo, inProgress);
-    }
-
-    if (value.isDouble()) {
-        return value;
-    }
-
-    if (value.isArray()) {
-        Json::Value out(Json::arrayValue);
-        for (const auto& item : value) {
-            out.append(resolveInline(item, root, memo, inProgress));
-        }
-        return out;
-    }
-
-    if (value.isObject()) {
-        Json::Value out(Json::objectValue);
-        for (const auto& key : value.getMemberNames()) {
-            std::string resolvedKey = key;
-            if (key.size() > 1 && key[0] == '_' &&
-                std::all_of(key.begin() + 1, key.end(), [](unsigned char ch) { return std::isdigit(ch); })) {
-                const int keyIndex = std::stoi(key.substr(1));
-                const Json::Value keyValue = resolveRef(keyIndex, root, memo, inProgress);
-                if (keyValue.isString()) {
-                    resolvedKey = keyValue.asString();
-                }
-            }
-            out[resolvedKey] = resolveInline(value[key], root, memo, inProgress);
-        }
-        return out;
-    }
-
-    return value;
-}
-
-Json::Value parseNexosSerializedData(const std::string& serializedText)
-{
-    Json::CharReaderBuilder builder;
-    std::string errs;
-    Json::Value root;
-    std::istringstream iss(serializedText);
-    if (!Json::parseFromStream(builder, iss, &root, &errs) || !root.isArray() || root.empty()) {
-        return Json::Value();
+    const Json::Value budgetUsed = data.get({"domains/auth/routes/LoggedInLayout", "data", "subscription", "budget_used"});
+    if (budgetUsed.isNumeric()) {
+        out = budgetUsed.asDouble();
+        return true;
     }
-
-    std::unordered_map<int, Json::Value> memo;
-    std::set<int> inProgress;
-    return resolveRef(0, root, memo, inProgress);
-}
-
-Json::Value findFirstKeyDeep(const Json::Value& value, const std::string& targetKey)
-{
-    if (!value.isObject() && !value.isArray()) {
-        return Json::Value();
-    }
-
-    if (value.isObject()) {
-        if (value.isMember(targetKey) && value[targetKey].isArray()) {
-            return value[targetKey];
-        }
-        for (const auto& key : value.getMemberNames()) {
-            Json::Value found = findFirstKeyDeep(value[key], targetKey);
-            if (!found.isNull()) {
-                return found;
-            }
-        }
-        if (value.isMember(targetKey)) {
-            return value[targetKey];
-        }
-    } else {
-        for (const auto& item : value) {
-            Json::Value found = findFirstKeyDeep(item, targetKey);
-            if (!found.isNull()) {
-                return found;
-            }
-        }
-    }
-
-    return Json::Value();
+    return extractNumberAfterToken(raw, "\"budget_used\"", out);
 }
 
 std::string mapRuntimeModelAlias(const Json::Value& modelInfo)
@@ -407,8 +212,48 @@ void nexosapi::init()
     modelListOpenAiFormat_["object"] = "list";
     modelListOpenAiFormat_["data"] = Json::arrayValue;
 
+    const auto& budgetConfig =
+        nexos.isMember("budget") && nexos["budget"].isObject()
+            ? nexos["budget"]
+            : emptyObject;
+    NexosBudgetTracker::Settings budgetSettings;
+    budgetSettings.limit = budgetConfig.get("limit", budgetSettings.limit).asDouble();
+    budgetSettings.reserve = budgetConfig.get("reserve", budgetSettings.reserve).asDouble();
+    budgetSettings.costPer1kChars = budgetConfig.get("cost_per_1k_chars", budgetSettings.costPer1kChars).asDouble();
+    budget_.setSettings(budgetSettings);
+    accountRefreshIntervalSeconds_ = budgetConfig.get("refresh_interval_seconds", accountRefreshIntervalSeconds_).asInt();
+    modelCacheTtlSeconds_ = nexos.get("model_cache_ttl_seconds", modelCacheTtlSeconds_).asInt();
+
+    if (accountRefreshIntervalSeconds_ > 0) {
+        app().getLoop()->runEvery(static_cast<double>(accountRefreshIntervalSeconds_), [this]() {
+            if (accountRefreshRunning_.exchange(true)) {
+                return;
+            }
+            BackgroundTaskQueue::instance().enqueue("nexos_account_refresh", [this]() {
+                refreshAccountData();
+                accountRefreshRunning_.store(false);
+            });
+        });
+    }
+
+    if (UpstreamThreadPool::getInstance().enabled()) {
+        const auto refillSeconds = UpstreamThreadPool::getInstance().settings().refillIntervalSeconds;
+        app().getLoop()->runEvery(static_cast<double>(refillSeconds), [this]() {
+            if (chatPrewarmRunning_.exchange(true)) {
+                return;
+            }
+            BackgroundTaskQueue::instance().enqueue("nexos_chat_prewarm", [this]() {
+                prewarmChats();
+                chatPrewarmRunning_.store(false);
+            });
+        });
+    }
+
     LOG_INFO << "[nexosapi] 初始化完成，baseUrl=" << baseUrl_
-             << "，cookies/模型均改为运行时从账号管理与 chat.data 获取";
+             << "，cookies/模型均改为运行时从账号管理与 chat.data 获取"
+             << "，预算上限=" << budgetSettings.limit
+             << "，刷新间隔=" << accountRefreshIntervalSeconds_ << "s"
+             << "，模型缓存TTL=" << modelCacheTtlSeconds_ << "s";
 }
 
 std::shared_ptr<Accountinfo_st> nexosapi::selectAccount(const session_st& session, bool& reuseExistingChat)
@@ -428,17 +273,16 @@ std::shared_ptr<Accountinfo_st> nexosapi::selectAccount(
         : session.state.conversationId;
 
     std::string preferredUserName;
-    {
-        std::lock_guard<std::mutex> lock(chatMutex_);
-        auto it = chatMap_.find(providerKey);
-        if (it != chatMap_.end() && !it->second.accountUserName.empty()) {
-            preferredUserName = it->second.accountUserName;
-            reuseExistingChat = !it->second.chatId.empty();
-        }
+    if (const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), providerKey)) {
+        preferredUserName = ctx->get("accountUserName", "").asString();
+        reuseExistingChat = !preferredUserName.empty() && !ctx->get("chatId", "").asString().empty();
     }
 
     std::shared_ptr<Accountinfo_st> account;
-    if (!preferredUserName.empty() && excludedUserNames.count(preferredUserName) == 0) {
+    if (!preferredUserName.empty() && excludedUserNames.count(preferredUserName) == 0 &&
+        !AccountManager::getInstance().isAccountCircuitOpen("nexosapi", preferredUserName) &&
+        AccountThrottle::getInstance().isAvailable("nexosapi", preferredUserName) &&
+        !budget_.likelyExhausted(preferredUserName)) {
         AccountManager::getInstance().getAccountByUserName("nexosapi", preferredUserName, account);
         if (isUsableNexosAccount(account)) {
             return account;
@@ -452,16 +296,38 @@ std::shared_ptr<Accountinfo_st> nexosapi::selectAccount(
         return nullptr;
     }
 
+    // 按健康度折算后的负载选择；熔断中的账号负载为无穷大，仅在没有其他账号时选中；
+    // 429 冷却中或在途已满的账号直接跳过；预测预算将耗尽的账号只在别无选择时使用（取预测剩余最多者）
+    const auto& health = AccountHealthTracker::getInstance();
+    const auto& throttle = AccountThrottle::getInstance();
+    const auto now = AccountHealthTracker::Clock::now();
     std::shared_ptr<Accountinfo_st> selected;
+    double selectedCost = 0.0;
+    std::shared_ptr<Accountinfo_st> lowBudget;
+    double lowBudgetRemaining = 0.0;
     for (const auto& [userName, current] : apiIt->second) {
-        if (excludedUserNames.count(userName) > 0 || !isUsableNexosAccount(current)) {
+        if (excludedUserNames.count(userName) > 0 || !isUsableNexosAccount(current) ||
+            !throttle.isAvailable("nexosapi", userName, now)) {
             continue;
         }
-        if (!selected || current->useCount < selected->useCount) {
+        if (budget_.likelyExhausted(userName)) {
+            const double remaining = budget_.predictedRemaining(userName);
+            if (!lowBudget || remaining > lowBudgetRemaining) {
+                lowBudget = current;
+                lowBudgetRemaining = remaining;
+            }
+            continue;
+        }
+        const double cost = health.loadCost(*current, now);
+        if (!selected || cost < selectedCost) {
             selected = current;
+            selectedCost = cost;
         }
     }
 
+    if (!selected) {
+        selected = lowBudget;
+    }
     if (!selected) {
         return nullptr;
     }
@@ -494,7 +360,7 @@ nexosapi::ChatDataPayload nexosapi::fetchChatDataPayload(const std::string& cook
     }
 
     payload.raw = std::string(response->getBody());
-    payload.decoded = parseNexosSerializedData(payload.raw);
+    payload.data = NexosSerializedData::parse(payload.raw);
     return payload;
 }
 
@@ -523,25 +389,30 @@ std::shared_ptr<Accountinfo_st> nexosapi::selectAccountByUserName(const std::str
 }
 
 nexosapi::RuntimeModelData nexosapi::fetchRuntimeModelData(const std::string& cookies)
+{
+    if (cookies.empty()) {
+        return parseRuntimeModelData(ChatDataPayload{});
+    }
+    return parseRuntimeModelData(fetchChatDataPayload(cookies));
+}
+
+nexosapi::RuntimeModelData nexosapi::parseRuntimeModelData(const ChatDataPayload& payload) const
 {
     RuntimeModelData runtimeData;
     runtimeData.models["object"] = "list";
     runtimeData.models["data"] = Json::arrayValue;
 
-    if (cookies.empty()) {
+    if (payload.raw.empty()) {
         return runtimeData;
     }
 
-    const auto payload = fetchChatDataPayload(cookies);
-    const Json::Value userModels = findFirstKeyDeep(payload.decoded, "userModels");
-    const std::string decodedPreview = jsonCompactString(payload.decoded);
-    LOG_INFO << "[nexosapi] 运行时模型解析: body_size=" << payload.raw.size()
-             << ", decoded_is_null=" << payload.decoded.isNull()
+    const Json::Value userModels = payload.data.findFirst("userModels");
+    LOG_DEBUG << "[nexosapi] 运行时模型解析: body_size=" << payload.raw.size()
+             << ", table_size=" << payload.data.tableSize()
              << ", userModels_is_array=" << userModels.isArray()
              << ", userModels_size=" << (userModels.isArray() ? static_cast<int>(userModels.size()) : 0)
              << ", userModels_type=" << userModels.type()
-             << ", userModels_preview=" << jsonCompactString(userModels).substr(0, 160)
-             << ", decoded_preview=" << decodedPreview.substr(0, 200);
+             << ", userModels_preview=" << jsonCompactString(userModels).substr(0, 160);
 
     std::set<std::string> seenAliases;
     if (userModels.isArray()) {
@@ -590,15 +461,89 @@ nexosapi::RuntimeModelData nexosapi::fetchRuntimeModelData(const std::string& co
         runtimeData.models["data"].append(model);
     }
 
-    LOG_INFO << "[nexosapi] 运行时模型映射完成: aliases=" << runtimeData.mapping.size()
+    LOG_DEBUG << "[nexosapi] 运行时模型映射完成: aliases=" << runtimeData.mapping.size()
              << ", defaultAlias=" << runtimeData.defaultAlias;
 
     return runtimeData;
 }
 
+std::shared_ptr<const nexosapi::RuntimeModelData> nexosapi::runtimeModelsFor(const std::shared_ptr<Accountinfo_st>& account)
+{
+    const std::string userName = account->userName;
+    const std::string cookies = account->authToken;
+    if (modelCacheTtlSeconds_ <= 0) {
+        auto runtimeModels = std::make_shared<const RuntimeModelData>(fetchRuntimeModelData(cookies));
+        buildModelList(*runtimeModels);
+        return runtimeModels;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(runtimeModelMutex_);
+        auto it = runtimeModelCache_.find(userName);
+        if (it != runtimeModelCache_.end() && it->second.data && it->second.cookies == cookies) {
+            auto& cached = it->second;
+            if (std::chrono::steady_clock::now() - cached.fetchedAt < std::chrono::seconds(modelCacheTtlSeconds_) ||
+                cached.refreshing) {
+                return cached.data;
+            }
+
+            // 过期：先用旧数据完成本次请求，后台刷新
+            cached.refreshing = true;
+            BackgroundTaskQueue::instance().enqueue("nexos_runtime_models_refresh", [this, userName, cookies]() {
+                auto runtimeModels = fetchRuntimeModelData(cookies);
+                if (!runtimeModels.mapping.empty()) {
+                    storeRuntimeModels(userName, cookies, std::move(runtimeModels));
+                    return;
+                }
+                std::lock_guard<std::mutex> guard(runtimeModelMutex_);
+                auto entry = runtimeModelCache_.find(userName);
+                if (entry != runtimeModelCache_.end()) {
+                    entry->second.refreshing = false;
+                }
+            });
+            return cached.data;
+        }
+    }
+
+    return storeRuntimeModels(userName, cookies, fetchRuntimeModelData(cookies));
+}
+
+std::shared_ptr<const nexosapi::RuntimeModelData> nexosapi::storeRuntimeModels(
+    const std::string& userName,
+    const std::string& cookies,
+    RuntimeModelData runtimeModels
+)
+{
+    auto data = std::make_shared<const RuntimeModelData>(std::move(runtimeModels));
+    if (data->mapping.empty()) {
+        return data;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(runtimeModelMutex_);
+        auto& cached = runtimeModelCache_[userName];
+        cached.cookies = cookies;
+        cached.data = data;
+        cached.fetchedAt = std::chrono::steady_clock::now();
+        cached.refreshing = false;
+    }
+    buildModelList(*data);
+    return data;
+}
+
+void nexosapi::invalidateRuntimeModels(const std::string& userName)
+{
+    std::lock_guard<std::mutex> lock(runtimeModelMutex_);
+    runtimeModelCache_.erase(userName);
+}
+
 Json::Value nexosapi::buildModelList(const RuntimeModelData& runtimeModels)
 {
     std::lock_guard<std::mutex> lock(modelMutex_);
+    if (runtimeModels.models == modelListOpenAiFormat_) {
+        return modelListOpenAiFormat_;
+    }
+
     modelListOpenAiFormat_ = runtimeModels.models;
     if (!modelListOpenAiFormat_.isObject()) {
         modelListOpenAiFormat_ = Json::objectValue;
@@ -643,8 +588,9 @@ Json::Value nexosapi::getModels()
         return modelListOpenAiFormat_;
     }
 
-    const auto runtimeModels = fetchRuntimeModelData(account->authToken);
-    return buildModelList(runtimeModels);
+    runtimeModelsFor(account);
+    std::lock_guard<std::mutex> lock(modelMutex_);
+    return modelListOpenAiFormat_;
 }
 
 Json::Value nexosapi::buildQuotaResponse(const std::shared_ptr<Accountinfo_st>& account, const ChatDataPayload& payload) const
@@ -666,19 +612,13 @@ Json::Value nexosapi::buildQuotaResponse(const std::shared_ptr<Accountinfo_st>&
         return result;
     }
 
-    const Json::Value subscription =
-        payload.decoded["domains/auth/routes/LoggedInLayout"]["data"].isObject()
-            ? payload.decoded["domains/auth/routes/LoggedInLayout"]["data"]["subscription"]
-            : Json::Value();
+    const Json::Value subscription = payload.data.get({"domains/auth/routes/LoggedInLayout", "data", "subscription"});
 
     Json::Value quota(Json::objectValue);
     if (subscription.isObject()) {
-        if (subscription.isMember("status")) quota["status"] = sanitizeJsonValue(subscription["status"]);
-        if (subscription.isMember("subscription_type")) quota["subscription_type"] = sanitizeJsonValue(subscription["subscription_type"]);
-        if (subscription.isMember("start_at")) quota["start_at"] = sanitizeJsonValue(subscription["start_at"]);
-        if (subscription.isMember("end_at")) quota["end_at"] = sanitizeJsonValue(subscription["end_at"]);
-        if (subscription.isMember("enabled")) quota["enabled"] = sanitizeJsonValue(subscription["enabled"]);
-        if (subscription.isMember("auto_renew")) quota["auto_renew"] = sanitizeJsonValue(subscription["auto_renew"]);
+        for (const char* field : {"status", "subscription_type", "start_at", "end_at", "enabled", "auto_renew"}) {
+            if (subscription.isMember(field)) quota[field] = subscription[field];
+        }
         if (subscription.isMember("budget_used") &&
             (subscription["budget_used"].isDouble() || subscription["budget_used"].isInt() || subscription["budget_used"].isUInt())) {
             quota["budget_used"] = subscription["budget_used"];
@@ -689,6 +629,7 @@ Json::Value nexosapi::buildQuotaResponse(const std::shared_ptr<Accountinfo_st>&
     if (extractNumberAfterToken(payload.raw, "\"budget_used\"", budgetUsed)) {
         quota["budget_used_raw"] = budgetUsed;
     }
+    quota["budget_predicted_remaining"] = budget_.predictedRemaining(account->userName);
 
     int seatsUsed = 0;
     if (extractIntegerAfterToken(payload.raw, "\"seats_used\"", seatsUsed)) {
@@ -715,7 +656,7 @@ Json::Value nexosapi::buildQuotaResponse(const std::shared_ptr<Accountinfo_st>&
     }
 
     result["available"] = !quota.empty();
-    result["quota"] = sanitizeJsonValue(quota);
+    result["quota"] = quota;
     return result;
 }
 
@@ -733,9 +674,99 @@ Json::Value nexosapi::getAccountQuota(const std::string& userName)
     }
 
     const auto payload = fetchChatDataPayload(account->authToken);
+    double budgetUsed = 0;
+    if (extractBudgetUsed(payload.data, payload.raw, budgetUsed)) {
+        budget_.updateObserved(account->userName, budgetUsed);
+    }
+    if (modelCacheTtlSeconds_ > 0 && !payload.raw.empty()) {
+        storeRuntimeModels(account->userName, account->authToken, parseRuntimeModelData(payload));
+    }
     return buildQuotaResponse(account, payload);
 }
 
+void nexosapi::refreshAccountData()
+{
+    const auto accountList = AccountManager::getInstance().getAccountList();
+    auto apiIt = accountList.find("nexosapi");
+    if (apiIt == accountList.end()) {
+        return;
+    }
+
+    int refreshed = 0;
+    int lowBudget = 0;
+    std::set<std::string> usableUserNames;
+    for (const auto& [userName, account] : apiIt->second) {
+        if (!isUsableNexosAccount(account)) {
+            budget_.forget(userName);
+            continue;
+        }
+        usableUserNames.insert(userName);
+
+        // 同一份 chat.data 同时刷新预算基准与运行时模型缓存
+        const auto payload = fetchChatDataPayload(account->authToken);
+        if (payload.raw.empty()) {
+            continue;
+        }
+        if (modelCacheTtlSeconds_ > 0) {
+            storeRuntimeModels(userName, account->authToken, parseRuntimeModelData(payload));
+        }
+        double budgetUsed = 0;
+        if (!extractBudgetUsed(payload.data, payload.raw, budgetUsed)) {
+            continue;
+        }
+        budget_.updateObserved(userName, budgetUsed);
+        ++refreshed;
+        if (budget_.likelyExhausted(userName)) {
+            ++lowBudget;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(runtimeModelMutex_);
+        for (auto it = runtimeModelCache_.begin(); it != runtimeModelCache_.end();) {
+            it = usableUserNames.count(it->first) > 0 ? std::next(it) : runtimeModelCache_.erase(it);
+        }
+    }
+
+    LOG_DEBUG << "[nexosapi] 账号数据刷新完成: accounts=" << apiIt->second.size()
+              << ", refreshed=" << refreshed
+              << ", lowBudget=" << lowBudget;
+}
+
+void nexosapi::prewarmChats()
+{
+    auto& pool = UpstreamThreadPool::getInstance();
+    pool.evictStale();
+
+    int created = 0;
+    for (const auto& userName : pool.demandedAccounts("nexosapi")) {
+        std::shared_ptr<Accountinfo_st> account;
+        AccountManager::getInstance().getAccountByUserName("nexosapi", userName, account);
+        // 不可用、熔断或预算将尽的账号丢弃其预建；冷却或在途已满时本轮跳过
+        if (!isUsableNexosAccount(account) ||
+            AccountManager::getInstance().isAccountCircuitOpen("nexosapi", userName) ||
+            budget_.likelyExhausted(userName)) {
+            pool.dropAccount("nexosapi", userName);
+            continue;
+        }
+        if (!AccountThrottle::getInstance().isAvailable("nexosapi", userName)) {
+            continue;
+        }
+        for (int i = pool.deficit("nexosapi", userName); i > 0; --i) {
+            const auto chatId = createChatId(account->authToken);
+            if (chatId.empty()) {
+                break;
+            }
+            pool.add("nexosapi", userName, chatId);
+            ++created;
+        }
+    }
+
+    if (created > 0) {
+        LOG_DEBUG << "[nexosapi] 预建空 chat " << created << " 个";
+    }
+}
+
 provider::ProviderError nexosapi::classifyHttpError(int httpStatus, const std::string& message) const
 {
     if (httpStatus == 401 || httpStatus == 403) {
@@ -800,10 +831,12 @@ void nexosapi::markAccountBudgetExceeded(const std::shared_ptr<Accountinfo_st>&
         return;
     }
 
-    account->tokenStatus = false;
-    account->accountStatus = false;
-    account->accountType = "trial_budget_exceeded";
-    account->status = AccountStatus::DISABLED;
+    AccountManager::getInstance().mutateAccount(account, [](Accountinfo_st& info) {
+        info.tokenStatus = false;
+        info.accountStatus = false;
+        info.accountType = "trial_budget_exceeded";
+        info.status = AccountStatus::DISABLED;
+    });
 
     const bool backedUp = AccountBackupDbManager::getInstance()->backupAccount(
         *account,
@@ -876,25 +909,90 @@ std::string nexosapi::ensureChatId(const session_st& session, const std::shared_
         : session.state.conversationId;
 
     if (reuseExistingChat) {
-        std::lock_guard<std::mutex> lock(chatMutex_);
-        auto it = chatMap_.find(key);
-        if (it != chatMap_.end() &&
-            !it->second.chatId.empty() &&
-            it->second.accountUserName == account->userName) {
-            return it->second.chatId;
+        const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), key);
+        if (ctx &&
+            !ctx->get("chatId", "").asString().empty() &&
+            ctx->get("accountUserName", "").asString() == account->userName) {
+            return ctx->get("chatId", "").asString();
         }
     }
 
-    const std::string chatId = createChatId(account->authToken);
+    // 优先领取后台预建的空 chat，省去首轮创建 chat 的往返
+    std::string chatId;
+    if (auto pooled = UpstreamThreadPool::getInstance().claim("nexosapi", account->userName)) {
+        chatId = std::move(*pooled);
+        LOG_DEBUG << "[nexosapi] 领取预建 chat: userName=" << account->userName << ", chatId=" << chatId;
+    } else {
+        chatId = createChatId(account->authToken);
+    }
     if (chatId.empty()) {
         return "";
     }
 
-    std::lock_guard<std::mutex> lock(chatMutex_);
-    chatMap_[key] = ChatContext{chatId, account->userName};
+    Json::Value ctx(Json::objectValue);
+    ctx["chatId"] = chatId;
+    ctx["accountUserName"] = account->userName;
+    ProviderContextStore::getInstance().put(contextNamespace(), key, std::move(ctx));
     return chatId;
 }
 
+std::string nexosapi::chatToolBridgeDigest(const session_st& session)
+{
+    const std::string key = !session.provider.prevProviderKey.empty()
+        ? session.provider.prevProviderKey
+        : session.state.conversationId;
+
+    const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), key);
+    return ctx ? ctx->get("toolBridgeDigest", "").asString() : "";
+}
+
+void nexosapi::rememberChatToolBridgeDigest(const session_st& session)
+{
+    if (session.provider.toolBridgeDigest.empty()) {
+        return;
+    }
+
+    const std::string key = !session.provider.prevProviderKey.empty()
+        ? session.provider.prevProviderKey
+        : session.state.conversationId;
+
+    ProviderContextStore::getInstance().update(contextNamespace(), key, [&session](Json::Value& ctx) {
+        if (!ctx.isMember("chatId") ||
+            ctx.get("toolBridgeDigest", "").asString() == session.provider.toolBridgeDigest) {
+            return false;
+        }
+        ctx["toolBridgeDigest"] = session.provider.toolBridgeDigest;
+        return true;
+    });
+}
+
+std::string nexosapi::cachedLastMessageId(const session_st& session, const std::string& chatId)
+{
+    const std::string key = !session.provider.prevProviderKey.empty()
+        ? session.provider.prevProviderKey
+        : session.state.conversationId;
+
+    const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), key);
+    return ctx && ctx->get("chatId", "").asString() == chatId ? ctx->get("lastMessageId", "").asString() : "";
+}
+
+void nexosapi::rememberLastMessageId(const session_st& session, const std::string& chatId, const std::string& messageId)
+{
+    const std::string key = !session.provider.prevProviderKey.empty()
+        ? session.provider.prevProviderKey
+        : session.state.conversationId;
+
+    // 本轮未解析到 id 时也要清空旧值：chat 已追加新消息，旧 id 不再是最后一条
+    ProviderContextStore::getInstance().update(contextNamespace(), key, [&chatId, &messageId](Json::Value& ctx) {
+        if (ctx.get("chatId", "").asString() != chatId ||
+            ctx.get("lastMessageId", "").asString() == messageId) {
+            return false;
+        }
+        ctx["lastMessageId"] = messageId;
+        return true;
+    });
+}
+
 std::string nexosapi::resolveHandlerId(const RuntimeModelData& runtimeModels, const std::string& requestedModel) const
 {
     const std::string targetModel = requestedModel.empty() ? "nexos-chat" : requestedModel;
@@ -983,7 +1081,8 @@ std::string nexosapi::sendChatRequest(
     const std::string& userText,
     const std::string& lastMessageId,
     const std::string& cookies,
-    int& httpStatus
+    int& httpStatus,
+    const std::string& accountUserName
 ) const
 {
     Json::Value data(Json::objectValue);
@@ -1031,40 +1130,10 @@ std::string nexosapi::sendChatRequest(
     }
 
     httpStatus = static_cast<int>(response->statusCode());
+    provider::noteUpstreamRateLimit(response, "nexosapi", accountUserName);
     return std::string(response->getBody());
 }
 
-std::string nexosapi::extractTextFromSsePayload(const std::string& payload) const
-{
-    std::stringstream ss(payload);
-    std::string line;
-    std::string fullText;
-
-    while (std::getline(ss, line)) {
-        if (line.rfind("data: ", 0) != 0 || line.find("[DONE]") != std::string::npos) {
-            continue;
-        }
-
-        Json::CharReaderBuilder builder;
-        std::string errs;
-        Json::Value json;
-        std::istringstream input(line.substr(6));
-        if (!Json::parseFromStream(builder, input, &json, &errs)) {
-            continue;
-        }
-
-        if (json.get("content_type", "").asString() == "text" &&
-            json.isMember("content") &&
-            json["content"].isObject() &&
-            json["content"].isMember("text") &&
-            json["content"]["text"].isString()) {
-            fullText += json["content"]["text"].asString();
-        }
-    }
-
-    return fullText;
-}
-
 Json::Value nexosapi::fetchWhoamiPayload(const std::string& cookies) const
 {
     if (cookies.empty()) {
@@ -1119,9 +1188,13 @@ std::string nexosapi::extractEmailFromWhoami(const Json::Value& whoamiPayload) c
     return "";
 }
 
-std::string nexosapi::buildUserPrompt(const session_st& session, bool useExistingChat) const
+std::string nexosapi::buildUserPrompt(const session_st& session, bool useExistingChat, const std::string& knownToolBridgeDigest) const
 {
     if (useExistingChat) {
+        // chat 已持有同一份工具定义时只发送简短引用
+        if (toolcall::canReuseToolBridgeDefinitions(session, knownToolBridgeDigest)) {
+            return toolcall::toolBridgeReferenceMessage(session);
+        }
         return session.request.message;
     }
 
@@ -1136,7 +1209,17 @@ std::string nexosapi::buildUserPrompt(const session_st& session, bool useExistin
             prompt << "\n\n";
         }
         prompt << "接下来是 OpenAI 风格的历史消息，请继续保持上下文一致：\n";
-        prompt << jsonCompactString(session.provider.messageContext);
+        // 逐条序列化并按会话缓存，拼成的数组与整体序列化结果一致
+        const auto& history = session.provider.transcriptCache.render(
+            "nexos_history_json",
+            session.provider.messageContext,
+            [](TranscriptRender& out, const Json::Value& msg) {
+                if (!out.text.empty()) {
+                    out.text.push_back(',');
+                }
+                out.text += jsonCompactString(msg);
+            });
+        prompt << '[' << history.text << ']';
     }
 
     if (!session.request.message.empty()) {
@@ -1154,13 +1237,17 @@ provider::ProviderResult nexosapi::requestChatCompletion(session_st& session)
     std::set<std::string> excludedUserNames;
     std::string lastFailureMessage = "No available nexos account/cookies in account manager";
     int lastHttpStatus = 0;
+    // 只被本地限流拒绝、没有任何请求到达上游时，失败不计入渠道熔断
+    bool onlyLocalRejections = true;
 
     while (true) {
         bool reuseExistingChat = false;
         auto account = selectAccount(session, reuseExistingChat, excludedUserNames);
         if (!account) {
             if (lastHttpStatus > 0) {
-                return provider::ProviderResult::fail(classifyHttpError(lastHttpStatus, lastFailureMessage));
+                auto error = classifyHttpError(lastHttpStatus, lastFailureMessage);
+                error.localRejection = onlyLocalRejections;
+                return provider::ProviderResult::fail(error);
             }
             return provider::ProviderResult::fail(
                 provider::ProviderError::auth("No available nexos account/cookies in account manager")
@@ -1169,39 +1256,88 @@ provider::ProviderResult nexosapi::requestChatCompletion(session_st& session)
 
         excludedUserNames.insert(account->userName);
 
-        const auto runtimeModels = fetchRuntimeModelData(account->authToken);
-        buildModelList(runtimeModels);
+        auto accountLease = AccountThrottle::getInstance().tryBegin("nexosapi", account->userName);
+        if (!accountLease) {
+            // 选号与占用之间被并发请求占满或进入冷却，换下一个账号
+            lastFailureMessage = "Nexos account is cooling down or at its in-flight limit";
+            lastHttpStatus = 429;
+            continue;
+        }
+        // 未上报结果就离开本轮（如下方模型解析失败）时，析构归还半开探测名额
+        const auto accountProbe = AccountManager::getInstance().beginAccountProbe("nexosapi", account->userName);
 
-        const std::string handlerId = resolveHandlerId(runtimeModels, session.request.model);
+        const auto runtimeModels = runtimeModelsFor(account);
+        const std::string handlerId = resolveHandlerId(*runtimeModels, session.request.model);
         if (handlerId.empty()) {
             return provider::ProviderResult::fail(
                 provider::ProviderError::internal("Failed to resolve nexos model handler from runtime model list")
             );
         }
 
+        const auto attemptStart = std::chrono::steady_clock::now();
+        auto reportAttempt = [&account, attemptStart](bool success) {
+            const double latencyMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - attemptStart).count();
+            AccountManager::getInstance().reportAccountResult("nexosapi", account->userName, latencyMs, success);
+        };
+
+        onlyLocalRejections = false;
         const std::string chatId = ensureChatId(session, account, reuseExistingChat);
         if (chatId.empty()) {
+            reportAttempt(false);
             lastFailureMessage = "Failed to create nexos chat";
             lastHttpStatus = 0;
             continue;
         }
 
-        const std::string lastMessageId = reuseExistingChat
-            ? fetchLastMessageId(chatId, account->authToken)
-            : "";
-        const std::string prompt = buildUserPrompt(session, reuseExistingChat);
+        // 续聊优先使用上一轮响应里记下的消息 id，缺失时才查询历史
+        std::string lastMessageId;
+        bool lastMessageIdCached = false;
+        if (reuseExistingChat) {
+            lastMessageId = cachedLastMessageId(session, chatId);
+            lastMessageIdCached = !lastMessageId.empty();
+            if (!lastMessageIdCached) {
+                lastMessageId = fetchLastMessageId(chatId, account->authToken);
+            }
+        }
+        const std::string prompt = buildUserPrompt(
+            session,
+            reuseExistingChat,
+            reuseExistingChat ? chatToolBridgeDigest(session) : ""
+        );
 
         int httpStatus = 0;
-        const std::string raw = sendChatRequest(
+        std::string raw = sendChatRequest(
             chatId,
             handlerId,
             prompt,
             lastMessageId,
             account->authToken,
-            httpStatus
+            httpStatus,
+            account->userName
         );
 
+        if (lastMessageIdCached && httpStatus >= 400 && httpStatus < 500 &&
+            httpStatus != 429 && !isBudgetExceededResponse(httpStatus, raw)) {
+            // 缓存的 last_message_id 被拒绝（如 chat 在别处被续写），查询历史后重发一次
+            const std::string fetchedMessageId = fetchLastMessageId(chatId, account->authToken);
+            if (!fetchedMessageId.empty() && fetchedMessageId != lastMessageId) {
+                LOG_WARN << "[nexosapi] 缓存的 last_message_id 被拒绝，按历史记录重发: chatId=" << chatId
+                         << ", status=" << httpStatus;
+                raw = sendChatRequest(
+                    chatId,
+                    handlerId,
+                    prompt,
+                    fetchedMessageId,
+                    account->authToken,
+                    httpStatus,
+                    account->userName
+                );
+            }
+        }
+
         if (httpStatus != 200) {
+            reportAttempt(false);
             std::string message = "Nexos upstream returned error";
             if (!raw.empty()) {
                 message += ": " + raw.substr(0, 500);
@@ -1212,20 +1348,37 @@ provider::ProviderResult nexosapi::requestChatCompletion(session_st& session)
 
             if (isBudgetExceededResponse(httpStatus, raw)) {
                 markAccountBudgetExceeded(account);
+                budget_.forget(account->userName);
                 LOG_WARN << "[nexosapi] 检测到预算耗尽，切换账号重试: userName=" << account->userName;
                 continue;
             }
+            if (httpStatus == 429) {
+                // 账号已按 Retry-After 进入冷却，换号重试
+                LOG_WARN << "[nexosapi] 上游限流，切换账号重试: userName=" << account->userName;
+                continue;
+            }
+
+            // 缓存的 handler 可能已失效，下次请求重新拉取
+            invalidateRuntimeModels(account->userName);
 
             return provider::ProviderResult::fail(classifyHttpError(httpStatus, message));
         }
 
-        const std::string text = extractTextFromSsePayload(raw);
+        NexosSseParser sse;
+        sse.feed(raw);
+        sse.finish();
+        const std::string& text = sse.text();
+        rememberLastMessageId(session, chatId, sse.messageId());
+        reportAttempt(!text.empty());
+        budget_.addEstimatedUsage(account->userName, prompt.size() + text.size());
         if (text.empty()) {
             provider::ProviderError err = provider::ProviderError::internal("Nexos returned empty response");
             err.httpStatusCode = 502;
             return provider::ProviderResult::fail(err);
         }
 
+        rememberChatToolBridgeDigest(session);
+
         provider::ProviderResult result = provider::ProviderResult::success(text);
         result.rawResponse = raw;
         return result;
@@ -1240,25 +1393,3 @@ provider::ProviderResult nexosapi::generate(session_st& session)
 void nexosapi::afterResponseProcess(session_st&)
 {
 }
-
-void nexosapi::eraseChatinfoMap(std::string conversationId)
-{
-    std::lock_guard<std::mutex> lock(chatMutex_);
-    chatMap_.erase(conversationId);
-}
-
-void nexosapi::transferThreadContext(const std::string& oldId, const std::string& newId)
-{
-    if (oldId.empty() || newId.empty() || oldId == newId) {
-        return;
-    }
-
-    std::lock_guard<std::mutex> lock(chatMutex_);
-    auto it = chatMap_.find(oldId);
-    if (it == chatMap_.end()) {
-        return;
-    }
-
-    chatMap_[newId] = it->second;
-    chatMap_.erase(it);
-}
@@ -3,6 +3,11 @@
 
 #include <apipoint/APIinterface.h>
 #include <apiManager/ApiFactory.h>
+#include "NexosBudgetTracker.h"
+#include "NexosSerializedData.h"
+#include "NexosSseParser.h"
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <regex>
@@ -27,17 +32,16 @@ class nexosapi : public APIinterface
     Json::Value getAccountQuota(const std::string& userName = "");
     void init() override;
     void afterResponseProcess(session_st& session) override;
-    void eraseChatinfoMap(std::string conversationId) override;
-    void transferThreadContext(const std::string& oldId, const std::string& newId) override;
+
+  protected:
+    // chat 上下文保存在 ProviderContextStore 的 nexosapi 命名空间下，字段：
+    // chatId、accountUserName、toolBridgeDigest（该 chat 已收到的工具定义块指纹）、
+    // lastMessageId（上一轮 SSE 响应中的消息 id，续聊时作为 last_message_id）
+    std::string contextNamespace() const override { return "nexosapi"; }
 
   private:
     DEClARE_RUNTIME(nexosapi);
 
-    struct ChatContext {
-        std::string chatId;
-        std::string accountUserName;
-    };
-
     struct RuntimeModelData {
         std::unordered_map<std::string, std::string> mapping;
         Json::Value models{Json::objectValue};
@@ -47,7 +51,14 @@ class nexosapi : public APIinterface
 
     struct ChatDataPayload {
         std::string raw;
-        Json::Value decoded;
+        NexosSerializedData data;
+    };
+
+    struct CachedRuntimeModels {
+        std::string cookies;
+        std::shared_ptr<const RuntimeModelData> data;
+        std::chrono::steady_clock::time_point fetchedAt;
+        bool refreshing = false;
     };
 
     provider::ProviderResult requestChatCompletion(session_st& session);
@@ -63,7 +74,25 @@ class nexosapi : public APIinterface
     std::shared_ptr<Accountinfo_st> selectAccountByUserName(const std::string& userName);
     ChatDataPayload fetchChatDataPayload(const std::string& cookies) const;
     RuntimeModelData fetchRuntimeModelData(const std::string& cookies);
-    std::string buildUserPrompt(const session_st& session, bool useExistingChat) const;
+    RuntimeModelData parseRuntimeModelData(const ChatDataPayload& payload) const;
+    /**
+     * @brief 读取账号的运行时模型数据（按账号缓存）
+     *
+     * TTL 内直接返回缓存；过期后先返回旧数据并在后台刷新；无缓存或 cookies 变化时同步拉取。
+     */
+    std::shared_ptr<const RuntimeModelData> runtimeModelsFor(const std::shared_ptr<Accountinfo_st>& account);
+    /// 写入缓存并在模型列表变化时重建；解析结果为空时不缓存
+    std::shared_ptr<const RuntimeModelData> storeRuntimeModels(
+        const std::string& userName,
+        const std::string& cookies,
+        RuntimeModelData runtimeModels
+    );
+    void invalidateRuntimeModels(const std::string& userName);
+    std::string buildUserPrompt(const session_st& session, bool useExistingChat, const std::string& knownToolBridgeDigest = "") const;
+    std::string chatToolBridgeDigest(const session_st& session);
+    void rememberChatToolBridgeDigest(const session_st& session);
+    std::string cachedLastMessageId(const session_st& session, const std::string& chatId);
+    void rememberLastMessageId(const session_st& session, const std::string& chatId, const std::string& messageId);
     std::string ensureChatId(const session_st& session, const std::shared_ptr<Accountinfo_st>& account, bool reuseExistingChat);
     std::string createChatId(const std::string& cookies) const;
     std::string resolveHandlerId(const RuntimeModelData& runtimeModels, const std::string& requestedModel) const;
@@ -74,14 +103,14 @@ class nexosapi : public APIinterface
         const std::string& userText,
         const std::string& lastMessageId,
         const std::string& cookies,
-        int& httpStatus
+        int& httpStatus,
+        const std::string& accountUserName = ""
     ) const;
     std::string buildMultipartBody(
         const std::string& boundary,
         const std::string& chatId,
         const Json::Value& data
     ) const;
-    std::string extractTextFromSsePayload(const std::string& payload) const;
     std::string extractChatIdFromChatData(const std::string& body) const;
     bool isBudgetExceededResponse(int httpStatus, const std::string& body) const;
     void markAccountBudgetExceeded(const std::shared_ptr<Accountinfo_st>& account) const;
@@ -89,13 +118,23 @@ class nexosapi : public APIinterface
     std::string extractEmailFromWhoami(const Json::Value& whoamiPayload) const;
     Json::Value buildModelList(const RuntimeModelData& runtimeModels);
     Json::Value buildQuotaResponse(const std::shared_ptr<Accountinfo_st>& account, const ChatDataPayload& payload) const;
+    /// 后台刷新所有 nexos 账号的 budget_used（预算预测基准）与运行时模型缓存
+    void refreshAccountData();
+    /// 按最近新会话需求为可用账号预建空 chat，供 ensureChatId 直接领取
+    void prewarmChats();
 
     std::string baseUrl_;
     mutable std::mutex modelMutex_;
     Json::Value modelListOpenAiFormat_{Json::objectValue};
 
-    std::mutex chatMutex_;
-    std::unordered_map<std::string, ChatContext> chatMap_;
+    std::mutex runtimeModelMutex_;
+    std::unordered_map<std::string, CachedRuntimeModels> runtimeModelCache_;
+    int modelCacheTtlSeconds_ = 300;
+
+    NexosBudgetTracker budget_;
+    int accountRefreshIntervalSeconds_ = 300;
+    std::atomic<bool> accountRefreshRunning_{false};
+    std::atomic<bool> chatPrewarmRunning_{false};
 };
 
 #endif
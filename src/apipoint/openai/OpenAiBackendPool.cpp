@@ -0,0 +1,149 @@
+#include "OpenAiBackendPool.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+OpenAiBackendPool::Backend parseBackend(const Json::Value& node, const std::string& defaultName) {
+    OpenAiBackendPool::Backend backend;
+    backend.name = node.get("name", defaultName).asString();
+    backend.baseUrl = node.get("base_url", "https://api.openai.com").asString();
+    backend.apiKey = node.get("api_key", "").asString();
+    backend.weight = node.get("weight", 1.0).asDouble();
+    if (node.isMember("models") && node["models"].isArray()) {
+        for (const auto& model : node["models"]) {
+            if (model.isString() && !model.asString().empty()) {
+                backend.models.insert(model.asString());
+            }
+        }
+    }
+    return backend;
+}
+
+} // 匿名命名空间
+
+std::vector<OpenAiBackendPool::Backend> OpenAiBackendPool::parseConfig(const Json::Value& openaiConfig,
+                                                                      std::vector<std::string>* warnings) {
+    std::vector<Backend> backends;
+    if (!openaiConfig.isObject()) {
+        return backends;
+    }
+    if (openaiConfig.isMember("backends") && openaiConfig["backends"].isArray() && !openaiConfig["backends"].empty()) {
+        std::set<std::string> names;
+        for (Json::ArrayIndex i = 0; i < openaiConfig["backends"].size(); ++i) {
+            const auto& node = openaiConfig["backends"][i];
+            if (!node.isObject()) {
+                continue;
+            }
+            auto backend = parseBackend(node, "backend-" + std::to_string(i));
+            if (backend.apiKey.empty() || backend.weight <= 0) {
+                continue;
+            }
+            if (!names.insert(backend.name).second) {
+                if (warnings) {
+                    warnings->push_back("backends[" + std::to_string(i) + "] 名称重复，已跳过: " + backend.name);
+                }
+                continue;
+            }
+            backends.push_back(std::move(backend));
+        }
+        return backends;
+    }
+    auto backend = parseBackend(openaiConfig, "default");
+    if (!backend.apiKey.empty()) {
+        backend.weight = 1.0;
+        backends.push_back(std::move(backend));
+    }
+    return backends;
+}
+
+void OpenAiBackendPool::setBackends(std::vector<Backend> backends) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    backends_ = std::move(backends);
+    states_.assign(backends_.size(), State{});
+}
+
+std::vector<OpenAiBackendPool::Backend> OpenAiBackendPool::backends() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return backends_;
+}
+
+bool OpenAiBackendPool::empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return backends_.empty();
+}
+
+bool OpenAiBackendPool::servesModel(const Backend& backend, const std::string& model) {
+    return backend.models.empty() || model.empty() || backend.models.count(model) > 0;
+}
+
+bool OpenAiBackendPool::supports(const std::string& model) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::any_of(backends_.begin(), backends_.end(),
+                       [&model](const Backend& backend) { return servesModel(backend, model); });
+}
+
+std::optional<OpenAiBackendPool::Selection> OpenAiBackendPool::pick(const std::string& model, const Filter& accept) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::optional<size_t> best;
+    double bestScore = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < backends_.size(); ++i) {
+        const auto& backend = backends_[i];
+        if (!servesModel(backend, model)) {
+            continue;
+        }
+        if (accept && !accept(backend)) {
+            continue;
+        }
+        const auto& state = states_[i];
+        const double latency = state.latencyMs > 0 ? state.latencyMs : kInitialLatencyMs;
+        const double score = static_cast<double>(state.inFlight + 1) * latency / backend.weight;
+        if (score < bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+    if (!best) {
+        return std::nullopt;
+    }
+    return Selection{*best, backends_[*best]};
+}
+
+void OpenAiBackendPool::begin(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index < states_.size()) {
+        ++states_[index].inFlight;
+    }
+}
+
+void OpenAiBackendPool::finish(size_t index, double latencyMs, bool success) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= states_.size()) {
+        return;
+    }
+    auto& state = states_[index];
+    if (state.inFlight > 0) {
+        --state.inFlight;
+    }
+    if (!success) {
+        const double current = state.latencyMs > 0 ? state.latencyMs : kInitialLatencyMs;
+        state.latencyMs = std::min(std::max(current, latencyMs) * kFailurePenalty, kMaxLatencyMs);
+        return;
+    }
+    if (latencyMs > 0) {
+        state.latencyMs = state.latencyMs > 0
+            ? state.latencyMs * (1.0 - kLatencyAlpha) + latencyMs * kLatencyAlpha
+            : latencyMs;
+    }
+}
+
+size_t OpenAiBackendPool::inFlight(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index < states_.size() ? states_[index].inFlight : 0;
+}
+
+double OpenAiBackendPool::latencyMs(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index < states_.size() ? states_[index].latencyMs : 0.0;
+}
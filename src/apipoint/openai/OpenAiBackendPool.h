@@ -0,0 +1,82 @@
+#ifndef OPENAI_BACKEND_POOL_H
+#define OPENAI_BACKEND_POOL_H
+
+#include <json/json.h>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief OpenAI 兼容上游的 (base_url, api_key) 后端列表与选择策略
+ *
+ * 每个后端可配置权重与支持的模型列表（为空表示不限）。选择时在支持该模型、
+ * 且未被调用方排除（如 key 处于 429 冷却）的后端中，取
+ * (在途数 + 1) * 平滑延迟 / 权重 最小者；尚无延迟样本的后端按 kInitialLatencyMs 计，
+ * 新加入的后端因此也能分到流量。失败（常常很快返回）不计入延迟样本，而是把平滑延迟
+ * 放大 kFailurePenalty 倍（不超过 kMaxLatencyMs），持续出错的后端随之少分流量，成功后逐步恢复。
+ */
+class OpenAiBackendPool {
+public:
+    struct Backend {
+        std::string name;       // 用作限流冷却的账号名
+        std::string baseUrl;
+        std::string apiKey;
+        double weight = 1.0;
+        std::set<std::string> models;  // 配置的模型列表，为空表示不限
+    };
+
+    struct Selection {
+        size_t index = 0;
+        Backend backend;
+    };
+
+    using Filter = std::function<bool(const Backend&)>;
+
+    static constexpr double kInitialLatencyMs = 1000.0;
+    static constexpr double kLatencyAlpha = 0.2;
+    static constexpr double kFailurePenalty = 2.0;
+    static constexpr double kMaxLatencyMs = 60000.0;
+
+    /**
+     * @brief 从 providers.openai 配置解析后端
+     *
+     * 优先读取非空的 backends 数组；未配置时兼容单个 api_key / base_url（名称为 default）。
+     * 缺少 api_key 的条目被跳过；名称与前面条目重复的条目也被跳过（名称是限流冷却与
+     * 选择排除的键，重复会让两个后端共用冷却状态），原因写入 warnings 由调用方记录。
+     */
+    static std::vector<Backend> parseConfig(const Json::Value& openaiConfig,
+                                            std::vector<std::string>* warnings = nullptr);
+
+    void setBackends(std::vector<Backend> backends);
+    std::vector<Backend> backends() const;
+    bool empty() const;
+    /// 是否有后端声明支持该模型（模型列表为空视为支持）
+    bool supports(const std::string& model) const;
+
+    /// 选出负载最低的后端；accept 返回 false 的后端不参与，无可用后端时返回 nullopt
+    std::optional<Selection> pick(const std::string& model, const Filter& accept = nullptr) const;
+
+    void begin(size_t index);
+    /// 请求结束：在途数减一；success 时按 latencyMs 更新平滑延迟，失败时按 kFailurePenalty 放大
+    void finish(size_t index, double latencyMs, bool success);
+
+    size_t inFlight(size_t index) const;
+    double latencyMs(size_t index) const;
+
+private:
+    static bool servesModel(const Backend& backend, const std::string& model);
+
+    struct State {
+        size_t inFlight = 0;
+        double latencyMs = 0.0;  // 0 表示尚无样本
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<Backend> backends_;
+    std::vector<State> states_;
+};
+
+#endif
@@ -2,11 +2,23 @@
 #include <drogon/drogon.h>
 #include <apipoint/ProviderResult.h>
 #include <apiManager/ApiManager.h>
+#include <apipoint/UpstreamRateLimit.h>
+#include <chrono>
+#include <set>
 
 using namespace drogon;
 
 IMPLEMENT_RUNTIME(OpenAiProvider, OpenAiProvider);
 
+namespace {
+// 限流冷却与在途上限按后端名计（每个 api_key 一个后端）
+constexpr const char* kThrottleProvider = "OpenAiProvider";
+
+double elapsedMsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
 OpenAiProvider::OpenAiProvider() = default;
 OpenAiProvider::~OpenAiProvider() = default;
 
@@ -21,53 +33,132 @@ void OpenAiProvider::init() {
     if (customConfig.isMember("providers") && customConfig["providers"].isObject() &&
         customConfig["providers"].isMember("openai") && customConfig["providers"]["openai"].isObject()) {
         const auto& openai = customConfig["providers"]["openai"];
-        apiKey_ = openai.get("api_key", "").asString();
-        baseUrl_ = openai.get("base_url", "https://api.openai.com").asString();
+        std::vector<std::string> warnings;
+        backendPool_.setBackends(OpenAiBackendPool::parseConfig(openai, &warnings));
+        for (const auto& warning : warnings) {
+            LOG_WARN << "[OpenAi上游] " << warning;
+        }
         defaultModel_ = openai.get("default_model", "gpt-4o-mini").asString();
     } else {
-        apiKey_.clear();
-        baseUrl_ = "https://api.openai.com";
+        backendPool_.setBackends({});
         defaultModel_ = "gpt-4o-mini";
     }
 
+    for (const auto& backend : backendPool_.backends()) {
+        LOG_INFO << "[OpenAi上游] 后端: " << backend.name << ", base_url=" << backend.baseUrl
+                 << ", weight=" << backend.weight << ", models=" << backend.models.size();
+    }
+
     checkModels();
 }
 
 provider::ProviderResult OpenAiProvider::requestChatCompletions(session_st& session) {
-    if (apiKey_.empty()) {
+    if (backendPool_.empty()) {
         return provider::ProviderResult::fail(provider::ProviderError::auth("OpenAI API key not configured"));
     }
 
-    auto client = HttpClient::newHttpClient(baseUrl_);
+    const Json::Value body = buildChatRequest(session);
+    const std::string model = body["model"].asString();
+    if (!backendPool_.supports(model)) {
+        provider::ProviderError err{provider::ProviderErrorCode::InvalidRequest,
+                                    "No OpenAI backend configured for model: " + model, "", 400};
+        return provider::ProviderResult::fail(err);
+    }
+
+    auto& throttle = AccountThrottle::getInstance();
+    std::set<std::string> tried;
+    std::optional<provider::ProviderResult> lastFailure;
+    while (true) {
+        // 跳过已尝试过的、以及处于 429 冷却或在途已满的后端
+        const auto now = AccountThrottle::Clock::now();
+        auto selection = backendPool_.pick(model, [&](const OpenAiBackendPool::Backend& backend) {
+            return tried.count(backend.name) == 0 && throttle.isAvailable(kThrottleProvider, backend.name, now);
+        });
+        if (!selection) {
+            break;
+        }
+        const auto& backend = selection->backend;
+        tried.insert(backend.name);
+
+        auto throttleLease = throttle.tryBegin(kThrottleProvider, backend.name);
+        if (!throttleLease) {
+            continue;
+        }
+
+        backendPool_.begin(selection->index);
+        const auto startedAt = std::chrono::steady_clock::now();
+        bool retryable = false;
+        auto result = sendChatCompletion(backend, body, retryable);
+        backendPool_.finish(selection->index, elapsedMsSince(startedAt), !result.error.hasError());
+
+        if (!result.error.hasError() || !retryable) {
+            return result;
+        }
+        LOG_WARN << "[OpenAi上游] 后端 " << backend.name << " 请求失败，尝试下一个后端: " << result.error.message;
+        lastFailure = std::move(result);
+    }
+
+    if (lastFailure) {
+        return *lastFailure;
+    }
+
+    // 所有支持该模型的后端都在冷却或在途已满，报告最短剩余冷却
+    double remaining = -1;
+    for (const auto& backend : backendPool_.backends()) {
+        const double cooldown = throttle.cooldownRemaining(kThrottleProvider, backend.name);
+        if (cooldown > 0 && (remaining < 0 || cooldown < remaining)) {
+            remaining = cooldown;
+        }
+    }
+    return provider::ProviderResult::fail(provider::ProviderError::localThrottle(
+        remaining > 0 ? "All OpenAI backends are cooling down after upstream 429 (" + std::to_string(static_cast<int>(remaining + 0.999)) + "s left)"
+                      : "All OpenAI backends reached their in-flight request limit"));
+}
+
+provider::ProviderResult OpenAiProvider::sendChatCompletion(const OpenAiBackendPool::Backend& backend,
+                                                            const Json::Value& body,
+                                                            bool& retryable) {
+    retryable = false;
+    auto client = HttpClient::newHttpClient(backend.baseUrl);
     if (!client) {
         return provider::ProviderResult::fail(provider::ProviderError::network("Failed to create HTTP client"));
     }
 
-    auto req = HttpRequest::newHttpJsonRequest(buildChatRequest(session));
+    auto req = HttpRequest::newHttpJsonRequest(body);
     req->setMethod(Post);
     req->setPath("/v1/chat/completions");
-    req->addHeader("Authorization", "Bearer " + apiKey_);
+    req->addHeader("Authorization", "Bearer " + backend.apiKey);
 
     auto [result, resp] = client->sendRequest(req);
     if (result != ReqResult::Ok || !resp) {
+        retryable = true;
         return provider::ProviderResult::fail(provider::ProviderError::network("OpenAI request failed"));
     }
 
+    const bool rateLimited = provider::noteUpstreamRateLimit(resp, kThrottleProvider, backend.name);
+    const int status = static_cast<int>(resp->statusCode());
+    retryable = rateLimited || status >= 500;
+
     auto json = resp->getJsonObject();
     if (!json) {
+        if (rateLimited) {
+            return provider::ProviderResult::fail(provider::ProviderError::rateLimited("OpenAI API rate limited"));
+        }
         provider::ProviderError err = provider::ProviderError::internal("OpenAI response JSON parse failed");
-        err.httpStatusCode = static_cast<int>(resp->statusCode());
+        err.httpStatusCode = status;
         return provider::ProviderResult::fail(err);
     }
 
     if (resp->statusCode() != k200OK) {
         provider::ProviderError err;
-        err.code = provider::ProviderErrorCode::Unknown;
-        err.httpStatusCode = static_cast<int>(resp->statusCode());
+        err.code = rateLimited ? provider::ProviderErrorCode::RateLimited : provider::ProviderErrorCode::Unknown;
+        err.httpStatusCode = status;
         err.message = (*json).get("error", Json::Value(Json::objectValue)).get("message", "OpenAI API error").asString();
         return provider::ProviderResult::fail(err);
     }
 
+    AccountThrottle::getInstance().noteSuccess(kThrottleProvider, backend.name);
+
     provider::ProviderResult out;
     out.statusCode = 200;
 
@@ -116,11 +207,17 @@ Json::Value OpenAiProvider::buildChatRequest(const session_st& session) const {
         messages.append(systemMsg);
     }
 
-    for (const auto& m : session.provider.messageContext) {
-        if (!m.isObject()) continue;
-        Json::Value msg;
-        msg["role"] = m.get("role", "user").asString();
-        msg["content"] = m.get("content", "").asString();
+    const auto& history = session.provider.transcriptCache.render(
+        "openai_chat_messages",
+        session.provider.messageContext,
+        [](TranscriptRender& out, const Json::Value& m) {
+            if (!m.isObject()) return;
+            Json::Value msg;
+            msg["role"] = m.get("role", "user").asString();
+            msg["content"] = m.get("content", "").asString();
+            out.items.append(std::move(msg));
+        });
+    for (const auto& msg : history.items) {
         messages.append(msg);
     }
 
@@ -179,36 +276,66 @@ provider::ProviderResult OpenAiProvider::generate(session_st& session) {
 }
 
 void OpenAiProvider::checkAlivableTokens() {
-    if (apiKey_.empty()) {
+    if (backendPool_.empty()) {
         LOG_WARN << "[OpenAi上游] api_key 未配置，跳过 可用性检测";
     }
 }
 
-void OpenAiProvider::checkModels() {
-    if (apiKey_.empty()) {
-        return;
+Json::Value OpenAiProvider::fetchBackendModels(const OpenAiBackendPool::Backend& backend) const {
+    Json::Value models(Json::arrayValue);
+    if (!backend.models.empty()) {
+        for (const auto& id : backend.models) {
+            Json::Value item(Json::objectValue);
+            item["id"] = id;
+            models.append(item);
+        }
+        return models;
     }
 
-    auto client = HttpClient::newHttpClient(baseUrl_);
-    if (!client) return;
+    auto client = HttpClient::newHttpClient(backend.baseUrl);
+    if (!client) return models;
 
     auto req = HttpRequest::newHttpRequest();
     req->setMethod(Get);
     req->setPath("/v1/models");
-    req->addHeader("Authorization", "Bearer " + apiKey_);
+    req->addHeader("Authorization", "Bearer " + backend.apiKey);
 
     auto [result, resp] = client->sendRequest(req);
     if (result != ReqResult::Ok || !resp || resp->statusCode() != k200OK) {
-        return;
+        LOG_WARN << "[OpenAi上游] 后端 " << backend.name << " 拉取模型列表失败";
+        return models;
     }
 
     auto json = resp->getJsonObject();
     if (!json || !(*json).isMember("data") || !(*json)["data"].isArray()) {
+        return models;
+    }
+    return (*json)["data"];
+}
+
+void OpenAiProvider::checkModels() {
+    const auto backends = backendPool_.backends();
+    if (backends.empty()) {
+        return;
+    }
+
+    // 合并各后端的模型列表，按 id 去重
+    Json::Value merged(Json::arrayValue);
+    std::set<std::string> seen;
+    for (const auto& backend : backends) {
+        for (const auto& item : fetchBackendModels(backend)) {
+            const std::string id = item.get("id", "").asString();
+            if (!id.empty() && seen.insert(id).second) {
+                merged.append(item);
+            }
+        }
+    }
+    if (merged.empty()) {
         return;
     }
 
     std::lock_guard<std::mutex> lock(modelMutex_);
-    modelList_ = (*json)["data"];
+    modelList_ = merged;
 
     modelListOpenAiFormat_ = Json::Value(Json::objectValue);
     modelListOpenAiFormat_["object"] = "list";
@@ -233,9 +360,3 @@ Json::Value OpenAiProvider::getModels() {
 
 void OpenAiProvider::afterResponseProcess(session_st&) {
 }
-
-void OpenAiProvider::eraseChatinfoMap(std::string) {
-}
-
-void OpenAiProvider::transferThreadContext(const std::string&, const std::string&) {
-}
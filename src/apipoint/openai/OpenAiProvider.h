@@ -3,6 +3,7 @@
 
 #include <apipoint/APIinterface.h>
 #include <apiManager/ApiFactory.h>
+#include <apipoint/openai/OpenAiBackendPool.h>
 #include <mutex>
 #include <string>
 
@@ -20,17 +21,20 @@ public:
     Json::Value getModels() override;
     void init() override;
     void afterResponseProcess(session_st& session) override;
-    void eraseChatinfoMap(std::string conversationId) override;
-    void transferThreadContext(const std::string& oldId, const std::string& newId) override;
 
 private:
     DEClARE_RUNTIME(OpenAiProvider);
 
     provider::ProviderResult requestChatCompletions(session_st& session);
+    /// 向单个后端发送请求；retryable 表示失败可换下一个后端重试（网络错误、429、5xx）
+    provider::ProviderResult sendChatCompletion(const OpenAiBackendPool::Backend& backend,
+                                                const Json::Value& body,
+                                                bool& retryable);
     Json::Value buildChatRequest(const session_st& session) const;
+    /// 拉取单个后端的模型列表：配置了 models 时直接使用，否则请求 /v1/models
+    Json::Value fetchBackendModels(const OpenAiBackendPool::Backend& backend) const;
 
-    std::string apiKey_;
-    std::string baseUrl_;
+    OpenAiBackendPool backendPool_;
     std::string defaultModel_;
 
     std::mutex modelMutex_;
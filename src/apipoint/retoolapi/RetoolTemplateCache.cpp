@@ -0,0 +1,178 @@
+#include "RetoolTemplateCache.h"
+
+#include <iterator>
+
+namespace
+{
+constexpr size_t kPruneThreshold = 256;
+}  // namespace
+
+std::shared_ptr<RetoolCompiledTemplate> RetoolCompiledTemplate::compile(Json::Value patchedWorkflow, bool cloned)
+{
+    auto compiled = std::make_shared<RetoolCompiledTemplate>();
+    const auto data = patchedWorkflow.get("templateData", "").asString();
+    const std::string slot = kPromptSlot;
+    const auto pos = data.find(slot);
+    if (pos == std::string::npos)
+    {
+        compiled->dataPrefix = data;
+    }
+    else
+    {
+        compiled->hasPromptSlot = true;
+        compiled->dataPrefix = data.substr(0, pos);
+        compiled->dataSuffix = data.substr(pos + slot.size());
+    }
+    compiled->cloned = cloned;
+    if (cloned)
+    {
+        patchedWorkflow.removeMember("templateData");
+        compiled->workflow = std::move(patchedWorkflow);
+    }
+    compiled->compiledAt = std::chrono::steady_clock::now();
+    return compiled;
+}
+
+void RetoolCompiledTemplate::overlayDestinationFields(Json::Value& workflow, const Json::Value& destination)
+{
+    static const char* const kKeys[] = {
+        "id", "saveId", "apiKey", "folderId", "createdAt", "updatedAt", "createdBy", "accessLevel", "releaseId",
+        "organizationId", "name", "description"};
+    for (const auto* key : kKeys)
+    {
+        if (destination.isMember(key))
+        {
+            workflow[key] = destination[key];
+        }
+    }
+}
+
+std::string RetoolCompiledTemplate::renderTemplateData(const std::string& encodedPrompt) const
+{
+    if (!hasPromptSlot)
+    {
+        return dataPrefix;
+    }
+    std::string data;
+    data.reserve(dataPrefix.size() + encodedPrompt.size() + dataSuffix.size());
+    data.append(dataPrefix).append(encodedPrompt).append(dataSuffix);
+    return data;
+}
+
+Json::Value RetoolCompiledTemplate::render(const Json::Value& destination, const std::string& encodedPrompt) const
+{
+    Json::Value out = cloned ? workflow : destination;
+    if (cloned)
+    {
+        overlayDestinationFields(out, destination);
+    }
+    out["templateData"] = renderTemplateData(encodedPrompt);
+    return out;
+}
+
+std::string RetoolTemplateCache::keyOf(const std::string& workspaceId, const std::string& route, const std::string& model)
+{
+    return workspaceId + "|" + route + "|" + model;
+}
+
+std::string RetoolTemplateCache::fingerprintOf(const Json::Value& workspaceJson)
+{
+    // 只取影响模板编译与资源绑定的字段；updatedAt 会随使用状态写回而变化，不参与
+    static const char* const kFields[] = {
+        "baseUrl", "workflowId", "agentId",
+        "openaiResourceUuid", "openaiResourceName", "anthropicResourceUuid", "anthropicResourceName"};
+    std::string fingerprint;
+    for (const auto* field : kFields)
+    {
+        fingerprint += workspaceJson.get(field, "").asString();
+        fingerprint.push_back('\x1f');
+    }
+    return fingerprint;
+}
+
+void RetoolTemplateCache::setTtl(std::chrono::seconds ttl)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = ttl;
+    if (ttl_.count() <= 0)
+    {
+        templates_.clear();
+        resourceFetches_.clear();
+    }
+}
+
+std::chrono::seconds RetoolTemplateCache::ttl() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ttl_;
+}
+
+std::shared_ptr<const RetoolCompiledTemplate> RetoolTemplateCache::get(const std::string& key,
+                                                                       const std::string& fingerprint,
+                                                                       Clock::time_point now) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = templates_.find(key);
+    if (it == templates_.end() || ttl_.count() <= 0)
+    {
+        return nullptr;
+    }
+    const auto& compiled = it->second;
+    if (compiled->fingerprint != fingerprint || now - compiled->compiledAt >= ttl_)
+    {
+        return nullptr;
+    }
+    return compiled;
+}
+
+void RetoolTemplateCache::put(const std::string& key, std::shared_ptr<const RetoolCompiledTemplate> compiled)
+{
+    if (!compiled)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ttl_.count() <= 0)
+    {
+        return;
+    }
+    if (templates_.size() >= kPruneThreshold)
+    {
+        const auto now = Clock::now();
+        for (auto it = templates_.begin(); it != templates_.end();)
+        {
+            it = now - it->second->compiledAt >= ttl_ ? templates_.erase(it) : std::next(it);
+        }
+    }
+    templates_[key] = std::move(compiled);
+}
+
+void RetoolTemplateCache::invalidate(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    templates_.erase(key);
+}
+
+size_t RetoolTemplateCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return templates_.size();
+}
+
+bool RetoolTemplateCache::beginResourceFetch(const std::string& workspaceId,
+                                             const std::string& fingerprint,
+                                             Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ttl_.count() <= 0)
+    {
+        return true;
+    }
+    auto it = resourceFetches_.find(workspaceId);
+    if (it != resourceFetches_.end() && it->second.fingerprint == fingerprint && now - it->second.fetchedAt < ttl_)
+    {
+        return false;
+    }
+    resourceFetches_[workspaceId] = ResourceFetch{fingerprint, now};
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef RETOOL_TEMPLATE_CACHE_H
+#define RETOOL_TEMPLATE_CACHE_H
+
+#include <json/json.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief 已完成 provider/model/资源绑定修补的 workflow 模板
+ *
+ * templateData 在编译时以占位符代替 instruction 的值，随后在占位符处切开为前后两段，
+ * 每次请求只需拼接编码后的 prompt。cloned 为 true 表示模板克隆自源 workflow（Anthropic 路径），
+ * 渲染时以 workflow 为底并覆盖目标 workflow 的标识字段；否则直接以目标 workflow 为底。
+ */
+struct RetoolCompiledTemplate
+{
+    static constexpr const char* kPromptSlot = "__AIAPI_RETOOL_PROMPT_SLOT__";
+
+    Json::Value workflow;
+    bool cloned = false;
+    bool hasPromptSlot = false;
+    std::string dataPrefix;
+    std::string dataSuffix;
+    std::string fingerprint;
+    std::chrono::steady_clock::time_point compiledAt;
+
+    /// patchedWorkflow 的 instruction 须已替换为 kPromptSlot；找不到占位符时整段作为前缀
+    static std::shared_ptr<RetoolCompiledTemplate> compile(Json::Value patchedWorkflow, bool cloned);
+    /// 将目标 workflow 的标识与归属字段（id、saveId、organizationId 等）覆盖到克隆的模板上
+    static void overlayDestinationFields(Json::Value& workflow, const Json::Value& destination);
+
+    /// encodedPrompt 为已做 JSON 字符串转义的 prompt
+    Json::Value render(const Json::Value& destination, const std::string& encodedPrompt) const;
+    std::string renderTemplateData(const std::string& encodedPrompt) const;
+};
+
+/**
+ * @brief 按 (workspace, route, model) 缓存编译好的模板，并限制 /api/resources 的重复拉取
+ *
+ * 条目带 workspace 指纹（baseUrl、workflow/agent id 与资源绑定字段），
+ * workspace 记录的这些字段变化后旧条目自动失效；另有 TTL 以便拾取在 Retool 侧对 workflow 的修改。
+ */
+class RetoolTemplateCache
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static std::string keyOf(const std::string& workspaceId, const std::string& route, const std::string& model);
+    static std::string fingerprintOf(const Json::Value& workspaceJson);
+
+    void setTtl(std::chrono::seconds ttl);
+    std::chrono::seconds ttl() const;
+
+    std::shared_ptr<const RetoolCompiledTemplate> get(const std::string& key,
+                                                      const std::string& fingerprint,
+                                                      Clock::time_point now = Clock::now()) const;
+    void put(const std::string& key, std::shared_ptr<const RetoolCompiledTemplate> compiled);
+    void invalidate(const std::string& key);
+    size_t size() const;
+
+    /// 同一 workspace 指纹在 TTL 内只拉取一次资源列表；返回 true 表示应当拉取并已记下本次尝试
+    bool beginResourceFetch(const std::string& workspaceId,
+                            const std::string& fingerprint,
+                            Clock::time_point now = Clock::now());
+
+  private:
+    struct ResourceFetch
+    {
+        std::string fingerprint;
+        Clock::time_point fetchedAt;
+    };
+
+    mutable std::mutex mutex_;
+    std::chrono::seconds ttl_{600};
+    std::unordered_map<std::string, std::shared_ptr<const RetoolCompiledTemplate>> templates_;
+    std::unordered_map<std::string, ResourceFetch> resourceFetches_;
+};
+
+#endif
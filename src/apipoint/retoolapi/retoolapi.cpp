@@ -1,9 +1,16 @@
 #include "retoolapi.h"
+#include <accountManager/accountManager.h>
 
 #include <channelManager/channelManager.h>
 #include <drogon/drogon.h>
 #include <managedAccount/service/ManagedAccountService.h>
 #include <retoolWorkspace/RetoolWorkspaceManager.h>
+#include <sessionManager/tooling/ToolBridgePromptCache.h>
+#include <apipoint/PollSchedule.h>
+#include <apipoint/UpstreamRateLimit.h>
+#include <apipoint/UpstreamThreadPool.h>
+#include <utils/BackgroundTaskQueue.h>
+#include <algorithm>
 #include <chrono>
 #include <cctype>
 #include <cstring>
@@ -47,6 +54,25 @@ std::string trimCopy(std::string value)
     return value;
 }
 
+// 轮询总等待时长与原先的固定 1 秒 x 次数一致
+constexpr std::chrono::milliseconds kWorkflowRunTimeout{120000};
+constexpr std::chrono::milliseconds kAgentRunTimeout{180000};
+
+// 无历史耗时分布时保持原来的 1 秒固定间隔
+PollSchedule::Bounds retoolPollBounds()
+{
+    PollSchedule::Bounds bounds;
+    bounds.minInterval = std::chrono::milliseconds(250);
+    bounds.maxInterval = std::chrono::milliseconds(3000);
+    bounds.fallbackInterval = std::chrono::milliseconds(1000);
+    return bounds;
+}
+
+std::chrono::milliseconds elapsedSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+}
+
 std::string envOrDefault(const char* key, const char* fallback)
 {
     const char* value = std::getenv(key);
@@ -97,6 +123,58 @@ bool replaceQuotedValueAfter(std::string& input,
     return true;
 }
 
+// 模板修补用到的固定字段模式只构造一次
+const std::regex kInstructionValuePattern("\"instruction\",\".*?\"");
+const std::regex kModelValuePattern("\"model\",\".*?\"");
+const std::regex kProviderIdValuePattern("\"providerId\",\".*?\"");
+const std::regex kProviderNameValuePattern("\"providerName\",\".*?\"");
+const std::regex kProviderResourceNameValuePattern("\"providerResourceName\",\".*?\"");
+
+// 限流冷却/在途上限按 workspaceId 计，缺失时与选号逻辑一致回退到 subdomain
+std::string throttleAccountOf(const Json::Value& workspaceJson)
+{
+    const auto workspaceId = workspaceJson.get("workspaceId", "").asString();
+    return !workspaceId.empty() ? workspaceId : workspaceJson.get("subdomain", "").asString();
+}
+
+// 选 workspace 时跳过 429 冷却、在途已满与健康度熔断中的 workspace
+bool workspaceSchedulable(const std::string& account)
+{
+    return AccountThrottle::getInstance().isAvailable("retoolapi", account) &&
+           !AccountManager::getInstance().isAccountCircuitOpen("retoolapi", account);
+}
+
+// 一次 workflow/agent 调用的耗时与成败上报给账号健康度统计：构造时占用半开探测名额，
+// 析构时上报，未调用 succeeded() 即按失败计
+class ScopedWorkspaceHealthReport
+{
+  public:
+    explicit ScopedWorkspaceHealthReport(std::string account)
+        : account_(std::move(account)),
+          probe_(AccountManager::getInstance().beginAccountProbe("retoolapi", account_)),
+          start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedWorkspaceHealthReport()
+    {
+        const double latencyMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+        AccountManager::getInstance().reportAccountResult("retoolapi", account_, latencyMs, success_);
+    }
+
+    ScopedWorkspaceHealthReport(const ScopedWorkspaceHealthReport&) = delete;
+    ScopedWorkspaceHealthReport& operator=(const ScopedWorkspaceHealthReport&) = delete;
+
+    void succeeded() { success_ = true; }
+
+  private:
+    std::string account_;
+    AccountHealthTracker::Probe probe_;
+    std::chrono::steady_clock::time_point start_;
+    bool success_ = false;
+};
+
 class ScopedWorkspaceUsage
 {
   public:
@@ -134,6 +212,26 @@ void* retoolapi::createApi()
 
 void retoolapi::init()
 {
+    int templateCacheTtlSeconds = 600;
+    const auto& customConfig = drogon::app().getCustomConfig();
+    if (customConfig.isMember("retoolapi") && customConfig["retoolapi"].isObject())
+    {
+        templateCacheTtlSeconds = customConfig["retoolapi"].get("template_cache_ttl_seconds", templateCacheTtlSeconds).asInt();
+    }
+    templateCache_.setTtl(std::chrono::seconds(std::max(0, templateCacheTtlSeconds)));
+
+    if (UpstreamThreadPool::getInstance().enabled())
+    {
+        const auto refillSeconds = UpstreamThreadPool::getInstance().settings().refillIntervalSeconds;
+        drogon::app().getLoop()->runEvery(static_cast<double>(refillSeconds), [this]() {
+            if (threadPrewarmRunning_.exchange(true)) return;
+            BackgroundTaskQueue::instance().enqueue("retool_thread_prewarm", [this]() {
+                prewarmAgentThreads();
+                threadPrewarmRunning_.store(false);
+            });
+        });
+    }
+
     modelListOpenAiFormat_ = Json::Value(Json::objectValue);
     modelListOpenAiFormat_["object"] = "list";
     modelListOpenAiFormat_["data"] = Json::Value(Json::arrayValue);
@@ -192,82 +290,61 @@ std::string retoolapi::requireWorkspaceId(const session_st& session) const
     return "";
 }
 
+void retoolapi::rememberConversationWorkspace(const std::string& conversationId, const std::string& workspaceId) const
+{
+    ProviderContextStore::getInstance().update(contextNamespace(), conversationId, [&workspaceId](Json::Value& ctx) {
+        if (ctx.get("workspaceId", "").asString() == workspaceId) return false;
+        ctx["workspaceId"] = workspaceId;
+        return true;
+    });
+}
+
 std::string retoolapi::resolveWorkspaceId(session_st& session, bool requireAgent, std::string* errorMessage) const
 {
     auto explicitId = requireWorkspaceId(session);
     if (!explicitId.empty())
     {
-        auto* self = const_cast<retoolapi*>(this);
-        std::lock_guard<std::mutex> lock(self->threadMutex_);
-        self->conversationWorkspaceMap_[session.state.conversationId] = explicitId;
+        rememberConversationWorkspace(session.state.conversationId, explicitId);
         LOG_INFO << "[retoolapi] workspace selection: source=explicit"
                  << ", conversation=" << session.state.conversationId
                  << ", workspace=" << explicitId;
         return explicitId;
     }
 
+    if (const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), session.state.conversationId))
     {
-        std::lock_guard<std::mutex> lock(const_cast<retoolapi*>(this)->threadMutex_);
-        auto affinityIt = conversationWorkspaceMap_.find(session.state.conversationId);
-        if (affinityIt != conversationWorkspaceMap_.end() && !affinityIt->second.empty())
+        const auto affinityId = ctx->get("workspaceId", "").asString();
+        // 亲和的 workspace 处于 429 冷却或在途已满时重新从池中选择（transcript 每轮重建，切换不丢上下文）
+        if (!affinityId.empty() && workspaceSchedulable(affinityId))
         {
-            session.provider.clientInfo["workspace_id"] = affinityIt->second;
+            session.provider.clientInfo["workspace_id"] = affinityId;
             LOG_INFO << "[retoolapi] workspace selection: source=conversation_affinity"
                      << ", conversation=" << session.state.conversationId
-                     << ", workspace=" << affinityIt->second;
-            return affinityIt->second;
+                     << ", workspace=" << affinityId;
+            return affinityId;
         }
     }
 
-    auto workspaces = RetoolWorkspaceManager::getInstance().listWorkspaces(errorMessage);
-    std::vector<RetoolWorkspaceInfo> candidates;
-    for (const auto& workspace : workspaces)
+    auto selected = RetoolWorkspaceManager::getInstance().selectWorkspace(
+        requireAgent,
+        [](const std::string& workspaceId) { return workspaceSchedulable(workspaceId); },
+        errorMessage);
+    if (!selected)
     {
-        if (workspace.status == "disabled") continue;
-        if (!(workspace.verifyStatus == "passed" || workspace.verifyStatus == "ready")) continue;
-        if (workspace.baseUrl.empty()) continue;
-        if (requireAgent)
-        {
-            if (workspace.agentId.empty()) continue;
-        }
-        else
-        {
-            if (workspace.workflowId.empty()) continue;
-        }
-        candidates.push_back(workspace);
-    }
-
-    if (candidates.empty())
-    {
-        if (errorMessage) *errorMessage = "no available retool workspace in pool";
+        if (errorMessage && errorMessage->empty()) *errorMessage = "no available retool workspace in pool";
         return "";
     }
 
-    std::sort(candidates.begin(), candidates.end(), [](const auto& left, const auto& right) {
-        if (left.inUseCount != right.inUseCount) return left.inUseCount < right.inUseCount;
-        const auto& leftUsed = left.lastUsedAt;
-        const auto& rightUsed = right.lastUsedAt;
-        if (leftUsed.empty() != rightUsed.empty()) return leftUsed.empty();
-        if (leftUsed != rightUsed) return leftUsed < rightUsed;
-        return left.createdAt < right.createdAt;
-    });
-
-    const auto selectedId = !candidates.front().workspaceId.empty()
-        ? candidates.front().workspaceId
-        : candidates.front().subdomain;
+    const auto selectedId = selected->id;
     session.provider.clientInfo["workspace_id"] = selectedId;
-    {
-        auto* self = const_cast<retoolapi*>(this);
-        std::lock_guard<std::mutex> lock(self->threadMutex_);
-        self->conversationWorkspaceMap_[session.state.conversationId] = selectedId;
-    }
+    rememberConversationWorkspace(session.state.conversationId, selectedId);
     LOG_INFO << "[retoolapi] workspace selection: source=pool"
              << ", conversation=" << session.state.conversationId
              << ", workspace=" << selectedId
-             << ", email=" << candidates.front().email
-             << ", baseUrl=" << candidates.front().baseUrl
-             << ", inUseCount=" << candidates.front().inUseCount
-             << ", verifyStatus=" << candidates.front().verifyStatus;
+             << ", email=" << selected->email
+             << ", baseUrl=" << selected->baseUrl
+             << ", inUseCount=" << selected->inUseCount
+             << ", verifyStatus=" << selected->verifyStatus;
     return selectedId;
 }
 
@@ -372,6 +449,7 @@ HttpResponsePtr retoolapi::sendJsonRequest(
     {
         return nullptr;
     }
+    provider::noteUpstreamRateLimit(resp, "retoolapi", throttleAccountOf(workspaceJson));
     return resp;
 }
 
@@ -396,32 +474,33 @@ std::string retoolapi::contentToText(const Json::Value& content) const
 
 std::string retoolapi::buildTranscriptPrompt(const session_st& session) const
 {
-    std::string systemText = session.request.systemPrompt;
-    std::string convoText;
-    for (const auto& msg : session.provider.messageContext)
-    {
-        if (!msg.isObject()) continue;
-        const auto role = msg.get("role", "user").asString();
-        if (role == "system")
-        {
+    // 历史部分按会话缓存，续聊时只渲染新追加的消息
+    const auto& history = session.provider.transcriptCache.render(
+        "retool_transcript",
+        session.provider.messageContext,
+        [this](TranscriptRender& out, const Json::Value& msg) {
+            if (!msg.isObject()) return;
+            const auto role = msg.get("role", "user").asString();
+            if (role != "system" && role != "user" && role != "assistant") return;
             const auto text = contentToText(msg["content"]);
-            if (!text.empty())
+            if (text.empty()) return;
+            if (role == "system")
             {
-                if (!systemText.empty()) systemText += "\n";
-                systemText += text;
+                if (!out.systemText.empty()) out.systemText += "\n";
+                out.systemText += text;
+                return;
             }
-            continue;
-        }
-        if (role == "user" || role == "assistant")
-        {
-            const auto text = contentToText(msg["content"]);
-            if (!text.empty())
-            {
-                if (!convoText.empty()) convoText += "\n";
-                convoText += role + ": " + text;
-            }
-        }
+            if (!out.text.empty()) out.text += "\n";
+            out.text += role + ": " + text;
+        });
+
+    std::string systemText = session.request.systemPrompt;
+    if (!history.systemText.empty())
+    {
+        if (!systemText.empty()) systemText += "\n";
+        systemText += history.systemText;
     }
+    std::string convoText = history.text;
     if (!session.request.message.empty())
     {
         if (!convoText.empty()) convoText += "\n";
@@ -453,7 +532,8 @@ std::string retoolapi::lastUserContent(const session_st& session) const
 
 std::string retoolapi::encodeJsonString(const std::string& value) const
 {
-    return toCompactJson(Json::Value(value)).substr(1, toCompactJson(Json::Value(value)).size() - 2);
+    const auto quoted = toCompactJson(Json::Value(value));
+    return quoted.substr(1, quoted.size() - 2);
 }
 
 Json::Value retoolapi::resolveRetoolProviderBinding(const Json::Value& workspaceJson, const std::string& model) const
@@ -598,19 +678,7 @@ Json::Value retoolapi::buildAnthropicWorkflowTemplate(const Json::Value& destina
     }
 
     Json::Value cloned = sourceJson["workflow"];
-    static const std::vector<std::string> copyKeys = {
-        "id", "saveId", "apiKey", "folderId", "createdAt", "updatedAt", "createdBy", "accessLevel", "releaseId"};
-    for (const auto& key : copyKeys)
-    {
-        if (destinationWorkflow.isMember(key))
-        {
-            cloned[key] = destinationWorkflow[key];
-        }
-    }
-    if (destinationWorkflow.isMember("id")) cloned["id"] = destinationWorkflow["id"];
-    if (destinationWorkflow.isMember("organizationId")) cloned["organizationId"] = destinationWorkflow["organizationId"];
-    if (destinationWorkflow.isMember("name")) cloned["name"] = destinationWorkflow["name"];
-    if (destinationWorkflow.isMember("description")) cloned["description"] = destinationWorkflow["description"];
+    RetoolCompiledTemplate::overlayDestinationFields(cloned, destinationWorkflow);
 
     auto serialized = toCompactJson(cloned);
     const auto sourceOrgId = sourceJson["workflow"].isMember("organizationId")
@@ -658,19 +726,19 @@ Json::Value retoolapi::patchWorkflowTemplate(const Json::Value& workflow, const
 {
     Json::Value patched = workflow;
     auto data = patched.get("templateData", "").asString();
-    replaceFirstRegex(data, std::regex("\"instruction\",\".*?\""), "\"instruction\",\"" + encodeJsonString(prompt) + "\"");
-    replaceFirstRegex(data, std::regex("\"model\",\".*?\""), "\"model\",\"" + encodeJsonString(model) + "\"");
+    replaceFirstRegex(data, kInstructionValuePattern, "\"instruction\",\"" + encodeJsonString(prompt) + "\"");
+    replaceFirstRegex(data, kModelValuePattern, "\"model\",\"" + encodeJsonString(model) + "\"");
     auto binding = resolveRetoolProviderBinding(workspaceJson, model);
     if (binding.isObject())
     {
         const auto providerId = binding.get("providerId", "").asString();
         const auto providerName = binding.get("providerName", "").asString();
         const auto providerResourceName = binding.get("providerResourceName", "").asString();
-        replaceFirstRegex(data, std::regex("\"providerId\",\".*?\""), "\"providerId\",\"" + encodeJsonString(providerId) + "\"");
-        replaceFirstRegex(data, std::regex("\"providerName\",\".*?\""), "\"providerName\",\"" + encodeJsonString(providerName) + "\"");
+        replaceFirstRegex(data, kProviderIdValuePattern, "\"providerId\",\"" + encodeJsonString(providerId) + "\"");
+        replaceFirstRegex(data, kProviderNameValuePattern, "\"providerName\",\"" + encodeJsonString(providerName) + "\"");
         if (!providerResourceName.empty())
         {
-            if (!replaceFirstRegex(data, std::regex("\"providerResourceName\",\".*?\""), "\"providerResourceName\",\"" + encodeJsonString(providerResourceName) + "\""))
+            if (!replaceFirstRegex(data, kProviderResourceNameValuePattern, "\"providerResourceName\",\"" + encodeJsonString(providerResourceName) + "\""))
             {
                 replaceFirstRegex(
                     data,
@@ -712,11 +780,11 @@ Json::Value retoolapi::patchAgentTemplate(const Json::Value& workflow, const Jso
     const auto providerId = binding.get("providerId", "").asString();
     const auto providerName = binding.get("providerName", "").asString();
     const auto providerResourceName = binding.get("providerResourceName", "").asString();
-    replaceFirstRegex(data, std::regex("\"providerId\",\".*?\""), "\"providerId\",\"" + encodeJsonString(providerId) + "\"");
-    replaceFirstRegex(data, std::regex("\"providerName\",\".*?\""), "\"providerName\",\"" + encodeJsonString(providerName) + "\"");
+    replaceFirstRegex(data, kProviderIdValuePattern, "\"providerId\",\"" + encodeJsonString(providerId) + "\"");
+    replaceFirstRegex(data, kProviderNameValuePattern, "\"providerName\",\"" + encodeJsonString(providerName) + "\"");
     if (!providerResourceName.empty())
     {
-        if (!replaceFirstRegex(data, std::regex("\"providerResourceName\",\".*?\""), "\"providerResourceName\",\"" + encodeJsonString(providerResourceName) + "\""))
+        if (!replaceFirstRegex(data, kProviderResourceNameValuePattern, "\"providerResourceName\",\"" + encodeJsonString(providerResourceName) + "\""))
         {
             replaceFirstRegex(
                 data,
@@ -724,11 +792,97 @@ Json::Value retoolapi::patchAgentTemplate(const Json::Value& workflow, const Jso
                 "\"providerId\",\"" + encodeJsonString(providerId) + "\",\"providerResourceName\",\"" + encodeJsonString(providerResourceName) + "\"");
         }
     }
-    replaceFirstRegex(data, std::regex("\"model\",\".*?\""), "\"model\",\"" + encodeJsonString(model) + "\"");
+    replaceFirstRegex(data, kModelValuePattern, "\"model\",\"" + encodeJsonString(model) + "\"");
     patched["templateData"] = data;
     return patched;
 }
 
+std::shared_ptr<const RetoolCompiledTemplate> retoolapi::compiledTemplateFor(const std::string& workspaceId,
+                                                                             const std::string& route,
+                                                                             const Json::Value& destinationWorkflow,
+                                                                             const Json::Value& workspaceJson,
+                                                                             const std::string& model) const
+{
+    const auto key = RetoolTemplateCache::keyOf(workspaceId, route, model);
+    const auto fingerprint = RetoolTemplateCache::fingerprintOf(workspaceJson);
+    if (auto cached = templateCache_.get(key, fingerprint))
+    {
+        return cached;
+    }
+
+    std::shared_ptr<RetoolCompiledTemplate> compiled;
+    bool cacheable = true;
+    if (route == "agent")
+    {
+        compiled = RetoolCompiledTemplate::compile(patchAgentTemplate(destinationWorkflow, workspaceJson, model), false);
+    }
+    else
+    {
+        // instruction 先写入占位符，修补完成后在占位符处切开，请求时只拼接 prompt
+        Json::Value patched;
+        if (isAnthropicModelName(model))
+        {
+            patched = buildAnthropicWorkflowTemplate(destinationWorkflow, workspaceJson, RetoolCompiledTemplate::kPromptSlot, model);
+            // 源 workflow 拉取失败时本次回退为直接修补，不缓存，下次重新尝试克隆
+            cacheable = patched.isObject();
+        }
+        const bool cloned = patched.isObject();
+        if (!cloned)
+        {
+            patched = patchWorkflowTemplate(destinationWorkflow, workspaceJson, RetoolCompiledTemplate::kPromptSlot, model);
+        }
+        compiled = RetoolCompiledTemplate::compile(std::move(patched), cloned);
+    }
+    compiled->fingerprint = fingerprint;
+    if (cacheable)
+    {
+        templateCache_.put(key, compiled);
+    }
+    LOG_DEBUG << "[retoolapi] 编译 workflow 模板: workspace=" << workspaceId
+              << ", route=" << route
+              << ", model=" << model
+              << ", cloned=" << (compiled->cloned ? 1 : 0)
+              << ", promptSlot=" << (compiled->hasPromptSlot ? 1 : 0)
+              << ", cached=" << (cacheable ? 1 : 0);
+    return compiled;
+}
+
+bool retoolapi::agentBindingApplied(const std::string& workspaceId, const std::string& signature) const
+{
+    const auto ttl = templateCache_.ttl();
+    if (ttl.count() <= 0)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(threadMutex_);
+    auto it = appliedAgentBindings_.find(workspaceId);
+    return it != appliedAgentBindings_.end() && it->second.signature == signature &&
+        std::chrono::steady_clock::now() - it->second.appliedAt < ttl;
+}
+
+void retoolapi::rememberAgentBinding(const std::string& workspaceId, const std::string& signature)
+{
+    std::lock_guard<std::mutex> lock(threadMutex_);
+    appliedAgentBindings_[workspaceId] = AppliedAgentBinding{signature, std::chrono::steady_clock::now()};
+}
+
+void retoolapi::forgetAgentBinding(const std::string& workspaceId)
+{
+    std::lock_guard<std::mutex> lock(threadMutex_);
+    appliedAgentBindings_.erase(workspaceId);
+}
+
+std::shared_ptr<std::mutex> retoolapi::agentBindingMutexFor(const std::string& workspaceId)
+{
+    std::lock_guard<std::mutex> lock(threadMutex_);
+    auto& mutex = agentBindingMutexes_[workspaceId];
+    if (!mutex)
+    {
+        mutex = std::make_shared<std::mutex>();
+    }
+    return mutex;
+}
+
 provider::ProviderResult retoolapi::requestWorkflow(session_st& session)
 {
     std::string resolveError;
@@ -746,6 +900,11 @@ provider::ProviderResult retoolapi::requestWorkflow(session_st& session)
         return provider::ProviderResult::fail(provider::ProviderError::auth(error.empty() ? "retool workspace not found" : error));
     }
     Json::Value workspace = ctx->data;
+    auto throttleLease = AccountThrottle::getInstance().tryBegin("retoolapi", throttleAccountOf(workspace));
+    if (!throttleLease)
+    {
+        return provider::ProviderResult::fail(provider::ProviderError::localThrottle("retool workspace is cooling down after upstream 429 or at its in-flight limit"));
+    }
     const std::string baseUrl = workspace.get("baseUrl", "").asString();
     const std::string workflowId = workspace.get("workflowId", "").asString();
     LOG_INFO << "[retoolapi] resolved workspace context: conversation=" << session.state.conversationId
@@ -757,6 +916,7 @@ provider::ProviderResult retoolapi::requestWorkflow(session_st& session)
     {
         return provider::ProviderResult::fail(provider::ProviderError::internal("retool workspace is missing workflow configuration"));
     }
+    ScopedWorkspaceHealthReport healthReport(throttleAccountOf(workspace));
 
     auto workflowResp = sendJsonRequest(baseUrl, Get, "/api/workflow/" + workflowId, nullptr, workspace);
     if (!workflowResp)
@@ -771,7 +931,8 @@ provider::ProviderResult retoolapi::requestWorkflow(session_st& session)
 
     const std::string requestedModel = session.request.model.empty() ? "gpt-4o-mini" : session.request.model;
     auto binding = resolveRetoolProviderBinding(workspace, requestedModel);
-    if (!binding.isObject())
+    if (!binding.isObject() &&
+        templateCache_.beginResourceFetch(workspaceId, RetoolTemplateCache::fingerprintOf(workspace)))
     {
         populateProviderResources(workspaceId, workspace);
         binding = resolveRetoolProviderBinding(workspace, requestedModel);
@@ -782,22 +943,12 @@ provider::ProviderResult retoolapi::requestWorkflow(session_st& session)
     }
 
     const auto prompt = buildTranscriptPrompt(session);
-    Json::Value patched;
-    if (isAnthropicModelName(requestedModel))
-    {
-        patched = buildAnthropicWorkflowTemplate(workflowJson["workflow"], workspace, prompt, requestedModel);
-    }
-    if (!patched.isObject())
-    {
-        patched = patchWorkflowTemplate(
-            workflowJson["workflow"],
-            workspace,
-            prompt,
-            requestedModel);
-    }
+    const auto compiled = compiledTemplateFor(workspaceId, "workflow", workflowJson["workflow"], workspace, requestedModel);
+    auto patched = compiled->render(workflowJson["workflow"], encodeJsonString(prompt));
     auto saveResp = sendJsonRequest(baseUrl, Post, "/api/workflow/" + workflowId, &patched, workspace, 60.0);
     if (!saveResp || saveResp->statusCode() >= 400)
     {
+        templateCache_.invalidate(RetoolTemplateCache::keyOf(workspaceId, "workflow", requestedModel));
         return provider::ProviderResult::fail(
             classifyHttpError(saveResp ? static_cast<int>(saveResp->statusCode()) : 503,
                               saveResp ? std::string(saveResp->getBody()) : std::string("failed to save retool workflow")));
@@ -816,7 +967,11 @@ provider::ProviderResult retoolapi::requestWorkflow(session_st& session)
         return provider::ProviderResult::fail(classifyHttpError(static_cast<int>(runResp->statusCode()), std::string(runResp->getBody())));
     }
     const std::string runId = runJson["id"].asString();
-    for (int i = 0; i < 120; ++i)
+    const auto schedule = PollSchedule::forModel("retoolapi", "workflow:" + requestedModel, retoolPollBounds());
+    const auto pollStart = std::chrono::steady_clock::now();
+    auto lastMiss = std::chrono::milliseconds(0);
+    std::this_thread::sleep_for(schedule.initialDelay());
+    for (auto elapsed = std::chrono::milliseconds(0); elapsed < kWorkflowRunTimeout; elapsed = elapsedSince(pollStart))
     {
         auto pollResp = sendJsonRequest(baseUrl, Get, "/api/workflowRun/getBlockLevelLogs?runId=" + runId, nullptr, workspace);
         if (!pollResp)
@@ -828,6 +983,9 @@ provider::ProviderResult retoolapi::requestWorkflow(session_st& session)
         const auto status = code1.get("status", "").asString();
         if (status == "SUCCESS")
         {
+            CompletionTimeStats::getInstance().record("retoolapi", "workflow:" + requestedModel, lastMiss,
+                                                      elapsedSince(pollStart));
+            healthReport.succeeded();
             std::string content = jsonToStringOrCompactJson(code1["output"]["data"], "");
             auto result = provider::ProviderResult::success(trimCopy(content));
             result.meta = buildRetoolMeta(workspaceId, "workflow", workflowId, binding, requestedModel);
@@ -838,7 +996,8 @@ provider::ProviderResult retoolapi::requestWorkflow(session_st& session)
             return provider::ProviderResult::fail(provider::ProviderError::internal(
                 jsonToStringOrCompactJson(code1["output"]["error"], "workflow failed")));
         }
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        lastMiss = elapsedSince(pollStart);
+        std::this_thread::sleep_for(schedule.nextDelay(lastMiss));
     }
     return provider::ProviderResult::fail(provider::ProviderError::timeout("retool workflow run timed out"));
 }
@@ -860,6 +1019,11 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
         return provider::ProviderResult::fail(provider::ProviderError::auth(error.empty() ? "retool workspace not found" : error));
     }
     Json::Value workspace = ctx->data;
+    auto throttleLease = AccountThrottle::getInstance().tryBegin("retoolapi", throttleAccountOf(workspace));
+    if (!throttleLease)
+    {
+        return provider::ProviderResult::fail(provider::ProviderError::localThrottle("retool workspace is cooling down after upstream 429 or at its in-flight limit"));
+    }
     const std::string baseUrl = workspace.get("baseUrl", "").asString();
     const std::string agentId = workspace.get("agentId", "").asString();
     LOG_INFO << "[retoolapi] resolved workspace context: conversation=" << session.state.conversationId
@@ -871,17 +1035,7 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
     {
         return provider::ProviderResult::fail(provider::ProviderError::internal("retool workspace is missing agent configuration"));
     }
-
-    auto workflowResp = sendJsonRequest(baseUrl, Get, "/api/workflow/" + agentId, nullptr, workspace);
-    if (!workflowResp)
-    {
-        return provider::ProviderResult::fail(provider::ProviderError::network("failed to fetch retool agent workflow"));
-    }
-    auto workflowJson = parseJsonResponse(workflowResp);
-    if (workflowResp->statusCode() != k200OK || !workflowJson.isMember("workflow"))
-    {
-        return provider::ProviderResult::fail(classifyHttpError(static_cast<int>(workflowResp->statusCode()), std::string(workflowResp->getBody())));
-    }
+    ScopedWorkspaceHealthReport healthReport(throttleAccountOf(workspace));
 
     std::string requestedModel = session.request.model;
     if (requestedModel.rfind("agent-", 0) == 0)
@@ -893,7 +1047,8 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
         requestedModel = "gpt-5.4";
     }
     auto binding = resolveRetoolProviderBinding(workspace, requestedModel);
-    if (!binding.isObject())
+    if (!binding.isObject() &&
+        templateCache_.beginResourceFetch(workspaceId, RetoolTemplateCache::fingerprintOf(workspace)))
     {
         populateProviderResources(workspaceId, workspace);
         binding = resolveRetoolProviderBinding(workspace, requestedModel);
@@ -902,44 +1057,75 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
     {
         return provider::ProviderResult::fail(provider::ProviderError::internal("matching retool provider resource not found for requested model"));
     }
-    auto patched = patchAgentTemplate(workflowJson["workflow"], workspace, requestedModel);
-    auto saveResp = sendJsonRequest(baseUrl, Post, "/api/workflow/" + agentId, &patched, workspace, 60.0);
-    if (!saveResp || saveResp->statusCode() >= 400)
+    // agent 已绑定到同一模型与资源时跳过拉取与保存 workflow
+    const auto bindingSignature = agentId + "|" + requestedModel + "|" + RetoolTemplateCache::fingerprintOf(workspace);
     {
-        return provider::ProviderResult::fail(
-            classifyHttpError(saveResp ? static_cast<int>(saveResp->statusCode()) : 503,
-                              saveResp ? std::string(saveResp->getBody()) : std::string("failed to save retool agent workflow")));
+        // 持锁覆盖检查、拉取、保存与记录：并发请求在同一 workspace 上按顺序保存各自的绑定
+        const auto bindingMutex = agentBindingMutexFor(workspaceId);
+        std::lock_guard<std::mutex> bindingLock(*bindingMutex);
+        if (agentBindingApplied(workspaceId, bindingSignature))
+        {
+            LOG_DEBUG << "[retoolapi] agent binding unchanged, skip workflow save: workspace=" << workspaceId
+                      << ", model=" << requestedModel;
+        }
+        else
+        {
+            auto workflowResp = sendJsonRequest(baseUrl, Get, "/api/workflow/" + agentId, nullptr, workspace);
+            if (!workflowResp)
+            {
+                return provider::ProviderResult::fail(provider::ProviderError::network("failed to fetch retool agent workflow"));
+            }
+            auto workflowJson = parseJsonResponse(workflowResp);
+            if (workflowResp->statusCode() != k200OK || !workflowJson.isMember("workflow"))
+            {
+                return provider::ProviderResult::fail(classifyHttpError(static_cast<int>(workflowResp->statusCode()), std::string(workflowResp->getBody())));
+            }
+
+            const auto compiled = compiledTemplateFor(workspaceId, "agent", workflowJson["workflow"], workspace, requestedModel);
+            auto patched = compiled->render(workflowJson["workflow"], "");
+            auto saveResp = sendJsonRequest(baseUrl, Post, "/api/workflow/" + agentId, &patched, workspace, 60.0);
+            if (!saveResp || saveResp->statusCode() >= 400)
+            {
+                templateCache_.invalidate(RetoolTemplateCache::keyOf(workspaceId, "agent", requestedModel));
+                forgetAgentBinding(workspaceId);
+                return provider::ProviderResult::fail(
+                    classifyHttpError(saveResp ? static_cast<int>(saveResp->statusCode()) : 503,
+                                      saveResp ? std::string(saveResp->getBody()) : std::string("failed to save retool agent workflow")));
+            }
+            rememberAgentBinding(workspaceId, bindingSignature);
+        }
     }
 
     auto createThread = [&](bool persistMapping) -> std::optional<std::string> {
-        Json::Value threadBody(Json::objectValue);
-        threadBody["name"] = "aiapi-thread";
-        threadBody["timezone"] = "UTC";
-        auto threadResp = sendJsonRequest(baseUrl, Post, "/api/agents/" + agentId + "/threads", &threadBody, workspace);
-        if (!threadResp)
+        // 会话绑定的 thread 优先领取后台预建的空 thread
+        std::optional<std::string> pooled;
+        if (persistMapping)
         {
-            LOG_ERROR << "[retoolapi] createThread failed: no response, workspace=" << workspaceId
-                      << ", conversation=" << session.state.conversationId;
-            return std::nullopt;
+            pooled = UpstreamThreadPool::getInstance().claim("retoolapi", workspaceId + "|" + agentId);
         }
-        auto threadJson = parseJsonResponse(threadResp);
-        if (threadResp->statusCode() >= 400 || !threadJson.isMember("id"))
+        std::string threadError;
+        const auto created = pooled ? pooled : createAgentThread(baseUrl, agentId, workspace, &threadError);
+        if (!created)
         {
-            LOG_ERROR << "[retoolapi] createThread failed: status=" << static_cast<int>(threadResp->statusCode())
-                      << ", body=" << threadResp->getBody()
+            LOG_ERROR << "[retoolapi] createThread failed: " << threadError
                       << ", workspace=" << workspaceId
                       << ", conversation=" << session.state.conversationId;
             return std::nullopt;
         }
-        const auto newThreadId = threadJson["id"].asString();
+        const auto newThreadId = *created;
         LOG_INFO << "[retoolapi] createThread success: workspace=" << workspaceId
                  << ", conversation=" << session.state.conversationId
                  << ", threadId=" << newThreadId
+                 << ", prewarmed=" << (pooled ? 1 : 0)
                  << ", persistMapping=" << (persistMapping ? 1 : 0);
         if (persistMapping)
         {
-            std::lock_guard<std::mutex> lock(threadMutex_);
-            agentThreadMap_[session.state.conversationId] = newThreadId;
+            ProviderContextStore::getInstance().update(
+                contextNamespace(), session.state.conversationId, [&newThreadId](Json::Value& ctx) {
+                    ctx["threadId"] = newThreadId;
+                    ctx.removeMember("toolBridgeDigest");
+                    return true;
+                });
         }
         return newThreadId;
     };
@@ -959,7 +1145,10 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
     };
 
     auto waitForAgentRun = [&](const std::string& runId, std::string* errorMessage) -> bool {
-        for (int i = 0; i < 180; ++i)
+        const auto schedule = PollSchedule::forModel("retoolapi", "agent:" + requestedModel, retoolPollBounds());
+        const auto pollStart = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(schedule.initialDelay());
+        for (auto elapsed = std::chrono::milliseconds(0); elapsed < kAgentRunTimeout; elapsed = elapsedSince(pollStart))
         {
             auto pollResp = sendJsonRequest(
                 baseUrl,
@@ -991,7 +1180,7 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
                 if (errorMessage) *errorMessage = message;
                 return false;
             }
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::this_thread::sleep_for(schedule.nextDelay(elapsedSince(pollStart)));
         }
         if (errorMessage) *errorMessage = "retool agent replay timed out";
         return false;
@@ -1117,11 +1306,10 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
     const bool disableThreadReuse = false;
     if (!disableThreadReuse)
     {
-        std::lock_guard<std::mutex> lock(threadMutex_);
-        auto it = agentThreadMap_.find(session.state.conversationId);
-        if (it != agentThreadMap_.end())
+        const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), session.state.conversationId);
+        if (ctx && ctx->isMember("threadId"))
         {
-            threadId = it->second;
+            threadId = ctx->get("threadId", "").asString();
             reusedThread = !threadId.empty();
             LOG_INFO << "[retoolapi] reuse cached thread: workspace=" << workspaceId
                      << ", conversation=" << session.state.conversationId
@@ -1152,8 +1340,24 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
         }
     }
 
+    // 复用的 thread 已持有同一份工具定义时只发送简短引用；thread 重建后必须发送完整内容
     const auto currentUserText = lastUserContent(session);
-    auto messageResp = sendThreadTextMessage(threadId, currentUserText);
+    std::string turnUserText = currentUserText;
+    if (reusedThread && !session.request.message.empty())
+    {
+        std::string threadDigest;
+        if (const auto ctx = ProviderContextStore::getInstance().get(contextNamespace(), session.state.conversationId))
+        {
+            if (ctx->get("threadId", "").asString() == threadId) threadDigest = ctx->get("toolBridgeDigest", "").asString();
+        }
+        if (toolcall::canReuseToolBridgeDefinitions(session, threadDigest))
+        {
+            turnUserText = toolcall::toolBridgeReferenceMessage(session);
+            LOG_INFO << "[retoolapi] tool definitions unchanged, sending reference: threadId=" << threadId
+                     << ", chars=" << currentUserText.size() << "->" << turnUserText.size();
+        }
+    }
+    auto messageResp = sendThreadTextMessage(threadId, turnUserText);
     if (!messageResp)
     {
         return provider::ProviderResult::fail(provider::ProviderError::network("failed to send retool agent message"));
@@ -1168,8 +1372,13 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
                      << ", oldThreadId=" << threadId;
             if (!disableThreadReuse)
             {
-                std::lock_guard<std::mutex> lock(threadMutex_);
-                agentThreadMap_.erase(session.state.conversationId);
+                ProviderContextStore::getInstance().update(
+                    contextNamespace(), session.state.conversationId, [&threadId](Json::Value& ctx) {
+                        if (ctx.get("threadId", "").asString() != threadId) return false;
+                        ctx.removeMember("threadId");
+                        ctx.removeMember("toolBridgeDigest");
+                        return true;
+                    });
             }
             auto replacementThreadId = createThread(!disableThreadReuse);
             if (!replacementThreadId)
@@ -1204,8 +1413,24 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
     auto messageJson = parseJsonResponse(messageResp);
     if (messageResp->statusCode() >= 400)
     {
+        // 可能是 agent 配置已在上游被改动，下次请求重新保存绑定
+        forgetAgentBinding(workspaceId);
         return provider::ProviderResult::fail(classifyHttpError(static_cast<int>(messageResp->statusCode()), std::string(messageResp->getBody())));
     }
+    if (!session.provider.toolBridgeDigest.empty())
+    {
+        ProviderContextStore::getInstance().update(
+            contextNamespace(), session.state.conversationId, [&](Json::Value& ctx) {
+                // 只记录会话映射中的线程；未映射的临时线程不会被复用
+                if (ctx.get("threadId", "").asString() != threadId ||
+                    ctx.get("toolBridgeDigest", "").asString() == session.provider.toolBridgeDigest)
+                {
+                    return false;
+                }
+                ctx["toolBridgeDigest"] = session.provider.toolBridgeDigest;
+                return true;
+            });
+    }
     const std::string runId =
         messageJson.get("agentRunId", "").asString().empty()
             ? messageJson["content"].get("runId", "").asString()
@@ -1215,7 +1440,11 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
         return provider::ProviderResult::fail(provider::ProviderError::internal("missing retool agent run id"));
     }
 
-    for (int i = 0; i < 180; ++i)
+    const auto schedule = PollSchedule::forModel("retoolapi", "agent:" + requestedModel, retoolPollBounds());
+    const auto pollStart = std::chrono::steady_clock::now();
+    auto lastMiss = std::chrono::milliseconds(0);
+    std::this_thread::sleep_for(schedule.initialDelay());
+    for (auto elapsed = std::chrono::milliseconds(0); elapsed < kAgentRunTimeout; elapsed = elapsedSince(pollStart))
     {
         auto pollResp = sendJsonRequest(
             baseUrl,
@@ -1232,6 +1461,9 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
         const auto status = pollJson.get("status", "").asString();
         if (status == "COMPLETED")
         {
+            CompletionTimeStats::getInstance().record("retoolapi", "agent:" + requestedModel, lastMiss,
+                                                      elapsedSince(pollStart));
+            healthReport.succeeded();
             const auto trace = pollJson["trace"];
             if (trace.isArray() && !trace.empty())
             {
@@ -1254,9 +1486,11 @@ provider::ProviderResult retoolapi::requestAgent(session_st& session)
                 const auto last = trace[static_cast<int>(trace.size()) - 1];
                 message = last["data"].get("error", message).asString();
             }
+            forgetAgentBinding(workspaceId);
             return provider::ProviderResult::fail(provider::ProviderError::internal(message));
         }
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        lastMiss = elapsedSince(pollStart);
+        std::this_thread::sleep_for(schedule.nextDelay(lastMiss));
     }
     return provider::ProviderResult::fail(provider::ProviderError::timeout("retool agent run timed out"));
 }
@@ -1273,38 +1507,85 @@ provider::ProviderResult retoolapi::generate(session_st& session)
     }
 
     const std::string requestedModel = session.request.model;
-    if (requestedModel.rfind("agent-", 0) == 0)
-    {
-        return requestAgent(session);
-    }
-    return requestWorkflow(session);
+    // 成功时的 noteSuccess 与健康度上报由 ScopedWorkspaceHealthReport 完成
+    return requestedModel.rfind("agent-", 0) == 0 ? requestAgent(session) : requestWorkflow(session);
 }
 
-void retoolapi::afterResponseProcess(session_st&)
+std::optional<std::string> retoolapi::createAgentThread(const std::string& baseUrl,
+                                                       const std::string& agentId,
+                                                       const Json::Value& workspaceJson,
+                                                       std::string* error) const
 {
+    Json::Value threadBody(Json::objectValue);
+    threadBody["name"] = "aiapi-thread";
+    threadBody["timezone"] = "UTC";
+    auto threadResp = sendJsonRequest(baseUrl, Post, "/api/agents/" + agentId + "/threads", &threadBody, workspaceJson);
+    if (!threadResp)
+    {
+        if (error) *error = "no response";
+        return std::nullopt;
+    }
+    auto threadJson = parseJsonResponse(threadResp);
+    if (threadResp->statusCode() >= 400 || !threadJson.isMember("id"))
+    {
+        if (error)
+        {
+            *error = "status=" + std::to_string(static_cast<int>(threadResp->statusCode())) +
+                     ", body=" + std::string(threadResp->getBody());
+        }
+        return std::nullopt;
+    }
+    return threadJson["id"].asString();
 }
 
-void retoolapi::eraseChatinfoMap(std::string conversationId)
-{
-    std::lock_guard<std::mutex> lock(threadMutex_);
-    agentThreadMap_.erase(conversationId);
-    conversationWorkspaceMap_.erase(conversationId);
-}
-
-void retoolapi::transferThreadContext(const std::string& oldId, const std::string& newId)
+void retoolapi::prewarmAgentThreads()
 {
-    if (oldId.empty() || newId.empty() || oldId == newId) return;
-    std::lock_guard<std::mutex> lock(threadMutex_);
-    auto it = agentThreadMap_.find(oldId);
-    if (it != agentThreadMap_.end())
-    {
-        agentThreadMap_[newId] = it->second;
-        agentThreadMap_.erase(it);
+    auto& pool = UpstreamThreadPool::getInstance();
+    pool.evictStale();
+
+    int created = 0;
+    for (const auto& key : pool.demandedAccounts("retoolapi"))
+    {
+        const auto sep = key.find('|');
+        if (sep == std::string::npos) continue;
+        const auto workspaceId = key.substr(0, sep);
+        const auto agentId = key.substr(sep + 1);
+
+        std::string error;
+        auto ctx = ManagedAccountService::getInstance().buildExecutionContext(
+            ManagedAccountKind::RetoolWorkspace, workspaceId, &error);
+        // workspace 已删除或 agent 已更换时丢弃旧 agent 下的预建 thread
+        if (!ctx || ctx->data.get("agentId", "").asString() != agentId)
+        {
+            pool.dropAccount("retoolapi", key);
+            continue;
+        }
+        const auto& workspace = ctx->data;
+        const auto baseUrl = workspace.get("baseUrl", "").asString();
+        if (baseUrl.empty() || !workspaceSchedulable(throttleAccountOf(workspace)))
+        {
+            continue;
+        }
+        for (int i = pool.deficit("retoolapi", key); i > 0; --i)
+        {
+            auto threadId = createAgentThread(baseUrl, agentId, workspace, &error);
+            if (!threadId)
+            {
+                LOG_WARN << "[retoolapi] prewarm thread failed: workspace=" << workspaceId << ", " << error;
+                break;
+            }
+            pool.add("retoolapi", key, *threadId);
+            ++created;
+        }
     }
-    auto workspaceIt = conversationWorkspaceMap_.find(oldId);
-    if (workspaceIt != conversationWorkspaceMap_.end())
+
+    if (created > 0)
     {
-        conversationWorkspaceMap_[newId] = workspaceIt->second;
-        conversationWorkspaceMap_.erase(workspaceIt);
+        LOG_DEBUG << "[retoolapi] prewarmed agent threads: " << created;
     }
 }
+
+void retoolapi::afterResponseProcess(session_st&)
+{
+}
+
@@ -3,8 +3,13 @@
 
 #include <apipoint/APIinterface.h>
 #include <apiManager/ApiFactory.h>
+#include <apipoint/retoolapi/RetoolTemplateCache.h>
 #include <drogon/HttpResponse.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <regex>
 #include <string>
 #include <unordered_map>
@@ -23,8 +28,11 @@ class retoolapi : public APIinterface
     Json::Value getModels() override;
     void init() override;
     void afterResponseProcess(session_st& session) override;
-    void eraseChatinfoMap(std::string conversationId) override;
-    void transferThreadContext(const std::string& oldId, const std::string& newId) override;
+
+  protected:
+    // 会话上下文保存在 ProviderContextStore 的 retoolapi 命名空间下，字段：
+    // workspaceId（会话亲和的 workspace）、threadId（agent 线程）、toolBridgeDigest（该线程已发送的工具定义块指纹）
+    std::string contextNamespace() const override { return "retoolapi"; }
 
   private:
     DEClARE_RUNTIME(retoolapi);
@@ -34,6 +42,7 @@ class retoolapi : public APIinterface
 
     std::string requireWorkspaceId(const session_st& session) const;
     std::string resolveWorkspaceId(session_st& session, bool requireAgent, std::string* errorMessage) const;
+    void rememberConversationWorkspace(const std::string& conversationId, const std::string& workspaceId) const;
     Json::Value resolveRetoolProviderBinding(const Json::Value& workspaceJson, const std::string& model) const;
     bool populateProviderResources(const std::string& workspaceId, Json::Value& workspaceJson) const;
     Json::Value buildRetoolMeta(const std::string& workspaceId,
@@ -63,11 +72,39 @@ class retoolapi : public APIinterface
                                                const std::string& model) const;
     Json::Value patchWorkflowTemplate(const Json::Value& workflow, const Json::Value& workspaceJson, const std::string& prompt, const std::string& model) const;
     Json::Value patchAgentTemplate(const Json::Value& workflow, const Json::Value& workspaceJson, const std::string& model) const;
+    /// 取 (workspace, route, model) 的编译模板，未命中时以 destinationWorkflow 编译并缓存
+    std::shared_ptr<const RetoolCompiledTemplate> compiledTemplateFor(const std::string& workspaceId,
+                                                                      const std::string& route,
+                                                                      const Json::Value& destinationWorkflow,
+                                                                      const Json::Value& workspaceJson,
+                                                                      const std::string& model) const;
+    /// 该 workspace 的 agent 是否已按 signature（agentId、模型、资源绑定）保存过且未超过模板 TTL
+    bool agentBindingApplied(const std::string& workspaceId, const std::string& signature) const;
+    void rememberAgentBinding(const std::string& workspaceId, const std::string& signature);
+    void forgetAgentBinding(const std::string& workspaceId);
+    /// 同一 workspace 的“检查绑定 - 保存 agent - 记录绑定”需串行，避免并发请求以不同模型互相覆盖
+    std::shared_ptr<std::mutex> agentBindingMutexFor(const std::string& workspaceId);
+
+    /// 在 agent 下新建空 thread；失败时返回 nullopt 并写入 error
+    std::optional<std::string> createAgentThread(const std::string& baseUrl,
+                                                 const std::string& agentId,
+                                                 const Json::Value& workspaceJson,
+                                                 std::string* error) const;
+    /// 按最近新会话需求为 workspace 的 agent 预建空 thread
+    void prewarmAgentThreads();
+
+    struct AppliedAgentBinding
+    {
+        std::string signature;
+        std::chrono::steady_clock::time_point appliedAt;
+    };
 
     Json::Value modelListOpenAiFormat_{Json::objectValue};
-    std::mutex threadMutex_;
-    std::unordered_map<std::string, std::string> agentThreadMap_;
-    std::unordered_map<std::string, std::string> conversationWorkspaceMap_;
+    mutable std::mutex threadMutex_;
+    std::atomic<bool> threadPrewarmRunning_{false};
+    std::unordered_map<std::string, AppliedAgentBinding> appliedAgentBindings_; // workspaceId -> 已保存到 agent 的绑定
+    std::unordered_map<std::string, std::shared_ptr<std::mutex>> agentBindingMutexes_; // workspaceId -> 绑定保存锁
+    mutable RetoolTemplateCache templateCache_;
 };
 
 #endif
@@ -0,0 +1,156 @@
+#include "ChannelRouter.h"
+#include <algorithm>
+
+ChannelRouter& ChannelRouter::getInstance()
+{
+    static ChannelRouter instance;
+    return instance;
+}
+
+std::vector<ChannelRouter::Candidate> ChannelRouter::candidates(const std::string& model,
+                                                                const std::string& preferredChannel,
+                                                                const RuntimeConfig::ModelRouting& routing,
+                                                                const std::vector<ChannelState>& channels,
+                                                                Clock::time_point now) const
+{
+    std::vector<Candidate> ordered;
+    auto addCandidate = [&ordered](const std::string& channel, const std::string& upstreamModel) {
+        for (const auto& existing : ordered) {
+            if (existing.channel == channel && existing.model == upstreamModel) {
+                return;
+            }
+        }
+        ordered.push_back(Candidate{channel, upstreamModel});
+    };
+
+    if (!preferredChannel.empty()) {
+        addCandidate(preferredChannel, model);
+    }
+    auto it = routing.routes.find(model);
+    if (it != routing.routes.end()) {
+        for (const auto& target : it->second) {
+            addCandidate(target.channel, target.model);
+        }
+    }
+
+    auto stateOf = [&channels](const std::string& name) {
+        for (const auto& channel : channels) {
+            if (channel.name == name) {
+                return channel;
+            }
+        }
+        ChannelState state;
+        state.name = name;
+        return state;
+    };
+    std::stable_sort(ordered.begin(), ordered.end(), [&stateOf](const Candidate& a, const Candidate& b) {
+        return stateOf(a.channel).priority > stateOf(b.channel).priority;
+    });
+
+    std::vector<Candidate> available;
+    for (const auto& candidate : ordered) {
+        if (stateOf(candidate.channel).enabled && !isOpen(candidate.channel, now)) {
+            available.push_back(candidate);
+        }
+    }
+    return available.empty() ? ordered : available;
+}
+
+bool ChannelRouter::record(const std::string& channel, bool success, const RuntimeConfig::ModelRouting& routing,
+                           Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& breaker = breakers_[channel];
+    const bool halfOpen = breaker.open && now >= breaker.openUntil;
+    breaker.probeInFlight = false;
+    if (success) {
+        breaker.consecutiveFailures = 0;
+        // 熔断前已发出的调用在熔断期内成功不提前恢复，只有半开探测成功才关闭
+        if (halfOpen) {
+            breaker.open = false;
+            breaker.lastOpenSeconds = 0;
+        }
+        return false;
+    }
+
+    breaker.consecutiveFailures++;
+    int openSeconds = 0;
+    if (halfOpen) {
+        openSeconds = std::min(std::max(breaker.lastOpenSeconds, 1) * 2, routing.maxOpenSeconds);
+    } else if (!breaker.open && breaker.consecutiveFailures >= routing.failureThreshold) {
+        openSeconds = routing.openSeconds;
+    }
+    if (openSeconds <= 0) {
+        return false;
+    }
+
+    breaker.open = true;
+    breaker.openUntil = now + std::chrono::seconds(openSeconds);
+    breaker.lastOpenSeconds = openSeconds;
+    return true;
+}
+
+bool ChannelRouter::rejects(const Breaker& breaker, Clock::time_point now)
+{
+    if (!breaker.open) {
+        return false;
+    }
+    return now < breaker.openUntil || (breaker.probeInFlight && now - breaker.probeStartedAt < kProbeTimeout);
+}
+
+bool ChannelRouter::isOpen(const std::string& channel, Clock::time_point now) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = breakers_.find(channel);
+    return it != breakers_.end() && rejects(it->second, now);
+}
+
+bool ChannelRouter::beginProbe(const std::string& channel, Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = breakers_.find(channel);
+    if (it == breakers_.end() || !it->second.open) {
+        return true;
+    }
+    if (rejects(it->second, now)) {
+        return false;
+    }
+    it->second.probeInFlight = true;
+    it->second.probeStartedAt = now;
+    return true;
+}
+
+void ChannelRouter::abortProbe(const std::string& channel)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = breakers_.find(channel);
+    if (it != breakers_.end()) {
+        it->second.probeInFlight = false;
+    }
+}
+
+void ChannelRouter::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    breakers_.clear();
+}
+
+bool ChannelRouter::isRetryable(const provider::ProviderError& error)
+{
+    switch (error.code) {
+        case provider::ProviderErrorCode::NetworkError:
+        case provider::ProviderErrorCode::RateLimited:
+        case provider::ProviderErrorCode::Timeout:
+        case provider::ProviderErrorCode::ServiceUnavailable:
+            return true;
+        case provider::ProviderErrorCode::None:
+            return false;
+        default:
+            return error.httpStatusCode >= 500 || error.httpStatusCode == 402;
+    }
+}
+
+bool ChannelRouter::countsAsChannelFailure(const provider::ProviderError& error)
+{
+    return isRetryable(error) && !error.localRejection;
+}
@@ -0,0 +1,94 @@
+#ifndef CHANNEL_ROUTER_H
+#define CHANNEL_ROUTER_H
+
+#include <apipoint/ProviderResult.h>
+#include <utils/RuntimeConfig.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 同一模型的跨渠道候选排序与渠道熔断
+ *
+ * 候选 = 请求路径对应的渠道（请求模型）+ model_routing.routes[模型] 中配置的 (渠道, 上游模型)，
+ * 去重后按渠道 priority 降序稳定排序，同优先级时请求路径渠道在前。禁用或熔断中的渠道被跳过；
+ * 全部不可用时按排序结果原样返回，仍尝试一次，不因熔断直接拒绝请求。
+ *
+ * 渠道连续 failureThreshold 次可重试失败后熔断 openSeconds 秒，到期后半开：只放行一个探测调用，
+ * 调用方发出请求前调用 beginProbe() 占用，探测成功则恢复，失败则以翻倍时长（最长 maxOpenSeconds）
+ * 重新熔断；探测超过 kProbeTimeout 未上报视为丢失，允许下一个调用方重新探测。
+ * 本地限流拒绝（ProviderError::localRejection）未到达上游，不计入熔断。
+ */
+class ChannelRouter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct ChannelState
+    {
+        std::string name;
+        int priority = 0;
+        bool enabled = true;
+    };
+
+    struct Candidate
+    {
+        std::string channel;
+        std::string model;
+    };
+
+    static ChannelRouter& getInstance();
+
+    ChannelRouter(const ChannelRouter&) = delete;
+    ChannelRouter& operator=(const ChannelRouter&) = delete;
+
+    /// channels 中找不到的渠道按 priority 0、启用处理
+    std::vector<Candidate> candidates(const std::string& model,
+                                      const std::string& preferredChannel,
+                                      const RuntimeConfig::ModelRouting& routing,
+                                      const std::vector<ChannelState>& channels,
+                                      Clock::time_point now = Clock::now()) const;
+
+    /// 上报一次渠道调用结果，本次上报导致熔断时返回 true
+    bool record(const std::string& channel, bool success, const RuntimeConfig::ModelRouting& routing,
+                Clock::time_point now = Clock::now());
+
+    /// 渠道是否拒绝调用：熔断期内，或半开且已有探测在途
+    bool isOpen(const std::string& channel, Clock::time_point now = Clock::now()) const;
+
+    /// 发出调用前占用：半开时占用唯一的探测名额；渠道拒绝调用时返回 false
+    bool beginProbe(const std::string& channel, Clock::time_point now = Clock::now());
+    /// 调用未产生可计入熔断的结果（本地拒绝、非可重试错误）时释放探测名额
+    void abortProbe(const std::string& channel);
+
+    void clear();
+
+    /// 网络错误、超时、限流、服务不可用、上游 5xx 与预算耗尽（402）可换渠道重试
+    static bool isRetryable(const provider::ProviderError& error);
+    /// 可重试且由上游产生的失败才计入渠道熔断
+    static bool countsAsChannelFailure(const provider::ProviderError& error);
+
+    static constexpr std::chrono::seconds kProbeTimeout{120};
+
+private:
+    ChannelRouter() = default;
+
+    struct Breaker
+    {
+        int consecutiveFailures = 0;
+        bool open = false;
+        Clock::time_point openUntil;
+        int lastOpenSeconds = 0;
+        bool probeInFlight = false;
+        Clock::time_point probeStartedAt;
+    };
+
+    static bool rejects(const Breaker& breaker, Clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Breaker> breakers_;
+};
+
+#endif
@@ -2,12 +2,13 @@
 
 #include <drogon/HttpFilter.h>
 #include <drogon/drogon.h>
+#include <utils/RuntimeConfig.h>
 
 /**
  * @brief Bearer Token 认证过滤器，用于保护 /aichat/* 管理接口。
  *
  * 从请求头 Authorization: Bearer <key> 中提取 token，
- * 与 config.json custom_config.admin_api_key 比对。
+ * 与运行期配置快照中的 custom_config.admin_api_key 比对（支持热重载）。
  * - key 匹配 → 放行
  * - key 不匹配 → 401
  * - admin_api_key 未配置或为空 → 跳过认证（向后兼容），并在首次启动时输出 WARN
@@ -19,13 +20,9 @@ public:
                   drogon::FilterCallback &&fcb,
                   drogon::FilterChainCallback &&fccb) override
     {
-        // 从 自定义配置中读取 admin_api_key
-        const auto &customConfig = drogon::app().getCustomConfig();
-        std::string configuredKey;
-        if (customConfig.isMember("admin_api_key") &&
-            customConfig["admin_api_key"].isString()) {
-            configuredKey = customConfig["admin_api_key"].asString();
-        }
+        // 从运行期配置快照读取 admin_api_key
+        const auto config = RuntimeConfigStore::getInstance().current();
+        const std::string &configuredKey = config->adminApiKey;
 
         // 如果 admin_api_key 未配置或为空，跳过认证（向后兼容）
         if (configuredKey.empty()) {
@@ -31,6 +31,7 @@ using namespace drogon;
 
 namespace {
 
+// 路径只决定首选渠道；同一模型的备选渠道由 model_routing 与渠道优先级决定（见 ChannelRouter）
 std::string inferProviderFromPath(const HttpRequestPtr& req)
 {
     const auto path = req ? req->path() : "";
@@ -0,0 +1,38 @@
+#include "ConfigController.h"
+#include "ControllerUtils.h"
+#include <utils/RuntimeConfig.h>
+
+using namespace drogon;
+
+void ConfigController::reload(const HttpRequestPtr &req, std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    LOG_INFO << "[ConfigCtrl] 收到配置重载请求";
+
+    auto& store = RuntimeConfigStore::getInstance();
+    const auto result = store.reload();
+
+    Json::Value response(Json::objectValue);
+    response["reloaded"] = result.valid;
+    response["version"] = static_cast<Json::UInt64>(store.version());
+
+    Json::Value errors(Json::arrayValue);
+    for (const auto& error : result.errors) {
+        LOG_ERROR << "[ConfigCtrl] 配置重载失败：" << error;
+        errors.append(error);
+    }
+    Json::Value warnings(Json::arrayValue);
+    for (const auto& warning : result.warnings) {
+        LOG_WARN << "[ConfigCtrl] 配置重载告警：" << warning;
+        warnings.append(warning);
+    }
+    response["errors"] = errors;
+    response["warnings"] = warnings;
+
+    if (!result.valid) {
+        ctl::sendJson(callback, response, k400BadRequest);
+        return;
+    }
+
+    LOG_INFO << "[ConfigCtrl] 运行期配置已重载，版本：" << store.version();
+    ctl::sendJson(callback, response);
+}
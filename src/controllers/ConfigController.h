@@ -0,0 +1,20 @@
+#pragma once
+
+#include "AdminAuthFilter.h"
+#include <drogon/HttpController.h>
+
+/**
+ * @brief 运行期配置管理 Controller
+ *
+ * 端点:
+ *   POST /aichat/config/reload   – 重新读取配置文件并原子发布新的运行期配置快照
+ */
+class ConfigController : public drogon::HttpController<ConfigController>
+{
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(ConfigController::reload, "/aichat/config/reload", drogon::Post, "AdminAuthFilter");
+    METHOD_LIST_END
+
+    void reload(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+};
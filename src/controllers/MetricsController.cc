@@ -2,6 +2,11 @@
 #include "ControllerUtils.h"
 #include "ErrorStatsDbManager.h"
 #include "StatusDbManager.h"
+#include <utils/RateLimiter.h>
+#include <utils/RuntimeConfig.h>
+#include <metrics/UsageQuotaService.h>
+#include <accountManager/AccountHealth.h>
+#include <accountManager/AccountThrottle.h>
 
 using namespace drogon;
 
@@ -322,3 +327,116 @@ void MetricsController::getStatusModels(const HttpRequestPtr &req, std::function
 
     ctl::sendJson(callback, response);
 }
+
+// ========== 限流 ==========
+
+void MetricsController::getRateLimitStats(const HttpRequestPtr &req, std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    int limit = 20;
+    std::string limitStr = req->getParameter("limit");
+    if (!limitStr.empty()) { try { limit = std::stoi(limitStr); } catch (...) {} }
+    if (limit <= 0) limit = 20;
+    if (limit > 500) limit = 500;
+
+    auto& limiter = RateLimiter::getInstance();
+
+    Json::Value response(Json::objectValue);
+    response["active_keys"]     = static_cast<Json::UInt64>(limiter.size());
+    response["total_allowed"]   = static_cast<Json::UInt64>(limiter.totalAllowed());
+    response["total_throttled"] = static_cast<Json::UInt64>(limiter.totalThrottled());
+    response["total_evicted"]   = static_cast<Json::UInt64>(limiter.totalEvicted());
+
+    Json::Value data(Json::arrayValue);
+    for (const auto& stats : limiter.topThrottled(static_cast<size_t>(limit))) {
+        Json::Value item;
+        item["key"]       = stats.key;
+        item["allowed"]   = static_cast<Json::UInt64>(stats.allowed);
+        item["throttled"] = static_cast<Json::UInt64>(stats.throttled);
+        data.append(item);
+    }
+    response["throttled_keys"] = data;
+
+    ctl::sendJson(callback, response);
+}
+
+// ========== token 用量 ==========
+
+void MetricsController::getUsageStats(const HttpRequestPtr &, std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    const auto config = RuntimeConfigStore::getInstance().current();
+    auto& service = metrics::UsageQuotaService::getInstance();
+
+    Json::Value response(Json::objectValue);
+    response["quota_enabled"]   = config->quota.enabled;
+    response["window_seconds"]  = config->quota.windowSeconds;
+    response["pending_records"] = static_cast<Json::UInt64>(service.pendingSize());
+
+    Json::Value data(Json::arrayValue);
+    for (const auto& usage : service.snapshot()) {
+        Json::Value item;
+        item["api_key"]       = usage.apiKey;
+        item["window_start"]  = static_cast<Json::Int64>(usage.windowStart);
+        item["input_tokens"]  = static_cast<Json::Int64>(usage.inputTokens);
+        item["output_tokens"] = static_cast<Json::Int64>(usage.outputTokens);
+        data.append(item);
+    }
+    response["data"]  = data;
+    response["count"] = static_cast<Json::UInt64>(data.size());
+
+    ctl::sendJson(callback, response);
+}
+
+// ========== 账号健康度 ==========
+
+void MetricsController::getAccountHealth(const HttpRequestPtr &req, std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    const std::string apiName = req->getParameter("apiName");
+    auto& health = AccountHealthTracker::getInstance();
+    const auto settings = health.settings();
+
+    Json::Value response(Json::objectValue);
+    response["error_threshold"]      = settings.errorThreshold;
+    response["consecutive_failures"] = settings.consecutiveFailures;
+    response["open_seconds"]         = settings.openSeconds;
+
+    Json::Value data(Json::arrayValue);
+    int openCount = 0;
+    for (const auto& stats : health.snapshot(apiName)) {
+        Json::Value item;
+        item["apiName"]                = stats.apiName;
+        item["userName"]               = stats.userName;
+        item["latency_ewma_ms"]        = stats.latencyEwmaMs;
+        item["error_rate_ewma"]        = stats.errorRateEwma;
+        item["samples"]                = static_cast<Json::UInt64>(stats.samples);
+        item["successes"]              = static_cast<Json::UInt64>(stats.successes);
+        item["failures"]               = static_cast<Json::UInt64>(stats.failures);
+        item["consecutive_failures"]   = stats.consecutiveFailures;
+        item["circuit"]                = AccountHealthTracker::stateName(stats.state);
+        item["open_remaining_seconds"] = static_cast<Json::Int64>(stats.openRemainingSeconds);
+        item["trips"]                  = static_cast<Json::UInt64>(stats.trips);
+        if (stats.state == AccountHealthTracker::CircuitState::Open) {
+            ++openCount;
+        }
+        data.append(item);
+    }
+    response["data"]       = data;
+    response["count"]      = static_cast<Json::UInt64>(data.size());
+    response["open_count"] = openCount;
+
+    // 上游限流：冷却中、有在途请求或学习到速率上限的账号
+    Json::Value throttle(Json::arrayValue);
+    for (const auto& stats : AccountThrottle::getInstance().snapshot(apiName)) {
+        Json::Value item;
+        item["apiName"]                   = stats.provider;
+        item["account"]                   = stats.account;
+        item["in_flight"]                 = stats.inFlight;
+        item["cooling_remaining_seconds"] = static_cast<Json::Int64>(stats.coolingRemainingSeconds);
+        item["learned_per_minute"]        = stats.learnedPerMinute;
+        item["rate_limited"]              = static_cast<Json::UInt64>(stats.rateLimitedCount);
+        item["rejected"]                  = static_cast<Json::UInt64>(stats.rejectedCount);
+        throttle.append(item);
+    }
+    response["throttle"] = throttle;
+
+    ctl::sendJson(callback, response);
+}
@@ -14,6 +14,9 @@
  *   GET /aichat/metrics/status/summary        – 服务状态概览
  *   GET /aichat/metrics/status/channels       – 渠道状态列表
  *   GET /aichat/metrics/status/models         – 模型状态列表
+ *   GET /aichat/metrics/ratelimit             – 限流统计（被拒绝最多的 key）
+ *   GET /aichat/metrics/usage                 – 当前额度窗口内各 API Key 的 token 用量
+ *   GET /aichat/metrics/accounts              – 账号健康度（延迟/错误率 EWMA、熔断状态、429 冷却）
  */
 class MetricsController : public drogon::HttpController<MetricsController>
 {
@@ -26,6 +29,9 @@ class MetricsController : public drogon::HttpController<MetricsController>
     ADD_METHOD_TO(MetricsController::getStatusSummary,    "/aichat/metrics/status/summary",      drogon::Get, "AdminAuthFilter");
     ADD_METHOD_TO(MetricsController::getStatusChannels,   "/aichat/metrics/status/channels",     drogon::Get, "AdminAuthFilter");
     ADD_METHOD_TO(MetricsController::getStatusModels,     "/aichat/metrics/status/models",       drogon::Get, "AdminAuthFilter");
+    ADD_METHOD_TO(MetricsController::getRateLimitStats,   "/aichat/metrics/ratelimit",           drogon::Get, "AdminAuthFilter");
+    ADD_METHOD_TO(MetricsController::getUsageStats,       "/aichat/metrics/usage",               drogon::Get, "AdminAuthFilter");
+    ADD_METHOD_TO(MetricsController::getAccountHealth,    "/aichat/metrics/accounts",            drogon::Get, "AdminAuthFilter");
     METHOD_LIST_END
 
     void getRequestsSeries(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
@@ -35,4 +41,7 @@ class MetricsController : public drogon::HttpController<MetricsController>
     void getStatusSummary(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
     void getStatusChannels(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
     void getStatusModels(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getRateLimitStats(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getUsageStats(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getAccountHealth(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
 };
@@ -1,59 +1,50 @@
 #pragma once
 
-#include <chrono>
 #include <drogon/drogon.h>
 #include <drogon/HttpFilter.h>
-#include <mutex>
 #include <string>
-#include <unordered_map>
+#include <metrics/UsageQuotaService.h>
+#include <utils/RateLimiter.h>
+#include <utils/RuntimeConfig.h>
 
 class RateLimitFilter : public drogon::HttpFilter<RateLimitFilter> {
 public:
     void doFilter(const drogon::HttpRequestPtr& req,
                   drogon::FilterCallback&& fcb,
                   drogon::FilterChainCallback&& fccb) override {
-        const auto& customConfig = drogon::app().getCustomConfig();
-        const auto& rateLimit = customConfig["rate_limit"];
+        const auto config = RuntimeConfigStore::getInstance().current();
+        const auto& rateLimit = config->rateLimit;
 
-        if (!rateLimit.isObject() || !rateLimit.get("enabled", false).asBool()) {
+        if (!rateLimit.enabled) {
             fccb();
             return;
         }
 
-        const int requestsPerSecond = rateLimit.get("requests_per_second", 10).asInt();
-        const int burst = rateLimit.get("burst", 20).asInt();
+        int requestsPerSecond = rateLimit.requestsPerSecond;
+        int burst = rateLimit.burst;
+        std::string key = buildIdentity(req, rateLimit);
+
+        // 命中按路由配置时使用独立的桶，不占用全局桶的令牌
+        auto routeIt = rateLimit.routes.find(req->path());
+        if (routeIt != rateLimit.routes.end()) {
+            requestsPerSecond = routeIt->second.requestsPerSecond;
+            burst = routeIt->second.burst;
+            key = routeIt->first + "|" + key;
+        }
+
         if (requestsPerSecond <= 0 || burst <= 0) {
             fccb();
             return;
         }
 
-        const std::string key = req->peerAddr().toIp();
-        const auto now = std::chrono::steady_clock::now();
-
-        bool allowed = false;
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            auto& bucket = buckets_[key];
-            if (bucket.lastRefill.time_since_epoch().count() == 0) {
-                bucket.tokens = static_cast<double>(burst);
-                bucket.lastRefill = now;
-            }
-
-            const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - bucket.lastRefill).count();
-            bucket.tokens = std::min<double>(burst, bucket.tokens + elapsed * requestsPerSecond);
-            bucket.lastRefill = now;
-
-            if (bucket.tokens >= 1.0) {
-                bucket.tokens -= 1.0;
-                allowed = true;
-            }
-        }
-
-        if (allowed) {
+        const auto decision = RateLimiter::getInstance().acquire(key, requestsPerSecond, burst);
+        if (decision.allowed) {
             fccb();
             return;
         }
 
+        LOG_DEBUG << "[限流] 拒绝请求 key=" << key << " path=" << req->path();
+
         Json::Value error;
         error["error"]["message"] = "Rate limit exceeded";
         error["error"]["type"] = "rate_limit_error";
@@ -61,17 +52,64 @@ public:
 
         auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
         resp->setStatusCode(drogon::k429TooManyRequests);
-        resp->addHeader("Retry-After", "1");
+        resp->addHeader("Retry-After", std::to_string(decision.retryAfterSeconds));
         fcb(resp);
     }
 
 private:
-    struct TokenBucket {
-        double tokens = 0.0;
-        std::chrono::steady_clock::time_point lastRefill;
-    };
+    static std::string buildIdentity(const drogon::HttpRequestPtr& req, const RuntimeConfig::RateLimit& rateLimit) {
+        using KeyPart = RuntimeConfig::RateLimit::KeyPart;
+        std::string identity;
+        for (const auto part : rateLimit.keyBy) {
+            if (!identity.empty()) identity += "|";
+            switch (part) {
+                case KeyPart::ApiKey: {
+                    // 限流 key 会出现在监控接口中，不保存明文 API Key
+                    const std::string apiKey = bearerToken(req);
+                    identity += apiKey.empty() ? "ip:" + req->peerAddr().toIp() : "key:" + metrics::UsageQuotaService::maskKey(apiKey);
+                    break;
+                }
+                case KeyPart::ForwardedFor: {
+                    const std::string forwarded = firstForwardedFor(req);
+                    identity += "ip:" + (forwarded.empty() ? req->peerAddr().toIp() : forwarded);
+                    break;
+                }
+                case KeyPart::ClientType:
+                    identity += "client:" + clientType(req);
+                    break;
+                case KeyPart::Ip:
+                default:
+                    identity += "ip:" + req->peerAddr().toIp();
+                    break;
+            }
+        }
+        return identity;
+    }
 
-    std::mutex mutex_;
-    std::unordered_map<std::string, TokenBucket> buckets_;
-};
+    static std::string bearerToken(const drogon::HttpRequestPtr& req) {
+        std::string auth = req->getHeader("Authorization");
+        if (auth.rfind("Bearer ", 0) == 0 || auth.rfind("bearer ", 0) == 0) {
+            auth = auth.substr(7);
+        }
+        return auth;
+    }
 
+    static std::string firstForwardedFor(const drogon::HttpRequestPtr& req) {
+        const std::string& header = req->getHeader("X-Forwarded-For");
+        const auto comma = header.find(',');
+        std::string first = header.substr(0, comma);
+        const auto begin = first.find_first_not_of(" \t");
+        if (begin == std::string::npos) {
+            return "";
+        }
+        const auto end = first.find_last_not_of(" \t");
+        return first.substr(begin, end - begin + 1);
+    }
+
+    static std::string clientType(const drogon::HttpRequestPtr& req) {
+        const std::string& userAgent = req->getHeader("User-Agent");
+        if (userAgent.find("Kilo-Code") != std::string::npos) return "Kilo-Code";
+        if (userAgent.find("RooCode") != std::string::npos) return "RooCode";
+        return userAgent.empty() ? "unknown" : userAgent;
+    }
+};
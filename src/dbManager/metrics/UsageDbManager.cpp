@@ -0,0 +1,111 @@
+#include "UsageDbManager.h"
+#include <algorithm>
+
+namespace metrics {
+
+static const char* CREATE_USAGE_AGG_HOUR_PG = R"(
+CREATE TABLE IF NOT EXISTS usage_agg_hour (
+    bucket_start TIMESTAMP NOT NULL,
+    api_key VARCHAR(64) NOT NULL DEFAULT '',
+    provider VARCHAR(64) NOT NULL DEFAULT '',
+    model VARCHAR(128) NOT NULL DEFAULT '',
+    input_tokens BIGINT NOT NULL DEFAULT 0,
+    output_tokens BIGINT NOT NULL DEFAULT 0,
+    request_count BIGINT NOT NULL DEFAULT 0,
+    estimated_count BIGINT NOT NULL DEFAULT 0,
+    PRIMARY KEY (bucket_start, api_key, provider, model)
+)
+)";
+
+static const char* CREATE_USAGE_AGG_HOUR_SQLITE = R"(
+CREATE TABLE IF NOT EXISTS usage_agg_hour (
+    bucket_start TEXT NOT NULL,
+    api_key TEXT NOT NULL DEFAULT '',
+    provider TEXT NOT NULL DEFAULT '',
+    model TEXT NOT NULL DEFAULT '',
+    input_tokens INTEGER NOT NULL DEFAULT 0,
+    output_tokens INTEGER NOT NULL DEFAULT 0,
+    request_count INTEGER NOT NULL DEFAULT 0,
+    estimated_count INTEGER NOT NULL DEFAULT 0,
+    PRIMARY KEY (bucket_start, api_key, provider, model)
+)
+)";
+
+std::shared_ptr<UsageDbManager> UsageDbManager::getInstance() {
+    static std::shared_ptr<UsageDbManager> instance = std::make_shared<UsageDbManager>();
+    return instance;
+}
+
+void UsageDbManager::detectDbType() {
+    auto customConfig = drogon::app().getCustomConfig();
+    std::string dbTypeStr = "postgresql";
+    if (customConfig.isMember("dbtype")) {
+        dbTypeStr = customConfig["dbtype"].asString();
+    }
+    std::transform(dbTypeStr.begin(), dbTypeStr.end(), dbTypeStr.begin(), ::tolower);
+    isPostgres_ = !(dbTypeStr == "sqlite3" || dbTypeStr == "sqlite");
+}
+
+bool UsageDbManager::ensureReady() {
+    std::lock_guard<std::mutex> lock(initMutex_);
+    if (tableReady_) {
+        return true;
+    }
+    if (!dbClient_) {
+        detectDbType();
+        dbClient_ = drogon::app().getDbClient("aichatpg");
+        if (!dbClient_) {
+            LOG_ERROR << "[用量数据库] 获取数据库客户端失败";
+            return false;
+        }
+    }
+    try {
+        dbClient_->execSqlSync(isPostgres_ ? CREATE_USAGE_AGG_HOUR_PG : CREATE_USAGE_AGG_HOUR_SQLITE);
+        tableReady_ = true;
+        LOG_INFO << "[用量数据库] 表结构检查完成";
+    } catch (const std::exception& e) {
+        LOG_ERROR << "[用量数据库] 创建表失败：" << e.what();
+    }
+    return tableReady_;
+}
+
+bool UsageDbManager::upsertUsageAggHour(const std::vector<UsageAggRecord>& records) {
+    if (records.empty()) return true;
+    if (!ensureReady()) return false;
+
+    try {
+        auto trans = dbClient_->newTransaction();
+        for (const auto& r : records) {
+            if (isPostgres_) {
+                trans->execSqlSync(
+                    "INSERT INTO usage_agg_hour (bucket_start, api_key, provider, model, input_tokens, output_tokens, "
+                    "request_count, estimated_count) VALUES ($1, $2, $3, $4, $5, $6, $7, $8) "
+                    "ON CONFLICT (bucket_start, api_key, provider, model) DO UPDATE SET "
+                    "input_tokens = usage_agg_hour.input_tokens + $5, "
+                    "output_tokens = usage_agg_hour.output_tokens + $6, "
+                    "request_count = usage_agg_hour.request_count + $7, "
+                    "estimated_count = usage_agg_hour.estimated_count + $8",
+                    r.bucketStart, r.apiKey, r.provider, r.model,
+                    r.inputTokens, r.outputTokens, r.requestCount, r.estimatedCount
+                );
+            } else {
+                trans->execSqlSync(
+                    "INSERT OR REPLACE INTO usage_agg_hour (bucket_start, api_key, provider, model, input_tokens, "
+                    "output_tokens, request_count, estimated_count) VALUES ($1, $2, $3, $4, "
+                    "COALESCE((SELECT input_tokens FROM usage_agg_hour WHERE bucket_start=$1 AND api_key=$2 AND provider=$3 AND model=$4), 0) + $5, "
+                    "COALESCE((SELECT output_tokens FROM usage_agg_hour WHERE bucket_start=$1 AND api_key=$2 AND provider=$3 AND model=$4), 0) + $6, "
+                    "COALESCE((SELECT request_count FROM usage_agg_hour WHERE bucket_start=$1 AND api_key=$2 AND provider=$3 AND model=$4), 0) + $7, "
+                    "COALESCE((SELECT estimated_count FROM usage_agg_hour WHERE bucket_start=$1 AND api_key=$2 AND provider=$3 AND model=$4), 0) + $8)",
+                    r.bucketStart, r.apiKey, r.provider, r.model,
+                    r.inputTokens, r.outputTokens, r.requestCount, r.estimatedCount
+                );
+            }
+        }
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR << "[用量数据库] 批量写入用量聚合失败：" << e.what();
+        return false;
+    }
+}
+
+} // namespace metrics
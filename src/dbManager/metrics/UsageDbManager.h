@@ -0,0 +1,41 @@
+#ifndef USAGE_DB_MANAGER_H
+#define USAGE_DB_MANAGER_H
+
+#include <drogon/drogon.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../../metrics/UsageQuotaService.h"
+
+namespace metrics {
+
+/**
+ * @brief 客户端 token 用量数据库管理器 - 单例
+ *
+ * 负责 usage_agg_hour 表（按小时 × API Key × provider × model 聚合）的建表与批量累加写入。
+ */
+class UsageDbManager {
+public:
+    static std::shared_ptr<UsageDbManager> getInstance();
+
+    /**
+     * @brief 在单个事务中累加写入一批聚合记录
+     */
+    bool upsertUsageAggHour(const std::vector<UsageAggRecord>& records);
+
+private:
+    /**
+     * @brief 确保数据库客户端与表结构已初始化（延迟初始化）
+     */
+    bool ensureReady();
+    void detectDbType();
+
+    std::shared_ptr<drogon::orm::DbClient> dbClient_;
+    bool isPostgres_ = true;
+    bool tableReady_ = false;
+    std::mutex initMutex_;
+};
+
+} // namespace metrics
+
+#endif
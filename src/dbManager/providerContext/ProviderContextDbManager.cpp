@@ -0,0 +1,192 @@
+#include "ProviderContextDbManager.h"
+#include <algorithm>
+
+namespace {
+Json::Value parseContextValue(const std::string& text)
+{
+    Json::Value value;
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if (!reader->parse(text.data(), text.data() + text.size(), &value, &errs)) {
+        return Json::Value();
+    }
+    return value;
+}
+
+std::string compactContextValue(const Json::Value& value)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, value);
+}
+} // namespace
+
+void ProviderContextDbManager::detectDbType()
+{
+    auto customConfig = drogon::app().getCustomConfig();
+    std::string dbTypeStr = "postgresql";
+
+    if (customConfig.isMember("dbtype")) {
+        dbTypeStr = customConfig["dbtype"].asString();
+    }
+
+    std::transform(dbTypeStr.begin(), dbTypeStr.end(), dbTypeStr.begin(), ::tolower);
+
+    if (dbTypeStr == "sqlite3" || dbTypeStr == "sqlite") {
+        dbType_ = DbType::SQLite3;
+    } else if (dbTypeStr == "mysql" || dbTypeStr == "mariadb") {
+        dbType_ = DbType::MySQL;
+    } else {
+        dbType_ = DbType::PostgreSQL;
+    }
+}
+
+std::string ProviderContextDbManager::getCreateTableSql() const
+{
+    switch (dbType_) {
+        case DbType::SQLite3:
+            return R"(
+                CREATE TABLE IF NOT EXISTS provider_context (
+                    provider TEXT NOT NULL,
+                    context_key TEXT NOT NULL,
+                    context_value TEXT NOT NULL,
+                    expires_at INTEGER NOT NULL,
+                    updatetime DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    PRIMARY KEY (provider, context_key)
+                );
+            )";
+        case DbType::MySQL:
+            return R"(
+                CREATE TABLE IF NOT EXISTS provider_context (
+                    provider VARCHAR(64) NOT NULL,
+                    context_key VARCHAR(255) NOT NULL,
+                    context_value TEXT NOT NULL,
+                    expires_at BIGINT NOT NULL,
+                    updatetime DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    PRIMARY KEY (provider, context_key)
+                ) ENGINE=InnoDB;
+            )";
+        case DbType::PostgreSQL:
+        default:
+            return R"(
+                CREATE TABLE IF NOT EXISTS provider_context (
+                    provider VARCHAR(64) NOT NULL,
+                    context_key VARCHAR(255) NOT NULL,
+                    context_value TEXT NOT NULL,
+                    expires_at BIGINT NOT NULL,
+                    updatetime TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+                    PRIMARY KEY (provider, context_key)
+                );
+            )";
+    }
+}
+
+bool ProviderContextDbManager::ensureTable(std::string* errorMessage)
+{
+    if (!dbClient_) {
+        if (errorMessage) {
+            *errorMessage = "未获取到数据库客户端";
+        }
+        return false;
+    }
+    if (tableReady_) {
+        return true;
+    }
+
+    try {
+        dbClient_->execSqlSync(getCreateTableSql());
+        tableReady_ = true;
+        return true;
+    } catch (const std::exception& ex) {
+        if (errorMessage) {
+            *errorMessage = std::string("创建上游会话上下文表失败: ") + ex.what();
+        }
+        return false;
+    }
+}
+
+std::vector<ProviderContextStore::Record> ProviderContextDbManager::loadActive(int64_t nowSeconds, std::string* errorMessage)
+{
+    std::vector<ProviderContextStore::Record> records;
+    if (!ensureTable(errorMessage)) {
+        return records;
+    }
+
+    try {
+        auto result = dbClient_->execSqlSync(
+            "select provider, context_key, context_value, expires_at from provider_context where expires_at > $1",
+            nowSeconds);
+        records.reserve(result.size());
+        for (const auto& row : result) {
+            ProviderContextStore::Record record;
+            record.ns = row["provider"].as<std::string>();
+            record.key = row["context_key"].as<std::string>();
+            record.value = parseContextValue(row["context_value"].as<std::string>());
+            record.expiresAt = row["expires_at"].as<int64_t>();
+            records.push_back(std::move(record));
+        }
+    } catch (const std::exception& ex) {
+        if (errorMessage) {
+            *errorMessage = std::string("读取上游会话上下文失败: ") + ex.what();
+        }
+        records.clear();
+    }
+    return records;
+}
+
+bool ProviderContextDbManager::applyBatch(const std::vector<ProviderContextStore::Record>& records, std::string* errorMessage)
+{
+    if (records.empty()) {
+        return true;
+    }
+    if (!ensureTable(errorMessage)) {
+        return false;
+    }
+
+    // 先删后插，三种数据库通用；同一事务内完成，不会读到中间状态
+    try {
+        auto trans = dbClient_->newTransaction();
+        for (const auto& record : records) {
+            trans->execSqlSync(
+                "delete from provider_context where provider=$1 and context_key=$2",
+                record.ns,
+                record.key);
+            if (record.erased) {
+                continue;
+            }
+            trans->execSqlSync(
+                "insert into provider_context(provider, context_key, context_value, expires_at, updatetime) "
+                "values($1, $2, $3, $4, CURRENT_TIMESTAMP)",
+                record.ns,
+                record.key,
+                compactContextValue(record.value),
+                record.expiresAt);
+        }
+        return true;
+    } catch (const std::exception& ex) {
+        if (errorMessage) {
+            *errorMessage = std::string("写入上游会话上下文失败: ") + ex.what();
+        }
+        return false;
+    }
+}
+
+size_t ProviderContextDbManager::deleteExpired(int64_t nowSeconds, std::string* errorMessage)
+{
+    if (!ensureTable(errorMessage)) {
+        return 0;
+    }
+
+    try {
+        auto result = dbClient_->execSqlSync(
+            "delete from provider_context where expires_at <= $1",
+            nowSeconds);
+        return result.affectedRows();
+    } catch (const std::exception& ex) {
+        if (errorMessage) {
+            *errorMessage = std::string("清理过期上游会话上下文失败: ") + ex.what();
+        }
+        return 0;
+    }
+}
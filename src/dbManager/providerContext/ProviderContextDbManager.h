@@ -0,0 +1,49 @@
+#ifndef PROVIDER_CONTEXT_DBMANAGER_H
+#define PROVIDER_CONTEXT_DBMANAGER_H
+
+#include <drogon/drogon.h>
+#include <apipoint/ProviderContextStore.h>
+#include <dbManager/DbType.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief provider 上游会话上下文持久化 - 单例
+ *
+ * provider_context 表按 (provider, context_key) 保存 ProviderContextStore 的记录，
+ * 由定时任务批量写入，启动时载入未过期的行。
+ */
+class ProviderContextDbManager {
+  public:
+    static std::shared_ptr<ProviderContextDbManager> getInstance()
+    {
+        static std::shared_ptr<ProviderContextDbManager> instance;
+        if (instance == nullptr) {
+            instance = std::make_shared<ProviderContextDbManager>();
+            instance->dbClient_ = drogon::app().getDbClient("aichatpg");
+            instance->detectDbType();
+        }
+        return instance;
+    }
+
+    bool ensureTable(std::string* errorMessage = nullptr);
+    /// 读取 expires_at 晚于 nowSeconds 的记录
+    std::vector<ProviderContextStore::Record> loadActive(int64_t nowSeconds, std::string* errorMessage = nullptr);
+    /// 在单个事务中写入一批记录，erased 的记录删除对应行
+    bool applyBatch(const std::vector<ProviderContextStore::Record>& records, std::string* errorMessage = nullptr);
+    /// 删除已过期的行，返回删除行数
+    size_t deleteExpired(int64_t nowSeconds, std::string* errorMessage = nullptr);
+
+  private:
+    void detectDbType();
+    std::string getCreateTableSql() const;
+
+    std::shared_ptr<drogon::orm::DbClient> dbClient_;
+    DbType dbType_ = DbType::PostgreSQL;
+    std::atomic<bool> tableReady_{false};
+};
+
+#endif
@@ -4,14 +4,24 @@
 #include <channelManager/channelManager.h>
 #include <sessionManager/core/Session.h>
 #include <metrics/ErrorStatsService.h>
+#include <metrics/UsageQuotaService.h>
+#include <dbManager/metrics/UsageDbManager.h>
+#include <dbManager/providerContext/ProviderContextDbManager.h>
+#include <apipoint/ProviderContextStore.h>
+#include <apipoint/UpstreamThreadPool.h>
 #include <retoolWorkspace/RetoolWorkspaceManager.h>
 #include <utils/BackgroundTaskQueue.h>
 #include <utils/ConfigValidator.h>
+#include <utils/RuntimeConfig.h>
+#include <utils/RateLimiter.h>
 #include <sessionManager/continuity/ResponseIndex.h>
 #include <controllers/HealthController.h>
 #include <controllers/AdminAuthFilter.h>
 #include <controllers/RateLimitFilter.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <csignal>
 #include <execinfo.h>
 #include <fstream>
 #include <iostream>
@@ -19,14 +29,13 @@
 
 namespace {
 
-bool validateConfigFile(const std::string& path) {
+bool validateConfigFile(const std::string& path, Json::Value& root) {
     std::ifstream in(path);
     if (!in.is_open()) {
         LOG_ERROR << "[启动] 无法打开配置文件：" << path;
         return false;
     }
 
-    Json::Value root;
     Json::CharReaderBuilder builder;
     builder["collectComments"] = false;
     std::string errs;
@@ -46,6 +55,26 @@ bool validateConfigFile(const std::string& path) {
     return validation.valid;
 }
 
+bool hasDbClient(const Json::Value& root, const std::string& name) {
+    if (!root.isMember("db_clients") || !root["db_clients"].isArray()) {
+        return false;
+    }
+    for (const auto& client : root["db_clients"]) {
+        if (client.isObject() && client["name"].isString() && client["name"].asString() == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void flushUsage() {
+    const size_t written = metrics::UsageQuotaService::getInstance().flush(
+        [](const std::vector<metrics::UsageAggRecord>& records) {
+            return metrics::UsageDbManager::getInstance()->upsertUsageAggHour(records);
+        });
+    LOG_DEBUG << "[用量统计] 已写入用量聚合 " << written << " 条";
+}
+
 const Json::Value& getCustomConfig() {
     return drogon::app().getCustomConfig();
 }
@@ -56,55 +85,119 @@ void ensureFilterReflectionRegistration() {
     (void)RateLimitFilter::classTypeName();
 }
 
-Json::Value getCorsConfig() {
-    const auto& custom = getCustomConfig();
-    if (custom.isMember("cors") && custom["cors"].isObject()) {
-        return custom["cors"];
-    }
-    Json::Value fallback(Json::objectValue);
-    fallback["allowed_origins"] = Json::arrayValue;
-    fallback["allowed_origins"].append("*");
-    fallback["allowed_methods"] = Json::arrayValue;
-    fallback["allowed_methods"].append("GET");
-    fallback["allowed_methods"].append("POST");
-    fallback["allowed_methods"].append("PUT");
-    fallback["allowed_methods"].append("DELETE");
-    fallback["allowed_methods"].append("OPTIONS");
-    fallback["allowed_methods"].append("PATCH");
-    fallback["allowed_headers"] = Json::arrayValue;
-    fallback["allowed_headers"].append("*");
-    fallback["expose_headers"] = Json::arrayValue;
-    fallback["expose_headers"].append("*");
-    fallback["allow_credentials"] = false;
-    fallback["max_age"] = 3600;
-    return fallback;
+std::atomic<bool> g_reloadRequested{false};
+
+void onSighup(int) {
+    // 信号处理函数内只置位，实际重载在事件循环中执行
+    g_reloadRequested.store(true, std::memory_order_relaxed);
+}
+
+// 注册为 RuntimeConfigStore 的发布监听器：启动发布、SIGHUP 与 HTTP 重载后立即生效
+void applyRuntimeConfig(const RuntimeConfig& config) {
+    auto& limiter = RateLimiter::getInstance();
+    limiter.setMaxKeys(static_cast<size_t>(std::max(1, config.rateLimit.maxKeys)));
+    limiter.setIdleTimeout(std::chrono::seconds(std::max(1, config.rateLimit.idleSeconds)));
+    AccountHealthTracker::getInstance().setSettings(config.accountHealth);
+    AccountThrottle::getInstance().setSettings(config.accountThrottle);
 }
 
-std::string joinJsonArray(const Json::Value& arr, const std::string& fallback) {
-    if (!arr.isArray() || arr.empty()) {
-        return fallback;
+void reloadRuntimeConfig(const char* trigger) {
+    const auto result = RuntimeConfigStore::getInstance().reload();
+    for (const auto& warning : result.warnings) {
+        LOG_WARN << "[配置重载]" << warning;
     }
-    std::string out;
-    for (Json::ArrayIndex i = 0; i < arr.size(); ++i) {
-        if (!arr[i].isString()) continue;
-        if (!out.empty()) out += ", ";
-        out += arr[i].asString();
+    for (const auto& error : result.errors) {
+        LOG_ERROR << "[配置重载]" << error;
+    }
+    if (result.valid) {
+        LOG_INFO << "[配置重载] 已发布新的运行期配置快照（" << trigger << "），版本："
+                 << RuntimeConfigStore::getInstance().version();
+    } else {
+        LOG_ERROR << "[配置重载] 校验失败，继续使用当前配置（" << trigger << "）";
     }
-    return out.empty() ? fallback : out;
 }
 
-bool isOriginAllowed(const std::string& origin, const Json::Value& allowedOrigins) {
-    if (!allowedOrigins.isArray() || allowedOrigins.empty()) {
-        return true;
-    }
-    for (const auto& item : allowedOrigins) {
-        if (!item.isString()) continue;
-        const auto v = item.asString();
-        if (v == "*" || (!origin.empty() && v == origin)) {
+// provider_context.persist 开启且已完成初始化时为 true，停机时据此补写剩余的待写上下文
+std::atomic<bool> g_providerContextPersist{false};
+
+size_t flushProviderContexts() {
+    const size_t written = ProviderContextStore::getInstance().flush(
+        [](const std::vector<ProviderContextStore::Record>& records) {
+            std::string error;
+            if (!ProviderContextDbManager::getInstance()->applyBatch(records, &error)) {
+                LOG_ERROR << "[上游上下文] 批量写库失败：" << error;
+                return false;
+            }
             return true;
+        });
+    LOG_DEBUG << "[上游上下文] 已写入 " << written << " 条";
+    return written;
+}
+
+// provider 上游会话上下文：载入库中未过期的记录，之后按间隔批量写库并回收过期条目
+void initProviderContextStore(const Json::Value& customConfig) {
+    int ttlSeconds = 86400;
+    int flushIntervalSeconds = 5;
+    bool persist = true;
+    if (customConfig.isMember("provider_context") && customConfig["provider_context"].isObject()) {
+        const auto& section = customConfig["provider_context"];
+        ttlSeconds = section.get("ttl_seconds", ttlSeconds).asInt();
+        flushIntervalSeconds = section.get("flush_interval_seconds", flushIntervalSeconds).asInt();
+        persist = section.get("persist", persist).asBool();
+    }
+
+    auto& store = ProviderContextStore::getInstance();
+    store.setTtl(std::chrono::seconds(std::max(1, ttlSeconds)));
+    if (persist) {
+        std::string error;
+        const auto nowSeconds = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        const auto records = ProviderContextDbManager::getInstance()->loadActive(nowSeconds, &error);
+        if (!error.empty()) {
+            LOG_ERROR << "[上游上下文] 载入失败：" << error;
+        } else {
+            LOG_INFO << "[上游上下文] 已载入 " << store.load(records) << " 条";
         }
     }
-    return false;
+    g_providerContextPersist.store(persist);
+
+    drogon::app().getLoop()->runEvery(static_cast<double>(std::max(1, flushIntervalSeconds)), [persist]() {
+        if (!persist || ProviderContextStore::getInstance().pendingSize() == 0) {
+            return;
+        }
+        BackgroundTaskQueue::instance().enqueue("provider_context_flush", []{ flushProviderContexts(); });
+    });
+
+    // 内存中的过期条目每分钟回收；库中的过期行随之清理
+    drogon::app().getLoop()->runEvery(60.0, [persist]() {
+        const size_t evicted = ProviderContextStore::getInstance().evictExpired();
+        if (evicted > 0) {
+            LOG_DEBUG << "[上游上下文] 回收过期条目 " << evicted << " 个，剩余 " << ProviderContextStore::getInstance().size();
+        }
+        if (!persist) {
+            return;
+        }
+        BackgroundTaskQueue::instance().enqueue("provider_context_cleanup", []{
+            const auto nowSeconds = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            ProviderContextDbManager::getInstance()->deleteExpired(nowSeconds);
+        });
+    });
+}
+
+// 预建空上游线程的数量上限与补充节奏；需在各 provider init 之前设置，补充定时任务由 provider 自行注册
+void initUpstreamThreadPool(const Json::Value& customConfig) {
+    UpstreamThreadPool::Settings settings;
+    if (customConfig.isMember("thread_prewarm") && customConfig["thread_prewarm"].isObject()) {
+        const auto& section = customConfig["thread_prewarm"];
+        settings.maxPerAccount = section.get("max_per_account", settings.maxPerAccount).asInt();
+        settings.maxIdleSeconds = section.get("max_idle_seconds", settings.maxIdleSeconds).asInt();
+        settings.demandWindowSeconds = section.get("demand_window_seconds", settings.demandWindowSeconds).asInt();
+        settings.refillIntervalSeconds = section.get("refill_interval_seconds", settings.refillIntervalSeconds).asInt();
+    }
+    UpstreamThreadPool::getInstance().setSettings(settings);
+    LOG_INFO << "[线程预建] 每账号上限=" << UpstreamThreadPool::getInstance().settings().maxPerAccount
+             << "，补充间隔=" << UpstreamThreadPool::getInstance().settings().refillIntervalSeconds << "s";
 }
 
 }
@@ -138,28 +231,37 @@ int main() {
     drogon::app().loadConfigFile("../config.json");
     ensureFilterReflectionRegistration();
 
-    if (!validateConfigFile("../config.json")) {
+    Json::Value fileConfig;
+    if (!validateConfigFile("../config.json", fileConfig)) {
         LOG_ERROR << "[启动] 配置校验失败，程序退出";
         return 1;
     }
+    metrics::UsageQuotaService::getInstance().setStoreEnabled(hasDbClient(fileConfig, "aichatpg"));
+
+    // 发布运行期配置快照；之后可通过 SIGHUP 或 POST /aichat/config/reload 热重载
+    RuntimeConfigStore::getInstance().setConfigPath("../config.json");
+    RuntimeConfigStore::getInstance().addPublishListener(applyRuntimeConfig);
+    RuntimeConfigStore::getInstance().publish(RuntimeConfig::fromCustomConfig(getCustomConfig()));
+    std::signal(SIGHUP, onSighup);
 
     // 全局 CORS 预处理（处理 OPTIONS 预检）
     drogon::app().registerPreRoutingAdvice(
         [](const drogon::HttpRequestPtr &req,
            drogon::AdviceCallback &&callback,
            drogon::AdviceChainCallback &&chainCallback) {
-            const auto corsConfig = getCorsConfig();
-            const auto origin = req->getHeader("Origin");
-            const bool originAllowed = isOriginAllowed(origin, corsConfig["allowed_origins"]);
-            const std::string allowOrigin = originAllowed ? (origin.empty() ? "*" : origin) : "null";
-
             if (req->method() == drogon::HttpMethod::Options) {
+                const auto config = RuntimeConfigStore::getInstance().current();
+                const auto& cors = config->cors;
+                const auto& origin = req->getHeader("Origin");
+                const bool originAllowed = cors.isOriginAllowed(origin);
+                const std::string allowOrigin = originAllowed ? (origin.empty() ? "*" : origin) : "null";
+
                 auto resp = drogon::HttpResponse::newHttpResponse();
                 resp->addHeader("Access-Control-Allow-Origin", allowOrigin);
-                resp->addHeader("Access-Control-Allow-Methods", joinJsonArray(corsConfig["allowed_methods"], "GET, POST, PUT, DELETE, OPTIONS, PATCH"));
-                resp->addHeader("Access-Control-Allow-Headers", joinJsonArray(corsConfig["allowed_headers"], "*"));
-                resp->addHeader("Access-Control-Max-Age", std::to_string(corsConfig.get("max_age", 3600).asInt()));
-                if (corsConfig.get("allow_credentials", false).asBool()) {
+                resp->addHeader("Access-Control-Allow-Methods", cors.allowMethods);
+                resp->addHeader("Access-Control-Allow-Headers", cors.allowHeaders);
+                resp->addHeader("Access-Control-Max-Age", cors.maxAge);
+                if (cors.allowCredentials) {
                     resp->addHeader("Access-Control-Allow-Credentials", "true");
                 }
                 resp->setStatusCode(drogon::k204NoContent);
@@ -172,12 +274,13 @@ int main() {
     // 全局 CORS 后处理（补充响应头）
     drogon::app().registerPostHandlingAdvice(
         [](const drogon::HttpRequestPtr &req, const drogon::HttpResponsePtr &resp) {
-            const auto corsConfig = getCorsConfig();
-            const auto origin = req->getHeader("Origin");
-            if (isOriginAllowed(origin, corsConfig["allowed_origins"])) {
+            const auto config = RuntimeConfigStore::getInstance().current();
+            const auto& cors = config->cors;
+            const auto& origin = req->getHeader("Origin");
+            if (cors.isOriginAllowed(origin)) {
                 resp->addHeader("Access-Control-Allow-Origin", origin.empty() ? "*" : origin);
-                resp->addHeader("Access-Control-Expose-Headers", joinJsonArray(corsConfig["expose_headers"], "*"));
-                if (corsConfig.get("allow_credentials", false).asBool()) {
+                resp->addHeader("Access-Control-Expose-Headers", cors.exposeHeaders);
+                if (cors.allowCredentials) {
                     resp->addHeader("Access-Control-Allow-Credentials", "true");
                 }
             }
@@ -191,6 +294,37 @@ int main() {
         LOG_INFO << "[后台任务队列] 已就绪";
     });
 
+    // SIGHUP 热重载：信号处理函数只置位，这里在事件循环中轮询执行
+    app().getLoop()->runEvery(1.0, []() {
+        if (g_reloadRequested.exchange(false)) {
+            reloadRuntimeConfig("SIGHUP");
+        }
+    });
+
+    // 限流桶空闲回收（容量、空闲阈值等由发布监听器在重载时同步）
+    app().getLoop()->runEvery(60.0, []() {
+        const auto idleSeconds = RuntimeConfigStore::getInstance().current()->rateLimit.idleSeconds;
+        const size_t evicted = RateLimiter::getInstance().evictIdle(std::chrono::seconds(std::max(1, idleSeconds)));
+        if (evicted > 0) {
+            LOG_DEBUG << "[限流] 回收空闲令牌桶 " << evicted << " 个，剩余 " << RateLimiter::getInstance().size();
+        }
+    });
+
+    // token 用量批量写库：写库间隔取自当前配置快照，写库本身放到后台队列执行
+    app().getLoop()->runEvery(5.0, []() {
+        static auto lastFlush = std::chrono::steady_clock::now();
+        const auto config = RuntimeConfigStore::getInstance().current();
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastFlush < std::chrono::seconds(std::max(1, config->quota.flushIntervalSeconds))) {
+            return;
+        }
+        lastFlush = now;
+        if (metrics::UsageQuotaService::getInstance().pendingSize() == 0) {
+            return;
+        }
+        BackgroundTaskQueue::instance().enqueue("usage_flush", []{ flushUsage(); });
+    });
+
     app().getLoop()->queueInLoop([](){
         BackgroundTaskQueue::instance().enqueue("init", []{
             LOG_INFO << "[启动] 后台初始化任务开始";
@@ -209,6 +343,9 @@ int main() {
                 LOG_INFO << "会话追踪模式：Hash（默认）";
             }
 
+            initProviderContextStore(customConfig);
+            initUpstreamThreadPool(customConfig);
+
             ChannelManager::getInstance().init();
             AccountManager::getInstance().init();
             RetoolWorkspaceManager::getInstance().init();
@@ -250,5 +387,19 @@ int main() {
     BackgroundTaskQueue::instance().shutdown();
     LOG_INFO << "[停机] 后台任务队列已停机";
 
+    // 后台队列停机后补写最后一批上游上下文、用量聚合与 workspace 使用状态，避免丢失最近一个写库间隔内的记录
+    if (g_providerContextPersist.load() && ProviderContextStore::getInstance().pendingSize() > 0) {
+        LOG_INFO << "[停机] 正在写入剩余上游上下文...";
+        flushProviderContexts();
+    }
+    if (const size_t written = RetoolWorkspaceManager::getInstance().flushUsage(); written > 0) {
+        LOG_INFO << "[停机] 已写回 workspace 使用状态 " << written << " 条";
+    }
+    if (metrics::UsageQuotaService::getInstance().storeEnabled() &&
+        metrics::UsageQuotaService::getInstance().pendingSize() > 0) {
+        LOG_INFO << "[停机] 正在写入剩余用量聚合...";
+        flushUsage();
+    }
+
     return 0;
 }
@@ -0,0 +1,206 @@
+#include "UsageQuotaService.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace metrics {
+
+namespace {
+
+std::string hourBucket(UsageQuotaService::Clock::time_point now) {
+    auto tt = UsageQuotaService::Clock::to_time_t(now);
+    std::tm tm{};
+    gmtime_r(&tt, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:00:00", &tm);
+    return buf;
+}
+
+} // 匿名命名空间
+
+UsageQuotaService& UsageQuotaService::getInstance() {
+    static UsageQuotaService instance;
+    return instance;
+}
+
+int64_t UsageQuotaService::windowStartFor(Clock::time_point now, int windowSeconds) {
+    const int64_t epoch = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    const int64_t window = std::max(1, windowSeconds);
+    return epoch - (epoch % window);
+}
+
+QuotaDecision UsageQuotaService::check(const std::string& apiKey,
+                                       int64_t estimatedInputTokens,
+                                       const RuntimeConfig::Quota& quota,
+                                       Clock::time_point now) {
+    QuotaDecision decision;
+    if (!quota.enabled) {
+        return decision;
+    }
+    const auto& limits = quota.limitsFor(apiKey);
+    if (limits.unlimited()) {
+        return decision;
+    }
+
+    const int64_t windowStart = windowStartFor(now, quota.windowSeconds);
+    int64_t input = 0;
+    int64_t output = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = windows_.find(apiKey);
+        if (it != windows_.end() && it->second.windowStart == windowStart) {
+            input = it->second.inputTokens;
+            output = it->second.outputTokens;
+        }
+    }
+
+    const int64_t pendingInput = std::max<int64_t>(0, estimatedInputTokens);
+    if (limits.inputTokens > 0 && input + pendingInput > limits.inputTokens) {
+        decision.reason = "输入 token 额度已用尽";
+    } else if (limits.outputTokens > 0 && output >= limits.outputTokens) {
+        decision.reason = "输出 token 额度已用尽";
+    } else if (limits.totalTokens > 0 && input + output + pendingInput > limits.totalTokens) {
+        decision.reason = "总 token 额度已用尽";
+    } else {
+        return decision;
+    }
+
+    const int64_t epoch = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    decision.allowed = false;
+    decision.retryAfterSeconds = static_cast<int>(std::max<int64_t>(1, windowStart + quota.windowSeconds - epoch));
+    return decision;
+}
+
+void UsageQuotaService::record(const std::string& apiKey,
+                               const std::string& provider,
+                               const std::string& model,
+                               int64_t inputTokens,
+                               int64_t outputTokens,
+                               bool estimated,
+                               const RuntimeConfig::Quota& quota,
+                               Clock::time_point now) {
+    inputTokens = std::max<int64_t>(0, inputTokens);
+    outputTokens = std::max<int64_t>(0, outputTokens);
+
+    UsageAggRecord record;
+    record.bucketStart = hourBucket(now);
+    record.apiKey = maskKey(apiKey);
+    record.provider = provider;
+    record.model = model;
+    record.inputTokens = inputTokens;
+    record.outputTokens = outputTokens;
+    record.requestCount = 1;
+    record.estimatedCount = estimated ? 1 : 0;
+
+    const int64_t windowStart = windowStartFor(now, quota.windowSeconds);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& window = windows_[apiKey];
+    if (window.windowStart != windowStart) {
+        window = Window{windowStart, 0, 0};
+    }
+    window.inputTokens += inputTokens;
+    window.outputTokens += outputTokens;
+
+    mergePendingLocked(record);
+}
+
+void UsageQuotaService::mergePendingLocked(const UsageAggRecord& record) {
+    auto key = std::make_tuple(record.bucketStart, record.apiKey, record.provider, record.model);
+    auto it = pending_.find(key);
+    if (it == pending_.end()) {
+        pending_.emplace(std::move(key), record);
+        return;
+    }
+    it->second.inputTokens += record.inputTokens;
+    it->second.outputTokens += record.outputTokens;
+    it->second.requestCount += record.requestCount;
+    it->second.estimatedCount += record.estimatedCount;
+}
+
+size_t UsageQuotaService::flush(const Writer& writer) {
+    std::vector<UsageAggRecord> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch.reserve(pending_.size());
+        for (auto& entry : pending_) {
+            batch.push_back(std::move(entry.second));
+        }
+        pending_.clear();
+
+        // 顺带清理已过期的窗口，避免长期不活跃的 key 常驻内存
+        int64_t latest = 0;
+        for (const auto& entry : windows_) {
+            latest = std::max(latest, entry.second.windowStart);
+        }
+        for (auto it = windows_.begin(); it != windows_.end();) {
+            if (it->second.windowStart < latest) {
+                it = windows_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (batch.empty()) {
+        return 0;
+    }
+    if (writer && writer(batch)) {
+        return batch.size();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& record : batch) {
+        mergePendingLocked(record);
+    }
+    return 0;
+}
+
+size_t UsageQuotaService::pendingSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+std::vector<KeyUsageSnapshot> UsageQuotaService::snapshot() const {
+    std::vector<KeyUsageSnapshot> out;
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.reserve(windows_.size());
+    for (const auto& [apiKey, window] : windows_) {
+        out.push_back(KeyUsageSnapshot{maskKey(apiKey), window.windowStart, window.inputTokens, window.outputTokens});
+    }
+    std::sort(out.begin(), out.end(), [](const KeyUsageSnapshot& a, const KeyUsageSnapshot& b) {
+        return a.inputTokens + a.outputTokens > b.inputTokens + b.outputTokens;
+    });
+    return out;
+}
+
+void UsageQuotaService::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    windows_.clear();
+    pending_.clear();
+}
+
+int64_t UsageQuotaService::estimateTokens(const std::string& text) {
+    int64_t asciiChars = 0;
+    int64_t otherChars = 0;
+    for (unsigned char c : text) {
+        if (c < 0x80) {
+            ++asciiChars;
+        } else if ((c & 0xC0) != 0x80) {
+            // 只统计 UTF-8 首字节
+            ++otherChars;
+        }
+    }
+    return (asciiChars + 3) / 4 + otherChars;
+}
+
+std::string UsageQuotaService::maskKey(const std::string& apiKey) {
+    if (apiKey.empty()) {
+        return "anonymous";
+    }
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "%016zx", std::hash<std::string>{}(apiKey));
+    return apiKey.substr(0, std::min<size_t>(4, apiKey.size())) + "…" + buf;
+}
+
+} // namespace metrics
@@ -0,0 +1,131 @@
+#ifndef METRICS_USAGE_QUOTA_SERVICE_H
+#define METRICS_USAGE_QUOTA_SERVICE_H
+
+#include <utils/RuntimeConfig.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace metrics {
+
+/**
+ * @brief 待写库的用量聚合（按小时桶 + 脱敏 key + provider + model）
+ */
+struct UsageAggRecord {
+    std::string bucketStart;    // 小时桶开始时间（UTC，"%Y-%m-%d %H:00:00"）
+    std::string apiKey;         // 脱敏后的客户端 API Key
+    std::string provider;
+    std::string model;
+    int64_t inputTokens = 0;
+    int64_t outputTokens = 0;
+    int64_t requestCount = 0;
+    int64_t estimatedCount = 0; // 上游未返回 usage、由估算得出的请求数
+};
+
+struct QuotaDecision {
+    bool allowed = true;
+    int retryAfterSeconds = 0;  // 距当前窗口结束的秒数
+    std::string reason;
+};
+
+struct KeyUsageSnapshot {
+    std::string apiKey;         // 脱敏后的客户端 API Key
+    int64_t windowStart = 0;    // 窗口开始时间（epoch 秒）
+    int64_t inputTokens = 0;
+    int64_t outputTokens = 0;
+};
+
+/**
+ * @brief 按客户端 API Key 的 token 额度与用量统计 - 单例
+ *
+ * 当前窗口的计数只保存在内存中，供请求前的额度检查使用；
+ * 每次记录同时累加到按小时聚合的待写队列，由定时任务调用 flush() 批量写库，停机时再补写一次。
+ * 配置了用量库（storeEnabled）时，额度未启用也记录用量。
+ */
+class UsageQuotaService {
+public:
+    using Clock = std::chrono::system_clock;
+    using Writer = std::function<bool(const std::vector<UsageAggRecord>&)>;
+
+    static UsageQuotaService& getInstance();
+
+    UsageQuotaService(const UsageQuotaService&) = delete;
+    UsageQuotaService& operator=(const UsageQuotaService&) = delete;
+
+    /**
+     * @brief 调用上游前检查额度
+     *
+     * @param estimatedInputTokens 本次请求的输入 token 估算值，输入额度按“已用 + 本次”判断
+     */
+    QuotaDecision check(const std::string& apiKey,
+                        int64_t estimatedInputTokens,
+                        const RuntimeConfig::Quota& quota,
+                        Clock::time_point now = Clock::now());
+
+    /// 记录一次上游调用的用量
+    void record(const std::string& apiKey,
+                const std::string& provider,
+                const std::string& model,
+                int64_t inputTokens,
+                int64_t outputTokens,
+                bool estimated,
+                const RuntimeConfig::Quota& quota,
+                Clock::time_point now = Clock::now());
+
+    /**
+     * @brief 将待写聚合交给 writer 批量写库
+     *
+     * writer 返回 false 时聚合放回队列，下次重试。
+     * @return 本次写入的记录数
+     */
+    size_t flush(const Writer& writer);
+
+    size_t pendingSize() const;
+
+    /// 是否配置了用量库（启动时按 db_clients 设置）
+    void setStoreEnabled(bool enabled) { storeEnabled_.store(enabled, std::memory_order_relaxed); }
+    bool storeEnabled() const { return storeEnabled_.load(std::memory_order_relaxed); }
+
+    std::vector<KeyUsageSnapshot> snapshot() const;
+    void clear();
+
+    /**
+     * @brief 粗略估算文本 token 数
+     *
+     * ASCII 约 4 字符 1 token，其他 UTF-8 字符（中日韩等）按 1 字符 1 token 计。
+     */
+    static int64_t estimateTokens(const std::string& text);
+
+    /// 脱敏 API Key，用于日志、监控与写库
+    static std::string maskKey(const std::string& apiKey);
+
+private:
+    UsageQuotaService() = default;
+
+    struct Window {
+        int64_t windowStart = 0;
+        int64_t inputTokens = 0;
+        int64_t outputTokens = 0;
+    };
+
+    using AggKey = std::tuple<std::string, std::string, std::string, std::string>;
+
+    static int64_t windowStartFor(Clock::time_point now, int windowSeconds);
+    void mergePendingLocked(const UsageAggRecord& record);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Window> windows_;
+    std::map<AggKey, UsageAggRecord> pending_;
+    std::atomic<bool> storeEnabled_{false};
+};
+
+} // namespace metrics
+
+#endif
@@ -2,6 +2,9 @@
 
 #include <algorithm>
 #include <dbManager/retoolWorkspace/RetoolWorkspaceDbManager.h>
+#include <drogon/drogon.h>
+#include <utils/BackgroundTaskQueue.h>
+#include <atomic>
 
 void RetoolWorkspaceManager::init()
 {
@@ -9,28 +12,115 @@ void RetoolWorkspaceManager::init()
     if (!RetoolWorkspaceDbManager::getInstance()->ensureTable(&error))
     {
         LOG_ERROR << "[RetoolWorkspaceManager] 初始化失败: " << error;
+        return;
+    }
+    if (!reloadPool(&error))
+    {
+        LOG_ERROR << "[RetoolWorkspaceManager] 加载 workspace 池失败: " << error;
+    }
+
+    int flushIntervalSeconds = 10;
+    const auto& customConfig = drogon::app().getCustomConfig();
+    if (customConfig.isMember("retoolapi") && customConfig["retoolapi"].isObject())
+    {
+        flushIntervalSeconds = customConfig["retoolapi"].get("usage_flush_interval_seconds", flushIntervalSeconds).asInt();
+    }
+    flushIntervalSeconds = std::max(1, flushIntervalSeconds);
+    drogon::app().getLoop()->runEvery(static_cast<double>(flushIntervalSeconds), [this]() {
+        static std::atomic<bool> running{false};
+        if (pool_.pendingSize() == 0 || running.exchange(true))
+        {
+            return;
+        }
+        BackgroundTaskQueue::instance().enqueue("retool_usage_flush", [this]() {
+            const size_t written = flushUsage();
+            running.store(false);
+            LOG_DEBUG << "[RetoolWorkspaceManager] 已写回 workspace 使用状态 " << written << " 条";
+        });
+    });
+    LOG_INFO << "[RetoolWorkspaceManager] workspace 池已加载 " << pool_.size()
+             << " 个，使用状态每 " << flushIntervalSeconds << " 秒批量写库";
+}
+
+bool RetoolWorkspaceManager::reloadPool(std::string* errorMessage)
+{
+    std::string error;
+    auto workspaces = RetoolWorkspaceDbManager::getInstance()->listWorkspaces(&error);
+    if (!error.empty())
+    {
+        if (errorMessage) *errorMessage = error;
+        return false;
+    }
+    pool_.reset(workspaces);
+    return true;
+}
+
+void RetoolWorkspaceManager::refreshPoolEntry(const std::string& workspaceId, const std::string& poolId)
+{
+    auto workspace = RetoolWorkspaceDbManager::getInstance()->getWorkspace(workspaceId, nullptr);
+    if (!workspace)
+    {
+        pool_.remove(poolId);
+        return;
+    }
+    // 池以 workspaceId 为 id，缺失时用 subdomain；id 变化时移除旧条目，避免同一 workspace 留下两份
+    if (!poolId.empty() && RetoolWorkspacePool::poolIdOf(*workspace) != poolId)
+    {
+        pool_.remove(poolId);
+    }
+    pool_.upsert(*workspace);
+}
+
+void RetoolWorkspaceManager::applyLiveUsage(RetoolWorkspaceInfo& info) const
+{
+    // 库中的 in_use_count 最多滞后一个写回周期，对外以内存计数为准
+    if (auto count = pool_.inUseCount(RetoolWorkspacePool::poolIdOf(info)))
+    {
+        info.inUseCount = *count;
     }
 }
 
 bool RetoolWorkspaceManager::upsertWorkspace(const RetoolWorkspaceInfo& info, std::string* errorMessage)
 {
-    return RetoolWorkspaceDbManager::getInstance()->upsertWorkspace(info, errorMessage);
+    RetoolWorkspaceInfo stored = info;
+    applyLiveUsage(stored);
+    if (!RetoolWorkspaceDbManager::getInstance()->upsertWorkspace(stored, errorMessage))
+    {
+        return false;
+    }
+    refreshPoolEntry(stored.workspaceId, RetoolWorkspacePool::poolIdOf(stored));
+    return true;
 }
 
 bool RetoolWorkspaceManager::deleteWorkspace(const std::string& workspaceId, std::string* errorMessage)
 {
-    return RetoolWorkspaceDbManager::getInstance()->deleteWorkspace(workspaceId, errorMessage);
+    if (!RetoolWorkspaceDbManager::getInstance()->deleteWorkspace(workspaceId, errorMessage))
+    {
+        return false;
+    }
+    pool_.remove(workspaceId);
+    return true;
 }
 
 std::optional<RetoolWorkspaceInfo> RetoolWorkspaceManager::getWorkspace(const std::string& workspaceId,
                                                                         std::string* errorMessage)
 {
-    return RetoolWorkspaceDbManager::getInstance()->getWorkspace(workspaceId, errorMessage);
+    auto workspace = RetoolWorkspaceDbManager::getInstance()->getWorkspace(workspaceId, errorMessage);
+    if (workspace)
+    {
+        applyLiveUsage(*workspace);
+    }
+    return workspace;
 }
 
 std::vector<RetoolWorkspaceInfo> RetoolWorkspaceManager::listWorkspaces(std::string* errorMessage)
 {
-    return RetoolWorkspaceDbManager::getInstance()->listWorkspaces(errorMessage);
+    auto workspaces = RetoolWorkspaceDbManager::getInstance()->listWorkspaces(errorMessage);
+    for (auto& workspace : workspaces)
+    {
+        applyLiveUsage(workspace);
+    }
+    return workspaces;
 }
 
 bool RetoolWorkspaceManager::updateWorkspaceStatus(const std::string& workspaceId,
@@ -38,32 +128,69 @@ bool RetoolWorkspaceManager::updateWorkspaceStatus(const std::string& workspaceI
                                                    const std::string& verifyStatus,
                                                    std::string* errorMessage)
 {
-    return RetoolWorkspaceDbManager::getInstance()->updateWorkspaceStatus(
-        workspaceId, status, verifyStatus, errorMessage);
+    if (!RetoolWorkspaceDbManager::getInstance()->updateWorkspaceStatus(
+            workspaceId, status, verifyStatus, errorMessage))
+    {
+        return false;
+    }
+    refreshPoolEntry(workspaceId, workspaceId);
+    return true;
 }
 
 bool RetoolWorkspaceManager::markWorkspaceUsageStarted(const std::string& workspaceId, std::string* errorMessage)
 {
-    auto workspace = getWorkspace(workspaceId, errorMessage);
-    if (!workspace)
+    if (!pool_.acquire(workspaceId))
     {
+        if (errorMessage) *errorMessage = "retool workspace not found in pool: " + workspaceId;
         return false;
     }
-    const int nextCount = std::max(0, workspace->inUseCount) + 1;
-    return RetoolWorkspaceDbManager::getInstance()->updateWorkspaceUsage(
-        workspaceId, nextCount, true, errorMessage);
+    return true;
 }
 
 bool RetoolWorkspaceManager::markWorkspaceUsageFinished(const std::string& workspaceId, std::string* errorMessage)
 {
-    auto workspace = getWorkspace(workspaceId, errorMessage);
-    if (!workspace)
+    (void)errorMessage;
+    pool_.release(workspaceId);
+    return true;
+}
+
+std::optional<RetoolWorkspacePool::Selection> RetoolWorkspaceManager::selectWorkspace(
+    bool requireAgent,
+    const RetoolWorkspacePool::AvailablePredicate& available,
+    std::string* errorMessage)
+{
+    if (!pool_.loaded() && !reloadPool(errorMessage))
     {
-        return false;
+        return std::nullopt;
+    }
+    return pool_.select(requireAgent ? RetoolWorkspacePool::Kind::Agent : RetoolWorkspacePool::Kind::Workflow,
+                        available);
+}
+
+size_t RetoolWorkspaceManager::flushUsage()
+{
+    const auto records = pool_.takePendingUsage();
+    std::vector<RetoolWorkspacePool::UsageRecord> failed;
+    size_t written = 0;
+    for (const auto& record : records)
+    {
+        std::string error;
+        if (RetoolWorkspaceDbManager::getInstance()->updateWorkspaceUsage(
+                record.workspaceId, record.inUseCount, record.touched, &error))
+        {
+            ++written;
+        }
+        else
+        {
+            LOG_WARN << "[RetoolWorkspaceManager] 写回 workspace 使用状态失败: " << record.workspaceId << ", " << error;
+            failed.push_back(record);
+        }
+    }
+    if (!failed.empty())
+    {
+        pool_.restorePendingUsage(failed);
     }
-    const int nextCount = std::max(0, workspace->inUseCount - 1);
-    return RetoolWorkspaceDbManager::getInstance()->updateWorkspaceUsage(
-        workspaceId, nextCount, true, errorMessage);
+    return written;
 }
 
 bool RetoolWorkspaceManager::disableWorkspace(const std::string& workspaceId, std::string* errorMessage)
@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <retoolWorkspace/RetoolWorkspaceInfo.h>
+#include <retoolWorkspace/RetoolWorkspacePool.h>
 #include <string>
 #include <vector>
 
@@ -24,10 +25,26 @@ class RetoolWorkspaceManager
                                const std::string& status,
                                const std::string& verifyStatus,
                                std::string* errorMessage = nullptr);
+    /// 在途计数只在内存池中增减，由 flushUsage() 定期批量写库
     bool markWorkspaceUsageStarted(const std::string& workspaceId, std::string* errorMessage = nullptr);
     bool markWorkspaceUsageFinished(const std::string& workspaceId, std::string* errorMessage = nullptr);
     bool disableWorkspace(const std::string& workspaceId, std::string* errorMessage = nullptr);
 
+    /// 从内存池中选出在途最少的可调度 workspace；池尚未加载时先从库中加载
+    std::optional<RetoolWorkspacePool::Selection> selectWorkspace(
+        bool requireAgent,
+        const RetoolWorkspacePool::AvailablePredicate& available,
+        std::string* errorMessage = nullptr);
+    bool reloadPool(std::string* errorMessage = nullptr);
+    /// 将待写回的在途计数与 last_used_at 写库，返回写入条数；停机时由 main 再调用一次
+    size_t flushUsage();
+
   private:
     RetoolWorkspaceManager() = default;
+
+    /// 按库中 workspace_id 重新读取并更新池；poolId 为该 workspace 当前在池中的 id
+    void refreshPoolEntry(const std::string& workspaceId, const std::string& poolId);
+    void applyLiveUsage(RetoolWorkspaceInfo& info) const;
+
+    RetoolWorkspacePool pool_;
 };
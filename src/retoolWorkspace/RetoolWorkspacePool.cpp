@@ -0,0 +1,215 @@
+#include "RetoolWorkspacePool.h"
+
+#include <algorithm>
+
+namespace
+{
+bool isVerified(const RetoolWorkspaceInfo& info)
+{
+    return info.verifyStatus == "passed" || info.verifyStatus == "ready";
+}
+
+bool isSchedulable(const RetoolWorkspaceInfo& info)
+{
+    return info.status != "disabled" && isVerified(info) && !info.baseUrl.empty();
+}
+}  // namespace
+
+std::string RetoolWorkspacePool::poolIdOf(const RetoolWorkspaceInfo& info)
+{
+    return !info.workspaceId.empty() ? info.workspaceId : info.subdomain;
+}
+
+RetoolWorkspacePool::Key RetoolWorkspacePool::keyOf(const std::string& id, const Entry& entry)
+{
+    return Key(entry.inUse,
+               entry.useSeq,
+               !entry.info.lastUsedAt.empty(),
+               entry.info.lastUsedAt,
+               entry.info.createdAt,
+               id);
+}
+
+void RetoolWorkspacePool::indexLocked(const std::string& id, const Entry& entry)
+{
+    if (entry.eligibleWorkflow) workflowIndex_.insert(keyOf(id, entry));
+    if (entry.eligibleAgent) agentIndex_.insert(keyOf(id, entry));
+}
+
+void RetoolWorkspacePool::unindexLocked(const std::string& id, const Entry& entry)
+{
+    if (entry.eligibleWorkflow) workflowIndex_.erase(keyOf(id, entry));
+    if (entry.eligibleAgent) agentIndex_.erase(keyOf(id, entry));
+}
+
+void RetoolWorkspacePool::putLocked(const std::string& id, const RetoolWorkspaceInfo& info)
+{
+    auto it = entries_.find(id);
+    if (it == entries_.end())
+    {
+        it = entries_.emplace(id, Entry{}).first;
+    }
+    else
+    {
+        unindexLocked(id, it->second);
+    }
+    auto& entry = it->second;
+    entry.info = info;
+    entry.eligibleWorkflow = isSchedulable(info) && !info.workflowId.empty();
+    entry.eligibleAgent = isSchedulable(info) && !info.agentId.empty();
+    if (info.inUseCount != entry.inUse && !info.workspaceId.empty())
+    {
+        entry.dirty = true;
+    }
+    indexLocked(id, entry);
+}
+
+void RetoolWorkspacePool::reset(const std::vector<RetoolWorkspaceInfo>& workspaces)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<std::string, Entry> previous;
+    previous.swap(entries_);
+    workflowIndex_.clear();
+    agentIndex_.clear();
+    for (const auto& info : workspaces)
+    {
+        const auto id = poolIdOf(info);
+        if (id.empty()) continue;
+        auto prevIt = previous.find(id);
+        if (prevIt != previous.end())
+        {
+            auto& entry = entries_[id];
+            entry.inUse = prevIt->second.inUse;
+            entry.useSeq = prevIt->second.useSeq;
+            entry.dirty = prevIt->second.dirty;
+            entry.touched = prevIt->second.touched;
+        }
+        putLocked(id, info);
+    }
+    loaded_ = true;
+}
+
+void RetoolWorkspacePool::upsert(const RetoolWorkspaceInfo& info)
+{
+    const auto id = poolIdOf(info);
+    if (id.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    putLocked(id, info);
+}
+
+void RetoolWorkspacePool::remove(const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(id);
+    if (it == entries_.end()) return;
+    unindexLocked(id, it->second);
+    entries_.erase(it);
+}
+
+bool RetoolWorkspacePool::loaded() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return loaded_;
+}
+
+size_t RetoolWorkspacePool::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+std::optional<RetoolWorkspacePool::Selection> RetoolWorkspacePool::select(Kind kind,
+                                                                          const AvailablePredicate& available) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto& index = kind == Kind::Agent ? agentIndex_ : workflowIndex_;
+    // 按负载从低到高遍历，通常第一个即可用；只有冷却中的 workspace 会被跳过
+    for (const auto& key : index)
+    {
+        const auto& id = std::get<5>(key);
+        if (available && !available(id)) continue;
+        const auto& entry = entries_.at(id);
+        Selection selection;
+        selection.id = id;
+        selection.email = entry.info.email;
+        selection.baseUrl = entry.info.baseUrl;
+        selection.verifyStatus = entry.info.verifyStatus;
+        selection.inUseCount = entry.inUse;
+        return selection;
+    }
+    return std::nullopt;
+}
+
+bool RetoolWorkspacePool::acquire(const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(id);
+    if (it == entries_.end()) return false;
+    auto& entry = it->second;
+    unindexLocked(id, entry);
+    ++entry.inUse;
+    entry.useSeq = nextUseSeq_++;
+    entry.dirty = true;
+    entry.touched = true;
+    indexLocked(id, entry);
+    return true;
+}
+
+void RetoolWorkspacePool::release(const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(id);
+    if (it == entries_.end()) return;
+    auto& entry = it->second;
+    unindexLocked(id, entry);
+    entry.inUse = std::max(0, entry.inUse - 1);
+    entry.dirty = true;
+    entry.touched = true;
+    indexLocked(id, entry);
+}
+
+std::optional<int> RetoolWorkspacePool::inUseCount(const std::string& id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(id);
+    if (it == entries_.end()) return std::nullopt;
+    return it->second.inUse;
+}
+
+std::vector<RetoolWorkspacePool::UsageRecord> RetoolWorkspacePool::takePendingUsage()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<UsageRecord> records;
+    for (auto& [id, entry] : entries_)
+    {
+        if (!entry.dirty) continue;
+        // 以 subdomain 代替 id 的 workspace 在库中无对应行，不写回
+        if (!entry.info.workspaceId.empty())
+        {
+            records.push_back(UsageRecord{entry.info.workspaceId, entry.inUse, entry.touched});
+        }
+        entry.dirty = false;
+        entry.touched = false;
+    }
+    return records;
+}
+
+void RetoolWorkspacePool::restorePendingUsage(const std::vector<UsageRecord>& records)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& record : records)
+    {
+        auto it = entries_.find(record.workspaceId);
+        if (it == entries_.end()) continue;
+        it->second.dirty = true;
+        it->second.touched = it->second.touched || record.touched;
+    }
+}
+
+size_t RetoolWorkspacePool::pendingSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<size_t>(std::count_if(entries_.begin(), entries_.end(), [](const auto& item) {
+        return item.second.dirty;
+    }));
+}
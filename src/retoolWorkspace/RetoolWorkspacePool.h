@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <retoolWorkspace/RetoolWorkspaceInfo.h>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Retool workspace 的内存调度索引
+ *
+ * 所有 workspace 按池内 id（workspaceId，缺失时为 subdomain）保存在内存中，在途计数只在内存里增减；
+ * 可调度的 workspace 另按 (inUseCount, 本进程内最近使用顺序, lastUsedAt, createdAt) 放入
+ * workflow / agent 两个有序索引，取最空闲者为 O(log n)，在途计数变化时重新插入即可。
+ *
+ * 在途计数与 lastUsedAt 的变化只记为待写回，由 takePendingUsage() 批量取走后写库。
+ */
+class RetoolWorkspacePool
+{
+  public:
+    enum class Kind
+    {
+        Workflow,
+        Agent
+    };
+
+    struct Selection
+    {
+        std::string id;
+        std::string email;
+        std::string baseUrl;
+        std::string verifyStatus;
+        int inUseCount = 0;
+    };
+
+    struct UsageRecord
+    {
+        std::string workspaceId;
+        int inUseCount = 0;
+        bool touched = false;  // 期间被使用过，写库时同时刷新 last_used_at
+    };
+
+    /// 返回 false 的 workspace 在本次选择中跳过（如限流冷却中）
+    using AvailablePredicate = std::function<bool(const std::string& id)>;
+
+    static std::string poolIdOf(const RetoolWorkspaceInfo& info);
+
+    /// 以库中全量数据重建；本进程的在途计数保留，库中残留的非零计数记为待写回以便归零
+    void reset(const std::vector<RetoolWorkspaceInfo>& workspaces);
+    /// 新增或更新单个 workspace 的资产/状态，在途计数保持不变
+    void upsert(const RetoolWorkspaceInfo& info);
+    void remove(const std::string& id);
+    bool loaded() const;
+    size_t size() const;
+
+    std::optional<Selection> select(Kind kind, const AvailablePredicate& available = nullptr) const;
+
+    /// 在途计数加 1；id 不在池中时返回 false
+    bool acquire(const std::string& id);
+    void release(const std::string& id);
+    std::optional<int> inUseCount(const std::string& id) const;
+
+    std::vector<UsageRecord> takePendingUsage();
+    /// 写库失败时放回，计数以写回时的内存值为准
+    void restorePendingUsage(const std::vector<UsageRecord>& records);
+    size_t pendingSize() const;
+
+  private:
+    // inUseCount, useSeq, lastUsedAt 非空, lastUsedAt, createdAt, id
+    using Key = std::tuple<int, uint64_t, bool, std::string, std::string, std::string>;
+
+    struct Entry
+    {
+        RetoolWorkspaceInfo info;
+        int inUse = 0;
+        uint64_t useSeq = 0;  // 0 表示本进程内尚未使用，按库中 lastUsedAt 排序
+        bool eligibleWorkflow = false;
+        bool eligibleAgent = false;
+        bool dirty = false;
+        bool touched = false;
+    };
+
+    static Key keyOf(const std::string& id, const Entry& entry);
+    void indexLocked(const std::string& id, const Entry& entry);
+    void unindexLocked(const std::string& id, const Entry& entry);
+    void putLocked(const std::string& id, const RetoolWorkspaceInfo& info);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::set<Key> workflowIndex_;
+    std::set<Key> agentIndex_;
+    uint64_t nextUseSeq_ = 1;
+    bool loaded_ = false;
+};
@@ -1,6 +1,7 @@
 #ifndef GENERATION_REQUEST_H
 #define GENERATION_REQUEST_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <optional>
@@ -102,17 +103,22 @@ struct Message {
     }
 };
 
+struct ImageBlob;  // 见 sessionManager/core/ImageBlobStore.h
+
 /**
  * @brief 图片信息
  *
- * 当前请求中的图片列表
+ * 当前请求中的图片列表。图片数据在解析时驻留到 ImageBlobStore，
+ * 这里只持有共享句柄，复制 ImageInfo 不会复制图片数据。
  */
 struct ImageInfo {
-    std::string base64Data;      // base64编码的图片数据
+    std::shared_ptr<const ImageBlob> blob;  // 解码后的图片数据（data URL 图片）
     std::string mediaType;       // 图片类型如 image/png, image/jpeg
     std::string uploadedUrl;     // 上传后的图片URL
     int width = 0;
     int height = 0;
+
+    bool empty() const { return !blob && uploadedUrl.empty(); }
 };
 
 /**
@@ -14,9 +14,13 @@
 #include <apipoint/ProviderResult.h>
 #include <tools/ZeroWidthEncoder.h>
 #include <channelManager/channelManager.h>
+#include <channelManager/ChannelRouter.h>
 #include <metrics/ErrorStatsService.h>
 #include <metrics/ErrorEvent.h>
+#include <metrics/UsageQuotaService.h>
+#include <utils/RuntimeConfig.h>
 #include <drogon/drogon.h>
+#include <algorithm>
 #include <iomanip>
 #include <random>
 #include <sstream>
@@ -41,6 +45,35 @@ Json::StreamWriterBuilder& compactJsonWriter() {
 std::string toCompactJson(const Json::Value& value) {
     return Json::writeString(compactJsonWriter(), value);
 }
+
+std::string clientApiKey(const session_st& session) {
+    return session.provider.clientInfo.get("client_authorization", "").asString();
+}
+
+/// 估算本轮发往上游的输入 token（系统提示词 + 历史上下文 + 当前输入）
+int64_t estimateInputTokens(const session_st& session) {
+    int64_t tokens = metrics::UsageQuotaService::estimateTokens(session.request.systemPrompt) +
+                     metrics::UsageQuotaService::estimateTokens(session.request.message);
+    for (const auto& msg : session.provider.messageContext) {
+        const auto& content = msg["content"];
+        if (content.isString()) {
+            tokens += metrics::UsageQuotaService::estimateTokens(content.asString());
+        }
+    }
+    return tokens;
+}
+
+std::vector<ChannelRouter::ChannelState> routableChannels() {
+    std::vector<ChannelRouter::ChannelState> states;
+    for (const auto& channel : ChannelManager::getInstance().getChannelList()) {
+        ChannelRouter::ChannelState state;
+        state.name = channel.channelName;
+        state.priority = channel.priority;
+        state.enabled = channel.channelStatus;
+        states.push_back(std::move(state));
+    }
+    return states;
+}
 } // 匿名命名空间
 
 std::string GenerationService::computeExecutionKey(const session_st& session) {
@@ -68,7 +101,7 @@ session_st GenerationService::materializeSession(const GenerationRequest& req) {
     session.request.systemPrompt = req.systemPrompt;
     session.provider.clientInfo = req.clientInfo;
     session.request.message = req.currentInput;
-    session.request.images = req.images;  // 传递图片列表
+    session.request.images = req.images;  // 传递图片列表（只复制 blob 句柄）
     session.request.tools = req.tools;           // 传递工具定义
     session.request.toolsRaw = req.tools;       // 保留原始工具定义（用于工具桥接场景下的兜底解析）
     session.request.toolChoice = req.toolChoice; // 传递工具选择策略
@@ -153,11 +186,13 @@ std::optional<AppError> GenerationService::executeGuardedWithSession(
     }
     
     LOG_DEBUG << "[生成服务] 已获取执行门控, 会话: " << sessionKey;
-    
+
 	    try {
 	        auto& sessionManager = *chatSession::getInstance();
 	        // 每次请求独立字段：仅对当前上游调用有效，进入新请求前必须清空。
 	        session.provider.toolBridgeTrigger.clear();
+	        session.provider.toolBridgeDigest.clear();
+	        session.provider.toolBridgeOffset = 0;
 	        
 	        // 0. 检查通道是否支持工具调用；若不支持则进入工具桥接模式并注入工具定义
 	        bool supportsToolCalls = getChannelSupportsToolCalls(session.request.api);
@@ -181,6 +216,23 @@ std::optional<AppError> GenerationService::executeGuardedWithSession(
 	            }
 	            transformRequestForToolBridge(session);
 	        }
+
+	        // 按客户端 API Key 检查 token 额度，超额时不调用上游，避免消耗共享账号池；
+	        // 放在工具桥接改写之后，估算值包含注入的工具定义提示
+	        {
+	            const auto config = RuntimeConfigStore::getInstance().current();
+	            if (config->quota.enabled) {
+	                const std::string apiKey = clientApiKey(session);
+	                const auto decision = metrics::UsageQuotaService::getInstance().check(
+	                    apiKey, estimateInputTokens(session), config->quota);
+	                if (!decision.allowed) {
+	                    LOG_WARN << "[生成服务] token 额度不足，拒绝请求, key: "
+	                             << metrics::UsageQuotaService::maskKey(apiKey) << ", 原因: " << decision.reason;
+	                    return AppError::rateLimited(decision.reason + "，请在 " +
+	                                                 std::to_string(decision.retryAfterSeconds) + " 秒后重试");
+	                }
+	            }
+	        }
         
         // 1. Responses 协议：生成 响应Id 并尽早绑定到 响应Index（用于 previous_响应_id 续接）
         if (session.isResponseApi() && session.response.responseId.empty()) {
@@ -343,17 +395,75 @@ std::optional<AppError> GenerationService::runGuarded(
 }
 
 bool GenerationService::executeProvider(session_st& session) {
-    LOG_DEBUG << "[生成服务] 执行提供者: " << session.request.api;
-    
-    auto api = ApiManager::getInstance().getApiByApiName(session.request.api);
-    if (!api) {
-        LOG_ERROR << "[生成服务] 未找到提供者: " << session.request.api;
-        session.response.message["error"] = "未找到上游提供者: " + session.request.api;
+    const auto config = RuntimeConfigStore::getInstance().current();
+    auto& router = ChannelRouter::getInstance();
+    const std::string requestedModel = session.request.model;
+    const std::string preferredChannel = session.request.api;
+    const auto candidates = router.candidates(requestedModel, preferredChannel, config->modelRouting, routableChannels());
+
+    // 工具桥接提示词已按首选渠道的原生工具能力构造，能力不同的渠道不作为备选
+    const bool hasTools = !session.request.tools.isNull() && session.request.tools.isArray() &&
+                          session.request.tools.size() > 0;
+    const bool preferredSupportsToolCalls = getChannelSupportsToolCalls(preferredChannel);
+
+    // 候选全部熔断时 candidates() 原样返回完整列表，此时不再按探测名额跳过
+    const bool anyAvailable = std::any_of(candidates.begin(), candidates.end(), [&router](const auto& candidate) {
+        return !router.isOpen(candidate.channel);
+    });
+
+    ProviderResult result;
+    bool attempted = false;
+    for (const auto& candidate : candidates) {
+        if (candidate.channel != preferredChannel && hasTools &&
+            getChannelSupportsToolCalls(candidate.channel) != preferredSupportsToolCalls) {
+            continue;
+        }
+        auto api = ApiManager::getInstance().getApiByApiName(candidate.channel);
+        if (!api) {
+            LOG_ERROR << "[生成服务] 未找到提供者: " << candidate.channel;
+            continue;
+        }
+        if (attempted) {
+            LOG_WARN << "[生成服务] 切换到备选渠道: " << candidate.channel << ", 上游模型: " << candidate.model;
+            session.response.message.removeMember("tool_calls");
+            session.response.message.removeMember("_meta");
+            session.response.message.removeMember("error");
+        }
+
+        // 半开渠道只放行一个探测调用，名额已被占用时换下一个候选
+        if (!router.beginProbe(candidate.channel) && anyAvailable) {
+            LOG_DEBUG << "[生成服务] 渠道半开探测进行中，跳过: " << candidate.channel;
+            continue;
+        }
+
+        session.request.api = candidate.channel;
+        session.request.model = candidate.model;
+        LOG_DEBUG << "[生成服务] 执行提供者: " << session.request.api;
+        // 使用 () 接口获取结构化结果
+        result = api->generate(session);
+        session.request.model = requestedModel;
+        attempted = true;
+
+        if (result.isSuccess()) {
+            router.record(candidate.channel, true, config->modelRouting);
+            break;
+        }
+        if (!ChannelRouter::countsAsChannelFailure(result.error)) {
+            router.abortProbe(candidate.channel);
+        } else if (router.record(candidate.channel, false, config->modelRouting)) {
+            LOG_WARN << "[生成服务] 渠道连续失败，进入熔断: " << candidate.channel;
+        }
+        if (!ChannelRouter::isRetryable(result.error)) {
+            break;
+        }
+        LOG_WARN << "[生成服务] 渠道 " << candidate.channel << " 返回可重试错误: " << result.error.message;
+    }
+
+    if (!attempted) {
+        LOG_ERROR << "[生成服务] 未找到提供者: " << preferredChannel;
+        session.response.message["error"] = "未找到上游提供者: " + preferredChannel;
         return false;
     }
-    
-    // 使用 () 接口获取结构化结果
-    ProviderResult result = api->generate(session);
 
     if (!result.toolCalls.empty()) {
         Json::Value toolCalls(Json::arrayValue);
@@ -380,6 +490,25 @@ bool GenerationService::executeProvider(session_st& session) {
         session.response.message["error"] = result.error.message;
         return false;
     }
+
+    // 记录 token 用量：优先使用上游返回的 usage，缺失时按文本长度估算；
+    // 额度未启用但配置了用量库时同样记录，用于用量统计
+    if (config->quota.enabled || metrics::UsageQuotaService::getInstance().storeEnabled()) {
+        const bool estimated = !result.usage.has_value() || !result.usage->isValid();
+        const int64_t inputTokens = estimated ? estimateInputTokens(session) : result.usage->inputTokens;
+        int64_t outputTokens = 0;
+        if (!estimated) {
+            outputTokens = result.usage->outputTokens;
+        } else {
+            outputTokens = metrics::UsageQuotaService::estimateTokens(result.text);
+            for (const auto& tc : result.toolCalls) {
+                outputTokens += metrics::UsageQuotaService::estimateTokens(tc.arguments);
+            }
+        }
+        metrics::UsageQuotaService::getInstance().record(
+            clientApiKey(session), session.request.api, session.request.model,
+            inputTokens, outputTokens, estimated, config->quota);
+    }
     
     return true;
 }
@@ -10,12 +10,14 @@
 #include "sessionManager/tooling/ForcedToolCallGenerator.h"
 #include "sessionManager/tooling/ToolCallNormalizer.h"
 #include "sessionManager/tooling/ToolDefinitionEncoder.h"
+#include "sessionManager/tooling/ToolBridgePromptCache.h"
 #include <apiManager/ApiManager.h>
 #include <apipoint/ProviderResult.h>
 #include <tools/ZeroWidthEncoder.h>
 #include <channelManager/channelManager.h>
 #include <metrics/ErrorStatsService.h>
 #include <metrics/ErrorEvent.h>
+#include <utils/RuntimeConfig.h>
 #include <drogon/drogon.h>
 #include <algorithm>
 #include <iomanip>
@@ -77,9 +79,12 @@ void rewriteBridgeConflictsInText(std::string& text) {
         "tool_format\":\"xml_bridge\"");
 }
 
-void rewriteBridgeConflictsInMessageContext(Json::Value& messageContext, bool rewriteUserRoleMessages) {
-    if (!messageContext.isArray()) return;
-    for (auto& msg : messageContext) {
+// 返回第一条被实际改写的消息下标，均未改动时返回 messageContext.size()
+size_t rewriteBridgeConflictsInMessageContext(Json::Value& messageContext, bool rewriteUserRoleMessages) {
+    if (!messageContext.isArray()) return 0;
+    size_t firstChanged = messageContext.size();
+    for (Json::ArrayIndex i = 0; i < messageContext.size(); ++i) {
+        auto& msg = messageContext[i];
         if (!msg.isObject()) continue;
 
         const std::string role = msg.get("role", "").asString();
@@ -87,24 +92,32 @@ void rewriteBridgeConflictsInMessageContext(Json::Value& messageContext, bool re
             continue;
         }
 
+        bool changed = false;
         if (msg.isMember("content") && msg["content"].isString()) {
             std::string content = msg["content"].asString();
             rewriteBridgeConflictsInText(content);
-            msg["content"] = content;
-            continue;
-        }
-
-        if (msg.isMember("content") && msg["content"].isArray()) {
+            if (content != msg["content"].asString()) {
+                msg["content"] = content;
+                changed = true;
+            }
+        } else if (msg.isMember("content") && msg["content"].isArray()) {
             for (auto& part : msg["content"]) {
                 if (!part.isObject()) continue;
                 if (part.get("type", "").asString() == "text" && part.isMember("text") && part["text"].isString()) {
                     std::string text = part["text"].asString();
                     rewriteBridgeConflictsInText(text);
-                    part["text"] = text;
+                    if (text != part["text"].asString()) {
+                        part["text"] = text;
+                        changed = true;
+                    }
                 }
             }
         }
+        if (changed && firstChanged == messageContext.size()) {
+            firstChanged = i;
+        }
     }
+    return firstChanged;
 }
 
 void rewriteBridgeConflictingDirectives(session_st& session, bool rewriteUserInput) {
@@ -116,7 +129,9 @@ void rewriteBridgeConflictingDirectives(session_st& session, bool rewriteUserInp
         rewriteBridgeConflictsInText(session.request.message);
     }
 
-    rewriteBridgeConflictsInMessageContext(session.provider.messageContext, rewriteUserInput);
+    const size_t firstRewritten = rewriteBridgeConflictsInMessageContext(session.provider.messageContext, rewriteUserInput);
+    // 已改写过的历史再次改写不会变化，通常只有上一轮新追加的消息被改写，已渲染的前缀仍可复用
+    session.provider.transcriptCache.invalidateFrom(firstRewritten);
     LOG_DEBUG << "[生成服务] bridge 冲突指令改写已执行: system_len "
               << beforeSystem << "->" << session.request.systemPrompt.size()
               << ", message_len(" << (rewriteUserInput ? "rewritten" : "unchanged_user_input")
@@ -129,16 +144,6 @@ struct ToolChoiceSpec {
     std::string forcedToolName;
 };
 
-bool containsStr(const Json::Value& arr, const std::string& value) {
-    if (!arr.isArray() || value.empty()) return false;
-    for (const auto& item : arr) {
-        if (item.isString() && item.asString() == value) {
-            return true;
-        }
-    }
-    return false;
-}
-
 ToolChoiceSpec parseToolChoiceSpec(const std::string& toolChoiceRaw) {
     ToolChoiceSpec spec;
     if (toolChoiceRaw.empty()) {
@@ -173,57 +178,11 @@ ToolChoiceSpec parseToolChoiceSpec(const std::string& toolChoiceRaw) {
 }
 
 bool isStrictSentinelEnabled(const session_st& session, bool strictToolClient, bool toolChoiceRequired) {
-    const auto& customConfig = drogon::app().getCustomConfig();
-    if (!customConfig.isObject() || !customConfig.isMember("tool_bridge") || !customConfig["tool_bridge"].isObject()) {
-        return strictToolClient || toolChoiceRequired;
-    }
-
-    const auto& tb = customConfig["tool_bridge"];
-    bool strictSentinel = true;
-
-    if (tb.isMember("strict_sentinel") && tb["strict_sentinel"].isBool()) {
-        strictSentinel = tb["strict_sentinel"].asBool();
-    }
-
-    if (tb.isMember("strict_sentinel_by_channel") && tb["strict_sentinel_by_channel"].isObject()) {
-        const auto& byChannel = tb["strict_sentinel_by_channel"];
-        if (byChannel.isMember(session.request.api) && byChannel[session.request.api].isBool()) {
-            strictSentinel = byChannel[session.request.api].asBool();
-        }
-    }
-
-    if (tb.isMember("strict_sentinel_by_model") && tb["strict_sentinel_by_model"].isObject()) {
-        const auto& byModel = tb["strict_sentinel_by_model"];
-        if (!session.request.model.empty() && byModel.isMember(session.request.model) && byModel[session.request.model].isBool()) {
-            strictSentinel = byModel[session.request.model].asBool();
-        }
-    }
-
-    if (tb.isMember("strict_sentinel_disabled_channels") &&
-        containsStr(tb["strict_sentinel_disabled_channels"], session.request.api)) {
-        strictSentinel = false;
-    }
-
-    if (tb.isMember("strict_sentinel_enabled_channels") &&
-        containsStr(tb["strict_sentinel_enabled_channels"], session.request.api)) {
-        strictSentinel = true;
-    }
-
-    if (tb.isMember("strict_sentinel_disabled_models") &&
-        containsStr(tb["strict_sentinel_disabled_models"], session.request.model)) {
-        strictSentinel = false;
-    }
-
-    if (tb.isMember("strict_sentinel_enabled_models") &&
-        containsStr(tb["strict_sentinel_enabled_models"], session.request.model)) {
-        strictSentinel = true;
-    }
-
     if (strictToolClient || toolChoiceRequired) {
-        strictSentinel = true;
+        return true;
     }
-
-    return strictSentinel;
+    const auto runtimeConfig = RuntimeConfigStore::getInstance().current();
+    return runtimeConfig->toolBridge.strictSentinelFor(session.request.api, session.request.model);
 }
 
 bool isRetoolAgentModel(const std::string& model) {
@@ -1414,42 +1373,15 @@ void GenerationService::transformRequestForToolBridge(session_st& session) {
     const std::string clientType = safeJsonAsString(session.provider.clientInfo.get("client_type", ""), "");
     const bool strictToolClient = (clientType == "Kilo-Code" || clientType == "RooCode");
 
-    // 工具定义详细度开关（可配置）
+    // 工具定义详细度开关（可配置，取自运行期配置快照）
     // 默认规则：compact 表示简化类型，full 表示详细类型。
-    bool useFullToolDefinitions = false;
-    bool includeToolDescriptions = false; // false=不输出描述；true=输出函数与参数说明
-    int maxDescriptionChars = 160;        // 截断描述长度，避免提示词膨胀
-
-    {
-        const auto& customConfig = drogon::app().getCustomConfig();
-        if (customConfig.isObject() && customConfig.isMember("tool_bridge") && customConfig["tool_bridge"].isObject()) {
-            const auto& tb = customConfig["tool_bridge"];
-
-            if (tb.isMember("definition_mode") && tb["definition_mode"].isString()) {
-                const std::string definitionMode = toLowerStr(tb["definition_mode"].asString());
-                if (definitionMode == "full") {
-                    useFullToolDefinitions = true;
-                } else if (definitionMode == "compact") {
-                    useFullToolDefinitions = false;
-                } else {
-                    LOG_WARN << "[生成服务] tool_bridge.definition_mode 配置无效：" << definitionMode
-                             << "，已回退到默认模式（compact）";
-                    useFullToolDefinitions = false;
-                }
-            }
-
-            if (tb.isMember("include_descriptions") && tb["include_descriptions"].isBool()) {
-                includeToolDescriptions = tb["include_descriptions"].asBool();
-            }
-
-            if (tb.isMember("max_description_chars") && tb["max_description_chars"].isInt()) {
-                maxDescriptionChars = tb["max_description_chars"].asInt();
-            }
-
-            if (maxDescriptionChars < 0) maxDescriptionChars = 0;
-            if (maxDescriptionChars > 2000) maxDescriptionChars = 2000;
-        }
-    }
+    const auto runtimeConfig = RuntimeConfigStore::getInstance().current();
+    const auto& toolBridgeConfig = runtimeConfig->toolBridge;
+    const bool useFullToolDefinitions = toolBridgeConfig.fullDefinitions;
+    const bool includeToolDescriptions = toolBridgeConfig.includeDescriptions; // false=不输出描述；true=输出函数与参数说明
+    const int maxDescriptionChars = toolBridgeConfig.maxDescriptionChars;      // 截断描述长度，避免提示词膨胀
+    const bool rewriteUserInputForBridge = toolBridgeConfig.rewriteUserInputConflicts;
+    const int triggerRandomLength = toolBridgeConfig.triggerRandomLength;
 
     auto encodeToolList = [&](const Json::Value& tools) -> std::string {
         if (!tools.isArray() || tools.empty()) {
@@ -1667,56 +1599,6 @@ void GenerationService::transformRequestForToolBridge(session_st& session) {
         return oss.str();
     };
 
-    // 为上游编码工具定义。
-    // 默认使用 列表，避免描述过长触发上游拒绝
-    // 并避免挤占上下文窗口导致用户请求被截断。
-    std::string toolDefinitions;
-    try {
-        toolDefinitions = encodeToolList(session.request.tools);
-    } catch (const std::exception& e) {
-        // 工具定义编码失败时不得中断请求，回退为仅工具名列表。
-        LOG_WARN << "[生成服务] 工具定义编码异常，回退为仅工具名列表: " << e.what();
-        std::ostringstream oss;
-        for (const auto& tool : session.request.tools) {
-            if (!tool.isObject()) continue;
-            if (tool.get("type", "").asString() != "function") continue;
-            const auto& func = tool["function"];
-            if (!func.isObject()) continue;
-            const std::string name = func.get("name", "").asString();
-            if (!name.empty()) {
-                oss << "Tool: " << name << "\n";
-            }
-        }
-        toolDefinitions = oss.str();
-    }
-
-    if (toolDefinitions.empty()) {
-        LOG_WARN << "[生成服务] 工具定义编码结果为空";
-        return;
-    }
-
-    // 保留原始输入与工具定义，供下游解析与兜底策略使用。
-    if (session.request.rawMessage.empty()) {
-        session.request.rawMessage = session.request.message;
-    }
-    if (session.request.toolsRaw.isNull() || !session.request.toolsRaw.isArray() || session.request.toolsRaw.size() == 0) {
-        session.request.toolsRaw = session.request.tools;
-    }
-
-    bool rewriteUserInputForBridge = false;
-    {
-        const auto& customConfig = drogon::app().getCustomConfig();
-        if (customConfig.isObject() && customConfig.isMember("tool_bridge") && customConfig["tool_bridge"].isObject()) {
-            const auto& tb = customConfig["tool_bridge"];
-            if (tb.isMember("rewrite_user_input_conflicts") && tb["rewrite_user_input_conflicts"].isBool()) {
-                rewriteUserInputForBridge = tb["rewrite_user_input_conflicts"].asBool();
-            }
-        }
-    }
-
-    // 对 bridge 模式下的冲突指令做改写：避免上游继续遵循 native tool-calling 提示。
-    rewriteBridgeConflictingDirectives(session, rewriteUserInputForBridge);
-
     // 解析 tool_choice（同时支持字符串与 JSON 对象两种编码）。
     auto normalizeLower = [](std::string s) {
         for (auto& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
@@ -1745,63 +1627,120 @@ void GenerationService::transformRequestForToolBridge(session_st& session) {
         }
     }
 
-    int triggerRandomLength = 8;
+    const bool isRetoolProvider = (session.request.api == "retoolapi");
+    const bool isRetoolAgentRoute = isRetoolAgentModel(session.request.model);
+
+    // 编码结果只取决于工具定义、编码选项、客户端类型、渠道路由与 tool_choice，
+    // 与触发标记无关；同一组合命中缓存时直接复用已编码片段，只拼接本次触发标记。
+    const std::string toolsHash = toolcall::hashToolDefinitions(session.request.tools);
+    std::string cacheKey;
     {
-        const auto& customConfig = drogon::app().getCustomConfig();
-        if (customConfig.isObject() && customConfig.isMember("tool_bridge") && customConfig["tool_bridge"].isObject()) {
-            const auto& tb = customConfig["tool_bridge"];
-            if (tb.isMember("trigger_random_length") && tb["trigger_random_length"].isInt()) {
-                triggerRandomLength = tb["trigger_random_length"].asInt();
+        std::ostringstream key;
+        key << toolsHash
+            << '|' << (useFullToolDefinitions ? "full" : "compact")
+            << '|' << (includeToolDescriptions ? maxDescriptionChars : -1)
+            << '|' << (strictToolClient ? "strict" : "default")
+            << '|' << session.request.api
+            << '|' << (isRetoolProvider ? (isRetoolAgentRoute ? "agent" : "workflow") : "generic")
+            << '|' << toolChoice
+            << '|' << forcedToolName;
+        cacheKey = key.str();
+    }
+
+    auto& promptCache = toolcall::ToolBridgePromptCache::getInstance();
+    auto fragment = promptCache.find(cacheKey);
+    if (!fragment) {
+        // 为上游编码工具定义。
+        // 默认使用 列表，避免描述过长触发上游拒绝
+        // 并避免挤占上下文窗口导致用户请求被截断。
+        std::string toolDefinitions;
+        try {
+            toolDefinitions = encodeToolList(session.request.tools);
+        } catch (const std::exception& e) {
+            // 工具定义编码失败时不得中断请求，回退为仅工具名列表。
+            LOG_WARN << "[生成服务] 工具定义编码异常，回退为仅工具名列表: " << e.what();
+            std::ostringstream oss;
+            for (const auto& tool : session.request.tools) {
+                if (!tool.isObject()) continue;
+                if (tool.get("type", "").asString() != "function") continue;
+                const auto& func = tool["function"];
+                if (!func.isObject()) continue;
+                const std::string name = func.get("name", "").asString();
+                if (!name.empty()) {
+                    oss << "Tool: " << name << "\n";
+                }
             }
+            toolDefinitions = oss.str();
         }
-    }
 
-    // 为每次请求生成随机触发标记，仅解析属于本次请求的工具调用，避免误命中
-    // 并避免将普通文本中的示例 XML 误解析为真实调用。
-    session.provider.toolBridgeTrigger = generateRandomTriggerSignal(static_cast<size_t>(triggerRandomLength));
-    const std::string& triggerSignal = session.provider.toolBridgeTrigger;
+        if (toolDefinitions.empty()) {
+            LOG_WARN << "[生成服务] 工具定义编码结果为空";
+            return;
+        }
 
-    // 使用 provider 定制的 bridge prompt：
-    // - 默认保留现有通用 XML bridge prompt
-    // - retoolapi/workflow 使用更短、更硬的单轮 tool-bridge prompt
-    // - retoolapi/agent 使用更严格的多轮 tool-router prompt
-    //
-    // 重要：外层标签 <tool_instructions> 故意与解析标签不同，
-    // 用于防止提示词本身被误判为工具调用。
-    {
-         const bool isRetoolProvider = (session.request.api == "retoolapi");
-         const bool isRetoolAgentRoute = isRetoolAgentModel(session.request.model);
-        
+        // 使用 provider 定制的 bridge prompt：
+        // - 默认保留现有通用 XML bridge prompt
+        // - retoolapi/workflow 使用更短、更硬的单轮 tool-bridge prompt
+        // - retoolapi/agent 使用更严格的多轮 tool-router prompt
+        //
+        // 重要：外层标签 <tool_instructions> 故意与解析标签不同，
+        // 用于防止提示词本身被误判为工具调用。
+        // 触发标记以占位符写入，拼接时再替换为本次请求的随机标记。
+        const std::string& triggerPlaceholder = toolcall::ToolBridgePromptCache::triggerPlaceholder();
         std::ostringstream policy;
         policy << "<tool_instructions>\n";
         if (isRetoolProvider && isRetoolAgentRoute) {
-            appendRetoolAgentRoutePolicy(policy, triggerSignal, forcedToolName);
+            appendRetoolAgentRoutePolicy(policy, triggerPlaceholder, forcedToolName);
         } else if (isRetoolProvider) {
-            appendRetoolProviderPolicy(policy, triggerSignal, forcedToolName);
+            appendRetoolProviderPolicy(policy, triggerPlaceholder, forcedToolName);
         } else {
             appendGenericXmlBridgePolicy(policy,
                                          strictToolClient,
                                          forcedToolName,
                                          toolChoice,
-                                         triggerSignal,
+                                         triggerPlaceholder,
                                          session.request.api);
         }
 
         policy << "\nAPI Definitions{\n";
-        toolDefinitions = policy.str() + toolDefinitions;
-        toolDefinitions += "}</tool_instructions>\n\n";
+        policy << toolDefinitions;
+        policy << "}</tool_instructions>\n\n";
+
+        LOG_DEBUG << "[生成服务] 工具定义: " << toolDefinitions;
+        fragment = toolcall::ToolBridgePromptCache::compile(policy.str(), toolsHash);
+        promptCache.insert(cacheKey, fragment);
+    } else {
+        LOG_DEBUG << "[生成服务] 工具定义命中缓存: " << toolsHash;
+    }
+
+    // 保留原始输入与工具定义，供下游解析与兜底策略使用。
+    if (session.request.rawMessage.empty()) {
+        session.request.rawMessage = session.request.message;
     }
+    if (session.request.toolsRaw.isNull() || !session.request.toolsRaw.isArray() || session.request.toolsRaw.size() == 0) {
+        session.request.toolsRaw = session.request.tools;
+    }
+
+    // 对 bridge 模式下的冲突指令做改写：避免上游继续遵循 native tool-calling 提示。
+    rewriteBridgeConflictingDirectives(session, rewriteUserInputForBridge);
+
+    // 为每次请求生成随机触发标记，仅解析属于本次请求的工具调用，避免误命中
+    // 并避免将普通文本中的示例 XML 误解析为真实调用。
+    session.provider.toolBridgeTrigger = generateRandomTriggerSignal(static_cast<size_t>(triggerRandomLength));
+    const std::string& triggerSignal = session.provider.toolBridgeTrigger;
 
-    LOG_DEBUG << "[生成服务] 已注入工具定义到请求消息，长度: " << toolDefinitions.length();
+    LOG_DEBUG << "[生成服务] 已注入工具定义到请求消息，长度: " << fragment->renderedSize(triggerSignal);
 
-    LOG_DEBUG << "[生成服务] 工具定义: " << toolDefinitions;
     static const std::string bridgeNotice =
         "\n\n【注意：回复时必须要满足下面<tool_instructions></tool_instructions>定义中的要求！！！】";
     session.request.message.reserve(
-        session.request.message.size() + bridgeNotice.size() + toolDefinitions.size() + 3
+        session.request.message.size() + bridgeNotice.size() + fragment->renderedSize(triggerSignal) + 3
     );
+    // 记录工具定义块的位置与指纹：上游续聊线程若已持有同一份定义，provider 可只发送简短引用。
+    session.provider.toolBridgeOffset = session.request.message.size();
+    session.provider.toolBridgeDigest = toolcall::digestToolBridgeKey(cacheKey);
     session.request.message.append(bridgeNotice);
-    session.request.message.append(toolDefinitions);
+    fragment->appendTo(session.request.message, triggerSignal);
     session.request.message.append("；");
 
     // 清空 字段，避免后续流程重复处理
@@ -0,0 +1,113 @@
+#include "ImageBlobStore.h"
+
+#include <drogon/utils/Utilities.h>
+#include <cstdint>
+
+namespace {
+
+int base64Value(unsigned char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+' || c == '-') return 62;
+    if (c == '/' || c == '_') return 63;
+    return -1;
+}
+
+// 解码标准与 URL 安全两种字母表，忽略空白，遇到 '=' 结束；含非法字符时返回 false
+bool decodeBase64(std::string_view input, std::string& out) {
+    out.clear();
+    out.reserve(input.size() / 4 * 3 + 3);
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (unsigned char c : input) {
+        if (c == '=') {
+            break;
+        }
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            continue;
+        }
+        const int value = base64Value(c);
+        if (value < 0) {
+            return false;
+        }
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+} // 匿名命名空间
+
+ImageBlobStore& ImageBlobStore::getInstance() {
+    static ImageBlobStore instance;
+    return instance;
+}
+
+ImageBlobStore::ImageBlobStore() : state_(std::make_shared<State>()) {}
+
+std::string ImageBlobStore::digestOf(std::string_view bytes) {
+    return drogon::utils::getSha256(bytes.data(), bytes.size());
+}
+
+std::shared_ptr<const ImageBlob> ImageBlobStore::internBase64(std::string_view base64) {
+    std::string bytes;
+    if (!decodeBase64(base64, bytes)) {
+        return nullptr;
+    }
+    return intern(std::move(bytes));
+}
+
+std::shared_ptr<const ImageBlob> ImageBlobStore::intern(std::string bytes) {
+    if (bytes.empty()) {
+        return nullptr;
+    }
+    auto digest = digestOf(bytes);
+
+    // existing 须在锁之外析构：它可能是最后一个句柄，删除器会再次加锁
+    std::shared_ptr<const ImageBlob> existing;
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    auto& slot = state_->blobs[digest];
+    existing = slot.lock();
+    if (existing && existing->bytes == bytes) {
+        return existing;
+    }
+    // 摘要相同而内容不同时不覆盖索引，新 blob 只由调用方持有
+    const bool indexed = !existing;
+
+    const size_t size = bytes.size();
+    std::weak_ptr<State> weakState = state_;
+    std::shared_ptr<const ImageBlob> blob(
+        new ImageBlob{std::move(bytes), digest},
+        [weakState, size](const ImageBlob* released) {
+            if (auto state = weakState.lock()) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                auto it = state->blobs.find(released->digest);
+                // 同一内容可能已被重新驻留，只移除已失效的索引
+                if (it != state->blobs.end() && it->second.expired()) {
+                    state->blobs.erase(it);
+                }
+                state->totalBytes -= size;
+            }
+            delete released;
+        });
+    if (indexed) {
+        slot = blob;
+    }
+    state_->totalBytes += size;
+    return blob;
+}
+
+size_t ImageBlobStore::size() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->blobs.size();
+}
+
+size_t ImageBlobStore::totalBytes() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->totalBytes;
+}
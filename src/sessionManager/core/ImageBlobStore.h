@@ -0,0 +1,58 @@
+#ifndef IMAGE_BLOB_STORE_H
+#define IMAGE_BLOB_STORE_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief 解码后的图片数据（不可变，由 ImageBlobStore 驻留并以 shared_ptr 共享）
+ */
+struct ImageBlob {
+    std::string bytes;   // 解码后的图片字节
+    std::string digest;  // 内容摘要（SHA-256 十六进制）
+};
+
+/**
+ * @brief 请求图片的驻留存储 - 单例
+ *
+ * 请求解析时把 data URL 中的 base64 解码一次并驻留，之后 GenerationRequest、session_st、
+ * 流式回调与会话存储中的 ImageInfo 只复制 shared_ptr 句柄，不再复制图片数据。
+ * 内容相同的图片（如 agent 客户端多轮重发的截图）共享同一份 blob：按 SHA-256 摘要索引，
+ * 复用前再比对字节，摘要相同而内容不同时返回不入索引的独立 blob；
+ * 最后一个句柄释放时 blob 随之释放并移出索引。
+ */
+class ImageBlobStore {
+public:
+    static ImageBlobStore& getInstance();
+
+    ImageBlobStore();
+    ImageBlobStore(const ImageBlobStore&) = delete;
+    ImageBlobStore& operator=(const ImageBlobStore&) = delete;
+
+    /// 解码 base64 并驻留；为空或含非法字符时返回 nullptr
+    std::shared_ptr<const ImageBlob> internBase64(std::string_view base64);
+    /// 驻留已解码的数据；为空时返回 nullptr
+    std::shared_ptr<const ImageBlob> intern(std::string bytes);
+
+    static std::string digestOf(std::string_view bytes);
+
+    /// 当前仍被持有的 blob 数与字节总数
+    size_t size() const;
+    size_t totalBytes() const;
+
+private:
+    struct State {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::weak_ptr<const ImageBlob>> blobs;
+        size_t totalBytes = 0;
+    };
+
+    // blob 可能比存储本身活得久，删除器只持有 State 的弱引用
+    std::shared_ptr<State> state_;
+};
+
+#endif
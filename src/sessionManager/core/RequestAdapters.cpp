@@ -1,4 +1,5 @@
 #include "sessionManager/core/RequestAdapters.h"
+#include "sessionManager/core/ImageBlobStore.h"
 #include <tools/ZeroWidthEncoder.h>
 #include <drogon/drogon.h>
 
@@ -92,12 +93,12 @@ GenerationRequest RequestAdapters::buildGenerationRequestFromChat(
     }
     
     // 将提取的图片传递给 Generation请求
-    genReq.images = images;
+    genReq.images = std::move(images);
     
     LOG_INFO << "[请求适配器] API 请求解析完成，模型：" << genReq.model
              << ", messages: " << genReq.messages.size()
              << ", currentInput length: " << genReq.currentInput.length()
-             << ", images: " << images.size();
+             << ", images: " << genReq.images.size();
     
     return genReq;
 }
@@ -225,12 +226,12 @@ GenerationRequest RequestAdapters::buildGenerationRequestFromResponses(
     }
     
     // 将提取的图片传递给 Generation请求
-    genReq.images = images;
+    genReq.images = std::move(images);
     
     LOG_INFO << "[请求适配器] Responses API 请求解析完成，模型：" << genReq.model
              << ", messages: " << genReq.messages.size()
              << ", currentInput length: " << genReq.currentInput.length()
-             << ", images: " << images.size();
+             << ", images: " << genReq.images.size();
     
     return genReq;
 }
@@ -479,9 +480,9 @@ void RequestAdapters::parseResponseInput(
             
             if (!url.empty()) {
                 ImageInfo imgInfo = parseImageUrl(url);
-                if (!imgInfo.base64Data.empty() || !imgInfo.uploadedUrl.empty()) {
-                    images.push_back(imgInfo);
+                if (!imgInfo.empty()) {
                     LOG_INFO << "[请求适配器] 提取到图片(input_image)，mediaType：" << imgInfo.mediaType;
+                    images.push_back(std::move(imgInfo));
                 }
             }
             continue;
@@ -493,9 +494,9 @@ void RequestAdapters::parseResponseInput(
                 const auto& imageUrl = item["image_url"];
                 if (imageUrl.isMember("url")) {
                     ImageInfo imgInfo = parseImageUrl(imageUrl["url"].asString());
-                    if (!imgInfo.base64Data.empty() || !imgInfo.uploadedUrl.empty()) {
-                        images.push_back(imgInfo);
+                    if (!imgInfo.empty()) {
                         LOG_INFO << "[请求适配器] 提取到图片(image_url)，mediaType：" << imgInfo.mediaType;
+                        images.push_back(std::move(imgInfo));
                     }
                 }
             }
@@ -564,8 +565,8 @@ void RequestAdapters::parseResponseInputItems(
 
             if (!url.empty()) {
                 ImageInfo imgInfo = parseImageUrl(url);
-                if (!imgInfo.base64Data.empty() || !imgInfo.uploadedUrl.empty()) {
-                    images.push_back(imgInfo);
+                if (!imgInfo.empty()) {
+                    images.push_back(std::move(imgInfo));
                 }
             }
             continue;
@@ -577,8 +578,8 @@ void RequestAdapters::parseResponseInputItems(
                 const auto& imageUrl = item["image_url"];
                 if (imageUrl.isMember("url")) {
                     ImageInfo imgInfo = parseImageUrl(imageUrl["url"].asString());
-                    if (!imgInfo.base64Data.empty() || !imgInfo.uploadedUrl.empty()) {
-                        images.push_back(imgInfo);
+                    if (!imgInfo.empty()) {
+                        images.push_back(std::move(imgInfo));
                     }
                 }
             }
@@ -649,8 +650,8 @@ std::string RequestAdapters::extractContentText(
                 const auto& imageUrl = item["image_url"];
                 if (imageUrl.isMember("url") && imageUrl["url"].isString()) {
                     ImageInfo imgInfo = parseImageUrl(imageUrl["url"].asString());
-                    if (!imgInfo.base64Data.empty() || !imgInfo.uploadedUrl.empty()) {
-                        images.push_back(imgInfo);
+                    if (!imgInfo.empty()) {
+                        images.push_back(std::move(imgInfo));
                     }
                 }
             }
@@ -671,8 +672,8 @@ std::string RequestAdapters::extractContentText(
             
             if (!url.empty()) {
                 ImageInfo imgInfo = parseImageUrl(url);
-                if (!imgInfo.base64Data.empty() || !imgInfo.uploadedUrl.empty()) {
-                    images.push_back(imgInfo);
+                if (!imgInfo.empty()) {
+                    images.push_back(std::move(imgInfo));
                 }
             }
         }
@@ -695,7 +696,8 @@ ImageInfo RequestAdapters::parseImageUrl(const std::string& url) {
         size_t commaPos = url.find(",");
         if (semicolonPos != std::string::npos && commaPos != std::string::npos) {
             imgInfo.mediaType = url.substr(5, semicolonPos - 5);  // 提取 image/png
-            imgInfo.base64Data = url.substr(commaPos + 1);        // 提取 base64 数据
+            // 直接从 URL 解码驻留，不再复制一份 base64 文本
+            imgInfo.blob = ImageBlobStore::getInstance().internBase64(std::string_view(url).substr(commaPos + 1));
         }
     } else {
 
@@ -1,5 +1,6 @@
 #include "sessionManager/core/Session.h"
 #include "sessionManager/continuity/ResponseIndex.h"
+#include "sessionManager/core/ImageBlobStore.h"
 #include <time.h>
 #include <drogon/drogon.h>
 #include <json/json.h>
@@ -144,6 +145,7 @@ session_st& chatSession::createOrUpdateResponseSession(session_st& session)
         if (getResponseSession(session.state.conversationId, prevSession)) {
             // 继承历史消息上下文
             session.provider.messageContext = prevSession.provider.messageContext;
+            session.provider.transcriptCache = prevSession.provider.transcriptCache;
             session.provider.prevProviderKey = session.state.conversationId;
             session.state.isContinuation = true;
             LOG_INFO << "[Response API] 从 previous_response_id 继承上下文, 消息数: "
@@ -169,6 +171,7 @@ session_st& chatSession::createOrUpdateResponseSession(session_st& session)
         if (getResponseSession(session.state.conversationId, prevSession)) {
             // 继承历史消息上下文
             session.provider.messageContext = prevSession.provider.messageContext;
+            session.provider.transcriptCache = prevSession.provider.transcriptCache;
             session.provider.prevProviderKey = session.state.conversationId;
             session.state.isContinuation = true;
             LOG_INFO << "[Response API] 从零宽字符会话继承上下文, 消息数: "
@@ -363,6 +366,8 @@ void chatSession::commitSessionTransfer(session_st& session)
     session.request.rawMessage.clear();
     session.response.message.clear();
     session.provider.toolBridgeTrigger.clear();
+    session.provider.toolBridgeDigest.clear();
+    session.provider.toolBridgeOffset = 0;
     
     // 3. 执行会话转移
     std::string oldSessionId = session.state.conversationId;
@@ -654,15 +659,15 @@ void chatSession::parseImageItem(const Json::Value& item, std::vector<ImageInfo>
         size_t commaPos = url.find(",");
         if (semicolonPos != std::string::npos && commaPos != std::string::npos) {
             imgInfo.mediaType = url.substr(5, semicolonPos - 5); // 提取 image/png
-            imgInfo.base64Data = url.substr(commaPos + 1);       // 提取 base64 数据
+            imgInfo.blob = ImageBlobStore::getInstance().internBase64(std::string_view(url).substr(commaPos + 1));
         }
     } else {
         // 直接是URL
         imgInfo.uploadedUrl = url;
     }
     
-    if (!imgInfo.base64Data.empty() || !imgInfo.uploadedUrl.empty()) {
-        images.push_back(imgInfo);
+    if (!imgInfo.empty()) {
+        images.push_back(std::move(imgInfo));
     }
 }
 
@@ -721,17 +726,17 @@ std::string chatSession::getContentAsString(const Json::Value& content, std::vec
                             size_t comma = url.find(',');
                             if (semicolon != std::string::npos && comma != std::string::npos) {
                                 imgInfo.mediaType = url.substr(5, semicolon - 5);
-                                imgInfo.base64Data = url.substr(comma + 1);
+                                imgInfo.blob = ImageBlobStore::getInstance().internBase64(std::string_view(url).substr(comma + 1));
                             }
                         } else {
                             imgInfo.uploadedUrl = url;
                         }
                         
-                        if (!imgInfo.base64Data.empty() || !imgInfo.uploadedUrl.empty()) {
-                            images.push_back(imgInfo);
+                        if (!imgInfo.empty()) {
                             LOG_DEBUG << "[getContentAsString] 提取到图片(input_image), mediaType: " << imgInfo.mediaType
-                                     << ", hasBase64: " << (!imgInfo.base64Data.empty())
+                                     << ", hasData: " << (imgInfo.blob != nullptr)
                                      << ", hasUrl: " << (!imgInfo.uploadedUrl.empty());
+                            images.push_back(std::move(imgInfo));
                         }
                     }
                 }
@@ -915,6 +920,8 @@ void chatSession::updateResponseSession(session_st& session)
     session.request.rawMessage.clear();
     session.response.message.clear();
     session.provider.toolBridgeTrigger.clear();
+    session.provider.toolBridgeDigest.clear();
+    session.provider.toolBridgeOffset = 0;
 
     // Provider 线程上下文转移（在发送响应给客户端后进行）
     // 只有当 isContinuation 为 true 且 prevProviderKey 与 conversationId 不同时才需要转移
@@ -17,6 +17,7 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include "TranscriptCache.h"
 
 // 前向声明 类型，避免在头文件中直接
 namespace drogon {
@@ -114,12 +115,18 @@ struct session_st
     std::string prevProviderKey = "";
     /// 工具桥接触发信号（随机哨兵串），用于识别与清洗桥接注入内容。
     std::string toolBridgeTrigger = "";
+    /// 本轮注入的工具定义块指纹（为空表示未注入），续聊线程据此判断能否只发送简短引用。
+    std::string toolBridgeDigest = "";
+    /// 工具定义块在 request.message 中的起始位置，用于替换为简短引用。
+    size_t toolBridgeOffset = 0;
     /// 当前 provider 是否支持原生工具调用；影响工具输出格式与桥接策略。
     bool supportsToolCalls = true;
     /// 客户端元信息（client_type、client_version 等），用于规则分流与兼容策略。
     Json::Value clientInfo;
     /// 历史消息上下文数组（role/content），作为续聊时上游输入的一部分。
     Json::Value messageContext = Json::Value(Json::arrayValue);
+    /// messageContext 按 provider 格式渲染的缓存；provider 以 const session_st& 读取时也可追加，故为 mutable。
+    mutable TranscriptCache transcriptCache;
   };
 
   RequestData request;
@@ -130,6 +137,7 @@ struct session_st
   void clearMessageContext()
   {
     provider.messageContext.clear();
+    provider.transcriptCache.clear();
   }
 
   void addMessageToContext(const Json::Value& message)
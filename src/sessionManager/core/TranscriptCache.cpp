@@ -0,0 +1,103 @@
+#include "TranscriptCache.h"
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t mixBytes(uint64_t h, const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= kFnvPrime;
+    }
+    return h;
+}
+
+template <typename T>
+uint64_t mixScalar(uint64_t h, T value) {
+    return mixBytes(h, &value, sizeof(value));
+}
+
+// 按值结构逐字段计算，不做序列化
+uint64_t mixValue(uint64_t h, const Json::Value& value) {
+    h = mixScalar(h, static_cast<int>(value.type()));
+    switch (value.type()) {
+        case Json::intValue:
+            return mixScalar(h, value.asLargestInt());
+        case Json::uintValue:
+            return mixScalar(h, value.asLargestUInt());
+        case Json::realValue:
+            return mixScalar(h, value.asDouble());
+        case Json::booleanValue:
+            return mixScalar(h, value.asBool());
+        case Json::stringValue: {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            value.getString(&begin, &end);
+            const size_t size = begin ? static_cast<size_t>(end - begin) : 0;
+            h = mixScalar(h, size);
+            return begin ? mixBytes(h, begin, size) : h;
+        }
+        case Json::arrayValue:
+        case Json::objectValue:
+            h = mixScalar(h, value.size());
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                if (value.isObject()) {
+                    const char* keyEnd = nullptr;
+                    const char* key = it.memberName(&keyEnd);
+                    const size_t size = key ? static_cast<size_t>(keyEnd - key) : 0;
+                    h = mixScalar(h, size);
+                    h = key ? mixBytes(h, key, size) : h;
+                }
+                h = mixValue(h, *it);
+            }
+            return h;
+        case Json::nullValue:
+        default:
+            return h;
+    }
+}
+
+} // namespace
+
+const TranscriptRender& TranscriptCache::render(const std::string& format,
+                                                const Json::Value& messages,
+                                                const Appender& append) {
+    auto& entry = entries_[format];
+    const size_t total = messages.isArray() ? messages.size() : 0;
+    uint64_t prefixHash = kFnvOffset;
+    if (entry.count <= total) {
+        for (size_t i = 0; i < entry.count; ++i) {
+            prefixHash = mixValue(prefixHash, messages[static_cast<Json::ArrayIndex>(i)]);
+        }
+    }
+    if (entry.count > total || (entry.count > 0 && prefixHash != entry.prefixHash)) {
+        entry = Entry{};
+        prefixHash = kFnvOffset;
+    }
+
+    for (size_t i = entry.count; i < total; ++i) {
+        const auto& message = messages[static_cast<Json::ArrayIndex>(i)];
+        append(entry.render, message);
+        prefixHash = mixValue(prefixHash, message);
+    }
+    entry.count = total;
+    entry.prefixHash = prefixHash;
+    return entry.render;
+}
+
+void TranscriptCache::invalidateFrom(size_t index) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.count > index) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t TranscriptCache::renderedCount(const std::string& format) const {
+    auto it = entries_.find(format);
+    return it == entries_.end() ? 0 : it->second.count;
+}
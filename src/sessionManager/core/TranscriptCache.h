@@ -0,0 +1,56 @@
+#ifndef TRANSCRIPT_CACHE_H
+#define TRANSCRIPT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <json/json.h>
+
+/**
+ * @brief 按 provider 格式渲染的历史消息结果
+ *
+ * 各字段的含义由 provider 的追加函数自定，例如 text 为对话正文、systemText 为历史中的 system 段、
+ * items 为转换后的消息数组。
+ */
+struct TranscriptRender {
+    std::string text;
+    std::string systemText;
+    Json::Value items = Json::Value(Json::arrayValue);
+};
+
+/**
+ * @brief 会话级的历史消息渲染缓存（随 session_st 一起复制与转移）
+ *
+ * messageContext 在续聊中只会在末尾追加本轮消息，因此按格式缓存已渲染的前缀，
+ * 下一轮只追加新增消息。缓存记录已渲染的条数与前缀的滚动哈希，每次渲染前按当前消息重算比对，
+ * 历史被截断或其中任一条被替换、改写时从头渲染；已知的原地改写（如工具桥接冲突指令改写）
+ * 另通过 invalidateFrom() 显式失效。
+ *
+ * 非线程安全：同一 session_st 只在单个请求内使用。
+ */
+class TranscriptCache {
+public:
+    using Appender = std::function<void(TranscriptRender&, const Json::Value& message)>;
+
+    /// 返回 messages 在 format 下的渲染结果，引用在下一次 render/失效前有效
+    const TranscriptRender& render(const std::string& format, const Json::Value& messages, const Appender& append);
+
+    /// 第 index 条及之后的消息被改写：覆盖到该位置的缓存失效
+    void invalidateFrom(size_t index);
+    void clear() { entries_.clear(); }
+
+    size_t renderedCount(const std::string& format) const;
+
+private:
+    struct Entry {
+        TranscriptRender render;
+        size_t count = 0;
+        uint64_t prefixHash = 0;  // 前 count 条消息的滚动哈希
+    };
+
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+#endif
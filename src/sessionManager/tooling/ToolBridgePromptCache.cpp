@@ -0,0 +1,163 @@
+#include "sessionManager/tooling/ToolBridgePromptCache.h"
+#include "sessionManager/core/Session.h"
+#include <cstdint>
+#include <cstdio>
+
+namespace toolcall {
+
+namespace {
+
+std::string toCompactJson(const Json::Value& value) {
+    static thread_local Json::StreamWriterBuilder writer = [] {
+        Json::StreamWriterBuilder instance;
+        instance["indentation"] = "";
+        return instance;
+    }();
+    return Json::writeString(writer, value);
+}
+
+uint64_t fnv1a64(const std::string& data) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string formatDigest(const std::string& data) {
+    char buf[40];
+    std::snprintf(buf, sizeof(buf), "%016llx-%zx",
+                  static_cast<unsigned long long>(fnv1a64(data)), data.size());
+    return buf;
+}
+
+} // 匿名命名空间
+
+void ToolBridgePromptFragment::appendTo(std::string& out, const std::string& triggerSignal) const {
+    out.reserve(out.size() + renderedSize(triggerSignal));
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (i) out.append(triggerSignal);
+        out.append(segments[i]);
+    }
+}
+
+size_t ToolBridgePromptFragment::renderedSize(const std::string& triggerSignal) const {
+    if (segments.empty()) return 0;
+    return staticSize + triggerSignal.size() * (segments.size() - 1);
+}
+
+ToolBridgePromptCache& ToolBridgePromptCache::getInstance() {
+    static ToolBridgePromptCache instance;
+    return instance;
+}
+
+const std::string& ToolBridgePromptCache::triggerPlaceholder() {
+    // 使用控制字符包裹，避免与工具定义/策略文本中的正常内容冲突
+    static const std::string placeholder = "\x1e__TOOL_BRIDGE_TRIGGER__\x1e";
+    return placeholder;
+}
+
+std::shared_ptr<const ToolBridgePromptFragment> ToolBridgePromptCache::compile(const std::string& text,
+                                                                             const std::string& toolsHash) {
+    auto fragment = std::make_shared<ToolBridgePromptFragment>();
+    fragment->toolsHash = toolsHash;
+
+    const std::string& placeholder = triggerPlaceholder();
+    size_t start = 0;
+    size_t pos = 0;
+    while ((pos = text.find(placeholder, start)) != std::string::npos) {
+        fragment->segments.emplace_back(text, start, pos - start);
+        start = pos + placeholder.size();
+    }
+    fragment->segments.emplace_back(text, start, std::string::npos);
+
+    for (const auto& seg : fragment->segments) {
+        fragment->staticSize += seg.size();
+    }
+    return fragment;
+}
+
+std::shared_ptr<const ToolBridgePromptFragment> ToolBridgePromptCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lruIt);
+    return it->second.fragment;
+}
+
+void ToolBridgePromptCache::insert(const std::string& key, std::shared_ptr<const ToolBridgePromptFragment> fragment) {
+    if (!fragment) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        it->second.fragment = std::move(fragment);
+        lru_.splice(lru_.begin(), lru_, it->second.lruIt);
+        return;
+    }
+
+    lru_.push_front(key);
+    entries_.emplace(key, Entry{std::move(fragment), lru_.begin()});
+
+    while (entries_.size() > capacity_ && !lru_.empty()) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+}
+
+void ToolBridgePromptCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+}
+
+size_t ToolBridgePromptCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void ToolBridgePromptCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity == 0 ? 1 : capacity;
+    while (entries_.size() > capacity_ && !lru_.empty()) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+}
+
+std::string hashToolDefinitions(const Json::Value& tools) {
+    if (tools.isNull()) return "";
+    return formatDigest(toCompactJson(tools));
+}
+
+std::string digestToolBridgeKey(const std::string& cacheKey) {
+    if (cacheKey.empty()) return "";
+    return formatDigest(cacheKey);
+}
+
+bool canReuseToolBridgeDefinitions(const session_st& session, const std::string& threadDigest) {
+    const auto& provider = session.provider;
+    return !provider.toolBridgeDigest.empty() &&
+           provider.toolBridgeDigest == threadDigest &&
+           !provider.toolBridgeTrigger.empty() &&
+           provider.toolBridgeOffset <= session.request.message.size();
+}
+
+std::string toolBridgeReferenceMessage(const session_st& session) {
+    const auto& provider = session.provider;
+    if (provider.toolBridgeDigest.empty() || provider.toolBridgeOffset > session.request.message.size()) {
+        return session.request.message;
+    }
+
+    std::string message = session.request.message.substr(0, provider.toolBridgeOffset);
+    message.append("\n\n【注意：工具定义与本对话此前提供的<tool_instructions></tool_instructions>完全相同，回复时仍必须严格满足其中的要求！！！"
+                   "本轮工具调用的触发标记改为：");
+    message.append(provider.toolBridgeTrigger);
+    message.append("】；");
+    return message;
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef TOOL_BRIDGE_PROMPT_CACHE_H
+#define TOOL_BRIDGE_PROMPT_CACHE_H
+
+#include <json/json.h>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct session_st;
+
+namespace toolcall {
+
+/**
+ * @brief 已编码的工具桥接提示词片段（不可变）
+ *
+ * 片段在构建时以占位符代替触发标记，构建后按占位符切分为 segments；
+ * 每次请求只需把本次随机生成的触发标记拼接进去，无需重新编码工具定义。
+ */
+struct ToolBridgePromptFragment {
+    /// 按触发标记占位符切分后的静态文本段（segments.size() == 占位符数量 + 1）
+    std::vector<std::string> segments;
+    /// 所有静态文本段的总长度，用于拼接前预留容量
+    size_t staticSize = 0;
+    /// 工具定义摘要（见 hashToolDefinitions），用于续聊线程判断工具集是否变化
+    std::string toolsHash;
+
+    /// 将触发标记拼接进片段，追加写入 out
+    void appendTo(std::string& out, const std::string& triggerSignal) const;
+    /// 拼接后的总长度
+    size_t renderedSize(const std::string& triggerSignal) const;
+};
+
+/**
+ * @brief 工具桥接提示词缓存
+ *
+ * key 由调用方根据（工具定义摘要、definition_mode 等编码选项、客户端类型、渠道/路由、tool_choice）生成；
+ * value 为共享的不可变片段。容量有限，超出后按最近最少使用淘汰。
+ */
+class ToolBridgePromptCache {
+public:
+    static ToolBridgePromptCache& getInstance();
+
+    /// 构建片段时代替触发标记的占位符
+    static const std::string& triggerPlaceholder();
+
+    /// 将含占位符的完整提示词文本切分为片段
+    static std::shared_ptr<const ToolBridgePromptFragment> compile(const std::string& text,
+                                                                   const std::string& toolsHash);
+
+    std::shared_ptr<const ToolBridgePromptFragment> find(const std::string& key);
+    void insert(const std::string& key, std::shared_ptr<const ToolBridgePromptFragment> fragment);
+    void clear();
+    size_t size() const;
+
+    void setCapacity(size_t capacity);
+
+private:
+    ToolBridgePromptCache() = default;
+
+    using LruList = std::list<std::string>;
+    struct Entry {
+        std::shared_ptr<const ToolBridgePromptFragment> fragment;
+        LruList::iterator lruIt;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    LruList lru_;
+    size_t capacity_ = 256;
+};
+
+/**
+ * @brief 计算工具定义数组的摘要（紧凑 JSON 的 FNV-1a 64 位十六进制 + 长度）
+ */
+std::string hashToolDefinitions(const Json::Value& tools);
+
+/**
+ * @brief 计算桥接片段缓存 key 的摘要，作为本轮注入工具定义块的指纹
+ */
+std::string digestToolBridgeKey(const std::string& cacheKey);
+
+/**
+ * @brief 上游续聊线程已持有同一份工具定义块时返回 true
+ *
+ * @param threadDigest 该线程上次完整发送工具定义块时记录的指纹
+ */
+bool canReuseToolBridgeDefinitions(const session_st& session, const std::string& threadDigest);
+
+/**
+ * @brief 将本轮消息中的完整工具定义块替换为简短引用（仅携带本轮触发标记）
+ *
+ * 未注入工具定义块时原样返回 session.request.message。
+ */
+std::string toolBridgeReferenceMessage(const session_st& session);
+
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include <drogon/drogon_test.h>
+#include "accountManager/AccountHealth.h"
+#include "accountManager/AccountPool.h"
+#include <cmath>
+
+namespace {
+using Clock = AccountHealthTracker::Clock;
+
+shared_ptr<Accountinfo_st> makeAccount(const string& userName, int useCount)
+{
+    return std::make_shared<Accountinfo_st>("chaynsapi", userName, "", "", useCount, true, true, 0, "", "", "pro");
+}
+
+RuntimeConfig::AccountHealth testSettings()
+{
+    RuntimeConfig::AccountHealth settings;
+    settings.ewmaAlpha = 0.5;
+    settings.errorThreshold = 0.5;
+    settings.minSamples = 3;
+    settings.consecutiveFailures = 3;
+    settings.openSeconds = 10;
+    settings.maxOpenSeconds = 40;
+    settings.latencyReferenceMs = 1000;
+    return settings;
+}
+}
+
+DROGON_TEST(AccountHealth_EwmaAndLoadCost)
+{
+    auto& health = AccountHealthTracker::getInstance();
+    health.clear();
+    health.setSettings(testSettings());
+    const auto now = Clock::now();
+
+    health.record("chaynsapi", "a", 1000, true, now);
+    health.record("chaynsapi", "a", 3000, true, now);
+    auto stats = health.get("chaynsapi", "a", now);
+    CHECK(stats.samples == 2);
+    CHECK(std::fabs(stats.latencyEwmaMs - 2000) < 1e-6);
+    CHECK(stats.errorRateEwma == 0.0);
+
+    // 无统计的账号负载即 useCount + 1；延迟 2 倍参考值时负载 ×3
+    Accountinfo_st fresh("chaynsapi", "fresh", "", "", 4, true, true, 0, "");
+    CHECK(health.loadCost(fresh, now) == 5.0);
+    Accountinfo_st slow("chaynsapi", "a", "", "", 4, true, true, 0, "");
+    CHECK(std::fabs(health.loadCost(slow, now) - 15.0) < 1e-6);
+
+    health.clear();
+}
+
+DROGON_TEST(AccountHealth_CircuitOpensAndRecovers)
+{
+    auto& health = AccountHealthTracker::getInstance();
+    health.clear();
+    health.setSettings(testSettings());
+    auto now = Clock::now();
+
+    CHECK(!health.record("chaynsapi", "b", 100, false, now));
+    CHECK(!health.record("chaynsapi", "b", 100, false, now));
+    CHECK(health.record("chaynsapi", "b", 100, false, now));
+    CHECK(health.isOpen("chaynsapi", "b", now));
+    CHECK(std::isinf(health.loadCost(*makeAccount("b", 0), now)));
+    CHECK(health.get("chaynsapi", "b", now).state == AccountHealthTracker::CircuitState::Open);
+
+    // 到期进入半开；探测失败则熔断时长翻倍
+    now += std::chrono::seconds(11);
+    CHECK(!health.isOpen("chaynsapi", "b", now));
+    CHECK(health.get("chaynsapi", "b", now).state == AccountHealthTracker::CircuitState::HalfOpen);
+    // 半开只放行一个探测：探测上报前其他调用方仍视为熔断
+    {
+        auto probe = health.beginProbe("chaynsapi", "b", now);
+        CHECK(probe);
+        CHECK(health.isOpen("chaynsapi", "b", now));
+        CHECK(!health.beginProbe("chaynsapi", "b", now));
+    }
+    // 探测未上报即析构时归还名额
+    CHECK(!health.isOpen("chaynsapi", "b", now));
+    auto probe = health.beginProbe("chaynsapi", "b", now);
+    CHECK(health.isOpen("chaynsapi", "b", now));
+    CHECK(std::isinf(health.loadCost(*makeAccount("b", 0), now)));
+    CHECK(health.record("chaynsapi", "b", 100, false, now));
+    // 已上报的探测析构不影响重新熔断
+    probe.release();
+    CHECK(health.isOpen("chaynsapi", "b", now + std::chrono::seconds(15)));
+    CHECK(!health.isOpen("chaynsapi", "b", now + std::chrono::seconds(21)));
+
+    // 半开探测成功后关闭
+    now += std::chrono::seconds(21);
+    probe = health.beginProbe("chaynsapi", "b", now);
+    CHECK(health.isOpen("chaynsapi", "b", now + std::chrono::seconds(1)));
+    // 探测超时未上报视为丢失，允许重新探测
+    CHECK(!health.isOpen("chaynsapi", "b", now + AccountHealthTracker::kProbeTimeout));
+    CHECK(!health.record("chaynsapi", "b", 100, true, now));
+    auto stats = health.get("chaynsapi", "b", now);
+    CHECK(stats.state == AccountHealthTracker::CircuitState::Closed);
+    CHECK(stats.trips == 2);
+    CHECK(stats.consecutiveFailures == 0);
+
+    health.clear();
+    health.setSettings(RuntimeConfig::AccountHealth{});
+}
+
+DROGON_TEST(AccountHealth_PoolSkipsOpenCircuit)
+{
+    auto& health = AccountHealthTracker::getInstance();
+    health.clear();
+    health.setSettings(testSettings());
+
+    AccountPool pool;
+    pool.put(makeAccount("good", 100));
+    pool.put(makeAccount("broken", 0));
+    for (int i = 0; i < 3; ++i) {
+        health.record("chaynsapi", "broken", 100, false);
+    }
+
+    for (int i = 0; i < 20; ++i) {
+        auto account = pool.acquire("chaynsapi", "pro");
+        CHECK(account != nullptr && account->userName == "good");
+    }
+
+    // 全部熔断时仍返回其中之一
+    pool.remove("chaynsapi", "good");
+    auto account = pool.acquire("chaynsapi", "pro");
+    CHECK(account != nullptr && account->userName == "broken");
+
+    health.clear();
+    health.setSettings(RuntimeConfig::AccountHealth{});
+}
@@ -0,0 +1,78 @@
+#include <drogon/drogon_test.h>
+#include "accountManager/AccountPool.h"
+#include <cstdlib>
+
+namespace {
+shared_ptr<Accountinfo_st> makeAccount(const string& userName, const string& type, int useCount, bool tokenStatus = true)
+{
+    return std::make_shared<Accountinfo_st>("chaynsapi", userName, "", "", useCount, tokenStatus, true, 0, "", "", type);
+}
+}
+
+DROGON_TEST(AccountPool_AcquireByType)
+{
+    AccountPool pool;
+    pool.put(makeAccount("free1", "free", 0));
+    pool.put(makeAccount("pro1", "pro", 5));
+    pool.put(makeAccount("pro2", "pro", 5));
+
+    for (int i = 0; i < 20; ++i) {
+        auto account = pool.acquire("chaynsapi", "pro");
+        CHECK(account != nullptr && account->accountType == "pro");
+    }
+    CHECK(pool.acquire("chaynsapi", "enterprise") == nullptr);
+    CHECK(pool.acquire("nexosapi") == nullptr);
+    CHECK(pool.size("chaynsapi") == 3);
+}
+
+DROGON_TEST(AccountPool_PrefersValidTokenAndBalancesUseCount)
+{
+    AccountPool pool;
+    auto invalid = makeAccount("bad", "free", 0, false);
+    auto a = makeAccount("a", "free", 0);
+    auto b = makeAccount("b", "free", 0);
+    pool.put(invalid);
+    pool.put(a);
+    pool.put(b);
+
+    for (int i = 0; i < 100; ++i) {
+        auto account = pool.acquire("chaynsapi");
+        CHECK(account != nullptr && account->tokenStatus);
+    }
+    CHECK(invalid->useCount == 0);
+    CHECK(a->useCount + b->useCount == 100);
+    CHECK(std::abs(a->useCount - b->useCount) <= 2);
+}
+
+DROGON_TEST(AccountPool_ReclassifiesAfterTypeChangeAndRemoves)
+{
+    AccountPool pool;
+    auto account = makeAccount("u1", "free", 0);
+    pool.put(account);
+
+    // 经 update() 修改类型后立即重新归类
+    pool.update(account, [](Accountinfo_st& info) { info.accountType = "pro"; });
+    CHECK(account->accountType == "pro");
+    CHECK(pool.acquire("chaynsapi", "free") == nullptr);
+    CHECK(pool.acquire("chaynsapi", "pro") == account);
+
+    // token 失效后仍可取到（由调用方判断），但不再累加使用次数
+    pool.update(account, [](Accountinfo_st& info) { info.tokenStatus = false; });
+    const int useCount = account->useCount;
+    CHECK(pool.acquire("chaynsapi", "pro") == account);
+    CHECK(account->useCount == useCount);
+
+    pool.remove("chaynsapi", "u1");
+    CHECK(pool.size("chaynsapi") == 0);
+
+    // 不在池中的账号只修改字段，不会被加入
+    pool.update(account, [](Accountinfo_st& info) { info.tokenStatus = true; });
+    CHECK(account->tokenStatus);
+    CHECK(pool.size("chaynsapi") == 0);
+    CHECK(pool.acquire("chaynsapi") == nullptr);
+
+    pool.reset("chaynsapi", {makeAccount("x", "free", 0), makeAccount("y", "pro", 0)});
+    CHECK(pool.size("chaynsapi") == 2);
+    auto pro = pool.acquire("chaynsapi", "pro");
+    CHECK(pro != nullptr && pro->userName == "y");
+}
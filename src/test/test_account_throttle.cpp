@@ -0,0 +1,156 @@
+#include <drogon/drogon_test.h>
+#include "accountManager/AccountThrottle.h"
+#include "accountManager/AccountPool.h"
+#include <cmath>
+
+namespace {
+using Clock = AccountThrottle::Clock;
+
+RuntimeConfig::AccountThrottle testSettings()
+{
+    RuntimeConfig::AccountThrottle settings;
+    settings.maxInFlight = 2;
+    settings.defaultCooldownSeconds = 10;
+    settings.maxCooldownSeconds = 60;
+    settings.learnRate = true;
+    return settings;
+}
+}
+
+DROGON_TEST(AccountThrottle_ParseDelaySeconds)
+{
+    const std::time_t now = 1700000000;
+    CHECK(AccountThrottle::parseDelaySeconds("5", now) == 5.0);
+    CHECK(AccountThrottle::parseDelaySeconds(" 1.5 ", now) == 1.5);
+    CHECK(AccountThrottle::parseDelaySeconds("1m30s", now) == 90.0);
+    CHECK(std::fabs(AccountThrottle::parseDelaySeconds("250ms", now) - 0.25) < 1e-9);
+    CHECK(AccountThrottle::parseDelaySeconds("1700000020", now) == 20.0);
+    // 1700000000 = Tue, 14 Nov 2023 22:13:20 GMT
+    CHECK(AccountThrottle::parseDelaySeconds("Tue, 14 Nov 2023 22:13:50 GMT", now) == 30.0);
+    CHECK(AccountThrottle::parseDelaySeconds("soon", now) < 0);
+    CHECK(AccountThrottle::parseDelaySeconds("", now) < 0);
+    CHECK(AccountThrottle::retryAfterFromHeaders({"", "bogus", "12"}, now) == 12.0);
+    CHECK(AccountThrottle::retryAfterFromHeaders({"", ""}, now) < 0);
+}
+
+DROGON_TEST(AccountThrottle_CooldownAndInFlight)
+{
+    auto& throttle = AccountThrottle::getInstance();
+    throttle.clear();
+    auto settings = testSettings();
+    settings.learnRate = false;
+    throttle.setSettings(settings);
+    auto now = Clock::now();
+
+    {
+        auto first = throttle.tryBegin("nexosapi", "a", now);
+        auto second = throttle.tryBegin("nexosapi", "a", now);
+        CHECK(first && second);
+        CHECK(!throttle.tryBegin("nexosapi", "a", now));
+        CHECK(!throttle.isAvailable("nexosapi", "a", now));
+        second.release();
+        CHECK(throttle.isAvailable("nexosapi", "a", now));
+    }
+
+    // 上游给出 Retry-After 时按其冷却，超出上限时截断
+    CHECK(throttle.noteRateLimited("nexosapi", "a", 5, now) == 5.0);
+    CHECK(!throttle.tryBegin("nexosapi", "a", now + std::chrono::seconds(4)));
+    CHECK(throttle.isAvailable("nexosapi", "a", now + std::chrono::seconds(6)));
+    CHECK(throttle.noteRateLimited("nexosapi", "b", 3600, now) == 60.0);
+
+    // 未给出时按连续 429 次数翻倍，成功后重置
+    CHECK(throttle.noteRateLimited("nexosapi", "c", -1, now) == 10.0);
+    CHECK(throttle.noteRateLimited("nexosapi", "c", -1, now) == 20.0);
+    throttle.noteSuccess("nexosapi", "c");
+    CHECK(throttle.noteRateLimited("nexosapi", "c", -1, now) == 10.0);
+
+    CHECK(throttle.snapshot("nexosapi").size() == 3);
+    CHECK(throttle.snapshot("chaynsapi").empty());
+
+    throttle.clear();
+    throttle.setSettings(RuntimeConfig::AccountThrottle{});
+}
+
+DROGON_TEST(AccountThrottle_LearnsRate)
+{
+    auto& throttle = AccountThrottle::getInstance();
+    throttle.clear();
+    auto settings = testSettings();
+    settings.maxInFlight = 0;
+    throttle.setSettings(settings);
+    auto now = Clock::now();
+
+    for (int i = 0; i < 20; ++i) {
+        CHECK(throttle.tryBegin("retoolapi", "ws", now));
+    }
+    throttle.noteRateLimited("retoolapi", "ws", 1, now);
+    auto stats = throttle.snapshot("retoolapi");
+    CHECK(stats.size() == 1 && stats[0].learnedPerMinute == 10.0);
+
+    // 冷却结束后按 10/min 补充令牌：6 秒一个
+    now += std::chrono::seconds(1);
+    CHECK(!throttle.tryBegin("retoolapi", "ws", now));
+    now += std::chrono::seconds(6);
+    CHECK(throttle.tryBegin("retoolapi", "ws", now));
+    CHECK(!throttle.tryBegin("retoolapi", "ws", now));
+
+    throttle.noteSuccess("retoolapi", "ws", now);
+    CHECK(throttle.snapshot("retoolapi")[0].learnedPerMinute == 11.0);
+
+    throttle.clear();
+    throttle.setSettings(RuntimeConfig::AccountThrottle{});
+}
+
+DROGON_TEST(AccountThrottle_LearnedRateFloor)
+{
+    auto& throttle = AccountThrottle::getInstance();
+    throttle.clear();
+    auto settings = testSettings();
+    settings.maxInFlight = 0;
+    throttle.setSettings(settings);
+    auto now = Clock::now();
+
+    // 最近一分钟成功 30 次：连续 429 反复减半也不低于 15/min
+    for (int i = 0; i < 30; ++i) {
+        CHECK(throttle.tryBegin("retoolapi", "busy", now));
+        throttle.noteSuccess("retoolapi", "busy", now);
+    }
+    for (int i = 0; i < 5; ++i) {
+        throttle.noteRateLimited("retoolapi", "busy", 1, now);
+    }
+    CHECK(throttle.snapshot("retoolapi")[0].learnedPerMinute == 15.0);
+
+    // 没有成功记录时不低于固定下限 6/min
+    CHECK(throttle.tryBegin("retoolapi", "idle", now));
+    for (int i = 0; i < 5; ++i) {
+        throttle.noteRateLimited("retoolapi", "idle", 1, now);
+    }
+    for (const auto& stats : throttle.snapshot("retoolapi")) {
+        if (stats.account == "idle") {
+            CHECK(stats.learnedPerMinute == 6.0);
+        }
+    }
+
+    throttle.clear();
+    throttle.setSettings(RuntimeConfig::AccountThrottle{});
+}
+
+DROGON_TEST(AccountThrottle_PoolSkipsCoolingAccount)
+{
+    auto& throttle = AccountThrottle::getInstance();
+    throttle.clear();
+    throttle.setSettings(testSettings());
+
+    AccountPool pool;
+    pool.put(std::make_shared<Accountinfo_st>("chaynsapi", "idle", "", "", 100, true, true, 0, "", "", "pro"));
+    pool.put(std::make_shared<Accountinfo_st>("chaynsapi", "cooling", "", "", 0, true, true, 0, "", "", "pro"));
+    throttle.noteRateLimited("chaynsapi", "cooling", 30);
+
+    for (int i = 0; i < 20; ++i) {
+        auto account = pool.acquire("chaynsapi", "pro");
+        CHECK(account != nullptr && account->userName == "idle");
+    }
+
+    throttle.clear();
+    throttle.setSettings(RuntimeConfig::AccountThrottle{});
+}
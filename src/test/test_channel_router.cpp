@@ -0,0 +1,162 @@
+#include <drogon/drogon_test.h>
+#include "channelManager/ChannelRouter.h"
+
+namespace {
+
+RuntimeConfig::ModelRouting makeRouting() {
+    RuntimeConfig::ModelRouting routing;
+    routing.routes["gpt-4o"] = {{"nexosapi", "GPT 4o"}, {"OpenAiProvider", "gpt-4o"}};
+    routing.failureThreshold = 2;
+    routing.openSeconds = 10;
+    routing.maxOpenSeconds = 30;
+    return routing;
+}
+
+std::vector<std::string> channelsOf(const std::vector<ChannelRouter::Candidate>& candidates) {
+    std::vector<std::string> out;
+    for (const auto& candidate : candidates) {
+        out.push_back(candidate.channel);
+    }
+    return out;
+}
+
+} // namespace
+
+DROGON_TEST(ChannelRouter_CandidatesFollowPriorityAndStatus)
+{
+    auto& router = ChannelRouter::getInstance();
+    router.clear();
+    const auto routing = makeRouting();
+    const auto now = ChannelRouter::Clock::now();
+
+    // 未配置路由的模型只走请求路径渠道
+    auto single = router.candidates("other", "chaynsapi", routing, {}, now);
+    CHECK(single.size() == 1);
+    CHECK(single[0].channel == "chaynsapi");
+    CHECK(single[0].model == "other");
+
+    // 同优先级时请求路径渠道在前，备选保留配置顺序与上游模型名
+    auto routed = router.candidates("gpt-4o", "chaynsapi", routing, {}, now);
+    CHECK((channelsOf(routed) == std::vector<std::string>{"chaynsapi", "nexosapi", "OpenAiProvider"}));
+    CHECK(routed[1].model == "GPT 4o");
+
+    // 优先级更高的渠道排在前面，禁用的渠道被跳过
+    std::vector<ChannelRouter::ChannelState> channels{
+        {"chaynsapi", 0, true},
+        {"nexosapi", 5, false},
+        {"OpenAiProvider", 10, true},
+    };
+    auto ordered = router.candidates("gpt-4o", "chaynsapi", routing, channels, now);
+    CHECK((channelsOf(ordered) == std::vector<std::string>{"OpenAiProvider", "chaynsapi"}));
+
+    // 全部不可用时仍返回完整候选
+    std::vector<ChannelRouter::ChannelState> allDisabled{{"chaynsapi", 0, false}};
+    CHECK(router.candidates("other", "chaynsapi", routing, allDisabled, now).size() == 1);
+}
+
+DROGON_TEST(ChannelRouter_CircuitBreaker)
+{
+    auto& router = ChannelRouter::getInstance();
+    router.clear();
+    const auto routing = makeRouting();
+    const auto t0 = ChannelRouter::Clock::now();
+
+    CHECK(!router.record("chaynsapi", false, routing, t0));
+    CHECK(router.record("chaynsapi", false, routing, t0));
+    CHECK(router.isOpen("chaynsapi", t0 + std::chrono::seconds(5)));
+    // 熔断中的渠道不参与路由
+    auto candidates = router.candidates("gpt-4o", "chaynsapi", routing, {}, t0 + std::chrono::seconds(5));
+    CHECK(candidates.front().channel == "nexosapi");
+
+    // 半开探测失败以翻倍时长重新熔断
+    const auto t1 = t0 + std::chrono::seconds(11);
+    CHECK(!router.isOpen("chaynsapi", t1));
+    CHECK(router.record("chaynsapi", false, routing, t1));
+    CHECK(router.isOpen("chaynsapi", t1 + std::chrono::seconds(15)));
+    CHECK(!router.isOpen("chaynsapi", t1 + std::chrono::seconds(21)));
+
+    // 半开探测成功后恢复
+    CHECK(!router.record("chaynsapi", true, routing, t1 + std::chrono::seconds(21)));
+    CHECK(!router.isOpen("chaynsapi", t1 + std::chrono::seconds(21)));
+    CHECK(!router.record("chaynsapi", false, routing, t1 + std::chrono::seconds(22)));
+}
+
+DROGON_TEST(ChannelRouter_HalfOpenAllowsSingleProbe)
+{
+    auto& router = ChannelRouter::getInstance();
+    router.clear();
+    const auto routing = makeRouting();
+    const auto t0 = ChannelRouter::Clock::now();
+
+    // 未熔断时不占用名额
+    CHECK(router.beginProbe("chaynsapi", t0));
+    CHECK(router.beginProbe("chaynsapi", t0));
+    router.record("chaynsapi", false, routing, t0);
+    router.record("chaynsapi", false, routing, t0);
+    CHECK(!router.beginProbe("chaynsapi", t0 + std::chrono::seconds(5)));
+
+    // 半开只放行一个探测，其余调用视为熔断
+    const auto t1 = t0 + std::chrono::seconds(11);
+    CHECK(router.beginProbe("chaynsapi", t1));
+    CHECK(router.isOpen("chaynsapi", t1));
+    CHECK(!router.beginProbe("chaynsapi", t1));
+    auto candidates = router.candidates("gpt-4o", "chaynsapi", routing, {}, t1);
+    CHECK(candidates.front().channel == "nexosapi");
+
+    // 探测未产生结果时释放名额
+    router.abortProbe("chaynsapi");
+    CHECK(!router.isOpen("chaynsapi", t1));
+    CHECK(router.beginProbe("chaynsapi", t1));
+
+    // 探测丢失超时后允许重新探测
+    const auto lost = t1 + ChannelRouter::kProbeTimeout;
+    CHECK(!router.isOpen("chaynsapi", lost));
+    CHECK(router.beginProbe("chaynsapi", lost));
+
+    // 探测上报后清除占用
+    CHECK(!router.record("chaynsapi", true, routing, lost));
+    CHECK(!router.isOpen("chaynsapi", lost));
+}
+
+DROGON_TEST(ChannelRouter_RetryableErrors)
+{
+    using provider::ProviderError;
+    CHECK(ChannelRouter::isRetryable(ProviderError::network("down")));
+    CHECK(ChannelRouter::isRetryable(ProviderError::rateLimited("429")));
+    CHECK(ChannelRouter::isRetryable(ProviderError::timeout("slow")));
+    CHECK(ChannelRouter::isRetryable(ProviderError::internal("5xx")));
+    CHECK(!ChannelRouter::isRetryable(ProviderError::auth("bad key")));
+    CHECK(!ChannelRouter::isRetryable(ProviderError::none()));
+
+    ProviderError budget{provider::ProviderErrorCode::InvalidRequest, "budget reached", "", 402};
+    CHECK(ChannelRouter::isRetryable(budget));
+    ProviderError badRequest{provider::ProviderErrorCode::InvalidRequest, "bad", "", 400};
+    CHECK(!ChannelRouter::isRetryable(badRequest));
+
+    // 本地限流拒绝仍可换渠道，但不计入熔断
+    const auto local = ProviderError::localThrottle("cooling down");
+    CHECK(local.code == provider::ProviderErrorCode::RateLimited);
+    CHECK(ChannelRouter::isRetryable(local));
+    CHECK(!ChannelRouter::countsAsChannelFailure(local));
+    CHECK(ChannelRouter::countsAsChannelFailure(ProviderError::rateLimited("429")));
+    CHECK(!ChannelRouter::countsAsChannelFailure(badRequest));
+}
+
+DROGON_TEST(RuntimeConfig_ParsesModelRouting)
+{
+    Json::Value custom(Json::objectValue);
+    custom["model_routing"]["failure_threshold"] = 4;
+    custom["model_routing"]["routes"]["gpt-4o"].append("nexosapi");
+    Json::Value target(Json::objectValue);
+    target["channel"] = "OpenAiProvider";
+    target["model"] = "gpt-4o-2024-08-06";
+    custom["model_routing"]["routes"]["gpt-4o"].append(target);
+
+    auto config = RuntimeConfig::fromCustomConfig(custom);
+    CHECK(config->modelRouting.failureThreshold == 4);
+    const auto& targets = config->modelRouting.routes.at("gpt-4o");
+    CHECK(targets.size() == 2);
+    CHECK(targets[0].channel == "nexosapi");
+    CHECK(targets[0].model == "gpt-4o");
+    CHECK(targets[1].model == "gpt-4o-2024-08-06");
+}
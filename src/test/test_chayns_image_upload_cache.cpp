@@ -0,0 +1,29 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/chaynsapi/ChaynsImageUploadCache.h"
+
+DROGON_TEST(ChaynsImageUploadCache_PerAccountTtl)
+{
+    const std::string digest = "image/png|0123456789abcdef-5";
+
+    ChaynsImageUploadCache cache;
+    cache.setTtl(std::chrono::seconds(60));
+    const auto t0 = ChaynsImageUploadCache::Clock::now();
+    const auto at = [t0](int seconds) { return t0 + std::chrono::seconds(seconds); };
+
+    CHECK(!cache.lookup("person-1", digest, t0));
+    cache.remember("person-1", digest, "https://tsimg.cloud/a.png", t0);
+    CHECK(*cache.lookup("person-1", digest, at(30)) == "https://tsimg.cloud/a.png");
+    // 按 personId 隔离
+    CHECK(!cache.lookup("person-2", digest, at(30)));
+    // 过期后需重新上传
+    CHECK(!cache.lookup("person-1", digest, at(60)));
+
+    // 上传失败的空 URL 不入缓存
+    cache.remember("person-2", digest, "", t0);
+    CHECK(cache.size() == 1);
+
+    cache.setTtl(std::chrono::seconds(0));
+    CHECK(cache.size() == 0);
+    cache.remember("person-1", digest, "https://tsimg.cloud/a.png", t0);
+    CHECK(!cache.lookup("person-1", digest, t0));
+}
@@ -0,0 +1,37 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/chaynsapi/ChaynsMessageScanner.h"
+
+DROGON_TEST(ChaynsMessageScanner_SplitTopLevelArray)
+{
+    std::vector<std::string_view> elements;
+    CHECK(chayns::splitTopLevelArray(R"( [ {"a":[1,2],"b":"x,]}"} , 3, "s\"]" ] )", elements));
+    CHECK(elements.size() == 3);
+    CHECK(elements[0] == R"({"a":[1,2],"b":"x,]}"})");
+    CHECK(elements[1] == "3");
+    CHECK(elements[2] == R"("s\"]")");
+
+    CHECK(chayns::splitTopLevelArray("[]", elements));
+    CHECK(elements.empty());
+    CHECK(!chayns::splitTopLevelArray(R"({"a":1})", elements));
+    CHECK(!chayns::splitTopLevelArray(R"([{"a":1})", elements));
+}
+
+DROGON_TEST(ChaynsMessageScanner_FindLatestBotReply)
+{
+    const std::string body = R"([
+        {"id":1,"typeId":1,"author":{"id":"user-1"},"text":"question"},
+        {"id":2,"typeId":1,"author":{"id":"bot-1"},"text":"first \"answer\""},
+        {"id":3,"typeId":7,"author":{"id":"bot-1"},"text":"typing"},
+        {"id":4,"typeId":1,"author":{"id":"user-1"},"text":"follow-up"}
+    ])";
+    // 从末尾起跳过本账号消息与非文本类型消息
+    auto reply = chayns::findLatestBotReply(body, "user-1");
+    CHECK(reply.has_value());
+    CHECK(*reply == "first \"answer\"");
+
+    CHECK(!chayns::findLatestBotReply(R"([{"typeId":1,"author":{"id":"user-1"},"text":"q"}])", "user-1"));
+    CHECK(!chayns::findLatestBotReply("[]", "user-1"));
+    CHECK(!chayns::findLatestBotReply("not json", "user-1"));
+    // 无 text 字段的 Bot 消息也算作已回复
+    CHECK(*chayns::findLatestBotReply(R"([{"typeId":1,"author":{"id":"bot"}}])", "user-1") == "");
+}
@@ -0,0 +1,60 @@
+#include <drogon/drogon_test.h>
+#include "sessionManager/core/ImageBlobStore.h"
+#include "sessionManager/contracts/GenerationRequest.h"
+#include <algorithm>
+#include <cctype>
+
+DROGON_TEST(ImageBlobStore_InternSharesAndReleases)
+{
+    ImageBlobStore store;
+
+    auto first = store.internBase64("aGVsbG8=");
+    CHECK(first != nullptr);
+    CHECK(first->bytes == "hello");
+    CHECK(first->digest == ImageBlobStore::digestOf("hello"));
+    // 摘要为 SHA-256 十六进制（大小写随 drogon 版本）
+    std::string upper = first->digest;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    CHECK(upper == "2CF24DBA5FB0A30E26E83B2AC5B9E29E1B161E5C1FA7425E73043362938B9824");
+
+    // 内容相同的图片共享同一份 blob（换行与省略的填充不影响内容）
+    auto second = store.internBase64("aGVs\nbG8");
+    CHECK(second.get() == first.get());
+    CHECK(store.size() == 1);
+    CHECK(store.totalBytes() == 5);
+
+    auto other = store.intern("world");
+    CHECK(other.get() != first.get());
+    CHECK(store.totalBytes() == 10);
+
+    // 复制 ImageInfo 只复制句柄
+    ImageInfo image;
+    image.blob = first;
+    image.mediaType = "image/png";
+    std::vector<ImageInfo> images{image, image};
+    CHECK(!image.empty());
+    CHECK(images[1].blob.get() == first.get());
+
+    // 最后一个句柄释放后 blob 移出存储
+    first.reset();
+    second.reset();
+    CHECK(store.size() == 2);
+    image.blob.reset();
+    images.clear();
+    CHECK(store.size() == 1);
+    CHECK(store.totalBytes() == 5);
+
+    CHECK(store.internBase64("") == nullptr);
+    CHECK(store.internBase64("not*base64") == nullptr);
+    CHECK(ImageInfo{}.empty());
+}
+
+DROGON_TEST(ImageBlobStore_BlobOutlivesStore)
+{
+    std::shared_ptr<const ImageBlob> blob;
+    {
+        ImageBlobStore store;
+        blob = store.intern("bytes");
+    }
+    CHECK(blob->bytes == "bytes");
+}
@@ -0,0 +1,35 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/nexosapi/NexosBudgetTracker.h"
+#include <cmath>
+
+DROGON_TEST(NexosBudget_PredictsFromObservedAndEstimate)
+{
+    NexosBudgetTracker budget;
+    NexosBudgetTracker::Settings settings;
+    settings.limit = 5.0;
+    settings.reserve = 0.5;
+    settings.costPer1kChars = 0.1;
+    budget.setSettings(settings);
+
+    // 未知账号按完整预算对待
+    CHECK(budget.predictedRemaining("a") == 5.0);
+    CHECK(!budget.likelyExhausted("a"));
+
+    budget.updateObserved("a", 4.0);
+    CHECK(std::fabs(budget.predictedRemaining("a") - 1.0) < 1e-9);
+
+    // 每 1000 字符估算 0.1，累计 6000 字符后剩余 0.4 < reserve
+    budget.addEstimatedUsage("a", 3000);
+    CHECK(!budget.likelyExhausted("a"));
+    budget.addEstimatedUsage("a", 3000);
+    CHECK(std::fabs(budget.predictedRemaining("a") - 0.4) < 1e-9);
+    CHECK(budget.likelyExhausted("a"));
+
+    // 刷新后以真实用量为准，估算累计清零
+    budget.updateObserved("a", 4.2);
+    CHECK(std::fabs(budget.predictedRemaining("a") - 0.8) < 1e-9);
+    CHECK(!budget.likelyExhausted("a"));
+
+    budget.forget("a");
+    CHECK(budget.predictedRemaining("a") == 5.0);
+}
@@ -0,0 +1,68 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/nexosapi/NexosSerializedData.h"
+
+namespace {
+// 0:根 → LoggedInLayout → data → {subscription, user, userModels, loop}
+const char* kPayload = R"([
+    {"_1":2},
+    "domains/auth/routes/LoggedInLayout",
+    {"_3":4},
+    "data",
+    {"_5":6,"_7":8,"_15":16,"_24":4},
+    "subscription",
+    {"_9":10,"_11":12,"_25":-5},
+    "user",
+    {"_13":14},
+    "budget_used",
+    3.5,
+    "seats_used",
+    2,
+    "email",
+    "a@b.c",
+    "userModels",
+    [17],
+    {"_18":19,"_20":21},
+    "id",
+    "h1",
+    "model",
+    {"_22":23},
+    "base_model_name",
+    "claude-opus-4-6",
+    "loop",
+    "trial"
+])";
+}
+
+DROGON_TEST(NexosSerializedData_PathAndSearch)
+{
+    const auto data = NexosSerializedData::parse(kPayload);
+    CHECK(data.valid());
+    CHECK(data.tableSize() == 26);
+
+    const auto layout = "domains/auth/routes/LoggedInLayout";
+    CHECK(data.get({layout, "data", "user", "email"}).asString() == "a@b.c");
+    CHECK(data.get({layout, "data", "subscription", "budget_used"}).asDouble() == 3.5);
+    // 表中的整数是字面值，不再当作引用
+    CHECK(data.get({layout, "data", "subscription", "seats_used"}).asInt() == 2);
+    CHECK(data.get({layout, "data", "subscription", "trial"}).isNull());
+    CHECK(data.get({layout, "data", "missing"}).isNull());
+
+    const auto userModels = data.findFirst("userModels");
+    CHECK(userModels.isArray() && userModels.size() == 1);
+    CHECK(userModels[0]["id"].asString() == "h1");
+    CHECK(userModels[0]["model"]["base_model_name"].asString() == "claude-opus-4-6");
+
+    // 循环引用解码为 null
+    const auto root = data.resolveRoot();
+    CHECK(root[layout]["data"]["loop"].isNull());
+    CHECK(root[layout]["data"]["user"]["email"].asString() == "a@b.c");
+}
+
+DROGON_TEST(NexosSerializedData_InvalidPayload)
+{
+    CHECK(!NexosSerializedData::parse("").valid());
+    CHECK(!NexosSerializedData::parse("{\"a\":1}").valid());
+    CHECK(!NexosSerializedData::parse("not json").valid());
+    CHECK(NexosSerializedData::parse("[]").findFirst("userModels").isNull());
+    CHECK(NexosSerializedData().get({"a"}).isNull());
+}
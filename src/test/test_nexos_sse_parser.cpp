@@ -0,0 +1,47 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/nexosapi/NexosSseParser.h"
+#include <vector>
+
+DROGON_TEST(NexosSseParser_ChunkedText)
+{
+    const std::string payload =
+        "event: message\n"
+        "data: {\"content_type\":\"text\",\"content\":{\"text\":\"Hel\"},\"message_id\":\"m-1\"}\n\n"
+        "data: {\"content\":{\"meta\":{\"a\":[1,2,{\"b\":null}]},\"text\":\"lo \\\"w\\\"\"},\"content_type\":\"text\"}\r\n"
+        "data: {\"content_type\":\"tool\",\"content\":{\"text\":\"ignored\"}}\n"
+        "data: not json\n"
+        "data: {\"content_type\":\"text\",\"content\":{\"text\":\"\\u4f60\\u597d\\ud83d\\ude00\"},\"message\":{\"id\":\"m-2\"}}\n"
+        "data: [DONE]\n";
+
+    // 逐字节喂入，验证跨块拼行
+    std::vector<std::string> deltas;
+    NexosSseParser parser([&](const std::string& delta) { deltas.push_back(delta); });
+    for (char ch : payload) {
+        parser.feed(std::string_view(&ch, 1));
+    }
+    parser.finish();
+
+    CHECK(parser.text() == "Hello \"w\"你好\xF0\x9F\x98\x80");
+    CHECK(parser.messageId() == "m-2");
+    CHECK(parser.done());
+    CHECK(deltas.size() == 3);
+    CHECK(deltas[0] == "Hel");
+
+    // 一次喂入整段结果一致
+    NexosSseParser whole;
+    whole.feed(payload);
+    whole.finish();
+    CHECK(whole.text() == parser.text());
+    CHECK(whole.messageId() == "m-2");
+}
+
+DROGON_TEST(NexosSseParser_TrailingLineWithoutNewline)
+{
+    NexosSseParser parser;
+    parser.feed("data: {\"content_type\":\"text\",\"content\":{\"text\":\"a\\nb\"}}");
+    CHECK(parser.text().empty());
+    parser.finish();
+    CHECK(parser.text() == "a\nb");
+    CHECK(!parser.done());
+    CHECK(parser.messageId().empty());
+}
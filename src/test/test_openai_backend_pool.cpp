@@ -0,0 +1,141 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/openai/OpenAiBackendPool.h"
+#include <sstream>
+
+namespace {
+
+Json::Value parseJson(const std::string& text) {
+    Json::Value value;
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    std::istringstream iss(text);
+    Json::parseFromStream(builder, iss, &value, &errs);
+    return value;
+}
+
+} // namespace
+
+DROGON_TEST(OpenAiBackendPool_ParseConfig)
+{
+    // 兼容单 key 配置
+    auto legacy = OpenAiBackendPool::parseConfig(parseJson(R"({"api_key":"sk-1","base_url":"https://a.example"})"));
+    CHECK(legacy.size() == 1);
+    CHECK(legacy[0].name == "default");
+    CHECK(legacy[0].baseUrl == "https://a.example");
+    CHECK(legacy[0].models.empty());
+
+    // 空 backends 数组沿用顶层 key
+    CHECK(OpenAiBackendPool::parseConfig(parseJson(R"({"api_key":"sk-1","backends":[]})")).size() == 1);
+    CHECK(OpenAiBackendPool::parseConfig(parseJson(R"({"api_key":""})")).empty());
+
+    auto backends = OpenAiBackendPool::parseConfig(parseJson(R"({
+        "api_key": "ignored",
+        "backends": [
+            {"name": "primary", "api_key": "sk-a", "weight": 2, "models": ["gpt-4o", "gpt-4o-mini"]},
+            {"api_key": "sk-b", "base_url": "https://b.example"},
+            {"name": "nokey", "api_key": ""},
+            {"name": "zero", "api_key": "sk-c", "weight": 0}
+        ]
+    })"));
+    CHECK(backends.size() == 2);
+    CHECK(backends[0].name == "primary");
+    CHECK(backends[0].weight == 2.0);
+    CHECK(backends[0].models.count("gpt-4o") == 1);
+    CHECK(backends[1].name == "backend-1");
+    CHECK(backends[1].baseUrl == "https://b.example");
+
+    // 名称重复（含与未命名条目的默认名冲突）时保留先出现的条目
+    std::vector<std::string> warnings;
+    auto deduped = OpenAiBackendPool::parseConfig(parseJson(R"({
+        "backends": [
+            {"name": "a", "api_key": "sk-a"},
+            {"name": "a", "api_key": "sk-b"},
+            {"name": "backend-3", "api_key": "sk-c"},
+            {"api_key": "sk-d"}
+        ]
+    })"), &warnings);
+    CHECK(deduped.size() == 2);
+    CHECK(deduped[0].apiKey == "sk-a");
+    CHECK(deduped[1].apiKey == "sk-c");
+    CHECK(warnings.size() == 2);
+}
+
+DROGON_TEST(OpenAiBackendPool_PickByModelLoadAndLatency)
+{
+    OpenAiBackendPool pool;
+    CHECK(!pool.pick("gpt-4o"));
+
+    OpenAiBackendPool::Backend a;
+    a.name = "a";
+    a.apiKey = "sk-a";
+    a.models = {"gpt-4o"};
+    OpenAiBackendPool::Backend b;
+    b.name = "b";
+    b.apiKey = "sk-b";
+    pool.setBackends({a, b});
+
+    // 模型列表过滤：只有 b 不限模型
+    CHECK(pool.supports("o1"));
+    CHECK(pool.pick("o1")->backend.name == "b");
+
+    // 无样本时按在途数分流
+    pool.begin(0);
+    CHECK(pool.pick("gpt-4o")->backend.name == "b");
+    pool.finish(0, 200.0, true);
+    CHECK(pool.inFlight(0) == 0);
+    CHECK(pool.latencyMs(0) == 200.0);
+
+    // 延迟更低的后端优先，直到在途数抵消延迟差
+    pool.begin(1);
+    pool.finish(1, 2000.0, true);
+    CHECK(pool.pick("gpt-4o")->index == 0);
+    pool.begin(0);
+    pool.begin(0);
+    CHECK(pool.pick("gpt-4o")->index == 0);
+    for (int i = 0; i < 8; ++i) {
+        pool.begin(0);
+    }
+    CHECK(pool.pick("gpt-4o")->index == 1);
+
+    // 被过滤掉的后端不参与
+    auto onlyA = pool.pick("gpt-4o", [](const OpenAiBackendPool::Backend& backend) { return backend.name != "b"; });
+    CHECK(onlyA->backend.name == "a");
+    CHECK(!pool.pick("o1", [](const OpenAiBackendPool::Backend&) { return false; }));
+}
+
+DROGON_TEST(OpenAiBackendPool_FailuresPenalizeScore)
+{
+    OpenAiBackendPool pool;
+    OpenAiBackendPool::Backend a;
+    a.name = "a";
+    a.apiKey = "sk-a";
+    OpenAiBackendPool::Backend b;
+    b.name = "b";
+    b.apiKey = "sk-b";
+    pool.setBackends({a, b});
+
+    pool.begin(0);
+    pool.finish(0, 200.0, true);
+    pool.begin(1);
+    pool.finish(1, 400.0, true);
+    CHECK(pool.pick("gpt-4o")->index == 0);
+
+    // 快速失败不会拉低延迟，反而放大平滑延迟，流量转向健康后端
+    pool.begin(0);
+    pool.finish(0, 5.0, false);
+    CHECK(pool.latencyMs(0) == 400.0);
+    pool.begin(0);
+    pool.finish(0, 5.0, false);
+    CHECK(pool.latencyMs(0) == 800.0);
+    CHECK(pool.pick("gpt-4o")->index == 1);
+
+    // 持续失败有上限
+    for (int i = 0; i < 20; ++i) {
+        pool.finish(0, 5.0, false);
+    }
+    CHECK(pool.latencyMs(0) == OpenAiBackendPool::kMaxLatencyMs);
+
+    // 成功后逐步恢复
+    pool.finish(0, 200.0, true);
+    CHECK(pool.latencyMs(0) < OpenAiBackendPool::kMaxLatencyMs);
+}
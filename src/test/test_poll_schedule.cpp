@@ -0,0 +1,100 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/PollSchedule.h"
+
+using std::chrono::milliseconds;
+
+DROGON_TEST(CompletionTimeStats_QuantilesFollowRecentSamples)
+{
+    CompletionTimeStats stats;
+    CHECK(!stats.quantiles("chaynsapi", "gpt-4o"));
+
+    for (int i = 0; i < 20; ++i) {
+        stats.record("chaynsapi", "gpt-4o", milliseconds(4000 + i * 100));
+    }
+    auto q = stats.quantiles("chaynsapi", "gpt-4o");
+    CHECK(q.has_value());
+    CHECK(q->p10 >= milliseconds(3000));
+    CHECK(q->p10 <= q->p50);
+    CHECK(q->p50 <= q->p90);
+    CHECK(q->p90 <= milliseconds(8000));
+    // 模型相互隔离
+    CHECK(!stats.quantiles("chaynsapi", "other"));
+
+    // 近期样本权重更高：上游变慢后中位数随之后移
+    for (int i = 0; i < 100; ++i) {
+        stats.record("chaynsapi", "gpt-4o", milliseconds(30000));
+    }
+    CHECK(stats.quantiles("chaynsapi", "gpt-4o")->p50 >= milliseconds(25000));
+}
+
+DROGON_TEST(PollSchedule_SparseEarlyDenseNearFinish)
+{
+    PollSchedule::Bounds bounds;
+    bounds.minInterval = milliseconds(100);
+    bounds.maxInterval = milliseconds(2000);
+    bounds.fallbackInterval = milliseconds(500);
+
+    // 无历史分布：立即查询，之后固定间隔
+    PollSchedule fixed(bounds, std::nullopt);
+    CHECK(!fixed.adaptive());
+    CHECK(fixed.initialDelay() == milliseconds(0));
+    CHECK(fixed.nextDelay(milliseconds(10000)) == milliseconds(500));
+
+    CompletionTimeStats::Quantiles q;
+    q.p10 = milliseconds(5000);
+    q.p50 = milliseconds(8000);
+    q.p90 = milliseconds(13000);
+    // 样本不足 kTrustedSamples：p10 之前的间隔不超过原固定间隔
+    PollSchedule untrusted(bounds, q);
+    CHECK(untrusted.adaptive());
+    CHECK(untrusted.initialDelay() == milliseconds(500));
+    CHECK(untrusted.nextDelay(milliseconds(1000)) == milliseconds(500));
+
+    q.samples = PollSchedule::kTrustedSamples;
+    PollSchedule schedule(bounds, q);
+    // 早期稀疏：首次查询在 p10 / 2（不超过上限），之后等到 p10
+    CHECK(schedule.initialDelay() == milliseconds(2000));
+    CHECK(schedule.nextDelay(milliseconds(1000)) == milliseconds(2000));
+    CHECK(schedule.nextDelay(milliseconds(4500)) == milliseconds(500));
+    // p10 ~ p90 之间密集
+    CHECK(schedule.nextDelay(milliseconds(6000)) == milliseconds(1000));
+    // 超过 p90 后逐步放宽，受上限约束
+    CHECK(schedule.nextDelay(milliseconds(14000)) == milliseconds(2000));
+    CHECK(schedule.nextDelay(milliseconds(4990)) == milliseconds(100));
+}
+
+DROGON_TEST(PollSchedule_CensoringFeedbackDoesNotRatchet)
+{
+    PollSchedule::Bounds bounds;
+    bounds.minInterval = milliseconds(250);
+    bounds.maxInterval = milliseconds(3000);
+    bounds.fallbackInterval = milliseconds(1000);
+
+    // 回放 "按分布轮询 -> 记录 -> 更新分布" 的闭环：上游真实耗时固定在 2000 ~ 3000ms
+    CompletionTimeStats stats;
+    uint32_t seed = 12345;
+    milliseconds worstLatency(0);
+    for (int round = 0; round < 300; ++round) {
+        seed = seed * 1103515245u + 12345u;
+        const milliseconds completion(2000 + (seed >> 16) % 1000);
+        const auto schedule = PollSchedule(bounds, stats.quantiles("retoolapi", "agent:m"));
+        milliseconds lastMiss(0);
+        milliseconds poll = schedule.initialDelay();
+        while (poll < completion) {
+            lastMiss = poll;
+            poll += schedule.nextDelay(poll);
+        }
+        stats.record("retoolapi", "agent:m", lastMiss, poll);
+        if (round >= 100) {
+            worstLatency = std::max(worstLatency, poll - completion);
+        }
+    }
+
+    auto q = stats.quantiles("retoolapi", "agent:m");
+    CHECK(q.has_value());
+    CHECK(q->p10 >= milliseconds(1500));
+    CHECK(q->p10 <= milliseconds(2500));
+    CHECK(q->p90 <= milliseconds(3500));
+    // 稳定后查到完成的延迟不超过原固定间隔
+    CHECK(worstLatency <= bounds.fallbackInterval);
+}
@@ -0,0 +1,90 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/ProviderContextStore.h"
+
+namespace {
+Json::Value makeContext(const std::string& threadId)
+{
+    Json::Value ctx(Json::objectValue);
+    ctx["threadId"] = threadId;
+    ctx["accountUserName"] = "user-" + threadId;
+    return ctx;
+}
+}
+
+DROGON_TEST(ProviderContextStore_SlidingTtlAndTransfer)
+{
+    ProviderContextStore store(4);
+    store.setTtl(std::chrono::seconds(100));
+    const auto t0 = ProviderContextStore::Clock::now();
+    const auto at = [t0](int seconds) { return t0 + std::chrono::seconds(seconds); };
+
+    store.put("chaynsapi", "conv-1", makeContext("t1"), t0);
+    CHECK(store.get("chaynsapi", "conv-1", at(10))->get("threadId", "").asString() == "t1");
+    // 命名空间相互隔离
+    CHECK(!store.get("nexosapi", "conv-1", at(10)));
+
+    // 读取顺延过期时间
+    CHECK(store.get("chaynsapi", "conv-1", at(90)));
+    CHECK(store.get("chaynsapi", "conv-1", at(180)));
+    CHECK(!store.get("chaynsapi", "conv-1", at(400)));
+    CHECK(store.evictExpired(at(400)) == 1);
+    CHECK(store.size() == 0);
+
+    store.put("chaynsapi", "conv-2", makeContext("t2"), t0);
+    CHECK(store.transfer("chaynsapi", "conv-2", "conv-3", at(1)));
+    CHECK(!store.get("chaynsapi", "conv-2", at(2)));
+    CHECK(store.get("chaynsapi", "conv-3", at(2))->get("threadId", "").asString() == "t2");
+    CHECK(!store.transfer("chaynsapi", "missing", "conv-4", at(2)));
+
+    // update 只在 mutate 返回 true 时写回
+    CHECK(!store.update("chaynsapi", "conv-3", [](Json::Value&) { return false; }, at(3)));
+    CHECK(store.update("chaynsapi", "conv-3", [](Json::Value& ctx) {
+        ctx["toolBridgeDigest"] = "d1";
+        return true;
+    }, at(3)));
+    CHECK(store.get("chaynsapi", "conv-3", at(4))->get("toolBridgeDigest", "").asString() == "d1");
+    CHECK(store.erase("chaynsapi", "conv-3"));
+    CHECK(!store.get("chaynsapi", "conv-3", at(4)));
+}
+
+DROGON_TEST(ProviderContextStore_WriteBehind)
+{
+    ProviderContextStore store(4);
+    store.setTtl(std::chrono::seconds(100));
+    const auto t0 = ProviderContextStore::Clock::now();
+
+    store.put("retoolapi", "a", makeContext("ta"), t0);
+    store.put("retoolapi", "b", makeContext("tb"), t0);
+    CHECK(store.pendingSize() == 2);
+
+    // 写库失败时记录保留待写
+    CHECK(store.flush([](const std::vector<ProviderContextStore::Record>&) { return false; }) == 0);
+    CHECK(store.pendingSize() == 2);
+
+    std::vector<ProviderContextStore::Record> written;
+    auto capture = [&written](const std::vector<ProviderContextStore::Record>& records) {
+        written = records;
+        return true;
+    };
+    CHECK(store.flush(capture) == 2);
+    CHECK(store.pendingSize() == 0);
+
+    // 短时间内的读取不触发写库，删除以删除标记写出
+    store.get("retoolapi", "a", t0 + std::chrono::seconds(5));
+    CHECK(store.pendingSize() == 0);
+    store.erase("retoolapi", "b");
+    CHECK(store.flush(capture) == 1);
+    CHECK(written.size() == 1 && written[0].key == "b" && written[0].erased);
+    CHECK(store.size() == 1);
+
+    // 载入的记录不计入待写，已过期与内存中已有的跳过
+    ProviderContextStore restored(4);
+    std::vector<ProviderContextStore::Record> rows;
+    rows.push_back(ProviderContextStore::Record{"retoolapi", "a", makeContext("ta"),
+        std::chrono::duration_cast<std::chrono::seconds>(t0.time_since_epoch()).count() + 50, false});
+    rows.push_back(ProviderContextStore::Record{"retoolapi", "old", makeContext("to"),
+        std::chrono::duration_cast<std::chrono::seconds>(t0.time_since_epoch()).count() - 1, false});
+    CHECK(restored.load(rows, t0) == 1);
+    CHECK(restored.pendingSize() == 0);
+    CHECK(restored.get("retoolapi", "a", t0)->get("threadId", "").asString() == "ta");
+}
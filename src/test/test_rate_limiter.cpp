@@ -0,0 +1,109 @@
+#include <drogon/drogon_test.h>
+#include "utils/RateLimiter.h"
+#include "utils/RuntimeConfig.h"
+
+using namespace std::chrono_literals;
+
+DROGON_TEST(RateLimiter_BurstThenRefill)
+{
+    auto& limiter = RateLimiter::getInstance();
+    limiter.clear();
+    const auto t0 = RateLimiter::Clock::now();
+
+    CHECK(limiter.acquire("a", 1, 2, t0).allowed);
+    CHECK(limiter.acquire("a", 1, 2, t0).allowed);
+    auto denied = limiter.acquire("a", 1, 2, t0);
+    CHECK(!denied.allowed);
+    CHECK(denied.retryAfterSeconds == 1);
+
+    // 其他 key 互不影响
+    CHECK(limiter.acquire("b", 1, 2, t0).allowed);
+
+    CHECK(limiter.acquire("a", 1, 2, t0 + 1s).allowed);
+    CHECK(limiter.totalThrottled() == 1);
+
+    auto top = limiter.topThrottled(10);
+    CHECK(top.size() == 1);
+    CHECK(top[0].key == "a");
+    CHECK(top[0].throttled == 1);
+    limiter.clear();
+}
+
+DROGON_TEST(RateLimiter_EvictsIdleAndBoundsSize)
+{
+    auto& limiter = RateLimiter::getInstance();
+    limiter.clear();
+    const auto t0 = RateLimiter::Clock::now();
+
+    limiter.acquire("old", 1, 1, t0);
+    limiter.acquire("new", 1, 1, t0 + 100s);
+    CHECK(limiter.evictIdle(60s, t0 + 120s) == 1);
+    CHECK(limiter.size() == 1);
+
+    // 每个分片只保留 1 个条目，总量不超过分片数
+    limiter.clear();
+    limiter.setMaxKeys(1);
+    for (int i = 0; i < 200; ++i) {
+        limiter.acquire("k" + std::to_string(i), 1, 1, t0 + std::chrono::seconds(i));
+    }
+    CHECK(limiter.size() <= 16);
+    CHECK(limiter.totalEvicted() > 0);
+
+    limiter.setMaxKeys(100000);
+    limiter.clear();
+}
+
+DROGON_TEST(RateLimiter_EvictsLeastRecentlyUsed)
+{
+    auto& limiter = RateLimiter::getInstance();
+    limiter.clear();
+    limiter.setMaxKeys(32);  // 每个分片 2 个条目
+    const auto t0 = RateLimiter::Clock::now();
+
+    // 找出落在同一分片的三个 key
+    std::vector<std::string> keys;
+    const auto shardOf = [](const std::string& key) { return std::hash<std::string>{}(key) % 16; };
+    for (int i = 0; keys.size() < 3; ++i) {
+        const std::string key = "lru" + std::to_string(i);
+        if (keys.empty() || shardOf(key) == shardOf(keys.front())) {
+            keys.push_back(key);
+        }
+    }
+
+    limiter.acquire(keys[0], 0.001, 5, t0);
+    limiter.acquire(keys[1], 0.001, 5, t0 + 1s);
+    // 再次访问 keys[0]，最久未访问的变为 keys[1]
+    limiter.acquire(keys[0], 0.001, 5, t0 + 2s);
+    limiter.acquire(keys[2], 0.001, 5, t0 + 3s);
+    CHECK(limiter.size() == 2);
+    CHECK(limiter.totalEvicted() == 1);
+    // keys[0] 仍保留已消耗的令牌；keys[1] 被淘汰后重建为满桶
+    CHECK(limiter.acquire(keys[0], 0.001, 5, t0 + 3s).allowed);
+    CHECK(limiter.acquire(keys[0], 0.001, 5, t0 + 3s).allowed);
+    CHECK(limiter.acquire(keys[0], 0.001, 5, t0 + 3s).allowed);
+    CHECK(!limiter.acquire(keys[0], 0.001, 5, t0 + 3s).allowed);
+
+    limiter.setMaxKeys(100000);
+    limiter.clear();
+}
+
+DROGON_TEST(RuntimeConfig_RateLimitKeyByAndRoutes)
+{
+    Json::Value custom;
+    auto& rl = custom["rate_limit"];
+    rl["enabled"] = true;
+    rl["requests_per_second"] = 5;
+    rl["key_by"].append("api_key");
+    rl["key_by"].append("client_type");
+    rl["routes"]["/nexosapi/v1/chat/completions"]["burst"] = 3;
+
+    auto config = RuntimeConfig::fromCustomConfig(custom);
+    using KeyPart = RuntimeConfig::RateLimit::KeyPart;
+    CHECK(config->rateLimit.keyBy.size() == 2);
+    CHECK(config->rateLimit.keyBy[0] == KeyPart::ApiKey);
+    CHECK(config->rateLimit.keyBy[1] == KeyPart::ClientType);
+
+    const auto& route = config->rateLimit.routes.at("/nexosapi/v1/chat/completions");
+    CHECK(route.requestsPerSecond == 5);
+    CHECK(route.burst == 3);
+}
@@ -0,0 +1,80 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/retoolapi/RetoolTemplateCache.h"
+
+namespace {
+Json::Value makeWorkflow(const std::string& id, const std::string& templateData)
+{
+    Json::Value workflow(Json::objectValue);
+    workflow["id"] = id;
+    workflow["saveId"] = id + "-save";
+    workflow["blocks"] = "source-blocks";
+    workflow["templateData"] = templateData;
+    return workflow;
+}
+}
+
+DROGON_TEST(RetoolTemplateCache_RendersPromptAtSplicePoint)
+{
+    const std::string slot = RetoolCompiledTemplate::kPromptSlot;
+    auto patched = makeWorkflow("src", "[\"instruction\",\"" + slot + "\",\"model\",\"gpt-5.4\"]");
+
+    auto direct = RetoolCompiledTemplate::compile(patched, false);
+    CHECK(direct->hasPromptSlot);
+    auto destination = makeWorkflow("dst", "[\"instruction\",\"old prompt\"]");
+    destination["blocks"] = "destination-blocks";
+    auto rendered = direct->render(destination, "hi \\\"there\\\"");
+    CHECK(rendered["templateData"].asString() == "[\"instruction\",\"hi \\\"there\\\"\",\"model\",\"gpt-5.4\"]");
+    CHECK(rendered["blocks"].asString() == "destination-blocks");
+    CHECK(rendered["id"].asString() == "dst");
+
+    // 克隆模板以源 workflow 为底，只覆盖目标的标识字段
+    auto cloned = RetoolCompiledTemplate::compile(patched, true);
+    CHECK(!cloned->workflow.isMember("templateData"));
+    rendered = cloned->render(destination, "p");
+    CHECK(rendered["blocks"].asString() == "source-blocks");
+    CHECK(rendered["id"].asString() == "dst");
+    CHECK(rendered["saveId"].asString() == "dst-save");
+    CHECK(rendered["templateData"].asString() == "[\"instruction\",\"p\",\"model\",\"gpt-5.4\"]");
+
+    auto agent = RetoolCompiledTemplate::compile(makeWorkflow("a", "[\"model\",\"x\"]"), false);
+    CHECK(!agent->hasPromptSlot);
+    CHECK(agent->render(destination, "ignored")["templateData"].asString() == "[\"model\",\"x\"]");
+}
+
+DROGON_TEST(RetoolTemplateCache_InvalidatesOnFingerprintAndTtl)
+{
+    RetoolTemplateCache cache;
+    cache.setTtl(std::chrono::seconds(60));
+    Json::Value workspace(Json::objectValue);
+    workspace["baseUrl"] = "https://a.retool.com";
+    workspace["openaiResourceName"] = "res-1";
+    workspace["updatedAt"] = "2026-01-01";
+    const auto fingerprint = RetoolTemplateCache::fingerprintOf(workspace);
+
+    // 只有 updatedAt 变化（如使用状态写回）时指纹不变
+    workspace["updatedAt"] = "2026-01-02";
+    CHECK(RetoolTemplateCache::fingerprintOf(workspace) == fingerprint);
+
+    auto compiled = RetoolCompiledTemplate::compile(makeWorkflow("w", "data"), false);
+    compiled->fingerprint = fingerprint;
+    const auto key = RetoolTemplateCache::keyOf("ws1", "workflow", "gpt-5.4");
+    cache.put(key, compiled);
+    CHECK(cache.get(key, fingerprint) == compiled);
+    CHECK(cache.get(RetoolTemplateCache::keyOf("ws1", "agent", "gpt-5.4"), fingerprint) == nullptr);
+
+    workspace["openaiResourceName"] = "res-2";
+    CHECK(cache.get(key, RetoolTemplateCache::fingerprintOf(workspace)) == nullptr);
+    CHECK(cache.get(key, fingerprint, compiled->compiledAt + std::chrono::seconds(61)) == nullptr);
+    cache.invalidate(key);
+    CHECK(cache.size() == 0);
+
+    const auto now = RetoolTemplateCache::Clock::now();
+    CHECK(cache.beginResourceFetch("ws1", fingerprint, now));
+    CHECK(!cache.beginResourceFetch("ws1", fingerprint, now + std::chrono::seconds(10)));
+    CHECK(cache.beginResourceFetch("ws1", "changed", now + std::chrono::seconds(10)));
+    CHECK(cache.beginResourceFetch("ws1", "changed", now + std::chrono::seconds(80)));
+
+    cache.setTtl(std::chrono::seconds(0));
+    cache.put(key, compiled);
+    CHECK(cache.get(key, fingerprint) == nullptr);
+}
@@ -0,0 +1,83 @@
+#include <drogon/drogon_test.h>
+#include "retoolWorkspace/RetoolWorkspacePool.h"
+
+namespace {
+RetoolWorkspaceInfo makeWorkspace(const std::string& id, const std::string& lastUsedAt = "", int inUseCount = 0)
+{
+    RetoolWorkspaceInfo info;
+    info.workspaceId = id;
+    info.baseUrl = "https://" + id + ".retool.com";
+    info.status = "active";
+    info.verifyStatus = "passed";
+    info.workflowId = "wf-" + id;
+    info.lastUsedAt = lastUsedAt;
+    info.inUseCount = inUseCount;
+    return info;
+}
+}
+
+DROGON_TEST(RetoolWorkspacePool_SelectsLeastLoaded)
+{
+    RetoolWorkspacePool pool;
+    auto agentOnly = makeWorkspace("agent");
+    agentOnly.workflowId.clear();
+    agentOnly.agentId = "ag-1";
+    auto disabled = makeWorkspace("off");
+    disabled.status = "disabled";
+    pool.reset({makeWorkspace("a", "2026-01-02"), makeWorkspace("b", "2026-01-01"), agentOnly, disabled});
+    CHECK(pool.loaded());
+    CHECK(pool.size() == 4);
+
+    // 在途相同时库中 lastUsedAt 更早者优先
+    auto first = pool.select(RetoolWorkspacePool::Kind::Workflow);
+    CHECK(first && first->id == "b");
+    CHECK(pool.acquire("b"));
+    CHECK(pool.select(RetoolWorkspacePool::Kind::Workflow)->id == "a");
+    CHECK(pool.acquire("a"));
+    // 两者在途均为 1 时，本进程内更早使用的 b 优先
+    CHECK(pool.select(RetoolWorkspacePool::Kind::Workflow)->id == "b");
+    pool.release("a");
+    CHECK(pool.select(RetoolWorkspacePool::Kind::Workflow)->id == "a");
+    CHECK(pool.inUseCount("b").value_or(-1) == 1);
+
+    auto skipA = pool.select(RetoolWorkspacePool::Kind::Workflow, [](const std::string& id) { return id != "a"; });
+    CHECK(skipA && skipA->id == "b" && skipA->inUseCount == 1);
+    CHECK(pool.select(RetoolWorkspacePool::Kind::Agent)->id == "agent");
+    CHECK(!pool.select(RetoolWorkspacePool::Kind::Agent, [](const std::string&) { return false; }));
+    CHECK(!pool.acquire("missing"));
+}
+
+DROGON_TEST(RetoolWorkspacePool_BatchesUsageWriteBack)
+{
+    RetoolWorkspacePool pool;
+    // 库中残留的在途计数在首次加载后需要写回归零
+    pool.reset({makeWorkspace("a", "", 3), makeWorkspace("b")});
+    auto records = pool.takePendingUsage();
+    CHECK(records.size() == 1);
+    CHECK(records[0].workspaceId == "a" && records[0].inUseCount == 0 && !records[0].touched);
+    CHECK(pool.pendingSize() == 0);
+
+    for (int i = 0; i < 5; ++i) {
+        pool.acquire("b");
+        pool.release("b");
+    }
+    pool.acquire("b");
+    records = pool.takePendingUsage();
+    CHECK(records.size() == 1);
+    CHECK(records[0].workspaceId == "b" && records[0].inUseCount == 1 && records[0].touched);
+
+    pool.restorePendingUsage(records);
+    CHECK(pool.pendingSize() == 1);
+
+    // 资产更新与重载不影响内存中的在途计数
+    auto updated = makeWorkspace("b");
+    updated.status = "disabled";
+    pool.upsert(updated);
+    CHECK(pool.inUseCount("b").value_or(-1) == 1);
+    CHECK(pool.select(RetoolWorkspacePool::Kind::Workflow)->id == "a");
+    pool.reset({makeWorkspace("b", "", 1)});
+    CHECK(pool.inUseCount("b").value_or(-1) == 1);
+    CHECK(!pool.inUseCount("a"));
+    pool.remove("b");
+    CHECK(pool.size() == 0);
+}
@@ -0,0 +1,182 @@
+#include <drogon/drogon_test.h>
+#include "utils/ConfigValidator.h"
+#include "utils/RuntimeConfig.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+DROGON_TEST(RuntimeConfig_Defaults)
+{
+    auto config = RuntimeConfig::fromCustomConfig(Json::Value(Json::objectValue));
+
+    CHECK(config->adminApiKey.empty());
+    CHECK(config->rateLimit.enabled == false);
+    CHECK(config->cors.allowAnyOrigin == true);
+    CHECK(config->cors.allowMethods == "GET, POST, PUT, DELETE, OPTIONS, PATCH");
+    CHECK(config->cors.maxAge == "3600");
+    CHECK(config->toolBridge.present == false);
+    CHECK(config->toolBridge.strictSentinelFor("chaynsapi", "gpt-4o") == false);
+    CHECK(config->accountThrottle.maxInFlight == 0);
+    CHECK(config->accountThrottle.learnRate == false);
+}
+
+DROGON_TEST(RuntimeConfig_CorsPrecomputedHeaders)
+{
+    Json::Value custom;
+    custom["cors"]["allowed_origins"].append("https://a.example");
+    custom["cors"]["allowed_methods"].append("GET");
+    custom["cors"]["allowed_methods"].append("POST");
+    custom["cors"]["max_age"] = 60;
+    custom["cors"]["allow_credentials"] = true;
+
+    auto config = RuntimeConfig::fromCustomConfig(custom);
+    CHECK(config->cors.allowMethods == "GET, POST");
+    CHECK(config->cors.allowHeaders == "*");
+    CHECK(config->cors.maxAge == "60");
+    CHECK(config->cors.allowCredentials == true);
+    CHECK(config->cors.isOriginAllowed("https://a.example"));
+    CHECK(!config->cors.isOriginAllowed("https://b.example"));
+    CHECK(!config->cors.isOriginAllowed(""));
+}
+
+DROGON_TEST(RuntimeConfig_ToolBridgeStrictSentinelPrecedence)
+{
+    Json::Value custom;
+    auto& tb = custom["tool_bridge"];
+    tb["definition_mode"] = "FULL";
+    tb["max_description_chars"] = 99999;
+    tb["strict_sentinel"] = true;
+    tb["strict_sentinel_by_channel"]["chaynsapi"] = false;
+    tb["strict_sentinel_by_model"]["strict-model"] = true;
+    tb["strict_sentinel_disabled_models"].append("loose-model");
+
+    auto config = RuntimeConfig::fromCustomConfig(custom);
+    CHECK(config->toolBridge.fullDefinitions == true);
+    CHECK(config->toolBridge.maxDescriptionChars == 2000);
+    CHECK(config->toolBridge.strictSentinelFor("nexosapi", "") == true);
+    CHECK(config->toolBridge.strictSentinelFor("chaynsapi", "") == false);
+    CHECK(config->toolBridge.strictSentinelFor("chaynsapi", "strict-model") == true);
+    CHECK(config->toolBridge.strictSentinelFor("nexosapi", "loose-model") == false);
+}
+
+DROGON_TEST(RuntimeConfigStore_ReloadKeepsSnapshotOnInvalidFile)
+{
+    auto& store = RuntimeConfigStore::getInstance();
+    const std::string path = "runtime_config_test.json";
+
+    {
+        std::ofstream out(path);
+        out << R"({"listeners":[{"port":1}],"custom_config":{"admin_api_key":"k1"}})";
+    }
+    auto ok = store.reloadFromFile(path);
+    CHECK(ok.valid);
+    CHECK(store.current()->adminApiKey == "k1");
+    const auto version = store.version();
+
+    {
+        std::ofstream out(path);
+        out << R"({"listeners":[],"custom_config":{"admin_api_key":"k2"}})";
+    }
+    auto bad = store.reloadFromFile(path);
+    CHECK(!bad.valid);
+    CHECK(store.current()->adminApiKey == "k1");
+    CHECK(store.version() == version);
+
+    std::remove(path.c_str());
+}
+
+DROGON_TEST(RuntimeConfigStore_ReloadRejectsMistypedFieldsWithoutThrowing)
+{
+    auto& store = RuntimeConfigStore::getInstance();
+    const std::string path = "runtime_config_types_test.json";
+
+    {
+        std::ofstream out(path);
+        out << R"({"listeners":[{"port":1}],"custom_config":{"admin_api_key":"k3"}})";
+    }
+    CHECK(store.reloadFromFile(path).valid);
+    const auto version = store.version();
+
+    {
+        std::ofstream out(path);
+        out << R"({"listeners":[{"port":1}],"custom_config":{"admin_api_key":"k4",)"
+               R"("session_tracking":{"mode":5},"rate_limit":{"enabled":"yes"}}})";
+    }
+    auto bad = store.reloadFromFile(path);
+    CHECK(!bad.valid);
+    CHECK(store.current()->adminApiKey == "k3");
+    CHECK(store.version() == version);
+
+    std::remove(path.c_str());
+}
+
+DROGON_TEST(ConfigValidator_RejectsMistypedOpenAiBackendFields)
+{
+    Json::Value config;
+    config["listeners"].append(Json::Value(Json::objectValue));
+    config["listeners"][0]["port"] = 1;
+    auto& backends = config["custom_config"]["providers"]["openai"]["backends"];
+    backends[0]["api_key"] = "sk-a";
+    backends[0]["name"]["nested"] = true;
+    backends[1]["api_key"] = "sk-b";
+    backends[1]["base_url"] = 443;
+    backends[2]["api_key"] = "sk-c";
+    backends[2]["name"] = "backend-1";
+
+    const auto result = ConfigValidator::validate(config);
+    CHECK(!result.valid);
+    CHECK(std::find(result.errors.begin(), result.errors.end(),
+                    "providers.openai.backends[0].name 必须为字符串") != result.errors.end());
+    CHECK(std::find(result.errors.begin(), result.errors.end(),
+                    "providers.openai.backends[1].base_url 必须为字符串") != result.errors.end());
+    CHECK(std::find(result.errors.begin(), result.errors.end(),
+                    "providers.openai.backends[2].name 重复: backend-1") != result.errors.end());
+}
+
+DROGON_TEST(RuntimeConfig_MistypedFieldsFallBackToDefaults)
+{
+    Json::Value custom(Json::objectValue);
+    custom["rate_limit"]["enabled"] = "yes";
+    custom["rate_limit"]["burst"] = "many";
+    custom["rate_limit"]["key_by"].append(1);
+    custom["account_health"]["ewma_alpha"] = "fast";
+    custom["cors"]["max_age"] = Json::Value(Json::arrayValue);
+    custom["model_routing"]["routes"]["gpt-4o"].append(Json::Value(Json::objectValue));
+    custom["model_routing"]["routes"]["gpt-4o"][0]["channel"] = 3;
+
+    auto config = RuntimeConfig::fromCustomConfig(custom);
+    CHECK(config->rateLimit.enabled == false);
+    CHECK(config->rateLimit.burst == 20);
+    CHECK(config->rateLimit.keyBy.size() == 1);
+    CHECK(config->accountHealth.ewmaAlpha == 0.2);
+    CHECK(config->cors.maxAge == "3600");
+    CHECK(config->modelRouting.routes.at("gpt-4o").empty());
+}
+
+DROGON_TEST(RuntimeConfigStore_PublishNotifiesListeners)
+{
+    auto& store = RuntimeConfigStore::getInstance();
+    const std::string path = "runtime_config_listener_test.json";
+    // 监听器随单例存活到进程结束，状态放在 shared_ptr 中
+    auto seen = std::make_shared<std::vector<std::string>>();
+    store.addPublishListener([seen](const RuntimeConfig& config) { seen->push_back(config.adminApiKey); });
+
+    {
+        std::ofstream out(path);
+        out << R"({"listeners":[{"port":1}],"custom_config":{"admin_api_key":"k5"}})";
+    }
+    CHECK(store.reloadFromFile(path).valid);
+    CHECK(seen->size() == 1);
+    CHECK(seen->back() == "k5");
+
+    // 校验失败不发布，也不通知
+    {
+        std::ofstream out(path);
+        out << R"({"listeners":[]})";
+    }
+    CHECK(!store.reloadFromFile(path).valid);
+    CHECK(seen->size() == 1);
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,94 @@
+#include <drogon/drogon_test.h>
+#include "sessionManager/tooling/ToolBridgePromptCache.h"
+#include "sessionManager/core/Session.h"
+using namespace toolcall;
+
+DROGON_TEST(ToolBridgePromptCache_Compile_SplicesTrigger)
+{
+    const auto& ph = ToolBridgePromptCache::triggerPlaceholder();
+    auto fragment = ToolBridgePromptCache::compile("A" + ph + "\nB\n" + ph + "\nC", "h1");
+
+    CHECK(fragment->segments.size() == 3);
+    CHECK(fragment->toolsHash == "h1");
+
+    std::string out = "prefix:";
+    fragment->appendTo(out, "<<T>>");
+    CHECK(out == "prefix:A<<T>>\nB\n<<T>>\nC");
+    CHECK(fragment->renderedSize("<<T>>") == out.size() - 7);
+}
+
+DROGON_TEST(ToolBridgePromptCache_Compile_NoPlaceholder)
+{
+    auto fragment = ToolBridgePromptCache::compile("static text", "");
+    CHECK(fragment->segments.size() == 1);
+
+    std::string out;
+    fragment->appendTo(out, "<<T>>");
+    CHECK(out == "static text");
+}
+
+DROGON_TEST(ToolBridgePromptCache_FindInsert_EvictsLeastRecentlyUsed)
+{
+    auto& cache = ToolBridgePromptCache::getInstance();
+    cache.clear();
+    cache.setCapacity(2);
+
+    cache.insert("k1", ToolBridgePromptCache::compile("one", ""));
+    cache.insert("k2", ToolBridgePromptCache::compile("two", ""));
+    CHECK(cache.find("k1") != nullptr);   // k1 变为最近使用
+
+    cache.insert("k3", ToolBridgePromptCache::compile("three", ""));
+    CHECK(cache.size() == 2);
+    CHECK(cache.find("k1") != nullptr);
+    CHECK(cache.find("k2") == nullptr);
+    CHECK(cache.find("k3") != nullptr);
+
+    cache.setCapacity(256);
+    cache.clear();
+}
+
+DROGON_TEST(ToolBridgePromptCache_HashToolDefinitions_StableAndDistinct)
+{
+    Json::Value tools(Json::arrayValue);
+    Json::Value tool;
+    tool["type"] = "function";
+    tool["function"]["name"] = "read_file";
+    tools.append(tool);
+
+    Json::Value same = tools;
+    CHECK(hashToolDefinitions(tools) == hashToolDefinitions(same));
+
+    Json::Value other = tools;
+    other[0]["function"]["name"] = "write_to_file";
+    CHECK(hashToolDefinitions(tools) != hashToolDefinitions(other));
+
+    CHECK(hashToolDefinitions(Json::Value()).empty());
+}
+
+DROGON_TEST(ToolBridgePromptCache_ReferenceMessage_ReplacesDefinitionBlock)
+{
+    session_st session;
+    session.request.message = "user question";
+    session.provider.toolBridgeOffset = session.request.message.size();
+    session.request.message += "\n\n<tool_instructions>...</tool_instructions>；";
+    session.provider.toolBridgeDigest = digestToolBridgeKey("key");
+    session.provider.toolBridgeTrigger = "<<CALL_ab12>>";
+
+    CHECK(canReuseToolBridgeDefinitions(session, digestToolBridgeKey("key")));
+    CHECK(!canReuseToolBridgeDefinitions(session, digestToolBridgeKey("other")));
+    CHECK(!canReuseToolBridgeDefinitions(session, ""));
+
+    const std::string reference = toolBridgeReferenceMessage(session);
+    CHECK(reference.rfind("user question", 0) == 0);
+    CHECK(reference.find("<tool_instructions>...") == std::string::npos);
+    CHECK(reference.find("<<CALL_ab12>>") != std::string::npos);
+}
+
+DROGON_TEST(ToolBridgePromptCache_ReferenceMessage_NoBridgeKeepsMessage)
+{
+    session_st session;
+    session.request.message = "plain";
+
+    CHECK(!canReuseToolBridgeDefinitions(session, ""));
+    CHECK(toolBridgeReferenceMessage(session) == "plain");
+}
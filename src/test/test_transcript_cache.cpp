@@ -0,0 +1,91 @@
+#include <drogon/drogon_test.h>
+#include "sessionManager/core/TranscriptCache.h"
+
+namespace {
+Json::Value makeMessage(const std::string& role, const std::string& content)
+{
+    Json::Value msg(Json::objectValue);
+    msg["role"] = role;
+    msg["content"] = content;
+    return msg;
+}
+
+std::string compact(const Json::Value& value)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, value);
+}
+
+void appendLine(TranscriptRender& out, const Json::Value& msg)
+{
+    if (!out.text.empty()) out.text += "\n";
+    out.text += msg["role"].asString() + ": " + msg["content"].asString();
+}
+}
+
+DROGON_TEST(TranscriptCache_AppendsOnlyNewMessages)
+{
+    TranscriptCache cache;
+    Json::Value messages(Json::arrayValue);
+    messages.append(makeMessage("user", "hi"));
+    messages.append(makeMessage("assistant", "hello"));
+
+    int calls = 0;
+    auto counting = [&calls](TranscriptRender& out, const Json::Value& msg) {
+        ++calls;
+        appendLine(out, msg);
+    };
+    CHECK(cache.render("lines", messages, counting).text == "user: hi\nassistant: hello");
+    CHECK(calls == 2);
+
+    messages.append(makeMessage("user", "again"));
+    CHECK(cache.render("lines", messages, counting).text == "user: hi\nassistant: hello\nuser: again");
+    CHECK(calls == 3);
+    CHECK(cache.renderedCount("lines") == 3);
+
+    // 逐条拼接的紧凑 JSON 与整体序列化一致
+    const auto& json = cache.render("json", messages, [](TranscriptRender& out, const Json::Value& msg) {
+        if (!out.text.empty()) out.text.push_back(',');
+        out.text += compact(msg);
+    });
+    CHECK("[" + json.text + "]" == compact(messages));
+}
+
+DROGON_TEST(TranscriptCache_RebuildsWhenHistoryChanges)
+{
+    TranscriptCache cache;
+    Json::Value messages(Json::arrayValue);
+    messages.append(makeMessage("user", "a"));
+    messages.append(makeMessage("assistant", "b"));
+    cache.render("lines", messages, appendLine);
+
+    // 末条被替换
+    messages[1u] = makeMessage("assistant", "c");
+    CHECK(cache.render("lines", messages, appendLine).text == "user: a\nassistant: c");
+
+    // 中间一条被原地改写（首尾不变）
+    messages.append(makeMessage("user", "e"));
+    cache.render("lines", messages, appendLine);
+    messages[1u]["content"] = "edited";
+    CHECK(cache.render("lines", messages, appendLine).text == "user: a\nassistant: edited\nuser: e");
+    messages.removeIndex(2u, nullptr);
+
+    // 历史被截断
+    Json::Value shorter(Json::arrayValue);
+    shorter.append(makeMessage("user", "x"));
+    CHECK(cache.render("lines", shorter, appendLine).text == "user: x");
+
+    // 显式失效覆盖到被改写位置的缓存
+    messages.append(makeMessage("user", "d"));
+    cache.render("lines", messages, appendLine);
+    cache.invalidateFrom(3);
+    CHECK(cache.renderedCount("lines") == 3);
+    cache.invalidateFrom(1);
+    CHECK(cache.renderedCount("lines") == 0);
+
+    Json::Value empty(Json::arrayValue);
+    CHECK(cache.render("lines", empty, appendLine).text.empty());
+    cache.clear();
+    CHECK(cache.renderedCount("lines") == 0);
+}
@@ -0,0 +1,81 @@
+#include <drogon/drogon_test.h>
+#include "apipoint/UpstreamThreadPool.h"
+
+DROGON_TEST(UpstreamThreadPool_ClaimAndDemandDrivenDeficit)
+{
+    UpstreamThreadPool pool;
+    UpstreamThreadPool::Settings settings;
+    settings.maxPerAccount = 3;
+    settings.maxIdleSeconds = 100;
+    settings.demandWindowSeconds = 60;
+    settings.refillIntervalSeconds = 15;
+    pool.setSettings(settings);
+    const auto t0 = UpstreamThreadPool::Clock::now();
+    const auto at = [t0](int seconds) { return t0 + std::chrono::seconds(seconds); };
+
+    // 没有需求的账号不预建
+    CHECK(pool.deficit("nexosapi", "a", t0) == 0);
+    CHECK(pool.demandedAccounts("nexosapi", t0).empty());
+
+    // 首次领取为空，但记下需求：一个补充周期约 1 个再加 1 个余量
+    CHECK(!pool.claim("nexosapi", "a", t0));
+    CHECK(pool.demandedAccounts("nexosapi", at(1)).size() == 1);
+    CHECK(pool.deficit("nexosapi", "a", at(1)) == 2);
+
+    pool.add("nexosapi", "a", "chat-1", at(2));
+    pool.add("nexosapi", "a", "chat-2", at(3));
+    CHECK(pool.deficit("nexosapi", "a", at(4)) == 0);
+
+    // 先建先用；provider 相互隔离
+    CHECK(*pool.claim("nexosapi", "a", at(5)) == "chat-1");
+    CHECK(!pool.claim("retoolapi", "a", at(5)));
+    CHECK(pool.readyCount("nexosapi", "a") == 1);
+
+    // 需求增多时补充量随之增加，但不超过上限
+    for (int i = 0; i < 10; ++i) {
+        pool.claim("nexosapi", "a", at(6));
+    }
+    CHECK(pool.readyCount("nexosapi", "a") == 0);
+    CHECK(pool.deficit("nexosapi", "a", at(7)) == 3);
+    for (int i = 0; i < 5; ++i) {
+        pool.add("nexosapi", "a", "extra", at(7));
+    }
+    CHECK(pool.readyCount("nexosapi", "a") == 3);
+
+    pool.dropAccount("nexosapi", "a");
+    CHECK(pool.readyCount("nexosapi", "a") == 0);
+    CHECK(pool.deficit("nexosapi", "a", at(8)) == 0);
+}
+
+DROGON_TEST(UpstreamThreadPool_EvictsStaleAndHonorsDisable)
+{
+    UpstreamThreadPool pool;
+    UpstreamThreadPool::Settings settings;
+    settings.maxPerAccount = 2;
+    settings.maxIdleSeconds = 30;
+    settings.demandWindowSeconds = 60;
+    pool.setSettings(settings);
+    const auto t0 = UpstreamThreadPool::Clock::now();
+    const auto at = [t0](int seconds) { return t0 + std::chrono::seconds(seconds); };
+
+    pool.claim("retoolapi", "ws|agent", t0);
+    pool.add("retoolapi", "ws|agent", "thread-old", t0);
+    pool.add("retoolapi", "ws|agent", "thread-new", at(20));
+
+    // 闲置过久的条目不会被领取
+    CHECK(*pool.claim("retoolapi", "ws|agent", at(40)) == "thread-new");
+    pool.add("retoolapi", "ws|agent", "thread-3", at(40));
+    CHECK(pool.evictStale(at(80)) == 1);
+    CHECK(pool.readyCount("retoolapi", "ws|agent") == 0);
+    // 需求也已移出窗口，账号不再预建
+    CHECK(pool.evictStale(at(200)) == 0);
+    CHECK(pool.demandedAccounts("retoolapi", at(200)).empty());
+
+    settings.maxPerAccount = 0;
+    pool.setSettings(settings);
+    CHECK(!pool.enabled());
+    CHECK(!pool.claim("retoolapi", "ws|agent", at(201)));
+    pool.add("retoolapi", "ws|agent", "thread-4", at(201));
+    CHECK(pool.readyCount("retoolapi", "ws|agent") == 0);
+    CHECK(pool.deficit("retoolapi", "ws|agent", at(202)) == 0);
+}
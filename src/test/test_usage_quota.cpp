@@ -0,0 +1,93 @@
+#include <drogon/drogon_test.h>
+#include "metrics/UsageQuotaService.h"
+
+using namespace metrics;
+
+namespace {
+RuntimeConfig::Quota makeQuota() {
+    RuntimeConfig::Quota quota;
+    quota.enabled = true;
+    quota.windowSeconds = 3600;
+    quota.defaults.inputTokens = 1000;
+    quota.defaults.outputTokens = 500;
+    RuntimeConfig::Quota::Limits big;
+    big.inputTokens = 100000;
+    quota.perKey["vip"] = big;
+    return quota;
+}
+
+UsageQuotaService::Clock::time_point at(int64_t epochSeconds) {
+    return UsageQuotaService::Clock::time_point(std::chrono::seconds(epochSeconds));
+}
+}
+
+DROGON_TEST(UsageQuota_EnforcesInputAndOutputLimits)
+{
+    auto& service = UsageQuotaService::getInstance();
+    service.clear();
+    const auto quota = makeQuota();
+    const auto t0 = at(7200);
+
+    CHECK(service.check("k", 900, quota, t0).allowed);
+    service.record("k", "nexosapi", "m", 900, 100, false, quota, t0);
+
+    // 已用 900 + 本次估算 200 超过 1000
+    auto denied = service.check("k", 200, quota, t0 + std::chrono::seconds(600));
+    CHECK(!denied.allowed);
+    CHECK(denied.retryAfterSeconds == 3000);
+    CHECK(service.check("k", 50, quota, t0).allowed);
+
+    service.record("k", "nexosapi", "m", 0, 400, true, quota, t0);
+    CHECK(!service.check("k", 0, quota, t0).allowed);
+
+    // 按 key 覆盖的额度与其他 key 互不影响
+    CHECK(service.check("vip", 5000, quota, t0).allowed);
+
+    // 进入下一个窗口后计数清零
+    CHECK(service.check("k", 900, quota, at(10800)).allowed);
+    service.clear();
+}
+
+DROGON_TEST(UsageQuota_FlushAggregatesAndRetriesOnFailure)
+{
+    auto& service = UsageQuotaService::getInstance();
+    service.clear();
+    const auto quota = makeQuota();
+    const auto t0 = at(7200);
+
+    service.record("k", "nexosapi", "m", 10, 1, false, quota, t0);
+    service.record("k", "nexosapi", "m", 20, 2, true, quota, t0 + std::chrono::seconds(5));
+    service.record("k", "chaynsapi", "m", 5, 5, false, quota, t0);
+    CHECK(service.pendingSize() == 2);
+
+    CHECK(service.flush([](const std::vector<UsageAggRecord>&) { return false; }) == 0);
+    CHECK(service.pendingSize() == 2);
+
+    std::vector<UsageAggRecord> written;
+    CHECK(service.flush([&written](const std::vector<UsageAggRecord>& records) {
+        written = records;
+        return true;
+    }) == 2);
+    CHECK(service.pendingSize() == 0);
+
+    bool found = false;
+    for (const auto& r : written) {
+        if (r.provider != "nexosapi") continue;
+        found = true;
+        CHECK(r.inputTokens == 30);
+        CHECK(r.outputTokens == 3);
+        CHECK(r.requestCount == 2);
+        CHECK(r.estimatedCount == 1);
+        CHECK(r.bucketStart == "1970-01-01 02:00:00");
+        CHECK(r.apiKey != "k");
+    }
+    CHECK(found);
+    service.clear();
+}
+
+DROGON_TEST(UsageQuota_EstimateTokens)
+{
+    CHECK(UsageQuotaService::estimateTokens("") == 0);
+    CHECK(UsageQuotaService::estimateTokens("abcdefgh") == 2);
+    CHECK(UsageQuotaService::estimateTokens("你好") == 2);
+}
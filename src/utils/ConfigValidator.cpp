@@ -1,5 +1,7 @@
 #include "ConfigValidator.h"
 #include <algorithm>
+#include <cctype>
+#include <set>
 
 namespace {
 
@@ -11,6 +13,14 @@ bool isNonNegativeInt(const Json::Value& value) {
     return value.isInt() && value.asInt() >= 0;
 }
 
+bool isNonNegativeInt64(const Json::Value& value) {
+    return value.isInt64() && value.asInt64() >= 0;
+}
+
+bool isValidRateLimitKeyPart(const std::string& part) {
+    return part == "ip" || part == "api_key" || part == "forwarded_for" || part == "client_type";
+}
+
 bool isValidSessionTrackingMode(const std::string& mode) {
     return mode == "hash" || mode == "zerowidth" || mode == "zero_width";
 }
@@ -44,8 +54,8 @@ ConfigValidator::ValidationResult ConfigValidator::validate(const Json::Value& c
     const auto& custom = config["custom_config"];
 
     if (custom.isMember("session_tracking") && custom["session_tracking"].isObject()) {
-        const auto mode = custom["session_tracking"].get("mode", "hash").asString();
-        if (!isValidSessionTrackingMode(mode)) {
+        const Json::Value modeValue = custom["session_tracking"].get("mode", "hash");
+        if (!modeValue.isString() || !isValidSessionTrackingMode(modeValue.asString())) {
             result.valid = false;
             result.errors.emplace_back(
                 "custom_config.session_tracking.mode 非法，允许值: hash/zerowidth/zero_width"
@@ -77,9 +87,90 @@ ConfigValidator::ValidationResult ConfigValidator::validate(const Json::Value& c
         }
     }
 
+    if (custom.isMember("provider_context") && custom["provider_context"].isObject()) {
+        const auto& providerContext = custom["provider_context"];
+        if (providerContext.isMember("ttl_seconds") &&
+            !isPositiveInt(providerContext["ttl_seconds"])) {
+            result.valid = false;
+            result.errors.emplace_back("provider_context.ttl_seconds 必须为正整数");
+        }
+        if (providerContext.isMember("flush_interval_seconds") &&
+            !isPositiveInt(providerContext["flush_interval_seconds"])) {
+            result.valid = false;
+            result.errors.emplace_back("provider_context.flush_interval_seconds 必须为正整数");
+        }
+    }
+
+    if (custom.isMember("thread_prewarm") && custom["thread_prewarm"].isObject()) {
+        const auto& threadPrewarm = custom["thread_prewarm"];
+        if (threadPrewarm.isMember("max_per_account") &&
+            !isNonNegativeInt(threadPrewarm["max_per_account"])) {
+            result.valid = false;
+            result.errors.emplace_back("thread_prewarm.max_per_account 必须为非负整数");
+        }
+        for (const char* field : {"max_idle_seconds", "demand_window_seconds", "refill_interval_seconds"}) {
+            if (threadPrewarm.isMember(field) && !isPositiveInt(threadPrewarm[field])) {
+                result.valid = false;
+                result.errors.emplace_back(std::string("thread_prewarm.") + field + " 必须为正整数");
+            }
+        }
+    }
+
+    if (custom.isMember("providers") && custom["providers"].isObject() &&
+        custom["providers"].isMember("openai") && custom["providers"]["openai"].isObject() &&
+        custom["providers"]["openai"].isMember("backends")) {
+        const auto& backends = custom["providers"]["openai"]["backends"];
+        if (!backends.isArray()) {
+            result.valid = false;
+            result.errors.emplace_back("providers.openai.backends 必须为数组");
+        } else {
+            std::set<std::string> names;
+            for (Json::ArrayIndex i = 0; i < backends.size(); ++i) {
+                const auto& backend = backends[i];
+                const std::string prefix = "providers.openai.backends[" + std::to_string(i) + "]";
+                if (!backend.isObject()) {
+                    result.valid = false;
+                    result.errors.emplace_back(prefix + " 必须为对象");
+                    continue;
+                }
+                if (!backend.get("api_key", "").isString() || backend.get("api_key", "").asString().empty()) {
+                    result.valid = false;
+                    result.errors.emplace_back(prefix + ".api_key 不能为空");
+                }
+                if (backend.isMember("base_url") && !backend["base_url"].isString()) {
+                    result.valid = false;
+                    result.errors.emplace_back(prefix + ".base_url 必须为字符串");
+                }
+                if (backend.isMember("weight") && (!backend["weight"].isNumeric() || backend["weight"].asDouble() <= 0)) {
+                    result.valid = false;
+                    result.errors.emplace_back(prefix + ".weight 必须为正数");
+                }
+                if (backend.isMember("models") && !backend["models"].isArray()) {
+                    result.valid = false;
+                    result.errors.emplace_back(prefix + ".models 必须为字符串数组");
+                }
+                if (backend.isMember("name") && !backend["name"].isString()) {
+                    result.valid = false;
+                    result.errors.emplace_back(prefix + ".name 必须为字符串");
+                } else {
+                    // 未命名的后端以 backend-<下标> 为名，同样参与判重
+                    const auto name = backend.get("name", "backend-" + std::to_string(i)).asString();
+                    if (!names.insert(name).second) {
+                        result.valid = false;
+                        result.errors.emplace_back(prefix + ".name 重复: " + name);
+                    }
+                }
+            }
+        }
+    }
+
     if (custom.isMember("rate_limit") && custom["rate_limit"].isObject()) {
         const auto& rateLimit = custom["rate_limit"];
-        if (rateLimit.get("enabled", false).asBool()) {
+        if (rateLimit.isMember("enabled") && !rateLimit["enabled"].isBool()) {
+            result.valid = false;
+            result.errors.emplace_back("rate_limit.enabled 必须为布尔值");
+        }
+        if (rateLimit.get("enabled", false).isBool() && rateLimit.get("enabled", false).asBool()) {
             if (!isPositiveInt(rateLimit.get("requests_per_second", Json::Value(0)))) {
                 result.valid = false;
                 result.errors.emplace_back("rate_limit.requests_per_second 必须为正整数");
@@ -89,6 +180,185 @@ ConfigValidator::ValidationResult ConfigValidator::validate(const Json::Value& c
                 result.errors.emplace_back("rate_limit.burst 必须为正整数");
             }
         }
+        if (rateLimit.isMember("idle_seconds") && !isPositiveInt(rateLimit["idle_seconds"])) {
+            result.valid = false;
+            result.errors.emplace_back("rate_limit.idle_seconds 必须为正整数");
+        }
+        if (rateLimit.isMember("max_keys") && !isPositiveInt(rateLimit["max_keys"])) {
+            result.valid = false;
+            result.errors.emplace_back("rate_limit.max_keys 必须为正整数");
+        }
+        if (rateLimit.isMember("key_by")) {
+            const auto& keyBy = rateLimit["key_by"];
+            bool ok = keyBy.isString() || keyBy.isArray();
+            auto check = [&ok](const Json::Value& item) {
+                if (!item.isString() || !isValidRateLimitKeyPart(item.asString())) ok = false;
+            };
+            if (keyBy.isString()) check(keyBy);
+            else if (keyBy.isArray()) for (const auto& item : keyBy) check(item);
+            if (!ok) {
+                result.valid = false;
+                result.errors.emplace_back("rate_limit.key_by 非法，允许值: ip/api_key/forwarded_for/client_type");
+            }
+        }
+        if (rateLimit.isMember("routes")) {
+            const auto& routes = rateLimit["routes"];
+            if (!routes.isObject()) {
+                result.valid = false;
+                result.errors.emplace_back("rate_limit.routes 必须为对象（路径 -> 限流参数）");
+            } else {
+                for (const auto& path : routes.getMemberNames()) {
+                    const auto& route = routes[path];
+                    if (!route.isObject() ||
+                        (route.isMember("requests_per_second") && !isPositiveInt(route["requests_per_second"])) ||
+                        (route.isMember("burst") && !isPositiveInt(route["burst"]))) {
+                        result.valid = false;
+                        result.errors.emplace_back("rate_limit.routes." + path + " 的 requests_per_second/burst 必须为正整数");
+                    }
+                }
+            }
+        }
+    }
+
+    if (custom.isMember("quota") && custom["quota"].isObject()) {
+        const auto& quota = custom["quota"];
+        if (quota.isMember("window_seconds") && !isPositiveInt(quota["window_seconds"])) {
+            result.valid = false;
+            result.errors.emplace_back("quota.window_seconds 必须为正整数");
+        }
+        if (quota.isMember("flush_interval_seconds") && !isPositiveInt(quota["flush_interval_seconds"])) {
+            result.valid = false;
+            result.errors.emplace_back("quota.flush_interval_seconds 必须为正整数");
+        }
+        auto checkLimits = [&result](const Json::Value& node, const std::string& path) {
+            for (const char* field : {"input_tokens", "output_tokens", "total_tokens"}) {
+                if (node.isMember(field) && !isNonNegativeInt64(node[field])) {
+                    result.valid = false;
+                    result.errors.emplace_back(path + "." + field + " 必须为非负整数");
+                }
+            }
+        };
+        checkLimits(quota, "quota");
+        if (quota.isMember("keys")) {
+            if (!quota["keys"].isObject()) {
+                result.valid = false;
+                result.errors.emplace_back("quota.keys 必须为对象（API Key -> 额度）");
+            } else {
+                for (const auto& apiKey : quota["keys"].getMemberNames()) {
+                    // 错误信息中不回显完整 API Key
+                    checkLimits(quota["keys"][apiKey], "quota.keys[" + apiKey.substr(0, 4) + "…]");
+                }
+            }
+        }
+    }
+
+    if (custom.isMember("account_health") && custom["account_health"].isObject()) {
+        const auto& health = custom["account_health"];
+        for (const char* field : {"ewma_alpha", "error_threshold"}) {
+            if (health.isMember(field) &&
+                (!health[field].isNumeric() || health[field].asDouble() <= 0 || health[field].asDouble() > 1)) {
+                result.valid = false;
+                result.errors.emplace_back(std::string("account_health.") + field + " 必须为 (0, 1] 之间的数");
+            }
+        }
+        for (const char* field : {"min_samples", "consecutive_failures", "open_seconds", "max_open_seconds", "latency_reference_ms"}) {
+            if (health.isMember(field) && !isPositiveInt(health[field])) {
+                result.valid = false;
+                result.errors.emplace_back(std::string("account_health.") + field + " 必须为正整数");
+            }
+        }
+    }
+
+    if (custom.isMember("account_throttle") && custom["account_throttle"].isObject()) {
+        const auto& throttle = custom["account_throttle"];
+        if (throttle.isMember("max_in_flight") && !isNonNegativeInt(throttle["max_in_flight"])) {
+            result.valid = false;
+            result.errors.emplace_back("account_throttle.max_in_flight 必须为非负整数");
+        }
+        for (const char* field : {"default_cooldown_seconds", "max_cooldown_seconds"}) {
+            if (throttle.isMember(field) && !isPositiveInt(throttle[field])) {
+                result.valid = false;
+                result.errors.emplace_back(std::string("account_throttle.") + field + " 必须为正整数");
+            }
+        }
+        if (throttle.isMember("learn_rate") && !throttle["learn_rate"].isBool()) {
+            result.valid = false;
+            result.errors.emplace_back("account_throttle.learn_rate 必须为布尔值");
+        }
+        if (throttle.isMember("max_in_flight_by_provider")) {
+            const auto& byProvider = throttle["max_in_flight_by_provider"];
+            bool ok = byProvider.isObject();
+            if (ok) {
+                for (const auto& provider : byProvider.getMemberNames()) {
+                    if (!isNonNegativeInt(byProvider[provider])) ok = false;
+                }
+            }
+            if (!ok) {
+                result.valid = false;
+                result.errors.emplace_back("account_throttle.max_in_flight_by_provider 必须为对象（渠道 -> 非负整数）");
+            }
+        }
+    }
+
+    if (custom.isMember("model_routing") && custom["model_routing"].isObject()) {
+        const auto& routing = custom["model_routing"];
+        for (const char* field : {"failure_threshold", "open_seconds", "max_open_seconds"}) {
+            if (routing.isMember(field) && !isPositiveInt(routing[field])) {
+                result.valid = false;
+                result.errors.emplace_back(std::string("model_routing.") + field + " 必须为正整数");
+            }
+        }
+        if (routing.isMember("routes")) {
+            const auto& routes = routing["routes"];
+            bool ok = routes.isObject();
+            if (ok) {
+                for (const auto& model : routes.getMemberNames()) {
+                    if (!routes[model].isArray()) {
+                        ok = false;
+                        continue;
+                    }
+                    for (const auto& item : routes[model]) {
+                        if (!item.isString() && !(item.isObject() && item.get("channel", "").isString() &&
+                                                  !item.get("channel", "").asString().empty())) {
+                            ok = false;
+                        }
+                    }
+                }
+            }
+            if (!ok) {
+                result.valid = false;
+                result.errors.emplace_back("model_routing.routes 必须为对象（模型 -> 渠道名或 {channel, model} 数组）");
+            }
+        }
+    }
+
+    if (custom.isMember("cors") && custom["cors"].isObject()) {
+        const auto& cors = custom["cors"];
+        if (cors.isMember("max_age") && !isNonNegativeInt(cors["max_age"])) {
+            result.valid = false;
+            result.errors.emplace_back("cors.max_age 必须为非负整数");
+        }
+        if (cors.isMember("allowed_origins") && !cors["allowed_origins"].isArray()) {
+            result.warnings.emplace_back("cors.allowed_origins 不是数组，将放行任意 Origin");
+        }
+    }
+
+    if (custom.isMember("tool_bridge") && custom["tool_bridge"].isObject()) {
+        const auto& toolBridge = custom["tool_bridge"];
+        if (toolBridge.isMember("definition_mode")) {
+            std::string mode = toolBridge["definition_mode"].isString() ? toolBridge["definition_mode"].asString() : "";
+            std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+            });
+            if (mode != "compact" && mode != "full") {
+                result.warnings.emplace_back("tool_bridge.definition_mode 非法（允许值: compact/full），将回退为 compact");
+            }
+        }
+        if (toolBridge.isMember("trigger_random_length") &&
+            !isPositiveInt(toolBridge["trigger_random_length"])) {
+            result.valid = false;
+            result.errors.emplace_back("tool_bridge.trigger_random_length 必须为正整数");
+        }
     }
 
     if (custom.isMember("account_automation") && custom["account_automation"].isObject()) {
@@ -0,0 +1,151 @@
+#include "RateLimiter.h"
+#include <algorithm>
+#include <cmath>
+
+RateLimiter& RateLimiter::getInstance() {
+    static RateLimiter instance;
+    return instance;
+}
+
+RateLimiter::Shard& RateLimiter::shardFor(const std::string& key) {
+    return shards_[std::hash<std::string>{}(key) % kShardCount];
+}
+
+RateLimiter::Decision RateLimiter::acquire(const std::string& key, double requestsPerSecond, double burst,
+                                           Clock::time_point now) {
+    Decision decision;
+    if (requestsPerSecond <= 0 || burst <= 0) {
+        return decision;
+    }
+
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.buckets.find(key);
+    if (it == shard.buckets.end()) {
+        enforceCapacity(shard, now);
+        Bucket bucket;
+        bucket.tokens = burst;
+        bucket.lastRefill = now;
+        shard.lru.push_front(key);
+        bucket.lruIt = shard.lru.begin();
+        it = shard.buckets.emplace(key, bucket).first;
+    } else {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lruIt);
+    }
+
+    auto& bucket = it->second;
+    const double elapsed = std::chrono::duration<double>(now - bucket.lastRefill).count();
+    if (elapsed > 0) {
+        bucket.tokens = std::min(burst, bucket.tokens + elapsed * requestsPerSecond);
+        bucket.lastRefill = now;
+    } else if (bucket.tokens > burst) {
+        // 配置热加载后 burst 变小
+        bucket.tokens = burst;
+    }
+    bucket.lastSeen = now;
+
+    if (bucket.tokens >= 1.0) {
+        bucket.tokens -= 1.0;
+        ++bucket.allowed;
+        totalAllowed_.fetch_add(1, std::memory_order_relaxed);
+        return decision;
+    }
+
+    ++bucket.throttled;
+    totalThrottled_.fetch_add(1, std::memory_order_relaxed);
+    decision.allowed = false;
+    decision.retryAfterSeconds = std::max(1, static_cast<int>(std::ceil((1.0 - bucket.tokens) / requestsPerSecond)));
+    return decision;
+}
+
+void RateLimiter::enforceCapacity(Shard& shard, Clock::time_point now) {
+    const size_t maxKeys = maxKeysPerShard_.load(std::memory_order_relaxed);
+    if (shard.buckets.size() < maxKeys) {
+        return;
+    }
+
+    const auto idle = std::chrono::seconds(idleTimeoutSeconds_.load(std::memory_order_relaxed));
+    size_t evicted = evictIdleLocked(shard, idle, now);
+
+    // 没有空闲条目可回收时，淘汰最久未访问的条目
+    while (!shard.lru.empty() && shard.buckets.size() >= maxKeys) {
+        shard.buckets.erase(shard.lru.back());
+        shard.lru.pop_back();
+        ++evicted;
+    }
+
+    totalEvicted_.fetch_add(evicted, std::memory_order_relaxed);
+}
+
+size_t RateLimiter::evictIdleLocked(Shard& shard, std::chrono::seconds idle, Clock::time_point now) {
+    size_t evicted = 0;
+    while (!shard.lru.empty()) {
+        auto it = shard.buckets.find(shard.lru.back());
+        if (it != shard.buckets.end() && now - it->second.lastSeen < idle) {
+            break;
+        }
+        if (it != shard.buckets.end()) {
+            shard.buckets.erase(it);
+        }
+        shard.lru.pop_back();
+        ++evicted;
+    }
+    return evicted;
+}
+
+size_t RateLimiter::evictIdle(std::chrono::seconds idle, Clock::time_point now) {
+    size_t evicted = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        evicted += evictIdleLocked(shard, idle, now);
+    }
+    totalEvicted_.fetch_add(evicted, std::memory_order_relaxed);
+    return evicted;
+}
+
+void RateLimiter::setMaxKeys(size_t maxKeys) {
+    maxKeysPerShard_.store(std::max<size_t>(1, maxKeys / kShardCount), std::memory_order_relaxed);
+}
+
+void RateLimiter::setIdleTimeout(std::chrono::seconds idle) {
+    idleTimeoutSeconds_.store(idle.count(), std::memory_order_relaxed);
+}
+
+size_t RateLimiter::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.buckets.size();
+    }
+    return total;
+}
+
+std::vector<RateLimiter::KeyStats> RateLimiter::topThrottled(size_t limit) const {
+    std::vector<KeyStats> out;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [key, bucket] : shard.buckets) {
+            if (bucket.throttled == 0) continue;
+            out.push_back(KeyStats{key, bucket.allowed, bucket.throttled});
+        }
+    }
+    std::sort(out.begin(), out.end(), [](const KeyStats& a, const KeyStats& b) {
+        return a.throttled > b.throttled;
+    });
+    if (out.size() > limit) {
+        out.resize(limit);
+    }
+    return out;
+}
+
+void RateLimiter::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.buckets.clear();
+        shard.lru.clear();
+    }
+    totalAllowed_.store(0, std::memory_order_relaxed);
+    totalThrottled_.store(0, std::memory_order_relaxed);
+    totalEvicted_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,104 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 分片令牌桶限流存储
+ *
+ * 按 key 的哈希分到固定数量的分片，每个分片独立加锁，避免所有请求争用同一把锁。
+ * 每个分片按访问顺序维护 LRU 链表，条目数有上限：超限时从链表尾部淘汰空闲条目，
+ * 仍超限则淘汰最久未访问的条目，均为 O(1)；另由定时任务调用 evictIdle() 回收长时间未访问的桶。
+ */
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Decision {
+        bool allowed = true;
+        /// 被拒绝时距离下一个令牌可用的秒数（向上取整，至少为 1）
+        int retryAfterSeconds = 0;
+    };
+
+    struct KeyStats {
+        std::string key;
+        uint64_t allowed = 0;
+        uint64_t throttled = 0;
+    };
+
+    static RateLimiter& getInstance();
+
+    /**
+     * @brief 从 key 对应的令牌桶取一个令牌
+     *
+     * @param requestsPerSecond 令牌补充速率
+     * @param burst 桶容量
+     */
+    Decision acquire(const std::string& key, double requestsPerSecond, double burst,
+                     Clock::time_point now = Clock::now());
+
+    /// 回收超过 idle 未访问的桶，返回回收数量
+    size_t evictIdle(std::chrono::seconds idle, Clock::time_point now = Clock::now());
+
+    /// 设置全部分片合计的最大条目数（按分片均摊）
+    void setMaxKeys(size_t maxKeys);
+    void setIdleTimeout(std::chrono::seconds idle);
+
+    size_t size() const;
+    uint64_t totalAllowed() const { return totalAllowed_.load(std::memory_order_relaxed); }
+    uint64_t totalThrottled() const { return totalThrottled_.load(std::memory_order_relaxed); }
+    uint64_t totalEvicted() const { return totalEvicted_.load(std::memory_order_relaxed); }
+
+    /// 按被拒绝次数降序返回前 limit 个 key（仅包含被拒绝过的 key）
+    std::vector<KeyStats> topThrottled(size_t limit) const;
+
+    void clear();
+
+private:
+    RateLimiter() = default;
+
+    static constexpr size_t kShardCount = 16;
+
+    using LruList = std::list<std::string>;
+
+    struct Bucket {
+        double tokens = 0.0;
+        Clock::time_point lastRefill;
+        Clock::time_point lastSeen;
+        uint64_t allowed = 0;
+        uint64_t throttled = 0;
+        LruList::iterator lruIt;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Bucket> buckets;
+        /// 头部为最近访问，尾部为最久未访问
+        LruList lru;
+    };
+
+    Shard& shardFor(const std::string& key);
+    /// 调用方需持有 shard.mutex
+    void enforceCapacity(Shard& shard, Clock::time_point now);
+    /// 从 LRU 尾部回收空闲超过 idle 的桶，调用方需持有 shard.mutex
+    static size_t evictIdleLocked(Shard& shard, std::chrono::seconds idle, Clock::time_point now);
+
+    std::array<Shard, kShardCount> shards_;
+    std::atomic<size_t> maxKeysPerShard_{100000 / kShardCount};
+    std::atomic<int64_t> idleTimeoutSeconds_{600};
+
+    std::atomic<uint64_t> totalAllowed_{0};
+    std::atomic<uint64_t> totalThrottled_{0};
+    std::atomic<uint64_t> totalEvicted_{0};
+};
+
+#endif
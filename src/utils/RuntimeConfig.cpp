@@ -0,0 +1,437 @@
+#include "RuntimeConfig.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+namespace {
+
+std::string joinStringArray(const Json::Value& arr, const std::string& fallback) {
+    if (!arr.isArray() || arr.empty()) {
+        return fallback;
+    }
+    std::string out;
+    for (Json::ArrayIndex i = 0; i < arr.size(); ++i) {
+        if (!arr[i].isString()) continue;
+        if (!out.empty()) out += ", ";
+        out += arr[i].asString();
+    }
+    return out.empty() ? fallback : out;
+}
+
+std::unordered_set<std::string> toStringSet(const Json::Value& arr) {
+    std::unordered_set<std::string> out;
+    if (!arr.isArray()) return out;
+    for (const auto& item : arr) {
+        if (item.isString()) out.insert(item.asString());
+    }
+    return out;
+}
+
+std::unordered_map<std::string, bool> toBoolMap(const Json::Value& obj) {
+    std::unordered_map<std::string, bool> out;
+    if (!obj.isObject()) return out;
+    for (const auto& key : obj.getMemberNames()) {
+        if (obj[key].isBool()) out[key] = obj[key].asBool();
+    }
+    return out;
+}
+
+// 字段类型不符时回退默认值：JsonCpp 的 asXxx() 遇到不兼容类型会抛异常，热重载时不能因此中断
+int intOr(const Json::Value& node, const char* key, int fallback) {
+    const auto& value = node[key];
+    return value.isInt() ? value.asInt() : fallback;
+}
+
+bool boolOr(const Json::Value& node, const char* key, bool fallback) {
+    const auto& value = node[key];
+    return value.isBool() ? value.asBool() : fallback;
+}
+
+double doubleOr(const Json::Value& node, const char* key, double fallback) {
+    const auto& value = node[key];
+    return value.isNumeric() ? value.asDouble() : fallback;
+}
+
+std::string stringOr(const Json::Value& node, const char* key, const std::string& fallback) {
+    const auto& value = node[key];
+    return value.isString() ? value.asString() : fallback;
+}
+
+std::string toLowerCopy(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return s;
+}
+
+void parseRateLimit(const Json::Value& custom, RuntimeConfig::RateLimit& rl) {
+    if (!custom.isMember("rate_limit") || !custom["rate_limit"].isObject()) {
+        return;
+    }
+    const auto& node = custom["rate_limit"];
+    rl.enabled = boolOr(node, "enabled", false);
+    rl.requestsPerSecond = intOr(node, "requests_per_second", 10);
+    rl.burst = intOr(node, "burst", 20);
+    rl.idleSeconds = intOr(node, "idle_seconds", 600);
+    rl.maxKeys = intOr(node, "max_keys", 100000);
+
+    Json::Value keyBy = node["key_by"];
+    if (keyBy.isString()) {
+        Json::Value arr(Json::arrayValue);
+        arr.append(keyBy);
+        keyBy = arr;
+    }
+    if (keyBy.isArray() && !keyBy.empty()) {
+        using KeyPart = RuntimeConfig::RateLimit::KeyPart;
+        rl.keyBy.clear();
+        for (const auto& item : keyBy) {
+            if (!item.isString()) continue;
+            const std::string part = toLowerCopy(item.asString());
+            if (part == "ip") rl.keyBy.push_back(KeyPart::Ip);
+            else if (part == "api_key") rl.keyBy.push_back(KeyPart::ApiKey);
+            else if (part == "forwarded_for") rl.keyBy.push_back(KeyPart::ForwardedFor);
+            else if (part == "client_type") rl.keyBy.push_back(KeyPart::ClientType);
+        }
+        if (rl.keyBy.empty()) {
+            rl.keyBy.push_back(KeyPart::Ip);
+        }
+    }
+
+    const auto& routes = node["routes"];
+    if (routes.isObject()) {
+        for (const auto& path : routes.getMemberNames()) {
+            const auto& route = routes[path];
+            if (!route.isObject()) continue;
+            RuntimeConfig::RateLimit::RouteLimit limit;
+            limit.requestsPerSecond = intOr(route, "requests_per_second", rl.requestsPerSecond);
+            limit.burst = intOr(route, "burst", rl.burst);
+            rl.routes[path] = limit;
+        }
+    }
+}
+
+RuntimeConfig::Quota::Limits parseQuotaLimits(const Json::Value& node, const RuntimeConfig::Quota::Limits& fallback) {
+    RuntimeConfig::Quota::Limits limits = fallback;
+    if (!node.isObject()) return limits;
+    if (node["input_tokens"].isInt64()) limits.inputTokens = node["input_tokens"].asInt64();
+    if (node["output_tokens"].isInt64()) limits.outputTokens = node["output_tokens"].asInt64();
+    if (node["total_tokens"].isInt64()) limits.totalTokens = node["total_tokens"].asInt64();
+    return limits;
+}
+
+void parseQuota(const Json::Value& custom, RuntimeConfig::Quota& quota) {
+    if (!custom.isMember("quota") || !custom["quota"].isObject()) {
+        return;
+    }
+    const auto& node = custom["quota"];
+    quota.enabled = boolOr(node, "enabled", false);
+    quota.windowSeconds = intOr(node, "window_seconds", 3600);
+    quota.flushIntervalSeconds = intOr(node, "flush_interval_seconds", 30);
+    quota.defaults = parseQuotaLimits(node, RuntimeConfig::Quota::Limits{});
+
+    const auto& keys = node["keys"];
+    if (keys.isObject()) {
+        for (const auto& apiKey : keys.getMemberNames()) {
+            // 未显式给出的字段继承默认额度
+            quota.perKey[apiKey] = parseQuotaLimits(keys[apiKey], quota.defaults);
+        }
+    }
+}
+
+void parseAccountHealth(const Json::Value& custom, RuntimeConfig::AccountHealth& health) {
+    if (!custom.isMember("account_health") || !custom["account_health"].isObject()) {
+        return;
+    }
+    const auto& node = custom["account_health"];
+    health.ewmaAlpha = std::clamp(doubleOr(node, "ewma_alpha", health.ewmaAlpha), 0.01, 1.0);
+    health.errorThreshold = std::clamp(doubleOr(node, "error_threshold", health.errorThreshold), 0.01, 1.0);
+    health.minSamples = intOr(node, "min_samples", health.minSamples);
+    health.consecutiveFailures = intOr(node, "consecutive_failures", health.consecutiveFailures);
+    health.openSeconds = intOr(node, "open_seconds", health.openSeconds);
+    health.maxOpenSeconds = std::max(health.openSeconds, intOr(node, "max_open_seconds", health.maxOpenSeconds));
+    health.latencyReferenceMs = intOr(node, "latency_reference_ms", health.latencyReferenceMs);
+}
+
+void parseAccountThrottle(const Json::Value& custom, RuntimeConfig::AccountThrottle& throttle) {
+    if (!custom.isMember("account_throttle") || !custom["account_throttle"].isObject()) {
+        return;
+    }
+    const auto& node = custom["account_throttle"];
+    throttle.maxInFlight = intOr(node, "max_in_flight", throttle.maxInFlight);
+    throttle.defaultCooldownSeconds = intOr(node, "default_cooldown_seconds", throttle.defaultCooldownSeconds);
+    throttle.maxCooldownSeconds = std::max(throttle.defaultCooldownSeconds,
+                                           intOr(node, "max_cooldown_seconds", throttle.maxCooldownSeconds));
+    throttle.learnRate = boolOr(node, "learn_rate", throttle.learnRate);
+
+    const auto& byProvider = node["max_in_flight_by_provider"];
+    if (byProvider.isObject()) {
+        for (const auto& provider : byProvider.getMemberNames()) {
+            if (byProvider[provider].isInt()) {
+                throttle.maxInFlightByProvider[provider] = byProvider[provider].asInt();
+            }
+        }
+    }
+}
+
+void parseModelRouting(const Json::Value& custom, RuntimeConfig::ModelRouting& routing) {
+    if (!custom.isMember("model_routing") || !custom["model_routing"].isObject()) {
+        return;
+    }
+    const auto& node = custom["model_routing"];
+    routing.failureThreshold = intOr(node, "failure_threshold", routing.failureThreshold);
+    routing.openSeconds = intOr(node, "open_seconds", routing.openSeconds);
+    routing.maxOpenSeconds = std::max(routing.openSeconds, intOr(node, "max_open_seconds", routing.maxOpenSeconds));
+
+    const auto& routes = node["routes"];
+    if (!routes.isObject()) {
+        return;
+    }
+    for (const auto& model : routes.getMemberNames()) {
+        if (!routes[model].isArray()) continue;
+        auto& targets = routing.routes[model];
+        for (const auto& item : routes[model]) {
+            // 字符串表示同名模型，对象可指定上游模型名
+            RuntimeConfig::ModelRouting::Target target;
+            if (item.isString()) {
+                target.channel = item.asString();
+            } else if (item.isObject()) {
+                target.channel = stringOr(item, "channel", "");
+                target.model = stringOr(item, "model", "");
+            }
+            if (target.channel.empty()) continue;
+            if (target.model.empty()) target.model = model;
+            targets.push_back(std::move(target));
+        }
+    }
+}
+
+void parseCors(const Json::Value& custom, RuntimeConfig::Cors& cors) {
+    if (!custom.isMember("cors") || !custom["cors"].isObject()) {
+        return;
+    }
+    const auto& c = custom["cors"];
+
+    const auto& origins = c["allowed_origins"];
+    cors.allowedOrigins.clear();
+    cors.allowAnyOrigin = !origins.isArray() || origins.empty();
+    if (origins.isArray()) {
+        for (const auto& item : origins) {
+            if (!item.isString()) continue;
+            if (item.asString() == "*") {
+                cors.allowAnyOrigin = true;
+            }
+            cors.allowedOrigins.insert(item.asString());
+        }
+    }
+
+    cors.allowMethods = joinStringArray(c["allowed_methods"], cors.allowMethods);
+    cors.allowHeaders = joinStringArray(c["allowed_headers"], cors.allowHeaders);
+    cors.exposeHeaders = joinStringArray(c["expose_headers"], cors.exposeHeaders);
+    cors.maxAge = std::to_string(intOr(c, "max_age", 3600));
+    cors.allowCredentials = boolOr(c, "allow_credentials", false);
+}
+
+void parseToolBridge(const Json::Value& custom, RuntimeConfig::ToolBridge& tb) {
+    if (!custom.isMember("tool_bridge") || !custom["tool_bridge"].isObject()) {
+        return;
+    }
+    const auto& node = custom["tool_bridge"];
+    tb.present = true;
+
+    if (node.isMember("definition_mode") && node["definition_mode"].isString()) {
+        // 非法取值由 ConfigValidator 给出告警，这里回退到 compact
+        tb.fullDefinitions = toLowerCopy(node["definition_mode"].asString()) == "full";
+    }
+    if (node.isMember("include_descriptions") && node["include_descriptions"].isBool()) {
+        tb.includeDescriptions = node["include_descriptions"].asBool();
+    }
+    if (node.isMember("max_description_chars") && node["max_description_chars"].isInt()) {
+        tb.maxDescriptionChars = std::clamp(node["max_description_chars"].asInt(), 0, 2000);
+    }
+    if (node.isMember("rewrite_user_input_conflicts") && node["rewrite_user_input_conflicts"].isBool()) {
+        tb.rewriteUserInputConflicts = node["rewrite_user_input_conflicts"].asBool();
+    }
+    if (node.isMember("trigger_random_length") && node["trigger_random_length"].isInt()) {
+        tb.triggerRandomLength = node["trigger_random_length"].asInt();
+    }
+
+    if (node.isMember("strict_sentinel") && node["strict_sentinel"].isBool()) {
+        tb.strictSentinel = node["strict_sentinel"].asBool();
+    }
+    tb.strictSentinelByChannel = toBoolMap(node["strict_sentinel_by_channel"]);
+    tb.strictSentinelByModel = toBoolMap(node["strict_sentinel_by_model"]);
+    tb.strictSentinelEnabledChannels = toStringSet(node["strict_sentinel_enabled_channels"]);
+    tb.strictSentinelDisabledChannels = toStringSet(node["strict_sentinel_disabled_channels"]);
+    tb.strictSentinelEnabledModels = toStringSet(node["strict_sentinel_enabled_models"]);
+    tb.strictSentinelDisabledModels = toStringSet(node["strict_sentinel_disabled_models"]);
+}
+
+} // 匿名命名空间
+
+bool RuntimeConfig::Cors::isOriginAllowed(const std::string& origin) const {
+    if (allowAnyOrigin) {
+        return true;
+    }
+    return !origin.empty() && allowedOrigins.count(origin) > 0;
+}
+
+const RuntimeConfig::Quota::Limits& RuntimeConfig::Quota::limitsFor(const std::string& apiKey) const {
+    auto it = perKey.find(apiKey);
+    return it != perKey.end() ? it->second : defaults;
+}
+
+int RuntimeConfig::AccountThrottle::maxInFlightFor(const std::string& provider) const {
+    auto it = maxInFlightByProvider.find(provider);
+    return it != maxInFlightByProvider.end() ? it->second : maxInFlight;
+}
+
+bool RuntimeConfig::ToolBridge::strictSentinelFor(const std::string& channel, const std::string& model) const {
+    if (!present) {
+        return false;
+    }
+
+    bool strict = strictSentinel;
+
+    auto channelIt = strictSentinelByChannel.find(channel);
+    if (channelIt != strictSentinelByChannel.end()) {
+        strict = channelIt->second;
+    }
+    if (!model.empty()) {
+        auto modelIt = strictSentinelByModel.find(model);
+        if (modelIt != strictSentinelByModel.end()) {
+            strict = modelIt->second;
+        }
+    }
+
+    if (!channel.empty()) {
+        if (strictSentinelDisabledChannels.count(channel)) strict = false;
+        if (strictSentinelEnabledChannels.count(channel)) strict = true;
+    }
+    if (!model.empty()) {
+        if (strictSentinelDisabledModels.count(model)) strict = false;
+        if (strictSentinelEnabledModels.count(model)) strict = true;
+    }
+
+    return strict;
+}
+
+std::shared_ptr<const RuntimeConfig> RuntimeConfig::fromCustomConfig(const Json::Value& customConfig) {
+    auto config = std::make_shared<RuntimeConfig>();
+    if (!customConfig.isObject()) {
+        return config;
+    }
+
+    if (customConfig.isMember("admin_api_key") && customConfig["admin_api_key"].isString()) {
+        config->adminApiKey = customConfig["admin_api_key"].asString();
+    }
+
+    parseRateLimit(customConfig, config->rateLimit);
+    parseQuota(customConfig, config->quota);
+    parseAccountHealth(customConfig, config->accountHealth);
+    parseAccountThrottle(customConfig, config->accountThrottle);
+    parseModelRouting(customConfig, config->modelRouting);
+    parseCors(customConfig, config->cors);
+    parseToolBridge(customConfig, config->toolBridge);
+
+    return config;
+}
+
+// ========== RuntimeConfigStore ==========
+
+RuntimeConfigStore& RuntimeConfigStore::getInstance() {
+    static RuntimeConfigStore instance;
+    return instance;
+}
+
+RuntimeConfigStore::RuntimeConfigStore()
+    : current_(RuntimeConfig::fromCustomConfig(Json::Value(Json::objectValue))) {
+}
+
+std::shared_ptr<const RuntimeConfig> RuntimeConfigStore::current() const {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return current_.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&current_, std::memory_order_acquire);
+#endif
+}
+
+void RuntimeConfigStore::publish(std::shared_ptr<const RuntimeConfig> config) {
+    if (!config) return;
+    const auto published = config;
+#if defined(__cpp_lib_atomic_shared_ptr)
+    current_.store(std::move(config), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&current_, std::move(config), std::memory_order_release);
+#endif
+    version_.fetch_add(1, std::memory_order_acq_rel);
+
+    std::vector<PublishListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(listenersMutex_);
+        listeners = listeners_;
+    }
+    for (const auto& listener : listeners) {
+        listener(*published);
+    }
+}
+
+void RuntimeConfigStore::addPublishListener(PublishListener listener) {
+    if (!listener) return;
+    std::lock_guard<std::mutex> lock(listenersMutex_);
+    listeners_.push_back(std::move(listener));
+}
+
+void RuntimeConfigStore::setConfigPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(pathMutex_);
+    configPath_ = path;
+}
+
+std::string RuntimeConfigStore::configPath() const {
+    std::lock_guard<std::mutex> lock(pathMutex_);
+    return configPath_;
+}
+
+ConfigValidator::ValidationResult RuntimeConfigStore::reloadFromFile(const std::string& path) {
+    ConfigValidator::ValidationResult result;
+
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        result.valid = false;
+        result.errors.emplace_back("无法打开配置文件：" + path);
+        return result;
+    }
+
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    std::string errs;
+    if (!Json::parseFromStream(builder, in, &root, &errs)) {
+        result.valid = false;
+        result.errors.emplace_back("配置文件 JSON 解析失败：" + errs);
+        return result;
+    }
+
+    try {
+        result = ConfigValidator::validate(root);
+        if (!result.valid) {
+            return result;
+        }
+        publish(RuntimeConfig::fromCustomConfig(root["custom_config"]));
+    } catch (const std::exception& e) {
+        // 兜底：字段类型与预期不符时 JsonCpp 抛异常，按校验失败处理，保留当前配置
+        result.valid = false;
+        result.errors.emplace_back(std::string("配置字段类型错误：") + e.what());
+    }
+    return result;
+}
+
+ConfigValidator::ValidationResult RuntimeConfigStore::reload() {
+    const std::string path = configPath();
+    if (path.empty()) {
+        ConfigValidator::ValidationResult result;
+        result.valid = false;
+        result.errors.emplace_back("未设置配置文件路径");
+        return result;
+    }
+    return reloadFromFile(path);
+}
@@ -0,0 +1,209 @@
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include "ConfigValidator.h"
+#include <json/json.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief 运行期配置快照（不可变）
+ *
+ * 由 custom_config 一次性解析为强类型字段，热路径（过滤器、CORS advice、工具桥接）
+ * 直接读取预计算结果，不再逐请求解析 Json。快照经 RuntimeConfigStore 原子发布，
+ * 持有者在快照生命周期内看到的配置保持一致。
+ */
+struct RuntimeConfig {
+    struct RateLimit {
+        /// 限流 key 的组成部分
+        enum class KeyPart { Ip, ApiKey, ForwardedFor, ClientType };
+
+        struct RouteLimit {
+            int requestsPerSecond = 0;
+            int burst = 0;
+        };
+
+        bool enabled = false;
+        int requestsPerSecond = 10;
+        int burst = 20;
+        /// 按顺序拼接为限流 key，默认仅按对端 IP
+        std::vector<KeyPart> keyBy{KeyPart::Ip};
+        /// 按请求路径覆盖速率（精确匹配），命中时使用独立的桶
+        std::unordered_map<std::string, RouteLimit> routes;
+        int idleSeconds = 600;
+        int maxKeys = 100000;
+    };
+
+    struct Quota {
+        /// 0 表示不限制
+        struct Limits {
+            int64_t inputTokens = 0;
+            int64_t outputTokens = 0;
+            int64_t totalTokens = 0;
+
+            bool unlimited() const { return inputTokens <= 0 && outputTokens <= 0 && totalTokens <= 0; }
+        };
+
+        bool enabled = false;
+        /// 固定窗口长度（秒），窗口按 epoch 对齐
+        int windowSeconds = 3600;
+        int flushIntervalSeconds = 30;
+        Limits defaults;
+        /// 按客户端 API Key 覆盖默认额度
+        std::unordered_map<std::string, Limits> perKey;
+
+        const Limits& limitsFor(const std::string& apiKey) const;
+    };
+
+    struct AccountHealth {
+        /// 延迟与错误率 EWMA 的平滑系数，越大越偏重最近的结果
+        double ewmaAlpha = 0.2;
+        /// 错误率 EWMA 达到该值（且样本数不少于 minSamples）时熔断
+        double errorThreshold = 0.5;
+        int minSamples = 5;
+        /// 连续失败达到该次数时直接熔断
+        int consecutiveFailures = 5;
+        /// 首次熔断时长，半开探测再次失败时翻倍，最长 maxOpenSeconds
+        int openSeconds = 30;
+        int maxOpenSeconds = 600;
+        /// 延迟惩罚的参考值：EWMA 延迟等于该值时调度权重减半
+        int latencyReferenceMs = 30000;
+    };
+
+    struct AccountThrottle {
+        /// 单账号最大在途请求数，0 表示不限制
+        int maxInFlight = 0;
+        /// 按渠道覆盖 maxInFlight
+        std::unordered_map<std::string, int> maxInFlightByProvider;
+        /// 上游 429 未给出 Retry-After 时的首次冷却时长，连续 429 时翻倍
+        int defaultCooldownSeconds = 10;
+        int maxCooldownSeconds = 300;
+        /// 是否根据 429 学习单账号的每分钟请求上限（AIMD）
+        bool learnRate = false;
+
+        int maxInFlightFor(const std::string& provider) const;
+    };
+
+    struct ModelRouting {
+        struct Target {
+            std::string channel;
+            /// 该渠道上使用的上游模型名
+            std::string model;
+        };
+        /// 请求模型 → 备选 (渠道, 上游模型)，未配置的模型只走请求路径对应的渠道
+        std::unordered_map<std::string, std::vector<Target>> routes;
+        /// 渠道连续可重试失败达到该次数时熔断
+        int failureThreshold = 3;
+        /// 首次熔断时长，半开探测再次失败时翻倍，最长 maxOpenSeconds
+        int openSeconds = 30;
+        int maxOpenSeconds = 300;
+    };
+
+    struct Cors {
+        /// allowed_origins 为空或包含 "*" 时放行任意 Origin
+        bool allowAnyOrigin = true;
+        std::unordered_set<std::string> allowedOrigins;
+        /// 预先拼接好的响应头值
+        std::string allowMethods = "GET, POST, PUT, DELETE, OPTIONS, PATCH";
+        std::string allowHeaders = "*";
+        std::string exposeHeaders = "*";
+        std::string maxAge = "3600";
+        bool allowCredentials = false;
+
+        bool isOriginAllowed(const std::string& origin) const;
+    };
+
+    struct ToolBridge {
+        /// custom_config 中是否存在 tool_bridge 节点（影响 strict_sentinel 默认值）
+        bool present = false;
+        bool fullDefinitions = false;
+        bool includeDescriptions = false;
+        int maxDescriptionChars = 160;
+        bool rewriteUserInputConflicts = false;
+        int triggerRandomLength = 8;
+
+        bool strictSentinel = true;
+        std::unordered_map<std::string, bool> strictSentinelByChannel;
+        std::unordered_map<std::string, bool> strictSentinelByModel;
+        std::unordered_set<std::string> strictSentinelEnabledChannels;
+        std::unordered_set<std::string> strictSentinelDisabledChannels;
+        std::unordered_set<std::string> strictSentinelEnabledModels;
+        std::unordered_set<std::string> strictSentinelDisabledModels;
+
+        /**
+         * @brief 按 全局 -> by_channel/by_model -> disabled/enabled 列表 的优先级计算 strict_sentinel
+         *
+         * 未配置 tool_bridge 时返回 false；strict 客户端与 tool_choice=required 的强制开启由调用方处理。
+         */
+        bool strictSentinelFor(const std::string& channel, const std::string& model) const;
+    };
+
+    std::string adminApiKey;
+    RateLimit rateLimit;
+    Quota quota;
+    AccountHealth accountHealth;
+    AccountThrottle accountThrottle;
+    ModelRouting modelRouting;
+    Cors cors;
+    ToolBridge toolBridge;
+
+    /// 从 custom_config 节点构建快照（调用方负责先行校验）
+    static std::shared_ptr<const RuntimeConfig> fromCustomConfig(const Json::Value& customConfig);
+};
+
+/**
+ * @brief 运行期配置快照的发布点
+ *
+ * 读取方通过 current() 取得 shared_ptr 副本后即可无锁访问；
+ * reloadFromFile() 解析并校验配置文件，仅在校验通过时原子替换快照。
+ * 需要把配置同步到其他单例的模块用 addPublishListener() 注册回调，
+ * 启动发布、SIGHUP 与 HTTP 重载都经 publish()，因此各路径行为一致。
+ */
+class RuntimeConfigStore {
+public:
+    static RuntimeConfigStore& getInstance();
+
+    std::shared_ptr<const RuntimeConfig> current() const;
+    using PublishListener = std::function<void(const RuntimeConfig&)>;
+
+    /// 替换快照后按注册顺序同步调用各监听器
+    void publish(std::shared_ptr<const RuntimeConfig> config);
+    void addPublishListener(PublishListener listener);
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    void setConfigPath(const std::string& path);
+    std::string configPath() const;
+
+    /**
+     * @brief 重新加载配置文件
+     *
+     * JSON 解析失败或校验不通过时保留当前快照，错误写入返回结果。
+     */
+    ConfigValidator::ValidationResult reloadFromFile(const std::string& path);
+    ConfigValidator::ValidationResult reload();
+
+private:
+    RuntimeConfigStore();
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<const RuntimeConfig>> current_;
+#else
+    std::shared_ptr<const RuntimeConfig> current_;
+#endif
+    std::atomic<uint64_t> version_{0};
+
+    mutable std::mutex pathMutex_;
+    std::string configPath_;
+
+    std::mutex listenersMutex_;
+    std::vector<PublishListener> listeners_;
+};
+
+#endif